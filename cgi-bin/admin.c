@@ -71,202 +71,209 @@ main(void)
   const char	*op;			/* Operation name */
 
 
- /*
-  * Connect to the HTTP server...
-  */
-
-  fputs("DEBUG: admin.cgi started...\n", stderr);
-
-  http = httpConnectEncrypt(cupsServer(), ippPort(), cupsEncryption());
-
-  if (!http)
-  {
-    perror("ERROR: Unable to connect to cupsd");
-    fprintf(stderr, "DEBUG: cupsServer()=\"%s\"\n",
-            cupsServer() ? cupsServer() : "(null)");
-    fprintf(stderr, "DEBUG: ippPort()=%d\n", ippPort());
-    fprintf(stderr, "DEBUG: cupsEncryption()=%d\n", cupsEncryption());
-    exit(1);
-  }
-
-  fprintf(stderr, "DEBUG: http=%p\n", http);
-
- /*
-  * Set the web interface section...
-  */
-
-  cgiSetVariable("SECTION", "admin");
-  cgiSetVariable("REFRESH_PAGE", "");
-
- /*
-  * See if we have form data...
-  */
-
-  if (!cgiInitialize() || !cgiGetVariable("OP"))
+  while (cgiAcceptRequest())
   {
    /*
-    * Nope, send the administration menu...
+    * Connect to the HTTP server...
     */
 
-    fputs("DEBUG: No form data, showing main menu...\n", stderr);
+    fputs("DEBUG: admin.cgi started...\n", stderr);
 
-    do_menu(http);
-  }
-  else if ((op = cgiGetVariable("OP")) != NULL && cgiIsPOST())
-  {
    /*
-    * Do the operation...
+    * Set the web interface section...
     */
 
-    fprintf(stderr, "DEBUG: op=\"%s\"...\n", op);
+    cgiSetVariable("SECTION", "admin");
+    cgiSetVariable("REFRESH_PAGE", "");
 
-    if (!*op)
-    {
-      const char *printer = getenv("PRINTER_NAME"),
-					/* Printer or class name */
-		*server_port = getenv("SERVER_PORT");
-					/* Port number string */
-      int	port = atoi(server_port ? server_port : "0");
-      					/* Port number */
-      char	uri[1024];		/* URL */
-
-      if (printer)
-        httpAssembleURIf(HTTP_URI_CODING_ALL, uri, sizeof(uri),
-	                 getenv("HTTPS") ? "https" : "http", NULL,
-			 getenv("SERVER_NAME"), port, "/%s/%s",
-			 cgiGetVariable("IS_CLASS") ? "classes" : "printers",
-			 printer);
-      else
-        httpAssembleURI(HTTP_URI_CODING_ALL, uri, sizeof(uri),
-	                getenv("HTTPS") ? "https" : "http", NULL,
-			getenv("SERVER_NAME"), port, "/admin");
+    http = cgiConnect();
 
-      printf("Location: %s\n\n", uri);
-    }
-    else if (!strcmp(op, "set-allowed-users"))
-      do_set_allowed_users(http);
-    else if (!strcmp(op, "set-as-default"))
-      do_set_default(http);
-    else if (!strcmp(op, "set-sharing"))
-      do_set_sharing(http);
-    else if (!strcmp(op, "find-new-printers") ||
-             !strcmp(op, "list-available-printers"))
-      do_list_printers(http);
-    else if (!strcmp(op, "add-class"))
-      do_am_class(http, 0);
-    else if (!strcmp(op, "add-printer"))
-      do_am_printer(http, 0);
-    else if (!strcmp(op, "modify-class"))
-      do_am_class(http, 1);
-    else if (!strcmp(op, "modify-printer"))
-      do_am_printer(http, 1);
-    else if (!strcmp(op, "delete-class"))
-      do_delete_class(http);
-    else if (!strcmp(op, "delete-printer"))
-      do_delete_printer(http);
-    else if (!strcmp(op, "set-class-options"))
-      do_set_options(http, 1);
-    else if (!strcmp(op, "set-printer-options"))
-      do_set_options(http, 0);
-    else if (!strcmp(op, "config-server"))
-      do_config_server(http);
-    else if (!strcmp(op, "export-samba"))
-      do_export(http);
-    else if (!strcmp(op, "add-rss-subscription"))
-      do_add_rss_subscription(http);
-    else if (!strcmp(op, "cancel-subscription"))
-      do_cancel_subscription(http);
-    else
+    if (!http)
     {
      /*
-      * Bad operation code - display an error...
+      * Show an error page and wait for the next request; a persistent worker
+      * must not exit in the middle of a request...
       */
 
+      perror("ERROR: Unable to connect to cupsd");
+      fprintf(stderr, "DEBUG: cupsServer()=\"%s\"\n",
+	      cupsServer() ? cupsServer() : "(null)");
+      fprintf(stderr, "DEBUG: ippPort()=%d\n", ippPort());
+      fprintf(stderr, "DEBUG: cupsEncryption()=%d\n", cupsEncryption());
+
       cgiStartHTML(cgiText(_("Administration")));
-      cgiCopyTemplateLang("error-op.tmpl");
+      cgiSetVariable("ERROR", cgiText(_("Unable to connect to host.")));
+      cgiCopyTemplateLang("error.tmpl");
       cgiEndHTML();
+      continue;
     }
-  }
-  else if (op && !strcmp(op, "redirect"))
-  {
-    const char	*url;			/* Redirection URL... */
-    char	prefix[1024];		/* URL prefix */
 
+    fprintf(stderr, "DEBUG: http=%p\n", http);
 
-    if (getenv("HTTPS"))
-      snprintf(prefix, sizeof(prefix), "https://%s:%s",
-	       getenv("SERVER_NAME"), getenv("SERVER_PORT"));
-    else
-      snprintf(prefix, sizeof(prefix), "http://%s:%s",
-	       getenv("SERVER_NAME"), getenv("SERVER_PORT"));
-
-    fprintf(stderr, "DEBUG: redirecting with prefix %s!\n", prefix);
+   /*
+    * See if we have form data...
+    */
 
-    if ((url = cgiGetVariable("URL")) != NULL)
+    if (!cgiInitialize() || !cgiGetVariable("OP"))
     {
-      char	encoded[1024],		/* Encoded URL string */
-      		*ptr;			/* Pointer into encoded string */
+     /*
+      * Nope, send the administration menu...
+      */
 
+      fputs("DEBUG: No form data, showing main menu...\n", stderr);
 
-      ptr = encoded;
-      if (*url != '/')
-        *ptr++ = '/';
+      do_menu(http);
+    }
+    else if ((op = cgiGetVariable("OP")) != NULL && cgiIsPOST())
+    {
+     /*
+      * Do the operation...
+      */
 
-      for (; *url && ptr < (encoded + sizeof(encoded) - 4); url ++)
-      {
-        if (strchr("%@&+ <>#=", *url) || *url < ' ' || *url & 128)
-	{
-	 /*
-	  * Percent-encode this character; safe because we have at least 4
-	  * bytes left in the array...
-	  */
+      fprintf(stderr, "DEBUG: op=\"%s\"...\n", op);
 
-	  sprintf(ptr, "%%%02X", *url & 255);
-	  ptr += 3;
-	}
+      if (!*op)
+      {
+	const char *printer = getenv("PRINTER_NAME"),
+					  /* Printer or class name */
+		  *server_port = getenv("SERVER_PORT");
+					  /* Port number string */
+	int	port = atoi(server_port ? server_port : "0");
+					  /* Port number */
+	char	uri[1024];		/* URL */
+
+	if (printer)
+	  httpAssembleURIf(HTTP_URI_CODING_ALL, uri, sizeof(uri),
+			   getenv("HTTPS") ? "https" : "http", NULL,
+			   getenv("SERVER_NAME"), port, "/%s/%s",
+			   cgiGetVariable("IS_CLASS") ? "classes" : "printers",
+			   printer);
 	else
-	  *ptr++ = *url;
-      }
-
-      *ptr = '\0';
+	  httpAssembleURI(HTTP_URI_CODING_ALL, uri, sizeof(uri),
+			  getenv("HTTPS") ? "https" : "http", NULL,
+			  getenv("SERVER_NAME"), port, "/admin");
 
-      if (*url)
+	printf("Location: %s\n\n", uri);
+      }
+      else if (!strcmp(op, "set-allowed-users"))
+	do_set_allowed_users(http);
+      else if (!strcmp(op, "set-as-default"))
+	do_set_default(http);
+      else if (!strcmp(op, "set-sharing"))
+	do_set_sharing(http);
+      else if (!strcmp(op, "find-new-printers") ||
+	       !strcmp(op, "list-available-printers"))
+	do_list_printers(http);
+      else if (!strcmp(op, "add-class"))
+	do_am_class(http, 0);
+      else if (!strcmp(op, "add-printer"))
+	do_am_printer(http, 0);
+      else if (!strcmp(op, "modify-class"))
+	do_am_class(http, 1);
+      else if (!strcmp(op, "modify-printer"))
+	do_am_printer(http, 1);
+      else if (!strcmp(op, "delete-class"))
+	do_delete_class(http);
+      else if (!strcmp(op, "delete-printer"))
+	do_delete_printer(http);
+      else if (!strcmp(op, "set-class-options"))
+	do_set_options(http, 1);
+      else if (!strcmp(op, "set-printer-options"))
+	do_set_options(http, 0);
+      else if (!strcmp(op, "config-server"))
+	do_config_server(http);
+      else if (!strcmp(op, "export-samba"))
+	do_export(http);
+      else if (!strcmp(op, "add-rss-subscription"))
+	do_add_rss_subscription(http);
+      else if (!strcmp(op, "cancel-subscription"))
+	do_cancel_subscription(http);
+      else
       {
        /*
-        * URL was too long, just redirect to the admin page...
+	* Bad operation code - display an error...
 	*/
 
-	printf("Location: %s/admin\n\n", prefix);
+	cgiStartHTML(cgiText(_("Administration")));
+	cgiCopyTemplateLang("error-op.tmpl");
+	cgiEndHTML();
       }
+    }
+    else if (op && !strcmp(op, "redirect"))
+    {
+      const char	*url;			/* Redirection URL... */
+      char	prefix[1024];		/* URL prefix */
+
+
+      if (getenv("HTTPS"))
+	snprintf(prefix, sizeof(prefix), "https://%s:%s",
+		 getenv("SERVER_NAME"), getenv("SERVER_PORT"));
       else
+	snprintf(prefix, sizeof(prefix), "http://%s:%s",
+		 getenv("SERVER_NAME"), getenv("SERVER_PORT"));
+
+      fprintf(stderr, "DEBUG: redirecting with prefix %s!\n", prefix);
+
+      if ((url = cgiGetVariable("URL")) != NULL)
       {
-       /*
-        * URL is OK, redirect there...
-	*/
+	char	encoded[1024],		/* Encoded URL string */
+		  *ptr;			/* Pointer into encoded string */
+
+
+	ptr = encoded;
+	if (*url != '/')
+	  *ptr++ = '/';
+
+	for (; *url && ptr < (encoded + sizeof(encoded) - 4); url ++)
+	{
+	  if (strchr("%@&+ <>#=", *url) || *url < ' ' || *url & 128)
+	  {
+	   /*
+	    * Percent-encode this character; safe because we have at least 4
+	    * bytes left in the array...
+	    */
+
+	    sprintf(ptr, "%%%02X", *url & 255);
+	    ptr += 3;
+	  }
+	  else
+	    *ptr++ = *url;
+	}
+
+	*ptr = '\0';
 
-        printf("Location: %s%s\n\n", prefix, encoded);
+	if (*url)
+	{
+	 /*
+	  * URL was too long, just redirect to the admin page...
+	  */
+
+	  printf("Location: %s/admin\n\n", prefix);
+	}
+	else
+	{
+	 /*
+	  * URL is OK, redirect there...
+	  */
+
+	  printf("Location: %s%s\n\n", prefix, encoded);
+	}
       }
+      else
+	printf("Location: %s/admin\n\n", prefix);
     }
     else
-      printf("Location: %s/admin\n\n", prefix);
-  }
-  else
-  {
-   /*
-    * Form data but no operation code - display an error...
-    */
+    {
+     /*
+      * Form data but no operation code - display an error...
+      */
 
-    cgiStartHTML(cgiText(_("Administration")));
-    cgiCopyTemplateLang("error-op.tmpl");
-    cgiEndHTML();
+      cgiStartHTML(cgiText(_("Administration")));
+      cgiCopyTemplateLang("error-op.tmpl");
+      cgiEndHTML();
+    }
   }
 
- /*
-  * Close the HTTP server connection...
-  */
-
-  httpClose(http);
-
  /*
   * Return with no errors...
   */
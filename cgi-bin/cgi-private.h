@@ -31,6 +31,13 @@
 #define CUPS_PAGE_MAX	100		/* Maximum items per page */
 
 
+/*
+ * Prototypes...
+ */
+
+extern void	_cgiResetIPPState(int keep);
+
+
 /*
  * End of "$Id: cgi-private.h 10996 2013-05-29 11:51:34Z msweet $".
  */
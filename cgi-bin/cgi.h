@@ -61,9 +61,11 @@ typedef struct cgi_file_s		/**** Uploaded file data ****/
 
 extern void		cgiAbort(const char *title, const char *stylesheet,
 			         const char *format, ...);
+extern int		cgiAcceptRequest(void);
 extern int		cgiCheckVariables(const char *names);
 extern void		cgiClearVariables(void);
 extern void		*cgiCompileSearch(const char *query);
+extern http_t		*cgiConnect(void);
 extern void		cgiCopyTemplateFile(FILE *out, const char *tmpl);
 extern void		cgiCopyTemplateLang(const char *tmpl);
 extern int		cgiDoSearch(void *search, const char *text);
@@ -77,6 +79,10 @@ extern void		cgiGetAttributes(ipp_t *request, const char *tmpl);
 extern const char	*cgiGetCookie(const char *name);
 extern const cgi_file_t	*cgiGetFile(void);
 extern cups_array_t	*cgiGetIPPObjects(ipp_t *response, void *search);
+extern cups_array_t	*cgiGetIPPPage(http_t *http, ipp_t *request,
+			               const char *query, int ascending,
+				       int *first, int *count,
+				       ipp_t **response);
 extern int		cgiGetSize(const char *name);
 extern char		*cgiGetTemplateDir(void);
 extern const char	*cgiGetVariable(const char *name);
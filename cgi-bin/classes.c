@@ -51,149 +51,146 @@ main(void)
 		};
 
 
- /*
-  * Get any form variables...
-  */
+  while (cgiAcceptRequest())
+  {
+   /*
+    * Get any form variables...
+    */
 
-  cgiInitialize();
+    cgiInitialize();
 
-  op = cgiGetVariable("OP");
+    op = cgiGetVariable("OP");
 
- /*
-  * Set the web interface section...
-  */
+   /*
+    * Set the web interface section...
+    */
 
-  cgiSetVariable("SECTION", "classes");
-  cgiSetVariable("REFRESH_PAGE", "");
+    cgiSetVariable("SECTION", "classes");
+    cgiSetVariable("REFRESH_PAGE", "");
 
- /*
-  * See if we are displaying a printer or all classes...
-  */
+   /*
+    * See if we are displaying a printer or all classes...
+    */
 
-  if ((pclass = getenv("PATH_INFO")) != NULL)
-  {
-    pclass ++;
+    if ((pclass = getenv("PATH_INFO")) != NULL)
+    {
+      pclass ++;
 
-    if (!*pclass)
-      pclass = NULL;
+      if (!*pclass)
+	pclass = NULL;
 
-    if (pclass)
-      cgiSetVariable("PRINTER_NAME", pclass);
-  }
+      if (pclass)
+	cgiSetVariable("PRINTER_NAME", pclass);
+    }
 
- /*
-  * See who is logged in...
-  */
+   /*
+    * See who is logged in...
+    */
 
-  user = getenv("REMOTE_USER");
+    user = getenv("REMOTE_USER");
 
- /*
-  * Connect to the HTTP server...
-  */
-
-  http = httpConnectEncrypt(cupsServer(), ippPort(), cupsEncryption());
+   /*
+    * Connect to the HTTP server...
+    */
 
- /*
-  * Get the default printer...
-  */
+    http = cgiConnect();
 
-  if (!op || !cgiIsPOST())
-  {
    /*
-    * Get the default destination...
+    * Get the default printer...
     */
 
-    request = ippNewRequest(CUPS_GET_DEFAULT);
+    if (!op || !cgiIsPOST())
+    {
+     /*
+      * Get the default destination...
+      */
 
-    ippAddStrings(request, IPP_TAG_OPERATION, IPP_TAG_KEYWORD,
-                  "requested-attributes",
-		  sizeof(def_attrs) / sizeof(def_attrs[0]), NULL, def_attrs);
+      request = ippNewRequest(CUPS_GET_DEFAULT);
 
-    if ((response = cupsDoRequest(http, request, "/")) != NULL)
-    {
-      if ((attr = ippFindAttribute(response, "printer-name", IPP_TAG_NAME)) != NULL)
-        cgiSetVariable("DEFAULT_NAME", attr->values[0].string.text);
+      ippAddStrings(request, IPP_TAG_OPERATION, IPP_TAG_KEYWORD,
+		    "requested-attributes",
+		    sizeof(def_attrs) / sizeof(def_attrs[0]), NULL, def_attrs);
 
-      if ((attr = ippFindAttribute(response, "printer-uri-supported", IPP_TAG_URI)) != NULL)
+      if ((response = cupsDoRequest(http, request, "/")) != NULL)
       {
-	char	url[HTTP_MAX_URI];	/* New URL */
+	if ((attr = ippFindAttribute(response, "printer-name", IPP_TAG_NAME)) != NULL)
+	  cgiSetVariable("DEFAULT_NAME", attr->values[0].string.text);
 
+	if ((attr = ippFindAttribute(response, "printer-uri-supported", IPP_TAG_URI)) != NULL)
+	{
+	  char	url[HTTP_MAX_URI];	/* New URL */
 
-        cgiSetVariable("DEFAULT_URI",
-	               cgiRewriteURL(attr->values[0].string.text,
-		                     url, sizeof(url), NULL));
-      }
 
-      ippDelete(response);
-    }
+	  cgiSetVariable("DEFAULT_URI",
+			 cgiRewriteURL(attr->values[0].string.text,
+				       url, sizeof(url), NULL));
+	}
 
-   /*
-    * See if we need to show a list of classes or the status of a
-    * single printer...
-    */
+	ippDelete(response);
+      }
 
-    if (!pclass)
-      show_all_classes(http, user);
-    else
-      show_class(http, pclass);
-  }
-  else if (pclass)
-  {
-    if (!*op)
+     /*
+      * See if we need to show a list of classes or the status of a
+      * single printer...
+      */
+
+      if (!pclass)
+	show_all_classes(http, user);
+      else
+	show_class(http, pclass);
+    }
+    else if (pclass)
     {
-      const char *server_port = getenv("SERVER_PORT");
-					/* Port number string */
-      int	port = atoi(server_port ? server_port : "0");
-      					/* Port number */
-      char	uri[1024];		/* URL */
+      if (!*op)
+      {
+	const char *server_port = getenv("SERVER_PORT");
+					  /* Port number string */
+	int	port = atoi(server_port ? server_port : "0");
+					  /* Port number */
+	char	uri[1024];		/* URL */
 
-      httpAssembleURIf(HTTP_URI_CODING_ALL, uri, sizeof(uri),
-		       getenv("HTTPS") ? "https" : "http", NULL,
-		       getenv("SERVER_NAME"), port, "/classes/%s", pclass);
+	httpAssembleURIf(HTTP_URI_CODING_ALL, uri, sizeof(uri),
+			 getenv("HTTPS") ? "https" : "http", NULL,
+			 getenv("SERVER_NAME"), port, "/classes/%s", pclass);
+
+	printf("Location: %s\n\n", uri);
+      }
+      else if (!strcmp(op, "start-class"))
+	do_class_op(http, pclass, IPP_RESUME_PRINTER, cgiText(_("Resume Class")));
+      else if (!strcmp(op, "stop-class"))
+	do_class_op(http, pclass, IPP_PAUSE_PRINTER, cgiText(_("Pause Class")));
+      else if (!strcmp(op, "accept-jobs"))
+	do_class_op(http, pclass, CUPS_ACCEPT_JOBS, cgiText(_("Accept Jobs")));
+      else if (!strcmp(op, "reject-jobs"))
+	do_class_op(http, pclass, CUPS_REJECT_JOBS, cgiText(_("Reject Jobs")));
+      else if (!strcmp(op, "cancel-jobs"))
+	do_class_op(http, pclass, IPP_OP_CANCEL_JOBS, cgiText(_("Cancel Jobs")));
+      else if (!_cups_strcasecmp(op, "print-test-page"))
+	cgiPrintTestPage(http, pclass);
+      else if (!_cups_strcasecmp(op, "move-jobs"))
+	cgiMoveJobs(http, pclass, 0);
+      else
+      {
+       /*
+	* Unknown/bad operation...
+	*/
 
-      printf("Location: %s\n\n", uri);
+	cgiStartHTML(pclass);
+	cgiCopyTemplateLang("error-op.tmpl");
+	cgiEndHTML();
+      }
     }
-    else if (!strcmp(op, "start-class"))
-      do_class_op(http, pclass, IPP_RESUME_PRINTER, cgiText(_("Resume Class")));
-    else if (!strcmp(op, "stop-class"))
-      do_class_op(http, pclass, IPP_PAUSE_PRINTER, cgiText(_("Pause Class")));
-    else if (!strcmp(op, "accept-jobs"))
-      do_class_op(http, pclass, CUPS_ACCEPT_JOBS, cgiText(_("Accept Jobs")));
-    else if (!strcmp(op, "reject-jobs"))
-      do_class_op(http, pclass, CUPS_REJECT_JOBS, cgiText(_("Reject Jobs")));
-    else if (!strcmp(op, "cancel-jobs"))
-      do_class_op(http, pclass, IPP_OP_CANCEL_JOBS, cgiText(_("Cancel Jobs")));
-    else if (!_cups_strcasecmp(op, "print-test-page"))
-      cgiPrintTestPage(http, pclass);
-    else if (!_cups_strcasecmp(op, "move-jobs"))
-      cgiMoveJobs(http, pclass, 0);
     else
     {
      /*
       * Unknown/bad operation...
       */
 
-      cgiStartHTML(pclass);
+      cgiStartHTML(cgiText(_("Classes")));
       cgiCopyTemplateLang("error-op.tmpl");
       cgiEndHTML();
     }
   }
-  else
-  {
-   /*
-    * Unknown/bad operation...
-    */
-
-    cgiStartHTML(cgiText(_("Classes")));
-    cgiCopyTemplateLang("error-op.tmpl");
-    cgiEndHTML();
-  }
-
- /*
-  * Close the HTTP server connection...
-  */
-
-  httpClose(http);
 
  /*
   * Return with no errors...
@@ -302,8 +299,8 @@ show_all_classes(http_t     *http,	/* I - Connection to server */
   int			ascending,	/* Order of classes (0 = descending) */
 			first,		/* First class to show */
 			count;		/* Number of classes */
-  const char		*var;		/* Form variable */
-  void			*search;	/* Search data */
+  const char		*var,		/* Form variable */
+			*query;		/* Query string */
   char			val[1024];	/* Form variable */
 
 
@@ -331,66 +328,36 @@ show_all_classes(http_t     *http,	/* I - Connection to server */
   cgiGetAttributes(request, "classes.tmpl");
 
  /*
-  * Do the request and get back a response...
+  * Figure out which classes to display...
   */
 
-  if ((response = cupsDoRequest(http, request, "/")) != NULL)
-  {
-   /*
-    * Get a list of matching job objects.
-    */
+  if ((query = cgiGetVariable("QUERY")) != NULL && cgiGetVariable("CLEAR"))
+    query = NULL;
 
-    if ((var = cgiGetVariable("QUERY")) != NULL &&
-        !cgiGetVariable("CLEAR"))
-      search = cgiCompileSearch(var);
-    else
-      search = NULL;
-
-    classes = cgiGetIPPObjects(response, search);
-    count   = cupsArrayCount(classes);
-
-    if (search)
-      cgiFreeSearch(search);
-
-   /*
-    * Figure out which classes to display...
-    */
-
-    if ((var = cgiGetVariable("FIRST")) != NULL)
-      first = atoi(var);
-    else
-      first = 0;
-
-    if (first >= count)
-      first = count - CUPS_PAGE_MAX;
+  if ((var = cgiGetVariable("FIRST")) != NULL)
+    first = atoi(var);
+  else
+    first = 0;
 
-    first = (first / CUPS_PAGE_MAX) * CUPS_PAGE_MAX;
+  if ((var = cgiGetVariable("ORDER")) != NULL && *var)
+    ascending = !_cups_strcasecmp(var, "asc");
+  else
+    ascending = 1;
 
-    if (first < 0)
-      first = 0;
+ /*
+  * Do the request and get back the matching classes on this page...
+  */
 
+  if ((classes = cgiGetIPPPage(http, request, query, ascending, &first,
+                               &count, &response)) != NULL)
+  {
     sprintf(val, "%d", count);
     cgiSetVariable("TOTAL", val);
 
-    if ((var = cgiGetVariable("ORDER")) != NULL && *var)
-      ascending = !_cups_strcasecmp(var, "asc");
-    else
-      ascending = 1;
-
-    if (ascending)
-    {
-      for (i = 0, pclass = (ipp_attribute_t *)cupsArrayIndex(classes, first);
-	   i < CUPS_PAGE_MAX && pclass;
-	   i ++, pclass = (ipp_attribute_t *)cupsArrayNext(classes))
-        cgiSetIPPObjectVars(pclass, NULL, i);
-    }
-    else
-    {
-      for (i = 0, pclass = (ipp_attribute_t *)cupsArrayIndex(classes, count - first - 1);
-	   i < CUPS_PAGE_MAX && pclass;
-	   i ++, pclass = (ipp_attribute_t *)cupsArrayPrev(classes))
-        cgiSetIPPObjectVars(pclass, NULL, i);
-    }
+    for (i = 0, pclass = (ipp_attribute_t *)cupsArrayFirst(classes);
+	 pclass;
+	 i ++, pclass = (ipp_attribute_t *)cupsArrayNext(classes))
+      cgiSetIPPObjectVars(pclass, NULL, i);
 
    /*
     * Save navigation URLs...
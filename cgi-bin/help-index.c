@@ -19,6 +19,87 @@
 
 #include "cgi-private.h"
 #include <cups/dir.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+
+
+/*
+ * Help index file format...
+ *
+ * The index file is written in host byte order and mapped read-only by
+ * helpLoadIndex(), so loading an index does not require any parsing.  The
+ * file contains the following sections, in order:
+ *
+ *   help_map_header_t  header
+ *   help_map_node_t    nodes[num_nodes]     (sorted by filename and anchor)
+ *   help_map_word_t    words[num_words]     (sorted, case-insensitive)
+ *   help_map_ref_t     refs[num_refs]       (word and count for each node)
+ *   help_map_ref_t     postings[num_refs]   (node and count for each word)
+ *   char               strings[num_strings] (nul-terminated strings)
+ *
+ * String offset 0 is reserved for "no string" (NULL).
+ */
+
+#define HELP_MAP_MAGIC	"HELPV3\n"	/* File magic */
+#define HELP_MAP_ENDIAN	0x01020304	/* Byte order marker */
+
+typedef struct help_map_header_s	/**** Index file header ****/
+{
+  char		magic[8];		/* HELP_MAP_MAGIC */
+  unsigned	endian,			/* HELP_MAP_ENDIAN */
+		num_nodes,		/* Number of nodes */
+		num_words,		/* Number of unique words */
+		num_refs,		/* Number of node/word references */
+		num_strings,		/* Bytes of string data */
+		reserved;		/* Reserved, 0 */
+} help_map_header_t;
+
+typedef struct help_map_node_s		/**** Index file node ****/
+{
+  long long	mtime,			/* Last modification time */
+		offset,			/* Offset in file */
+		length;			/* Length in bytes */
+  unsigned	filename,		/* Filename string */
+		anchor,			/* Anchor string or 0 */
+		section,		/* Section string or 0 */
+		text,			/* Text string */
+		first_ref,		/* First word reference */
+		num_refs;		/* Number of word references */
+} help_map_node_t;
+
+typedef struct help_map_word_s		/**** Index file word ****/
+{
+  unsigned	text,			/* Word string */
+		first_ref,		/* First posting */
+		num_refs;		/* Number of postings */
+} help_map_word_t;
+
+typedef struct help_map_ref_s		/**** Index file word reference ****/
+{
+  unsigned	index,			/* Word (refs) or node (postings) */
+		count;			/* Number of occurrences */
+} help_map_ref_t;
+
+typedef struct help_map_s		/**** Mapped index file ****/
+{
+  void			*data;		/* Mapped file */
+  size_t		size;		/* Size of file */
+  const help_map_header_t *header;	/* Header */
+  const help_map_node_t	*nodes;		/* Nodes */
+  const help_map_word_t	*words;		/* Words */
+  const help_map_ref_t	*refs,		/* Words for each node */
+			*postings;	/* Nodes for each word */
+  const char		*strings;	/* Strings */
+  help_node_t		*hnodes;	/* Help nodes */
+} help_map_t;
+
+typedef struct help_dict_s		/**** Word in index being saved ****/
+{
+  const char	*text;			/* Word text */
+  unsigned	index,			/* Word number */
+		first_ref,		/* First posting */
+		num_refs;		/* Number of postings */
+} help_dict_t;
 
 
 /*
@@ -130,6 +211,8 @@ static char		help_common_words[][6] =
  * Local functions...
  */
 
+static unsigned		help_add_string(char **strings, size_t *num_strings,
+			                size_t *alloc_strings, const char *s);
 static help_word_t	*help_add_word(help_node_t *n, const char *text);
 static void		help_delete_node(help_node_t *n);
 static void		help_delete_word(help_word_t *w);
@@ -140,14 +223,20 @@ static int		help_load_file(help_index_t *hi,
 			               const char *filename,
 				       const char *relative,
 				       time_t     mtime);
+static help_map_t	*help_map_file(const char *hifile);
+static int		help_mapped_node(help_index_t *hi, help_node_t *node);
 static help_node_t	*help_new_node(const char *filename, const char *anchor,
 			               const char *section, const char *text,
 				       time_t mtime, off_t offset,
 				       size_t length)
 				       __attribute__((nonnull(1,3,4)));
+static const char	*help_node_word(help_index_t *hi, help_node_t *node,
+			                int n, int *count);
 static int		help_sort_by_name(help_node_t *p1, help_node_t *p2);
 static int		help_sort_by_score(help_node_t *p1, help_node_t *p2);
+static int		help_sort_dict(help_dict_t *d1, help_dict_t *d2);
 static int		help_sort_words(help_word_t *w1, help_word_t *w2);
+static void		help_unmap_file(help_map_t *map);
 
 
 /*
@@ -169,13 +258,16 @@ helpDeleteIndex(help_index_t *hi)	/* I - Help index */
        node;
        node = (help_node_t *)cupsArrayNext(hi->nodes))
   {
-    if (!hi->search)
+    if (!hi->search && help_mapped_node(hi, node) < 0)
       help_delete_node(node);
   }
 
   cupsArrayDelete(hi->nodes);
   cupsArrayDelete(hi->sorted);
 
+  if (hi->map)
+    help_unmap_file(hi->map);
+
   free(hi);
 }
 
@@ -226,20 +318,10 @@ helpLoadIndex(const char *hifile,	/* I - Index filename */
               const char *directory)	/* I - Directory that is indexed */
 {
   help_index_t	*hi;			/* Help index */
-  cups_file_t	*fp;			/* Current file */
-  char		line[2048],		/* Line from file */
-		*ptr,			/* Pointer into line */
-		*filename,		/* Filename in line */
-		*anchor,		/* Anchor in line */
-		*sectptr,		/* Section pointer in line */
-		section[1024],		/* Section name */
-		*text;			/* Text in line */
-  time_t	mtime;			/* Modification time */
-  off_t		offset;			/* Offset into file */
-  size_t	length;			/* Length in bytes */
+  help_map_t	*map;			/* Mapped index file */
+  unsigned	i;			/* Looping var */
   int		update;			/* Update? */
   help_node_t	*node;			/* Current node */
-  help_word_t	*word;			/* Current word */
 
 
   DEBUG_printf(("helpLoadIndex(hifile=\"%s\", directory=\"%s\")",
@@ -264,127 +346,19 @@ helpLoadIndex(const char *hifile,	/* I - Index filename */
   }
 
  /*
-  * Try loading the existing index file...
+  * Try mapping the existing index file...
   */
 
-  if ((fp = cupsFileOpen(hifile, "r")) != NULL)
+  if ((hi->map = help_map_file(hifile)) != NULL)
   {
-   /*
-    * Lock the file and then read the first line...
-    */
-
-    //cupsFileLock(fp, 1);
-
-    if (cupsFileGets(fp, line, sizeof(line)) && !strcmp(line, "HELPV2"))
+    for (i = 0, node = hi->map->hnodes;
+         i < hi->map->header->num_nodes;
+	 i ++, node ++)
     {
-     /*
-      * Got a valid header line, now read the data lines...
-      */
-
-      node = NULL;
-
-      while (cupsFileGets(fp, line, sizeof(line)))
-      {
-       /*
-	* Each line looks like one of the following:
-	*
-	*     filename mtime offset length "section" "text"
-	*     filename#anchor offset length "text"
-	*     SP count word
-	*/
-
-        if (line[0] == ' ')
-	{
-	 /*
-	  * Read a word in the current node...
-	  */
-
-          if (!node || (ptr = strrchr(line, ' ')) == NULL)
-	    continue;
-
-          if ((word = help_add_word(node, ptr + 1)) != NULL)
-	    word->count = atoi(line + 1);
-        }
-	else
-	{
-	 /*
-	  * Add a node...
-	  */
-
-	  filename = line;
-
-	  if ((ptr = strchr(line, ' ')) == NULL)
-            break;
-
-	  while (isspace(*ptr & 255))
-            *ptr++ = '\0';
-
-	  if ((anchor = strrchr(filename, '#')) != NULL)
-	  {
-            *anchor++ = '\0';
-	    mtime = 0;
-	  }
-	  else
-	    mtime = strtol(ptr, &ptr, 10);
-
-	  offset = strtoll(ptr, &ptr, 10);
-	  length = (size_t)strtoll(ptr, &ptr, 10);
-
-	  while (isspace(*ptr & 255))
-            ptr ++;
-
-          if (!anchor)
-	  {
-	   /*
-	    * Get section...
-	    */
-
-            if (*ptr != '\"')
-	      break;
-
-            ptr ++;
-	    sectptr = ptr;
-
-            while (*ptr && *ptr != '\"')
-	      ptr ++;
-
-            if (*ptr != '\"')
-	      break;
-
-            *ptr++ = '\0';
-
-            strlcpy(section, sectptr, sizeof(section));
-
-	    while (isspace(*ptr & 255))
-              ptr ++;
-          }
-
-          if (*ptr != '\"')
-	    break;
-
-          ptr ++;
-	  text = ptr;
-
-          while (*ptr && *ptr != '\"')
-	    ptr ++;
-
-          if (*ptr != '\"')
-	    break;
-
-          *ptr++ = '\0';
-
-	  if ((node = help_new_node(filename, anchor, section, text,
-				    mtime, offset, length)) == NULL)
-            break;
+      node->score = -1;
 
-	  node->score = -1;
-
-	  cupsArrayAdd(hi->nodes, node);
-        }
-      }
+      cupsArrayAdd(hi->nodes, node);
     }
-
-    cupsFileClose(fp);
   }
 
  /*
@@ -407,9 +381,38 @@ helpLoadIndex(const char *hifile,	/* I - Index filename */
       */
 
       cupsArrayRemove(hi->nodes, node);
-      help_delete_node(node);
+
+      if (help_mapped_node(hi, node) < 0)
+        help_delete_node(node);
+
+      update = 1;
     }
 
+ /*
+  * Save the index if we updated it, and then switch to the new index file
+  * so that searches can use its word lists...
+  */
+
+  if (update && !helpSaveIndex(hi, hifile) &&
+      (map = help_map_file(hifile)) != NULL)
+  {
+    for (node = (help_node_t *)cupsArrayFirst(hi->nodes);
+         node;
+	 node = (help_node_t *)cupsArrayNext(hi->nodes))
+      if (help_mapped_node(hi, node) < 0)
+        help_delete_node(node);
+
+    cupsArrayClear(hi->nodes);
+
+    if (hi->map)
+      help_unmap_file(hi->map);
+
+    hi->map = map;
+
+    for (i = 0, node = map->hnodes; i < map->header->num_nodes; i ++, node ++)
+      cupsArrayAdd(hi->nodes, node);
+  }
+
  /*
   * Add nodes to the sorted array...
   */
@@ -419,13 +422,6 @@ helpLoadIndex(const char *hifile,	/* I - Index filename */
        node = (help_node_t *)cupsArrayNext(hi->nodes))
     cupsArrayAdd(hi->sorted, node);
 
- /*
-  * Save the index if we updated it...
-  */
-
-  if (update)
-    helpSaveIndex(hi, hifile);
-
  /*
   * Return the index...
   */
@@ -442,72 +438,210 @@ int					/* O - 0 on success, -1 on error */
 helpSaveIndex(help_index_t *hi,		/* I - Index */
               const char   *hifile)	/* I - Index filename */
 {
-  cups_file_t	*fp;			/* Index file */
-  help_node_t	*node;			/* Current node */
-  help_word_t	*word;			/* Current word */
+  cups_file_t		*fp;		/* Index file */
+  char			tempfile[1024];	/* Temporary index file */
+  help_node_t		*node;		/* Current node */
+  const char		*text;		/* Word text */
+  int			count,		/* Word count */
+			j,		/* Looping var */
+			status;		/* Status of save */
+  unsigned		i,		/* Looping var */
+			num_nodes,	/* Number of nodes */
+			num_refs;	/* Number of word references */
+  cups_array_t		*dict;		/* Words in index */
+  help_dict_t		key,		/* Search key */
+			*d;		/* Current word */
+  help_map_header_t	header;		/* File header */
+  help_map_node_t	*nodes = NULL;	/* Nodes */
+  help_map_word_t	*words = NULL;	/* Words */
+  help_map_ref_t	*refs = NULL,	/* Words for each node */
+			*postings = NULL;
+					/* Nodes for each word */
+  char			*strings = NULL;/* Strings */
+  size_t		num_strings = 0,/* Bytes of strings */
+			alloc_strings = 0;
+					/* Allocated bytes of strings */
 
 
   DEBUG_printf(("helpSaveIndex(hi=%p, hifile=\"%s\")", hi, hifile));
 
  /*
-  * Try creating a new index file...
+  * Build the word dictionary and count the references...
   */
 
-  if ((fp = cupsFileOpen(hifile, "w9")) == NULL)
+  if ((dict = cupsArrayNew((cups_array_func_t)help_sort_dict, NULL)) == NULL)
     return (-1);
 
+  status    = -1;
+  num_nodes = (unsigned)cupsArrayCount(hi->nodes);
+  num_refs  = 0;
+
+  for (node = (help_node_t *)cupsArrayFirst(hi->nodes);
+       node;
+       node = (help_node_t *)cupsArrayNext(hi->nodes))
+    for (j = 0; (text = help_node_word(hi, node, j, &count)) != NULL; j ++)
+    {
+      key.text = text;
+
+      if ((d = (help_dict_t *)cupsArrayFind(dict, &key)) == NULL)
+      {
+        if ((d = calloc(1, sizeof(help_dict_t))) == NULL)
+	  goto cleanup;
+
+        d->text = text;
+	cupsArrayAdd(dict, d);
+      }
+
+      d->num_refs ++;
+      num_refs ++;
+    }
+
  /*
-  * Lock the file while we write it...
+  * Allocate memory for the file sections...
   */
 
-  //cupsFileLock(fp, 1);
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, HELP_MAP_MAGIC, sizeof(header.magic));
+  header.endian    = HELP_MAP_ENDIAN;
+  header.num_nodes = num_nodes;
+  header.num_words = (unsigned)cupsArrayCount(dict);
+  header.num_refs  = num_refs;
 
-  cupsFilePuts(fp, "HELPV2\n");
+  if ((nodes = calloc(num_nodes + 1, sizeof(help_map_node_t))) == NULL ||
+      (words = calloc(header.num_words + 1, sizeof(help_map_word_t))) == NULL ||
+      (refs = calloc(num_refs + 1, sizeof(help_map_ref_t))) == NULL ||
+      (postings = calloc(num_refs + 1, sizeof(help_map_ref_t))) == NULL ||
+      (strings = calloc(1, 65536)) == NULL)
+    goto cleanup;
 
-  for (node = (help_node_t *)cupsArrayFirst(hi->nodes);
-       node;
-       node = (help_node_t *)cupsArrayNext(hi->nodes))
+  num_strings   = 1;			/* Offset 0 is "no string" */
+  alloc_strings = 65536;
+
+ /*
+  * Number the words and lay out the posting lists...
+  */
+
+  for (i = 0, num_refs = 0, d = (help_dict_t *)cupsArrayFirst(dict);
+       d;
+       i ++, d = (help_dict_t *)cupsArrayNext(dict))
   {
-   /*
-    * Write the current node with/without the anchor...
-    */
+    d->index     = i;
+    d->first_ref = num_refs;
 
-    if (node->anchor)
-    {
-      if (cupsFilePrintf(fp, "%s#%s " CUPS_LLFMT " " CUPS_LLFMT " \"%s\"\n",
-                         node->filename, node->anchor,
-                         CUPS_LLCAST node->offset, CUPS_LLCAST node->length,
-			 node->text) < 0)
-        break;
-    }
-    else
+    words[i].first_ref = num_refs;
+    words[i].num_refs  = d->num_refs;
+
+    if ((words[i].text = help_add_string(&strings, &num_strings,
+                                         &alloc_strings, d->text)) == 0)
+      goto cleanup;
+
+    num_refs    += d->num_refs;
+    d->num_refs = 0;
+  }
+
+ /*
+  * Then add the nodes and their words...
+  */
+
+  for (i = 0, num_refs = 0, node = (help_node_t *)cupsArrayFirst(hi->nodes);
+       node;
+       i ++, node = (help_node_t *)cupsArrayNext(hi->nodes))
+  {
+    nodes[i].mtime     = (long long)node->mtime;
+    nodes[i].offset    = (long long)node->offset;
+    nodes[i].length    = (long long)node->length;
+    nodes[i].first_ref = num_refs;
+
+    if ((nodes[i].filename = help_add_string(&strings, &num_strings,
+                                             &alloc_strings,
+					     node->filename)) == 0 ||
+        (nodes[i].text = help_add_string(&strings, &num_strings,
+	                                 &alloc_strings, node->text)) == 0)
+      goto cleanup;
+
+    if (node->anchor &&
+        (nodes[i].anchor = help_add_string(&strings, &num_strings,
+	                                   &alloc_strings, node->anchor)) == 0)
+      goto cleanup;
+
+    if (node->section &&
+        (nodes[i].section = help_add_string(&strings, &num_strings,
+	                                    &alloc_strings,
+					    node->section)) == 0)
+      goto cleanup;
+
+    for (j = 0; (text = help_node_word(hi, node, j, &count)) != NULL; j ++)
     {
-      if (cupsFilePrintf(fp, "%s %d " CUPS_LLFMT " " CUPS_LLFMT " \"%s\" \"%s\"\n",
-                         node->filename, (int)node->mtime,
-                         CUPS_LLCAST node->offset, CUPS_LLCAST node->length,
-			 node->section ? node->section : "", node->text) < 0)
-        break;
+      key.text = text;
+      d        = (help_dict_t *)cupsArrayFind(dict, &key);
+
+      refs[num_refs].index = d->index;
+      refs[num_refs].count = (unsigned)count;
+      num_refs ++;
+
+      postings[d->first_ref + d->num_refs].index = i;
+      postings[d->first_ref + d->num_refs].count = (unsigned)count;
+      d->num_refs ++;
     }
 
-   /*
-    * Then write the words associated with the node...
-    */
+    nodes[i].num_refs = num_refs - nodes[i].first_ref;
+  }
 
-    for (word = (help_word_t *)cupsArrayFirst(node->words);
-         word;
-	 word = (help_word_t *)cupsArrayNext(node->words))
-      if (cupsFilePrintf(fp, " %d %s\n", word->count, word->text) < 0)
-        break;
+  header.num_strings = (unsigned)num_strings;
+
+ /*
+  * Write the index to a temporary file and then rename it, so that any
+  * help.cgi that has the old index mapped is not disturbed...
+  */
+
+  snprintf(tempfile, sizeof(tempfile), "%s.%d", hifile, (int)getpid());
+
+  if ((fp = cupsFileOpen(tempfile, "w")) == NULL)
+    goto cleanup;
+
+  if (cupsFileWrite(fp, (char *)&header, sizeof(header)) < 0 ||
+      cupsFileWrite(fp, (char *)nodes,
+                    num_nodes * sizeof(help_map_node_t)) < 0 ||
+      cupsFileWrite(fp, (char *)words,
+                    header.num_words * sizeof(help_map_word_t)) < 0 ||
+      cupsFileWrite(fp, (char *)refs, num_refs * sizeof(help_map_ref_t)) < 0 ||
+      cupsFileWrite(fp, (char *)postings,
+                    num_refs * sizeof(help_map_ref_t)) < 0 ||
+      cupsFileWrite(fp, strings, num_strings) < 0)
+  {
+    cupsFileClose(fp);
+    unlink(tempfile);
+    goto cleanup;
   }
 
-  cupsFileFlush(fp);
+  if (cupsFileClose(fp) < 0 || rename(tempfile, hifile))
+  {
+    unlink(tempfile);
+    goto cleanup;
+  }
 
-  if (cupsFileClose(fp) < 0)
-    return (-1);
-  else if (node)
-    return (-1);
-  else
-    return (0);
+  status = 0;
+
+ /*
+  * Free memory and return...
+  */
+
+  cleanup:
+
+  for (d = (help_dict_t *)cupsArrayFirst(dict);
+       d;
+       d = (help_dict_t *)cupsArrayNext(dict))
+    free(d);
+
+  cupsArrayDelete(dict);
+
+  free(nodes);
+  free(words);
+  free(refs);
+  free(postings);
+  free(strings);
+
+  return (status);
 }
 
 
@@ -523,9 +657,12 @@ helpSearchIndex(help_index_t *hi,	/* I - Index */
 {
   help_index_t	*search;		/* Search index */
   help_node_t	*node;			/* Current node */
-  help_word_t	*word;			/* Current word */
+  const char	*text;			/* Word text */
   void		*sc;			/* Search context */
-  int		matches;		/* Number of matches */
+  int		matches,		/* Number of matches */
+		count,			/* Word count */
+		i;			/* Looping var */
+  int		*scores;		/* Word scores for mapped nodes */
 
 
   DEBUG_printf(("helpSearchIndex(hi=%p, query=\"%s\", filename=\"%s\")",
@@ -593,6 +730,33 @@ helpSearchIndex(help_index_t *hi,	/* I - Index */
 
   search->search = 1;
 
+ /*
+  * When searching the whole index file, match each unique word once and
+  * add its precomputed counts to the nodes in its posting list...
+  */
+
+  scores = NULL;
+
+  if (hi->map && !filename &&
+      (scores = calloc(hi->map->header->num_nodes + 1, sizeof(int))) != NULL)
+  {
+    const help_map_word_t *word;	/* Current word */
+    const help_map_ref_t *ref;		/* Current posting */
+    unsigned		j;		/* Looping var */
+
+    for (i = 0, word = hi->map->words;
+         i < (int)hi->map->header->num_words;
+	 i ++, word ++)
+      if (cgiDoSearch(sc, hi->map->strings + word->text) > 0)
+      {
+        for (j = word->num_refs, ref = hi->map->postings + word->first_ref;
+	     j > 0;
+	     j --, ref ++)
+	  if (ref->index < hi->map->header->num_nodes)
+	    scores[ref->index] += (int)ref->count;
+      }
+  }
+
  /*
   * Check each node in the index, adding matching nodes to the
   * search index...
@@ -607,11 +771,14 @@ helpSearchIndex(help_index_t *hi,	/* I - Index */
     {
       matches = cgiDoSearch(sc, node->text);
 
-      for (word = (help_word_t *)cupsArrayFirst(node->words);
-           word;
-	   word = (help_word_t *)cupsArrayNext(node->words))
-        if (cgiDoSearch(sc, word->text) > 0)
-          matches += word->count;
+      if (scores && (i = help_mapped_node(hi, node)) >= 0)
+        matches += scores[i];
+      else
+      {
+        for (i = 0; (text = help_node_word(hi, node, i, &count)) != NULL; i ++)
+          if (cgiDoSearch(sc, text) > 0)
+            matches += count;
+      }
 
       if (matches > 0)
       {
@@ -630,6 +797,7 @@ helpSearchIndex(help_index_t *hi,	/* I - Index */
   * Free the search context...
   */
 
+  free(scores);
   cgiFreeSearch(sc);
 
  /*
@@ -640,6 +808,49 @@ helpSearchIndex(help_index_t *hi,	/* I - Index */
 }
 
 
+/*
+ * 'help_add_string()' - Add a string to the strings in an index file.
+ */
+
+static unsigned				/* O - Offset of string or 0 on error */
+help_add_string(char       **strings,	/* IO - Strings */
+                size_t     *num_strings,/* IO - Bytes of strings */
+		size_t     *alloc_strings,
+					/* IO - Allocated bytes of strings */
+		const char *s)		/* I  - String to add */
+{
+  size_t	len;			/* Length of string */
+  unsigned	offset;			/* Offset of string */
+
+
+  len = strlen(s) + 1;
+
+  if ((*num_strings + len) > *alloc_strings)
+  {
+    char	*temp;			/* New strings */
+    size_t	alloc;			/* New allocation */
+
+
+    for (alloc = *alloc_strings ? *alloc_strings : 65536;
+         alloc < (*num_strings + len);
+	 alloc *= 2);
+
+    if (alloc > 0xffffffff || (temp = realloc(*strings, alloc)) == NULL)
+      return (0);
+
+    *strings       = temp;
+    *alloc_strings = alloc;
+  }
+
+  offset = (unsigned)*num_strings;
+
+  memcpy(*strings + offset, s, len);
+  *num_strings += len;
+
+  return (offset);
+}
+
+
 /*
  * 'help_add_word()' - Add a word to a node.
  */
@@ -1016,7 +1227,19 @@ help_load_file(
         break;
       }
 
-      if ((node = helpFindNode(hi, relative, anchor)) != NULL)
+      if ((node = helpFindNode(hi, relative, anchor)) != NULL &&
+          help_mapped_node(hi, node) >= 0)
+      {
+       /*
+        * Node is in the mapped index file, so remove it and add a new
+	* node...
+	*/
+
+        cupsArrayRemove(hi->nodes, node);
+	node = NULL;
+      }
+
+      if (node)
       {
        /*
 	* Node already in the index, so replace the text and other
@@ -1194,6 +1417,143 @@ help_load_file(
 }
 
 
+/*
+ * 'help_map_file()' - Map an index file into memory.
+ */
+
+static help_map_t *			/* O - Mapped index file or NULL */
+help_map_file(const char *hifile)	/* I - Index filename */
+{
+  int			fd;		/* Index file */
+  struct stat		fileinfo;	/* File information */
+  help_map_t		*map;		/* Mapped index file */
+  const help_map_header_t *header;	/* File header */
+  const help_map_node_t	*mnode;		/* Current file node */
+  const help_map_word_t	*mword;		/* Current file word */
+  help_node_t		*node;		/* Current help node */
+  unsigned		i;		/* Looping var */
+  size_t		size;		/* Expected size of file */
+
+
+  DEBUG_printf(("2help_map_file(hifile=\"%s\")", hifile));
+
+  if ((fd = open(hifile, O_RDONLY)) < 0)
+    return (NULL);
+
+  if (fstat(fd, &fileinfo) || fileinfo.st_size < (off_t)sizeof(help_map_header_t) ||
+      (map = calloc(1, sizeof(help_map_t))) == NULL)
+  {
+    close(fd);
+    return (NULL);
+  }
+
+  map->size = (size_t)fileinfo.st_size;
+  map->data = mmap(NULL, map->size, PROT_READ, MAP_SHARED, fd, 0);
+
+  close(fd);
+
+  if (map->data == MAP_FAILED)
+  {
+    free(map);
+    return (NULL);
+  }
+
+ /*
+  * Validate the header and section sizes; old text index files will fail
+  * here and get rebuilt...
+  */
+
+  header = map->header = (const help_map_header_t *)map->data;
+
+  if (memcmp(header->magic, HELP_MAP_MAGIC, sizeof(header->magic)) ||
+      header->endian != HELP_MAP_ENDIAN || header->num_strings == 0 ||
+      header->num_nodes > map->size || header->num_words > map->size ||
+      header->num_refs > map->size || header->num_strings > map->size)
+    goto error;
+
+  size = sizeof(help_map_header_t) +
+         header->num_nodes * sizeof(help_map_node_t) +
+         header->num_words * sizeof(help_map_word_t) +
+         2 * header->num_refs * sizeof(help_map_ref_t) +
+	 header->num_strings;
+
+  if (size != map->size)
+    goto error;
+
+  map->nodes    = (const help_map_node_t *)(header + 1);
+  map->words    = (const help_map_word_t *)(map->nodes + header->num_nodes);
+  map->refs     = (const help_map_ref_t *)(map->words + header->num_words);
+  map->postings = map->refs + header->num_refs;
+  map->strings  = (const char *)(map->postings + header->num_refs);
+
+  if (map->strings[header->num_strings - 1])
+    goto error;
+
+  for (i = header->num_words, mword = map->words; i > 0; i --, mword ++)
+    if (mword->text >= header->num_strings ||
+        mword->first_ref > header->num_refs ||
+	mword->num_refs > (header->num_refs - mword->first_ref))
+      goto error;
+
+ /*
+  * Create help nodes that point into the file...
+  */
+
+  if ((map->hnodes = calloc(header->num_nodes + 1, sizeof(help_node_t))) == NULL)
+    goto error;
+
+  for (i = 0, mnode = map->nodes, node = map->hnodes;
+       i < header->num_nodes;
+       i ++, mnode ++, node ++)
+  {
+    if (!mnode->filename || mnode->filename >= header->num_strings ||
+        !mnode->text || mnode->text >= header->num_strings ||
+	mnode->anchor >= header->num_strings ||
+	mnode->section >= header->num_strings ||
+        mnode->first_ref > header->num_refs ||
+	mnode->num_refs > (header->num_refs - mnode->first_ref))
+      goto error;
+
+    node->filename = (char *)map->strings + mnode->filename;
+    node->anchor   = mnode->anchor ? (char *)map->strings + mnode->anchor : NULL;
+    node->section  = mnode->section ? (char *)map->strings + mnode->section :
+                                      NULL;
+    node->text     = (char *)map->strings + mnode->text;
+    node->mtime    = (time_t)mnode->mtime;
+    node->offset   = (off_t)mnode->offset;
+    node->length   = (size_t)mnode->length;
+  }
+
+  return (map);
+
+ /*
+  * If we get here the file is not a valid index file...
+  */
+
+  error:
+
+  help_unmap_file(map);
+
+  return (NULL);
+}
+
+
+/*
+ * 'help_mapped_node()' - Get the number of a node in the mapped index file.
+ */
+
+static int				/* O - Node number or -1 if not mapped */
+help_mapped_node(help_index_t *hi,	/* I - Index */
+                 help_node_t  *node)	/* I - Node */
+{
+  if (hi->map && node >= hi->map->hnodes &&
+      node < (hi->map->hnodes + hi->map->header->num_nodes))
+    return ((int)(node - hi->map->hnodes));
+  else
+    return (-1);
+}
+
+
 /*
  * 'help_new_node()' - Create a new node and add it to an index.
  */
@@ -1230,6 +1590,52 @@ help_new_node(const char   *filename,	/* I - Filename */
 }
 
 
+/*
+ * 'help_node_word()' - Get a word from a node.
+ */
+
+static const char *			/* O - Word text or NULL if none */
+help_node_word(help_index_t *hi,	/* I - Index */
+               help_node_t  *node,	/* I - Node */
+	       int          n,		/* I - Word number (0-based) */
+	       int          *count)	/* O - Number of occurrences */
+{
+  int			i;		/* Node number */
+  help_word_t		*word;		/* Word */
+  const help_map_node_t	*mnode;		/* Node in index file */
+  const help_map_ref_t	*ref;		/* Word reference */
+
+
+  if (node->words)
+  {
+    if ((word = (help_word_t *)cupsArrayIndex(node->words, n)) == NULL)
+      return (NULL);
+
+    *count = word->count;
+
+    return (word->text);
+  }
+  else if ((i = help_mapped_node(hi, node)) >= 0)
+  {
+    mnode = hi->map->nodes + i;
+
+    if (n < 0 || (unsigned)n >= mnode->num_refs)
+      return (NULL);
+
+    ref = hi->map->refs + mnode->first_ref + n;
+
+    if (ref->index >= hi->map->header->num_words)
+      return (NULL);
+
+    *count = (int)ref->count;
+
+    return (hi->map->strings + hi->map->words[ref->index].text);
+  }
+  else
+    return (NULL);
+}
+
+
 /*
  * 'help_sort_nodes_by_name()' - Sort nodes by section, filename, and anchor.
  */
@@ -1290,6 +1696,18 @@ help_sort_by_score(help_node_t *n1,	/* I - First node */
 }
 
 
+/*
+ * 'help_sort_dict()' - Sort dictionary words alphabetically.
+ */
+
+static int				/* O - Difference */
+help_sort_dict(help_dict_t *d1,		/* I - First word */
+               help_dict_t *d2)		/* I - Second word */
+{
+  return (_cups_strcasecmp(d1->text, d2->text));
+}
+
+
 /*
  * 'help_sort_words()' - Sort words alphabetically.
  */
@@ -1305,6 +1723,22 @@ help_sort_words(help_word_t *w1,	/* I - Second word */
 }
 
 
+/*
+ * 'help_unmap_file()' - Unmap an index file.
+ */
+
+static void
+help_unmap_file(help_map_t *map)	/* I - Mapped index file */
+{
+  DEBUG_printf(("2help_unmap_file(map=%p)", map));
+
+  munmap(map->data, map->size);
+
+  free(map->hnodes);
+  free(map);
+}
+
+
 /*
  * End of "$Id: help-index.c 12644 2015-05-19 21:22:35Z msweet $".
  */
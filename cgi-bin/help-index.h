@@ -47,7 +47,8 @@ typedef struct help_node_s		/**** Help node structure... ****/
   char		*section;		/* Section name (NULL if none) */
   char		*anchor;		/* Anchor name (NULL if none) */
   char		*text;			/* Text in anchor */
-  cups_array_t	*words;			/* Words after this node */
+  cups_array_t	*words;			/* Words after this node (NULL if
+					 * loaded from the index file) */
   time_t	mtime;			/* Last modification time */
   off_t		offset;			/* Offset in file */
   size_t	length;			/* Length in bytes */
@@ -59,6 +60,7 @@ typedef struct help_index_s		/**** Help index structure ****/
   int		search;			/* 1 = search index, 0 = normal */
   cups_array_t	*nodes;			/* Nodes sorted by filename */
   cups_array_t	*sorted;		/* Nodes sorted by score + text */
+  struct help_map_s *map;		/* Mapped index file, if any */
 } help_index_t;
 
 
@@ -40,7 +40,7 @@ main(int  argc,				/* I - Number of command-line arguments */
   const char	*cache_dir;		/* CUPS_CACHEDIR environment variable */
   const char	*docroot;		/* CUPS_DOCROOT environment variable */
   const char	*helpfile,		/* Current help file */
-		*helptitle = NULL;	/* Current help title */
+		*helptitle;		/* Current help title */
   const char	*topic;			/* Current topic */
   char		topic_data[1024];	/* Topic form data */
   const char	*section;		/* Current section */
@@ -51,338 +51,345 @@ main(int  argc,				/* I - Number of command-line arguments */
   int		printable;		/* Show printable version? */
 
 
- /*
-  * Get any form variables...
-  */
-
-  cgiInitialize();
-
-  printable = cgiGetVariable("PRINTABLE") != NULL;
-
- /*
-  * Set the web interface section...
-  */
-
-  cgiSetVariable("SECTION", "help");
-  cgiSetVariable("REFRESH_PAGE", "");
+  while (cgiAcceptRequest())
+  {
+   /*
+    * Get any form variables...
+    */
 
- /*
-  * Load the help index...
-  */
+    cgiInitialize();
 
-  if ((cache_dir = getenv("CUPS_CACHEDIR")) == NULL)
-    cache_dir = CUPS_CACHEDIR;
+    printable = cgiGetVariable("PRINTABLE") != NULL;
 
-  snprintf(filename, sizeof(filename), "%s/help.index", cache_dir);
+   /*
+    * Set the web interface section...
+    */
 
-  if ((docroot = getenv("CUPS_DOCROOT")) == NULL)
-    docroot = CUPS_DOCROOT;
+    cgiSetVariable("SECTION", "help");
+    cgiSetVariable("REFRESH_PAGE", "");
 
-  snprintf(directory, sizeof(directory), "%s/help", docroot);
+   /*
+    * Load the help index...
+    */
 
-  fprintf(stderr, "DEBUG: helpLoadIndex(filename=\"%s\", directory=\"%s\")\n",
-          filename, directory);
+    if ((cache_dir = getenv("CUPS_CACHEDIR")) == NULL)
+      cache_dir = CUPS_CACHEDIR;
 
-  hi = helpLoadIndex(filename, directory);
-  if (!hi)
-  {
-    perror(filename);
+    snprintf(filename, sizeof(filename), "%s/help.index", cache_dir);
 
-    cgiStartHTML(cgiText(_("Online Help")));
-    cgiSetVariable("ERROR", cgiText(_("Unable to load help index.")));
-    cgiCopyTemplateLang("error.tmpl");
-    cgiEndHTML();
+    if ((docroot = getenv("CUPS_DOCROOT")) == NULL)
+      docroot = CUPS_DOCROOT;
 
-    return (1);
-  }
+    snprintf(directory, sizeof(directory), "%s/help", docroot);
 
-  fprintf(stderr, "DEBUG: %d nodes in help index...\n",
-          cupsArrayCount(hi->nodes));
+    fprintf(stderr, "DEBUG: helpLoadIndex(filename=\"%s\", directory=\"%s\")\n",
+	    filename, directory);
 
- /*
-  * See if we are viewing a file...
-  */
+    hi = helpLoadIndex(filename, directory);
+    if (!hi)
+    {
+      perror(filename);
 
-  for (i = 0; i < argc; i ++)
-    fprintf(stderr, "DEBUG: argv[%d]=\"%s\"\n", i, argv[i]);
+      cgiStartHTML(cgiText(_("Online Help")));
+      cgiSetVariable("ERROR", cgiText(_("Unable to load help index.")));
+      cgiCopyTemplateLang("error.tmpl");
+      cgiEndHTML();
 
-  if ((helpfile = getenv("PATH_INFO")) != NULL)
-  {
-    helpfile ++;
+      continue;
+    }
 
-    if (!*helpfile)
-      helpfile = NULL;
-  }
+    fprintf(stderr, "DEBUG: %d nodes in help index...\n",
+	    cupsArrayCount(hi->nodes));
 
-  if (helpfile)
-  {
    /*
-    * Verify that the help file exists and is part of the index...
+    * See if we are viewing a file...
     */
 
-    snprintf(filename, sizeof(filename), "%s/help/%s", docroot, helpfile);
+    for (i = 0; i < argc; i ++)
+      fprintf(stderr, "DEBUG: argv[%d]=\"%s\"\n", i, argv[i]);
 
-    fprintf(stderr, "DEBUG: helpfile=\"%s\", filename=\"%s\"\n",
-            helpfile, filename);
+    helptitle = NULL;
 
-    if (access(filename, R_OK))
+    if ((helpfile = getenv("PATH_INFO")) != NULL)
     {
-      perror(filename);
+      helpfile ++;
 
-      cgiStartHTML(cgiText(_("Online Help")));
-      cgiSetVariable("ERROR", cgiText(_("Unable to access help file.")));
-      cgiCopyTemplateLang("error.tmpl");
-      cgiEndHTML();
-
-      return (1);
+      if (!*helpfile)
+	helpfile = NULL;
     }
 
-    if ((n = helpFindNode(hi, helpfile, NULL)) == NULL)
+    if (helpfile)
     {
-      cgiStartHTML(cgiText(_("Online Help")));
-      cgiSetVariable("ERROR", cgiText(_("Help file not in index.")));
-      cgiCopyTemplateLang("error.tmpl");
-      cgiEndHTML();
+     /*
+      * Verify that the help file exists and is part of the index...
+      */
 
-      return (1);
-    }
+      snprintf(filename, sizeof(filename), "%s/help/%s", docroot, helpfile);
 
-   /*
-    * Save the page title and help file...
-    */
+      fprintf(stderr, "DEBUG: helpfile=\"%s\", filename=\"%s\"\n",
+	      helpfile, filename);
 
-    helptitle = n->text;
-    topic     = n->section;
+      if (access(filename, R_OK))
+      {
+	perror(filename);
 
-   /*
-    * Send a standard page header...
-    */
+	cgiStartHTML(cgiText(_("Online Help")));
+	cgiSetVariable("ERROR", cgiText(_("Unable to access help file.")));
+	cgiCopyTemplateLang("error.tmpl");
+	cgiEndHTML();
 
-    if (printable)
-      puts("Content-Type: text/html;charset=utf-8\n");
-    else
-      cgiStartHTML(n->text);
-  }
-  else
-  {
-   /*
-    * Send a standard page header...
-    */
+	helpDeleteIndex(hi);
+	continue;
+      }
 
-    cgiStartHTML(cgiText(_("Online Help")));
+      if ((n = helpFindNode(hi, helpfile, NULL)) == NULL)
+      {
+	cgiStartHTML(cgiText(_("Online Help")));
+	cgiSetVariable("ERROR", cgiText(_("Help file not in index.")));
+	cgiCopyTemplateLang("error.tmpl");
+	cgiEndHTML();
 
-    topic = cgiGetVariable("TOPIC");
-  }
+	helpDeleteIndex(hi);
+	continue;
+      }
 
- /*
-  * Do a search as needed...
-  */
+     /*
+      * Save the page title and help file...
+      */
 
-  if (cgiGetVariable("CLEAR"))
-    cgiSetVariable("QUERY", "");
+      helptitle = n->text;
+      topic     = n->section;
 
-  query = cgiGetVariable("QUERY");
-  si    = helpSearchIndex(hi, query, topic, helpfile);
+     /*
+      * Send a standard page header...
+      */
 
-  cgiClearVariables();
-  if (query)
-    cgiSetVariable("QUERY", query);
-  if (topic)
-    cgiSetVariable("TOPIC", topic);
-  if (helpfile)
-    cgiSetVariable("HELPFILE", helpfile);
-  if (helptitle)
-    cgiSetVariable("HELPTITLE", helptitle);
+      if (printable)
+	puts("Content-Type: text/html;charset=utf-8\n");
+      else
+	cgiStartHTML(n->text);
+    }
+    else
+    {
+     /*
+      * Send a standard page header...
+      */
 
-  fprintf(stderr, "DEBUG: query=\"%s\", topic=\"%s\"\n",
-          query ? query : "(null)", topic ? topic : "(null)");
+      cgiStartHTML(cgiText(_("Online Help")));
 
-  if (si)
-  {
-    help_node_t	*nn;			/* Parent node */
+      topic = cgiGetVariable("TOPIC");
+    }
 
+   /*
+    * Do a search as needed...
+    */
 
-    fprintf(stderr,
-            "DEBUG: si=%p, si->sorted=%p, cupsArrayCount(si->sorted)=%d\n", si,
-            si->sorted, cupsArrayCount(si->sorted));
+    if (cgiGetVariable("CLEAR"))
+      cgiSetVariable("QUERY", "");
 
-    for (i = 0, n = (help_node_t *)cupsArrayFirst(si->sorted);
-         n;
-	 i ++, n = (help_node_t *)cupsArrayNext(si->sorted))
-    {
-      if (helpfile && n->anchor)
-        snprintf(line, sizeof(line), "#%s", n->anchor);
-      else if (n->anchor)
-        snprintf(line, sizeof(line), "/help/%s?QUERY=%s#%s", n->filename,
-	         query ? query : "", n->anchor);
-      else
-        snprintf(line, sizeof(line), "/help/%s?QUERY=%s", n->filename,
-	         query ? query : "");
+    query = cgiGetVariable("QUERY");
+    si    = helpSearchIndex(hi, query, topic, helpfile);
 
-      cgiSetArray("QTEXT", i, n->text);
-      cgiSetArray("QLINK", i, line);
+    cgiClearVariables();
+    if (query)
+      cgiSetVariable("QUERY", query);
+    if (topic)
+      cgiSetVariable("TOPIC", topic);
+    if (helpfile)
+      cgiSetVariable("HELPFILE", helpfile);
+    if (helptitle)
+      cgiSetVariable("HELPTITLE", helptitle);
 
-      if (!helpfile && n->anchor)
-      {
-        nn = helpFindNode(hi, n->filename, NULL);
+    fprintf(stderr, "DEBUG: query=\"%s\", topic=\"%s\"\n",
+	    query ? query : "(null)", topic ? topic : "(null)");
 
-        snprintf(line, sizeof(line), "/help/%s?QUERY=%s", nn->filename,
-	         query ? query : "");
+    if (si)
+    {
+      help_node_t	*nn;			/* Parent node */
 
-        cgiSetArray("QPTEXT", i, nn->text);
-	cgiSetArray("QPLINK", i, line);
-      }
-      else
+
+      fprintf(stderr,
+	      "DEBUG: si=%p, si->sorted=%p, cupsArrayCount(si->sorted)=%d\n", si,
+	      si->sorted, cupsArrayCount(si->sorted));
+
+      for (i = 0, n = (help_node_t *)cupsArrayFirst(si->sorted);
+	   n;
+	   i ++, n = (help_node_t *)cupsArrayNext(si->sorted))
       {
-        cgiSetArray("QPTEXT", i, "");
-	cgiSetArray("QPLINK", i, "");
-      }
+	if (helpfile && n->anchor)
+	  snprintf(line, sizeof(line), "#%s", n->anchor);
+	else if (n->anchor)
+	  snprintf(line, sizeof(line), "/help/%s?QUERY=%s#%s", n->filename,
+		   query ? query : "", n->anchor);
+	else
+	  snprintf(line, sizeof(line), "/help/%s?QUERY=%s", n->filename,
+		   query ? query : "");
+
+	cgiSetArray("QTEXT", i, n->text);
+	cgiSetArray("QLINK", i, line);
+
+	if (!helpfile && n->anchor)
+	{
+	  nn = helpFindNode(hi, n->filename, NULL);
 
-      fprintf(stderr, "DEBUG: [%d] = \"%s\" @ \"%s\"\n", i, n->text, line);
-    }
+	  snprintf(line, sizeof(line), "/help/%s?QUERY=%s", nn->filename,
+		   query ? query : "");
 
-    helpDeleteIndex(si);
-  }
+	  cgiSetArray("QPTEXT", i, nn->text);
+	  cgiSetArray("QPLINK", i, line);
+	}
+	else
+	{
+	  cgiSetArray("QPTEXT", i, "");
+	  cgiSetArray("QPLINK", i, "");
+	}
 
- /*
-  * OK, now list the bookmarks within the index...
-  */
+	fprintf(stderr, "DEBUG: [%d] = \"%s\" @ \"%s\"\n", i, n->text, line);
+      }
 
-  for (i = 0, section = NULL, n = (help_node_t *)cupsArrayFirst(hi->sorted);
-       n;
-       n = (help_node_t *)cupsArrayNext(hi->sorted))
-  {
-    if (n->anchor)
-      continue;
+      helpDeleteIndex(si);
+    }
 
    /*
-    * Add a section link as needed...
+    * OK, now list the bookmarks within the index...
     */
 
-    if (n->section &&
-        (!section || strcmp(n->section, section)))
+    for (i = 0, section = NULL, n = (help_node_t *)cupsArrayFirst(hi->sorted);
+	 n;
+	 n = (help_node_t *)cupsArrayNext(hi->sorted))
     {
+      if (n->anchor)
+	continue;
+
+     /*
+      * Add a section link as needed...
+      */
+
+      if (n->section &&
+	  (!section || strcmp(n->section, section)))
+      {
+       /*
+	* Add a link for this node...
+	*/
+
+	snprintf(line, sizeof(line), "/help/?TOPIC=%s&QUERY=%s",
+		 cgiFormEncode(topic_data, n->section, sizeof(topic_data)),
+		 query ? query : "");
+	cgiSetArray("BMLINK", i, line);
+	cgiSetArray("BMTEXT", i, n->section);
+	cgiSetArray("BMINDENT", i, "0");
+
+	i ++;
+	section = n->section;
+      }
+
+      if (!topic || strcmp(n->section, topic))
+	continue;
+
      /*
       * Add a link for this node...
       */
 
-      snprintf(line, sizeof(line), "/help/?TOPIC=%s&QUERY=%s",
-               cgiFormEncode(topic_data, n->section, sizeof(topic_data)),
+      snprintf(line, sizeof(line), "/help/%s?TOPIC=%s&QUERY=%s", n->filename,
+	       cgiFormEncode(topic_data, n->section, sizeof(topic_data)),
 	       query ? query : "");
       cgiSetArray("BMLINK", i, line);
-      cgiSetArray("BMTEXT", i, n->section);
-      cgiSetArray("BMINDENT", i, "0");
+      cgiSetArray("BMTEXT", i, n->text);
+      cgiSetArray("BMINDENT", i, "1");
 
       i ++;
-      section = n->section;
-    }
-
-    if (!topic || strcmp(n->section, topic))
-      continue;
 
-   /*
-    * Add a link for this node...
-    */
-
-    snprintf(line, sizeof(line), "/help/%s?TOPIC=%s&QUERY=%s", n->filename,
-             cgiFormEncode(topic_data, n->section, sizeof(topic_data)),
-	     query ? query : "");
-    cgiSetArray("BMLINK", i, line);
-    cgiSetArray("BMTEXT", i, n->text);
-    cgiSetArray("BMINDENT", i, "1");
-
-    i ++;
-
-    if (helpfile && !strcmp(helpfile, n->filename))
-    {
-      help_node_t	*nn;		/* Pointer to sub-node */
+      if (helpfile && !strcmp(helpfile, n->filename))
+      {
+	help_node_t	*nn;		/* Pointer to sub-node */
 
 
-      cupsArraySave(hi->sorted);
+	cupsArraySave(hi->sorted);
 
-      for (nn = (help_node_t *)cupsArrayFirst(hi->sorted);
-           nn;
-	   nn = (help_node_t *)cupsArrayNext(hi->sorted))
-        if (nn->anchor && !strcmp(helpfile, nn->filename))
-	{
-	 /*
-	  * Add a link for this node...
-	  */
+	for (nn = (help_node_t *)cupsArrayFirst(hi->sorted);
+	     nn;
+	     nn = (help_node_t *)cupsArrayNext(hi->sorted))
+	  if (nn->anchor && !strcmp(helpfile, nn->filename))
+	  {
+	   /*
+	    * Add a link for this node...
+	    */
 
-	  snprintf(line, sizeof(line), "#%s", nn->anchor);
-	  cgiSetArray("BMLINK", i, line);
-	  cgiSetArray("BMTEXT", i, nn->text);
-	  cgiSetArray("BMINDENT", i, "2");
+	    snprintf(line, sizeof(line), "#%s", nn->anchor);
+	    cgiSetArray("BMLINK", i, line);
+	    cgiSetArray("BMTEXT", i, nn->text);
+	    cgiSetArray("BMINDENT", i, "2");
 
-	  i ++;
-	}
+	    i ++;
+	  }
 
-      cupsArrayRestore(hi->sorted);
+	cupsArrayRestore(hi->sorted);
+      }
     }
-  }
 
- /*
-  * Show the search and bookmark content...
-  */
+   /*
+    * Show the search and bookmark content...
+    */
 
-  if (!helpfile || !printable)
-    cgiCopyTemplateLang("help-header.tmpl");
-  else
-    cgiCopyTemplateLang("help-printable.tmpl");
+    if (!helpfile || !printable)
+      cgiCopyTemplateLang("help-header.tmpl");
+    else
+      cgiCopyTemplateLang("help-printable.tmpl");
 
- /*
-  * If we are viewing a file, copy it in now...
-  */
+   /*
+    * If we are viewing a file, copy it in now...
+    */
 
-  if (helpfile)
-  {
-    if ((fp = cupsFileOpen(filename, "r")) != NULL)
+    if (helpfile)
     {
-      int	inbody;			/* Are we inside the body? */
+      if ((fp = cupsFileOpen(filename, "r")) != NULL)
+      {
+	int	inbody;			/* Are we inside the body? */
 
 
-      inbody = 0;
+	inbody = 0;
 
-      while (cupsFileGets(fp, line, sizeof(line)))
-      {
-        if (inbody)
+	while (cupsFileGets(fp, line, sizeof(line)))
 	{
-	  if (!_cups_strncasecmp(line, "</BODY>", 7))
-	    break;
+	  if (inbody)
+	  {
+	    if (!_cups_strncasecmp(line, "</BODY>", 7))
+	      break;
+
+	    printf("%s\n", line);
+	  }
+	  else if (!_cups_strncasecmp(line, "<BODY", 5))
+	    inbody = 1;
+	}
 
-	  printf("%s\n", line);
-        }
-	else if (!_cups_strncasecmp(line, "<BODY", 5))
-	  inbody = 1;
+	cupsFileClose(fp);
+      }
+      else
+      {
+	perror(filename);
+	cgiSetVariable("ERROR", cgiText(_("Unable to open help file.")));
+	cgiCopyTemplateLang("error.tmpl");
       }
-
-      cupsFileClose(fp);
     }
-    else
+
+   /*
+    * Send a standard trailer...
+    */
+
+    if (!printable)
     {
-      perror(filename);
-      cgiSetVariable("ERROR", cgiText(_("Unable to open help file.")));
-      cgiCopyTemplateLang("error.tmpl");
+      cgiCopyTemplateLang("help-trailer.tmpl");
+      cgiEndHTML();
     }
-  }
+    else
+      puts("</BODY>\n</HTML>");
 
- /*
-  * Send a standard trailer...
-  */
+   /*
+    * Delete the index...
+    */
 
-  if (!printable)
-  {
-    cgiCopyTemplateLang("help-trailer.tmpl");
-    cgiEndHTML();
+    helpDeleteIndex(hi);
   }
-  else
-    puts("</BODY>\n</HTML>");
-
- /*
-  * Delete the index...
-  */
-
-  helpDeleteIndex(hi);
 
  /*
   * Return with no errors...
@@ -71,6 +71,8 @@ cgiEndMultipart(void)
   {
     printf("\n%s--\n", cgi_multipart);
     fflush(stdout);
+
+    cgi_multipart = NULL;
   }
 }
 
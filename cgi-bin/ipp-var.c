@@ -20,6 +20,56 @@
 #include "cgi-private.h"
 
 
+/*
+ * Local globals...
+ */
+
+static http_t		*cgi_http = NULL;
+					/* Connection to the scheduler */
+static int		cgi_http_reused = 0;
+					/* Connection kept from a previous request? */
+static cups_lang_t	*cgi_language = NULL;
+					/* Language for cgiText() */
+
+
+/*
+ * 'cgiConnect()' - Connect to the scheduler.
+ *
+ * Persistent workers keep the connection open for the next request, so
+ * callers must not close it.
+ */
+
+http_t *				/* O - Connection to the scheduler */
+cgiConnect(void)
+{
+  if (cgi_http && cgi_http_reused)
+  {
+   /*
+    * Drop the previous request's credentials, and reconnect if the scheduler
+    * closed the idle connection (an idle connection is only readable at
+    * end-of-file)...
+    */
+
+    cgi_http_reused = 0;
+
+    httpSetAuthString(cgi_http, NULL, NULL);
+
+    if (httpGetState(cgi_http) != HTTP_STATE_WAITING || httpWait(cgi_http, 0))
+    {
+      fputs("DEBUG: Scheduler closed connection, reconnecting.\n", stderr);
+
+      httpClose(cgi_http);
+      cgi_http = NULL;
+    }
+  }
+
+  if (!cgi_http)
+    cgi_http = httpConnectEncrypt(cupsServer(), ippPort(), cupsEncryption());
+
+  return (cgi_http);
+}
+
+
 /*
  * 'cgiGetAttributes()' - Get the list of attributes that are needed
  *                        by the template file.
@@ -251,6 +301,160 @@ cgiGetIPPObjects(ipp_t *response,	/* I - IPP response */
 }
 
 
+/*
+ * 'cgiGetIPPPage()' - Get a page of objects from the scheduler.
+ *
+ * The request is sent with "limit", "first-index", "sort-order", and
+ * "search-query" attributes so the scheduler only returns the objects on the
+ * page.  If the scheduler does not report a "total-count", the full list is
+ * requested and filtered, sorted, and paged locally instead.  The request is
+ * always freed.
+ */
+
+cups_array_t *				/* O - Objects on the page or NULL */
+cgiGetIPPPage(http_t     *http,		/* I - Connection to server */
+              ipp_t      *request,	/* I - IPP request */
+	      const char *query,	/* I - Search query or NULL */
+	      int        ascending,	/* I - 1 for ascending, 0 for descending */
+	      int        *first,	/* IO - Index of first object */
+	      int        *count,	/* O - Number of matching objects */
+	      ipp_t      **response)	/* O - IPP response */
+{
+  int			i,		/* Looping var */
+			start;		/* Requested first object */
+  ipp_t			*paged;		/* Paged request */
+  ipp_attribute_t	*total,		/* total-count attribute */
+			*obj;		/* Current object */
+  cups_array_t		*objs,		/* Array of objects */
+			*page;		/* Objects on the page */
+  void			*search;	/* Search data */
+
+
+  *count    = 0;
+  *response = NULL;
+
+  if (query && !*query)
+    query = NULL;
+
+  start  = *first;
+  *first = start < 0 ? 0 : (start / CUPS_PAGE_MAX) * CUPS_PAGE_MAX;
+
+  for (i = 0; i < 2; i ++)
+  {
+   /*
+    * Copy the request and add the paging attributes...
+    */
+
+    paged = ippNew();
+
+    ippSetOperation(paged, ippGetOperation(request));
+    ippSetRequestId(paged, ippGetRequestId(request));
+    ippCopyAttributes(paged, request, 0, NULL, NULL);
+
+    ippAddInteger(paged, IPP_TAG_OPERATION, IPP_TAG_INTEGER, "limit",
+                  CUPS_PAGE_MAX);
+    ippAddInteger(paged, IPP_TAG_OPERATION, IPP_TAG_INTEGER, "first-index",
+                  *first + 1);
+    ippAddString(paged, IPP_TAG_OPERATION, IPP_TAG_KEYWORD, "sort-order",
+                 NULL, ascending ? "ascending" : "descending");
+    if (query)
+      ippAddString(paged, IPP_TAG_OPERATION, IPP_TAG_TEXT, "search-query",
+                   NULL, query);
+
+    if ((*response = cupsDoRequest(http, paged, "/")) == NULL)
+    {
+      ippDelete(request);
+      return (NULL);
+    }
+
+    if ((total = ippFindAttribute(*response, "total-count",
+                                  IPP_TAG_INTEGER)) == NULL)
+    {
+      if (ippGetStatusCode(*response) > IPP_STATUS_OK_EVENTS_COMPLETE)
+      {
+       /*
+        * Errors are reported the same way for either kind of request...
+	*/
+
+        ippDelete(request);
+	return (cgiGetIPPObjects(*response, NULL));
+      }
+
+      break;
+    }
+
+    *count = ippGetInteger(total, 0);
+
+    if (start >= *count)
+    {
+     /*
+      * Past the end of the list, show an earlier page instead...
+      */
+
+      start = *count - CUPS_PAGE_MAX;
+      start = start < 0 ? 0 : (start / CUPS_PAGE_MAX) * CUPS_PAGE_MAX;
+    }
+    else
+      start = *first;
+
+    if (start == *first || i > 0)
+    {
+      ippDelete(request);
+      return (cgiGetIPPObjects(*response, NULL));
+    }
+
+    ippDelete(*response);
+
+    *first = start;
+  }
+
+ /*
+  * The scheduler does not support paging, get everything...
+  */
+
+  ippDelete(*response);
+
+  if ((*response = cupsDoRequest(http, request, "/")) == NULL)
+    return (NULL);
+
+  search = query ? cgiCompileSearch(query) : NULL;
+  objs   = cgiGetIPPObjects(*response, search);
+  *count = cupsArrayCount(objs);
+
+  if (search)
+    cgiFreeSearch(search);
+
+  if ((*first = start) >= *count)
+    *first = *count - CUPS_PAGE_MAX;
+
+  *first = (*first / CUPS_PAGE_MAX) * CUPS_PAGE_MAX;
+
+  if (*first < 0)
+    *first = 0;
+
+  page = cupsArrayNew(NULL, NULL);
+
+  if (ascending)
+  {
+    for (i = 0, obj = (ipp_attribute_t *)cupsArrayIndex(objs, *first);
+	 i < CUPS_PAGE_MAX && obj;
+	 i ++, obj = (ipp_attribute_t *)cupsArrayNext(objs))
+      cupsArrayAdd(page, obj);
+  }
+  else
+  {
+    for (i = 0, obj = (ipp_attribute_t *)cupsArrayIndex(objs, *count - *first - 1);
+	 i < CUPS_PAGE_MAX && obj;
+	 i ++, obj = (ipp_attribute_t *)cupsArrayPrev(objs))
+      cupsArrayAdd(page, obj);
+  }
+
+  cupsArrayDelete(objs);
+
+  return (page);
+}
+
+
 /*
  * 'cgiMoveJobs()' - Move one or more jobs.
  *
@@ -792,6 +996,30 @@ cgiPrintTestPage(http_t     *http,	/* I - Connection to server */
 }
 
 
+/*
+ * '_cgiResetIPPState()' - Reset the IPP state between requests.
+ */
+
+void
+_cgiResetIPPState(int keep)		/* I - Keep the scheduler connection? */
+{
+  cgi_language = NULL;
+
+  if (!cgi_http)
+    return;
+
+  if (keep)
+  {
+    cgi_http_reused = 1;
+  }
+  else
+  {
+    httpClose(cgi_http);
+    cgi_http = NULL;
+  }
+}
+
+
 /*
  * 'cgiRewriteURL()' - Rewrite a printer URI into a web browser URL...
  */
@@ -811,39 +1039,32 @@ cgiRewriteURL(const char *uri,		/* I - Current URI */
 			*rawptr,	/* Pointer into rawresource */
 			*resptr;	/* Pointer into resource */
   int			port;		/* Port number */
-  static int		ishttps = -1;	/* Using encryption? */
-  static const char	*server;	/* Name of server */
-  static char		servername[1024];
+  int			ishttps;	/* Using encryption? */
+  const char		*server;	/* Name of server */
+  static char		servername[1024] = "";
 					/* Local server name */
   static const char	hexchars[] = "0123456789ABCDEF";
 					/* Hexadecimal conversion characters */
 
 
  /*
-  * Check if we have been called before...
+  * Get the server name associated with the client interface as well as the
+  * locally configured hostname.  We'll check *both* of these to see if the
+  * printer URL is local.  The client values can change from request to
+  * request in a persistent worker, so only the local hostname is cached...
   */
 
-  if (ishttps < 0)
-  {
-   /*
-    * No, initialize static vars for the conversion...
-    *
-    * First get the server name associated with the client interface as
-    * well as the locally configured hostname.  We'll check *both* of
-    * these to see if the printer URL is local...
-    */
-
-    if ((server = getenv("SERVER_NAME")) == NULL)
-      server = "";
+  if ((server = getenv("SERVER_NAME")) == NULL)
+    server = "";
 
+  if (!servername[0])
     httpGetHostname(NULL, servername, sizeof(servername));
 
-   /*
-    * Then flag whether we are using SSL on this connection...
-    */
+ /*
+  * Then flag whether we are using SSL on this connection...
+  */
 
-    ishttps = getenv("HTTPS") != NULL;
-  }
+  ishttps = getenv("HTTPS") != NULL;
 
  /*
   * Convert the URI to a URL...
@@ -1366,7 +1587,6 @@ cgiShowJobs(http_t     *http,		/* I - Connection to server */
   const char		*var,		/* Form variable */
 			*query,		/* Query string */
 			*section;	/* Section in web interface */
-  void			*search;	/* Search data */
   char			url[1024],	/* Printer URI */
 			val[1024];	/* Form variable */
 
@@ -1400,53 +1620,30 @@ cgiShowJobs(http_t     *http,		/* I - Connection to server */
   cgiGetAttributes(request, "jobs.tmpl");
 
  /*
-  * Do the request and get back a response...
+  * Figure out which jobs to display...
   */
 
-  if ((response = cupsDoRequest(http, request, "/")) != NULL)
-  {
-   /*
-    * Get a list of matching job objects.
-    */
-
-    if ((query = cgiGetVariable("QUERY")) != NULL &&
-        !cgiGetVariable("CLEAR"))
-      search = cgiCompileSearch(query);
-    else
-    {
-      query  = NULL;
-      search = NULL;
-    }
-
-    jobs  = cgiGetIPPObjects(response, search);
-    count = cupsArrayCount(jobs);
-
-    if (search)
-      cgiFreeSearch(search);
-
-   /*
-    * Figure out which jobs to display...
-    */
-
-    if ((var = cgiGetVariable("FIRST")) != NULL)
-      first = atoi(var);
-    else
-      first = 0;
-
-    if (first >= count)
-      first = count - CUPS_PAGE_MAX;
+  if ((query = cgiGetVariable("QUERY")) != NULL && cgiGetVariable("CLEAR"))
+    query = NULL;
 
-    first = (first / CUPS_PAGE_MAX) * CUPS_PAGE_MAX;
+  if ((var = cgiGetVariable("FIRST")) != NULL)
+    first = atoi(var);
+  else
+    first = 0;
 
-    if (first < 0)
-      first = 0;
+  if ((var = cgiGetVariable("ORDER")) != NULL && *var)
+    ascending = !_cups_strcasecmp(var, "asc");
+  else
+    ascending = !which_jobs || !*which_jobs ||
+                !_cups_strcasecmp(which_jobs, "not-completed");
 
-    if ((var = cgiGetVariable("ORDER")) != NULL && *var)
-      ascending = !_cups_strcasecmp(var, "asc");
-    else
-      ascending = !which_jobs || !*which_jobs ||
-                  !_cups_strcasecmp(which_jobs, "not-completed");
+ /*
+  * Do the request and get back the matching jobs on this page...
+  */
 
+  if ((jobs = cgiGetIPPPage(http, request, query, ascending, &first, &count,
+                            &response)) != NULL)
+  {
     section = cgiGetVariable("SECTION");
 
     cgiClearVariables();
@@ -1464,20 +1661,10 @@ cgiShowJobs(http_t     *http,		/* I - Connection to server */
     if (which_jobs)
       cgiSetVariable("WHICH_JOBS", which_jobs);
 
-    if (ascending)
-    {
-      for (i = 0, job = (ipp_attribute_t *)cupsArrayIndex(jobs, first);
-	   i < CUPS_PAGE_MAX && job;
-	   i ++, job = (ipp_attribute_t *)cupsArrayNext(jobs))
-        cgiSetIPPObjectVars(job, NULL, i);
-    }
-    else
-    {
-      for (i = 0, job = (ipp_attribute_t *)cupsArrayIndex(jobs, count - first - 1);
-	   i < CUPS_PAGE_MAX && job;
-	   i ++, job = (ipp_attribute_t *)cupsArrayPrev(jobs))
-        cgiSetIPPObjectVars(job, NULL, i);
-    }
+    for (i = 0, job = (ipp_attribute_t *)cupsArrayFirst(jobs);
+	 job;
+	 i ++, job = (ipp_attribute_t *)cupsArrayNext(jobs))
+      cgiSetIPPObjectVars(job, NULL, i);
 
    /*
     * Save navigation URLs...
@@ -1538,14 +1725,10 @@ cgiShowJobs(http_t     *http,		/* I - Connection to server */
 const char *				/* O - Localized message */
 cgiText(const char *message)		/* I - Message */
 {
-  static cups_lang_t	*language = NULL;
-					/* Language */
-
-
-  if (!language)
-    language = cupsLangDefault();
+  if (!cgi_language)
+    cgi_language = cupsLangDefault();
 
-  return (_cupsLangString(language, message));
+  return (_cupsLangString(cgi_language, message));
 }
 
 
@@ -40,81 +40,78 @@ main(void)
   int		job_id;			/* Job ID */
 
 
- /*
-  * Get any form variables...
-  */
-
-  cgiInitialize();
+  while (cgiAcceptRequest())
+  {
+   /*
+    * Get any form variables...
+    */
 
- /*
-  * Set the web interface section...
-  */
+    cgiInitialize();
 
-  cgiSetVariable("SECTION", "jobs");
-  cgiSetVariable("REFRESH_PAGE", "");
+   /*
+    * Set the web interface section...
+    */
 
- /*
-  * Connect to the HTTP server...
-  */
+    cgiSetVariable("SECTION", "jobs");
+    cgiSetVariable("REFRESH_PAGE", "");
 
-  http = httpConnectEncrypt(cupsServer(), ippPort(), cupsEncryption());
+   /*
+    * Connect to the HTTP server...
+    */
 
- /*
-  * Get the job ID, if any...
-  */
+    http = cgiConnect();
 
-  if ((job_id_var = cgiGetVariable("JOB_ID")) != NULL)
-    job_id = atoi(job_id_var);
-  else
-    job_id = 0;
+   /*
+    * Get the job ID, if any...
+    */
 
- /*
-  * Do the operation...
-  */
+    if ((job_id_var = cgiGetVariable("JOB_ID")) != NULL)
+      job_id = atoi(job_id_var);
+    else
+      job_id = 0;
 
-  if ((op = cgiGetVariable("OP")) != NULL && job_id > 0 && cgiIsPOST())
-  {
    /*
     * Do the operation...
     */
 
-    if (!strcmp(op, "cancel-job"))
-      do_job_op(http, job_id, IPP_CANCEL_JOB);
-    else if (!strcmp(op, "hold-job"))
-      do_job_op(http, job_id, IPP_HOLD_JOB);
-    else if (!strcmp(op, "move-job"))
-      cgiMoveJobs(http, NULL, job_id);
-    else if (!strcmp(op, "release-job"))
-      do_job_op(http, job_id, IPP_RELEASE_JOB);
-    else if (!strcmp(op, "restart-job"))
-      do_job_op(http, job_id, IPP_RESTART_JOB);
+    if ((op = cgiGetVariable("OP")) != NULL && job_id > 0 && cgiIsPOST())
+    {
+     /*
+      * Do the operation...
+      */
+
+      if (!strcmp(op, "cancel-job"))
+	do_job_op(http, job_id, IPP_CANCEL_JOB);
+      else if (!strcmp(op, "hold-job"))
+	do_job_op(http, job_id, IPP_HOLD_JOB);
+      else if (!strcmp(op, "move-job"))
+	cgiMoveJobs(http, NULL, job_id);
+      else if (!strcmp(op, "release-job"))
+	do_job_op(http, job_id, IPP_RELEASE_JOB);
+      else if (!strcmp(op, "restart-job"))
+	do_job_op(http, job_id, IPP_RESTART_JOB);
+      else
+      {
+       /*
+	* Bad operation code...  Display an error...
+	*/
+
+	cgiStartHTML(cgiText(_("Jobs")));
+	cgiCopyTemplateLang("error-op.tmpl");
+	cgiEndHTML();
+      }
+    }
     else
     {
      /*
-      * Bad operation code...  Display an error...
+      * Show a list of jobs...
       */
 
       cgiStartHTML(cgiText(_("Jobs")));
-      cgiCopyTemplateLang("error-op.tmpl");
+      cgiShowJobs(http, NULL);
       cgiEndHTML();
     }
   }
-  else
-  {
-   /*
-    * Show a list of jobs...
-    */
-
-    cgiStartHTML(cgiText(_("Jobs")));
-    cgiShowJobs(http, NULL);
-    cgiEndHTML();
-  }
-
- /*
-  * Close the HTTP server connection...
-  */
-
-  httpClose(http);
 
  /*
   * Return with no errors...
@@ -52,157 +52,154 @@ main(void)
 		};
 
 
- /*
-  * Get any form variables...
-  */
+  while (cgiAcceptRequest())
+  {
+   /*
+    * Get any form variables...
+    */
 
-  cgiInitialize();
+    cgiInitialize();
 
-  op = cgiGetVariable("OP");
+    op = cgiGetVariable("OP");
 
- /*
-  * Set the web interface section...
-  */
+   /*
+    * Set the web interface section...
+    */
 
-  cgiSetVariable("SECTION", "printers");
-  cgiSetVariable("REFRESH_PAGE", "");
+    cgiSetVariable("SECTION", "printers");
+    cgiSetVariable("REFRESH_PAGE", "");
 
- /*
-  * See if we are displaying a printer or all printers...
-  */
+   /*
+    * See if we are displaying a printer or all printers...
+    */
 
-  if ((printer = getenv("PATH_INFO")) != NULL)
-  {
-    printer ++;
+    if ((printer = getenv("PATH_INFO")) != NULL)
+    {
+      printer ++;
 
-    if (!*printer)
-      printer = NULL;
+      if (!*printer)
+	printer = NULL;
 
-    if (printer)
-      cgiSetVariable("PRINTER_NAME", printer);
-  }
+      if (printer)
+	cgiSetVariable("PRINTER_NAME", printer);
+    }
 
- /*
-  * See who is logged in...
-  */
+   /*
+    * See who is logged in...
+    */
 
-  user = getenv("REMOTE_USER");
+    user = getenv("REMOTE_USER");
 
- /*
-  * Connect to the HTTP server...
-  */
-
-  http = httpConnectEncrypt(cupsServer(), ippPort(), cupsEncryption());
+   /*
+    * Connect to the HTTP server...
+    */
 
- /*
-  * Get the default printer...
-  */
+    http = cgiConnect();
 
-  if (!op || !cgiIsPOST())
-  {
    /*
-    * Get the default destination...
+    * Get the default printer...
     */
 
-    request = ippNewRequest(CUPS_GET_DEFAULT);
+    if (!op || !cgiIsPOST())
+    {
+     /*
+      * Get the default destination...
+      */
 
-    ippAddStrings(request, IPP_TAG_OPERATION, IPP_TAG_KEYWORD,
-                  "requested-attributes",
-		  sizeof(def_attrs) / sizeof(def_attrs[0]), NULL, def_attrs);
+      request = ippNewRequest(CUPS_GET_DEFAULT);
 
-    if ((response = cupsDoRequest(http, request, "/")) != NULL)
-    {
-      if ((attr = ippFindAttribute(response, "printer-name", IPP_TAG_NAME)) != NULL)
-        cgiSetVariable("DEFAULT_NAME", attr->values[0].string.text);
+      ippAddStrings(request, IPP_TAG_OPERATION, IPP_TAG_KEYWORD,
+		    "requested-attributes",
+		    sizeof(def_attrs) / sizeof(def_attrs[0]), NULL, def_attrs);
 
-      if ((attr = ippFindAttribute(response, "printer-uri-supported", IPP_TAG_URI)) != NULL)
+      if ((response = cupsDoRequest(http, request, "/")) != NULL)
       {
-	char	url[HTTP_MAX_URI];	/* New URL */
+	if ((attr = ippFindAttribute(response, "printer-name", IPP_TAG_NAME)) != NULL)
+	  cgiSetVariable("DEFAULT_NAME", attr->values[0].string.text);
 
+	if ((attr = ippFindAttribute(response, "printer-uri-supported", IPP_TAG_URI)) != NULL)
+	{
+	  char	url[HTTP_MAX_URI];	/* New URL */
 
-        cgiSetVariable("DEFAULT_URI",
-	               cgiRewriteURL(attr->values[0].string.text,
-		                     url, sizeof(url), NULL));
-      }
 
-      ippDelete(response);
-    }
+	  cgiSetVariable("DEFAULT_URI",
+			 cgiRewriteURL(attr->values[0].string.text,
+				       url, sizeof(url), NULL));
+	}
 
-   /*
-    * See if we need to show a list of printers or the status of a
-    * single printer...
-    */
+	ippDelete(response);
+      }
 
-    if (!printer)
-      show_all_printers(http, user);
-    else
-      show_printer(http, printer);
-  }
-  else if (printer)
-  {
-    if (!*op)
+     /*
+      * See if we need to show a list of printers or the status of a
+      * single printer...
+      */
+
+      if (!printer)
+	show_all_printers(http, user);
+      else
+	show_printer(http, printer);
+    }
+    else if (printer)
     {
-      const char *server_port = getenv("SERVER_PORT");
-					/* Port number string */
-      int	port = atoi(server_port ? server_port : "0");
-      					/* Port number */
-      char	uri[1024];		/* URL */
+      if (!*op)
+      {
+	const char *server_port = getenv("SERVER_PORT");
+					  /* Port number string */
+	int	port = atoi(server_port ? server_port : "0");
+					  /* Port number */
+	char	uri[1024];		/* URL */
 
-      httpAssembleURIf(HTTP_URI_CODING_ALL, uri, sizeof(uri),
-		       getenv("HTTPS") ? "https" : "http", NULL,
-		       getenv("SERVER_NAME"), port, "/printers/%s", printer);
+	httpAssembleURIf(HTTP_URI_CODING_ALL, uri, sizeof(uri),
+			 getenv("HTTPS") ? "https" : "http", NULL,
+			 getenv("SERVER_NAME"), port, "/printers/%s", printer);
+
+	printf("Location: %s\n\n", uri);
+      }
+      else if (!strcmp(op, "start-printer"))
+	do_printer_op(http, printer, IPP_RESUME_PRINTER,
+		      cgiText(_("Resume Printer")));
+      else if (!strcmp(op, "stop-printer"))
+	do_printer_op(http, printer, IPP_PAUSE_PRINTER,
+		      cgiText(_("Pause Printer")));
+      else if (!strcmp(op, "accept-jobs"))
+	do_printer_op(http, printer, CUPS_ACCEPT_JOBS, cgiText(_("Accept Jobs")));
+      else if (!strcmp(op, "reject-jobs"))
+	do_printer_op(http, printer, CUPS_REJECT_JOBS, cgiText(_("Reject Jobs")));
+      else if (!strcmp(op, "cancel-jobs"))
+	do_printer_op(http, printer, IPP_OP_CANCEL_JOBS, cgiText(_("Cancel Jobs")));
+      else if (!_cups_strcasecmp(op, "print-self-test-page"))
+	cgiPrintCommand(http, printer, "PrintSelfTestPage",
+			cgiText(_("Print Self-Test Page")));
+      else if (!_cups_strcasecmp(op, "clean-print-heads"))
+	cgiPrintCommand(http, printer, "Clean all",
+			cgiText(_("Clean Print Heads")));
+      else if (!_cups_strcasecmp(op, "print-test-page"))
+	cgiPrintTestPage(http, printer);
+      else if (!_cups_strcasecmp(op, "move-jobs"))
+	cgiMoveJobs(http, printer, 0);
+      else
+      {
+       /*
+	* Unknown/bad operation...
+	*/
 
-      printf("Location: %s\n\n", uri);
+	cgiStartHTML(printer);
+	cgiCopyTemplateLang("error-op.tmpl");
+	cgiEndHTML();
+      }
     }
-    else if (!strcmp(op, "start-printer"))
-      do_printer_op(http, printer, IPP_RESUME_PRINTER,
-                    cgiText(_("Resume Printer")));
-    else if (!strcmp(op, "stop-printer"))
-      do_printer_op(http, printer, IPP_PAUSE_PRINTER,
-                    cgiText(_("Pause Printer")));
-    else if (!strcmp(op, "accept-jobs"))
-      do_printer_op(http, printer, CUPS_ACCEPT_JOBS, cgiText(_("Accept Jobs")));
-    else if (!strcmp(op, "reject-jobs"))
-      do_printer_op(http, printer, CUPS_REJECT_JOBS, cgiText(_("Reject Jobs")));
-    else if (!strcmp(op, "cancel-jobs"))
-      do_printer_op(http, printer, IPP_OP_CANCEL_JOBS, cgiText(_("Cancel Jobs")));
-    else if (!_cups_strcasecmp(op, "print-self-test-page"))
-      cgiPrintCommand(http, printer, "PrintSelfTestPage",
-                      cgiText(_("Print Self-Test Page")));
-    else if (!_cups_strcasecmp(op, "clean-print-heads"))
-      cgiPrintCommand(http, printer, "Clean all",
-                      cgiText(_("Clean Print Heads")));
-    else if (!_cups_strcasecmp(op, "print-test-page"))
-      cgiPrintTestPage(http, printer);
-    else if (!_cups_strcasecmp(op, "move-jobs"))
-      cgiMoveJobs(http, printer, 0);
     else
     {
      /*
       * Unknown/bad operation...
       */
 
-      cgiStartHTML(printer);
+      cgiStartHTML(cgiText(_("Printers")));
       cgiCopyTemplateLang("error-op.tmpl");
       cgiEndHTML();
     }
   }
-  else
-  {
-   /*
-    * Unknown/bad operation...
-    */
-
-    cgiStartHTML(cgiText(_("Printers")));
-    cgiCopyTemplateLang("error-op.tmpl");
-    cgiEndHTML();
-  }
-
- /*
-  * Close the HTTP server connection...
-  */
-
-  httpClose(http);
 
  /*
   * Return with no errors...
@@ -309,8 +306,8 @@ show_all_printers(http_t     *http,	/* I - Connection to server */
   int			ascending,	/* Order of printers (0 = descending) */
 			first,		/* First printer to show */
 			count;		/* Number of printers */
-  const char		*var;		/* Form variable */
-  void			*search;	/* Search data */
+  const char		*var,		/* Form variable */
+			*query;		/* Query string */
   char			val[1024];	/* Form variable */
 
 
@@ -348,66 +345,36 @@ show_all_printers(http_t     *http,	/* I - Connection to server */
   cgiGetAttributes(request, "printers.tmpl");
 
  /*
-  * Do the request and get back a response...
+  * Figure out which printers to display...
   */
 
-  if ((response = cupsDoRequest(http, request, "/")) != NULL)
-  {
-   /*
-    * Get a list of matching job objects.
-    */
+  if ((query = cgiGetVariable("QUERY")) != NULL && cgiGetVariable("CLEAR"))
+    query = NULL;
 
-    if ((var = cgiGetVariable("QUERY")) != NULL &&
-        !cgiGetVariable("CLEAR"))
-      search = cgiCompileSearch(var);
-    else
-      search = NULL;
-
-    printers  = cgiGetIPPObjects(response, search);
-    count     = cupsArrayCount(printers);
-
-    if (search)
-      cgiFreeSearch(search);
-
-   /*
-    * Figure out which printers to display...
-    */
-
-    if ((var = cgiGetVariable("FIRST")) != NULL)
-      first = atoi(var);
-    else
-      first = 0;
-
-    if (first >= count)
-      first = count - CUPS_PAGE_MAX;
+  if ((var = cgiGetVariable("FIRST")) != NULL)
+    first = atoi(var);
+  else
+    first = 0;
 
-    first = (first / CUPS_PAGE_MAX) * CUPS_PAGE_MAX;
+  if ((var = cgiGetVariable("ORDER")) != NULL && *var)
+    ascending = !_cups_strcasecmp(var, "asc");
+  else
+    ascending = 1;
 
-    if (first < 0)
-      first = 0;
+ /*
+  * Do the request and get back the matching printers on this page...
+  */
 
+  if ((printers = cgiGetIPPPage(http, request, query, ascending, &first,
+                                &count, &response)) != NULL)
+  {
     sprintf(val, "%d", count);
     cgiSetVariable("TOTAL", val);
 
-    if ((var = cgiGetVariable("ORDER")) != NULL && *var)
-      ascending = !_cups_strcasecmp(var, "asc");
-    else
-      ascending = 1;
-
-    if (ascending)
-    {
-      for (i = 0, printer = (ipp_attribute_t *)cupsArrayIndex(printers, first);
-	   i < CUPS_PAGE_MAX && printer;
-	   i ++, printer = (ipp_attribute_t *)cupsArrayNext(printers))
-        cgiSetIPPObjectVars(printer, NULL, i);
-    }
-    else
-    {
-      for (i = 0, printer = (ipp_attribute_t *)cupsArrayIndex(printers, count - first - 1);
-	   i < CUPS_PAGE_MAX && printer;
-	   i ++, printer = (ipp_attribute_t *)cupsArrayPrev(printers))
-        cgiSetIPPObjectVars(printer, NULL, i);
-    }
+    for (i = 0, printer = (ipp_attribute_t *)cupsArrayFirst(printers);
+	 printer;
+	 i ++, printer = (ipp_attribute_t *)cupsArrayNext(printers))
+      cgiSetIPPObjectVars(printer, NULL, i);
 
    /*
     * Save navigation URLs...
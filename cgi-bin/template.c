@@ -11,21 +11,124 @@
  * law.  Distribution and use rights are outlined in the file "LICENSE.txt"
  * which should have been included with this file.  If this file is
  * file is missing or damaged, see the license at "http://www.cups.org/".
+ *
+ * Template files are compiled once into a flat list of instructions and
+ * cached by filename, modification time, and size.  Nested constructs
+ * ({[array ...}, {name?true:false}) record the index of the instruction
+ * that follows them, so rendering is a simple walk of the list.
  */
 
 #include "cgi-private.h"
 #include <errno.h>
 #include <regex.h>
+#include <sys/stat.h>
+
+
+/*
+ * Local types...
+ */
+
+typedef enum _cgi_op_e			/**** Template instructions ****/
+{
+  _CGI_OP_TEXT,				/* Copy literal text */
+  _CGI_OP_VALUE,			/* Insert {name} value */
+  _CGI_OP_LOOP,				/* Repeat {[name ...} body */
+  _CGI_OP_TEST,				/* Choose {name?true:false} part */
+  _CGI_OP_CTEXT,			/* Comparison: literal text */
+  _CGI_OP_CELEMENT,			/* Comparison: element number (#) */
+  _CGI_OP_CVALUE			/* Comparison: {name} value */
+} _cgi_op_t;
+
+typedef struct _cgi_inst_s		/**** Template instruction ****/
+{
+  _cgi_op_t	op;			/* Operation */
+  int		mode;			/* Output mode, operator, or lookup */
+  size_t	text,			/* Offset of text or name in pool */
+		length;			/* Length of text */
+  int		indexed,		/* Name has "-N" array index? */
+		index,			/* Array index (N - 1) */
+		body,			/* First instruction of loop/true part */
+		alt,			/* First instruction of false part */
+		end;			/* Instruction after this one */
+} _cgi_inst_t;
+
+typedef struct _cgi_tmpl_s		/**** Compiled template ****/
+{
+  char		*filename;		/* Template filename */
+  time_t	mtime;			/* Modification time of file */
+  off_t		size;			/* Size of file */
+  char		*pool;			/* Text and name pool */
+  size_t	pool_used,		/* Bytes used in pool */
+		pool_alloc;		/* Bytes allocated for pool */
+  _cgi_inst_t	*insts;			/* Instructions */
+  int		num_insts,		/* Number of instructions */
+		alloc_insts;		/* Allocated instructions */
+} _cgi_tmpl_t;
+
+typedef struct _cgi_src_s		/**** Template source ****/
+{
+  const char	*ptr,			/* Current position */
+		*end;			/* End of source */
+} _cgi_src_t;
+
+typedef struct _cgi_out_s		/**** Buffered template output ****/
+{
+  FILE		*fp;			/* Output file */
+  size_t	used;			/* Bytes in buffer */
+  char		buffer[32768];		/* Output buffer */
+} _cgi_out_t;
+
+
+/*
+ * Output modes for _CGI_OP_VALUE...
+ */
+
+#define _CGI_MODE_HTML	0		/* Quote HTML special characters */
+#define _CGI_MODE_URI	1		/* Encode as URI */
+#define _CGI_MODE_RAW	2		/* Copy as-is to stdout */
+
+
+/*
+ * Lookups for _CGI_OP_CVALUE...
+ */
+
+#define _CGI_LOOKUP_SIZE	0	/* {#name} - number of elements */
+#define _CGI_LOOKUP_INDEX	1	/* {name-N} - Nth element or "" */
+#define _CGI_LOOKUP_EXISTS	2	/* {?name} - element or "" */
+#define _CGI_LOOKUP_ELEMENT	3	/* {name} - element or "{name}" */
+
+
+/*
+ * Local globals...
+ */
+
+static cups_array_t	*cgi_templates = NULL;
+					/* Compiled templates */
 
 
 /*
  * Local functions...
  */
 
-static void	cgi_copy(FILE *out, FILE *in, int element, char term,
-		         int indent);
-static void	cgi_puts(const char *s, FILE *out);
-static void	cgi_puturi(const char *s, FILE *out);
+static int	cgi_add_inst(_cgi_tmpl_t *t, _cgi_op_t op);
+static size_t	cgi_add_string(_cgi_tmpl_t *t, const char *s, size_t len);
+static int	cgi_add_text(_cgi_tmpl_t *t, int text, _cgi_op_t op,
+		             const char *s, size_t len);
+static int	cgi_compare_templates(_cgi_tmpl_t *a, _cgi_tmpl_t *b);
+static int	cgi_compile(_cgi_tmpl_t *t, _cgi_src_t *src, char term);
+static void	cgi_copy(_cgi_tmpl_t *t, int first, int last, int element,
+		         _cgi_out_t *out);
+static void	cgi_free_template(_cgi_tmpl_t *t);
+static _cgi_tmpl_t *cgi_get_template(const char *filename);
+static int	cgi_getc(_cgi_src_t *src);
+static void	cgi_put(_cgi_out_t *out, const char *s, size_t len);
+static void	cgi_puts(const char *s, _cgi_out_t *out);
+static void	cgi_puturi(const char *s, _cgi_out_t *out);
+static void	cgi_render(FILE *out, _cgi_tmpl_t *t);
+static int	cgi_test(_cgi_tmpl_t *t, _cgi_inst_t *inst, int element,
+		         const char *value);
+static const char *cgi_value(_cgi_tmpl_t *t, _cgi_inst_t *inst, int element,
+		             char *buffer, size_t bufsize);
 
 
 /*
@@ -37,7 +140,7 @@ void
 cgiCopyTemplateFile(FILE       *out,	/* I - Output file */
                     const char *tmpl)	/* I - Template file to read */
 {
-  FILE	*in;				/* Input file */
+  _cgi_tmpl_t	*t;			/* Compiled template */
 
 
   fprintf(stderr, "DEBUG2: cgiCopyTemplateFile(out=%p, tmpl=\"%s\")\n", out,
@@ -51,10 +154,10 @@ cgiCopyTemplateFile(FILE       *out,	/* I - Output file */
     return;
 
  /*
-  * Open the template file...
+  * Get the compiled template...
   */
 
-  if ((in = fopen(tmpl, "r")) == NULL)
+  if ((t = cgi_get_template(tmpl)) == NULL)
   {
     fprintf(stderr, "ERROR: Unable to open template file \"%s\" - %s\n",
             tmpl ? tmpl : "(null)", strerror(errno));
@@ -62,16 +165,10 @@ cgiCopyTemplateFile(FILE       *out,	/* I - Output file */
   }
 
  /*
-  * Parse the file to the end...
+  * Render the template...
   */
 
-  cgi_copy(out, in, 0, 0, 0);
-
- /*
-  * Close the template file and return...
-  */
-
-  fclose(in);
+  cgi_render(out, t);
 }
 
 
@@ -87,7 +184,7 @@ cgiCopyTemplateLang(const char *tmpl)	/* I - Base filename */
 		*locptr;		/* Pointer into locale name */
   const char	*directory,		/* Directory for templates */
 		*lang;			/* Language */
-  FILE		*in;			/* Input file */
+  _cgi_tmpl_t	*t;			/* Compiled template */
 
 
   fprintf(stderr, "DEBUG2: cgiCopyTemplateLang(tmpl=\"%s\")\n",
@@ -118,25 +215,21 @@ cgiCopyTemplateLang(const char *tmpl)	/* I - Base filename */
   directory = cgiGetTemplateDir();
 
   snprintf(filename, sizeof(filename), "%s%s/%s", directory, locale, tmpl);
-  if ((in = fopen(filename, "r")) == NULL)
+  if ((t = cgi_get_template(filename)) == NULL)
   {
     locale[3] = '\0';
 
     snprintf(filename, sizeof(filename), "%s%s/%s", directory, locale, tmpl);
-    if ((in = fopen(filename, "r")) == NULL)
+    if ((t = cgi_get_template(filename)) == NULL)
     {
       snprintf(filename, sizeof(filename), "%s/%s", directory, tmpl);
-      in = fopen(filename, "r");
+      t = cgi_get_template(filename);
     }
   }
 
   fprintf(stderr, "DEBUG2: Template file is \"%s\"...\n", filename);
 
- /*
-  * Open the template file...
-  */
-
-  if (!in)
+  if (!t)
   {
     fprintf(stderr, "ERROR: Unable to open template file \"%s\" - %s\n",
             filename, strerror(errno));
@@ -144,16 +237,10 @@ cgiCopyTemplateLang(const char *tmpl)	/* I - Base filename */
   }
 
  /*
-  * Parse the file to the end...
+  * Render the template...
   */
 
-  cgi_copy(stdout, in, 0, 0, 0);
-
- /*
-  * Close the template file and return...
-  */
-
-  fclose(in);
+  cgi_render(stdout, t);
 }
 
 
@@ -202,41 +289,163 @@ cgiSetServerVersion(void)
 
 
 /*
- * 'cgi_copy()' - Copy the template file, substituting as needed...
+ * 'cgi_add_inst()' - Add an instruction to a template.
  */
 
-static void
-cgi_copy(FILE *out,			/* I - Output file */
-         FILE *in,			/* I - Input file */
-	 int  element,			/* I - Element number (0 to N) */
-	 char term,			/* I - Terminating character */
-	 int  indent)			/* I - Debug info indentation */
+static int				/* O - Instruction index or -1 on error */
+cgi_add_inst(_cgi_tmpl_t *t,		/* I - Template */
+             _cgi_op_t   op)		/* I - Operation */
+{
+  _cgi_inst_t	*inst;			/* New instruction */
+
+
+  if (t->num_insts >= t->alloc_insts)
+  {
+    int		alloc_insts;		/* New allocation */
+
+
+    alloc_insts = t->alloc_insts ? 2 * t->alloc_insts : 64;
+
+    if ((inst = realloc(t->insts, (size_t)alloc_insts * sizeof(_cgi_inst_t))) == NULL)
+      return (-1);
+
+    t->insts       = inst;
+    t->alloc_insts = alloc_insts;
+  }
+
+  inst = t->insts + t->num_insts;
+
+  memset(inst, 0, sizeof(_cgi_inst_t));
+  inst->op  = op;
+  inst->end = t->num_insts + 1;
+
+  return (t->num_insts ++);
+}
+
+
+/*
+ * 'cgi_add_string()' - Add a string to the template pool.
+ */
+
+static size_t				/* O - Offset of string */
+cgi_add_string(_cgi_tmpl_t *t,		/* I - Template */
+               const char  *s,		/* I - String */
+	       size_t      len)		/* I - Length of string */
+{
+  size_t	offset;			/* Offset of string */
+
+
+  if ((t->pool_used + len + 1) > t->pool_alloc)
+  {
+    size_t	pool_alloc;		/* New allocation */
+    char	*pool;			/* New pool */
+
+
+    for (pool_alloc = t->pool_alloc ? t->pool_alloc : 1024;
+         pool_alloc < (t->pool_used + len + 1);
+	 pool_alloc *= 2);
+
+    if ((pool = realloc(t->pool, pool_alloc)) == NULL)
+      return ((size_t)-1);
+
+    t->pool       = pool;
+    t->pool_alloc = pool_alloc;
+  }
+
+  offset = t->pool_used;
+
+  memcpy(t->pool + offset, s, len);
+  t->pool_used += len;
+  t->pool[t->pool_used ++] = '\0';
+
+  return (offset);
+}
+
+
+/*
+ * 'cgi_add_text()' - Add literal text to a template.
+ *
+ * Text is appended to the previous instruction when "text" refers to the last
+ * instruction, otherwise a new instruction is added.
+ */
+
+static int				/* O - Text instruction or -1 on error */
+cgi_add_text(_cgi_tmpl_t *t,		/* I - Template */
+             int         text,		/* I - Current text instruction or -1 */
+	     _cgi_op_t   op,		/* I - _CGI_OP_TEXT or _CGI_OP_CTEXT */
+	     const char  *s,		/* I - Text */
+	     size_t      len)		/* I - Length of text */
+{
+  _cgi_inst_t	*inst;			/* Text instruction */
+
+
+  if (text >= 0 && text == (t->num_insts - 1))
+  {
+   /*
+    * Text is always the last thing in the pool, so just overwrite the nul...
+    */
+
+    inst = t->insts + text;
+    t->pool_used --;
+
+    if (cgi_add_string(t, s, len) == (size_t)-1)
+      return (-1);
+
+    inst->length += len;
+
+    return (text);
+  }
+
+  if ((text = cgi_add_inst(t, op)) < 0)
+    return (-1);
+
+  inst = t->insts + text;
+
+  if ((inst->text = cgi_add_string(t, s, len)) == (size_t)-1)
+    return (-1);
+
+  inst->length = len;
+
+  return (text);
+}
+
+
+/*
+ * 'cgi_compare_templates()' - Compare two templates by filename.
+ */
+
+static int				/* O - Result of comparison */
+cgi_compare_templates(_cgi_tmpl_t *a,	/* I - First template */
+                      _cgi_tmpl_t *b)	/* I - Second template */
+{
+  return (strcmp(a->filename, b->filename));
+}
+
+
+/*
+ * 'cgi_compile()' - Compile template source up to the terminating character.
+ */
+
+static int				/* O - Terminating character, EOF, or -2 on error */
+cgi_compile(_cgi_tmpl_t *t,		/* I - Template */
+            _cgi_src_t  *src,		/* I - Template source */
+	    char        term)		/* I - Terminating character */
 {
   int		ch;			/* Character from file */
-  char		op;			/* Operation */
-  char		name[255],		/* Name of variable */
+  char		c,			/* Character to add */
+		name[255],		/* Name of variable */
 		*nameptr,		/* Pointer into name */
-		innername[255],		/* Inner comparison name */
-		*innerptr,		/* Pointer into inner name */
 		*s;			/* String pointer */
-  const char	*value;			/* Value of variable */
-  const char	*innerval;		/* Inner value */
-  const char	*outptr;		/* Output string pointer */
-  char		outval[1024],		/* Formatted output string */
-		compare[1024];		/* Comparison string */
-  int		result;			/* Result of comparison */
-  int		uriencode;		/* Encode as URI */
-  regex_t	re;			/* Regular expression to match */
+  int		uriencode,		/* Encode as URI */
+		text,			/* Current text instruction */
+		start,			/* First instruction of construct */
+		i;			/* Instruction index */
+  _cgi_inst_t	*inst;			/* Current instruction */
 
 
-  fprintf(stderr, "DEBUG2: %*sStarting at file position %ld...\n", indent, "",
-          ftell(in));
+  text = -1;
 
- /*
-  * Parse the file to the end...
-  */
-
-  while ((ch = getc(in)) != EOF)
+  while ((ch = cgi_getc(src)) != EOF)
     if (ch == term)
       break;
     else if (ch == '{')
@@ -247,7 +456,7 @@ cgi_copy(FILE *out,			/* I - Output file */
 
       uriencode = 0;
 
-      for (s = name; (ch = getc(in)) != EOF;)
+      for (s = name; (ch = cgi_getc(src)) != EOF;)
         if (strchr("}]<>=!~ \t\n", ch))
           break;
 	else if (s == name && ch == '%')
@@ -260,147 +469,62 @@ cgi_copy(FILE *out,			/* I - Output file */
       *s = '\0';
 
       if (s == name && isspace(ch & 255))
-      {
-        fprintf(stderr, "DEBUG2: %*sLone { at %ld...\n", indent, "", ftell(in));
-
-        if (out)
-	{
-          putc('{', out);
-	  putc(ch, out);
-        }
-
-	continue;
-      }
-
-      if (ch == '}')
-	fprintf(stderr, "DEBUG2: %*s\"{%s}\" at %ld...\n", indent, "", name,
-        	ftell(in));
-
-     /*
-      * See if it has a value...
-      */
-
-      if (name[0] == '?')
       {
        /*
-        * Insert value only if it exists...
+        * Lone "{"...
 	*/
 
-	if ((nameptr = strrchr(name, '-')) != NULL && isdigit(nameptr[1] & 255))
-	{
-	  *nameptr++ = '\0';
+        char	lone[2];		/* Lone brace and whitespace */
 
-	  if ((value = cgiGetArray(name + 1, atoi(nameptr) - 1)) != NULL)
-	    outptr = value;
-	  else
-	  {
-	    outval[0] = '\0';
-	    outptr    = outval;
-	  }
-	}
-        else if ((value = cgiGetArray(name + 1, element)) != NULL)
-	  outptr = value;
-	else
-	{
-	  outval[0] = '\0';
-	  outptr    = outval;
-	}
-      }
-      else if (name[0] == '#')
-      {
-       /*
-        * Insert count...
-	*/
+        lone[0] = '{';
+	lone[1] = (char)ch;
 
-        if (name[1])
-          sprintf(outval, "%d", cgiGetSize(name + 1));
-	else
-	  sprintf(outval, "%d", element + 1);
+        if ((text = cgi_add_text(t, text, _CGI_OP_TEXT, lone, 2)) < 0)
+	  return (-2);
 
-        outptr = outval;
+	continue;
       }
-      else if (name[0] == '[')
+
+      text  = -1;
+      start = t->num_insts;
+
+      if (name[0] == '[')
       {
        /*
         * Loop for # of elements...
 	*/
 
-	int  i;		/* Looping var */
-        long pos;	/* File position */
-	int  count;	/* Number of elements */
+        if ((i = cgi_add_inst(t, _CGI_OP_LOOP)) < 0 ||
+	    (t->insts[i].text = cgi_add_string(t, name, strlen(name))) == (size_t)-1)
+	  return (-2);
 
+        t->insts[i].body = t->num_insts;
 
-        if (isdigit(name[1] & 255))
-	  count = atoi(name + 1);
-	else
-          count = cgiGetSize(name + 1);
-
-	pos = ftell(in);
+        if ((ch = cgi_compile(t, src, '}')) == -2)
+	  return (-2);
 
-        fprintf(stderr, "DEBUG2: %*sLooping on \"%s\" at %ld, count=%d...\n",
-	        indent, "", name + 1, pos, count);
-
-        if (count > 0)
-	{
-          for (i = 0; i < count; i ++)
-	  {
-	    if (i)
-	      fseek(in, pos, SEEK_SET);
+        t->insts[i].end = t->num_insts;
+        continue;
+      }
 
-	    cgi_copy(out, in, i, '}', indent + 2);
-	  }
-        }
-	else
-	  cgi_copy(NULL, in, 0, '}', indent + 2);
+     /*
+      * Simple substitution or test...
+      */
 
-        fprintf(stderr, "DEBUG2: %*sFinished looping on \"%s\"...\n", indent,
-	        "", name + 1);
+      if ((i = cgi_add_inst(t, ch == '}' ? _CGI_OP_VALUE : _CGI_OP_TEST)) < 0)
+        return (-2);
 
-        continue;
-      }
-      else if (name[0] == '$')
+      if (name[0] != '#' && name[0] != '$' &&
+          (nameptr = strrchr(name, '-')) != NULL && isdigit(nameptr[1] & 255))
       {
-       /*
-        * Insert cookie value or nothing if not defined.
-	*/
+        *nameptr++ = '\0';
 
-        if ((value = cgiGetCookie(name + 1)) != NULL)
-	  outptr = value;
-	else
-	{
-	  outval[0] = '\0';
-	  outptr    = outval;
-	}
+        t->insts[i].indexed = 1;
+	t->insts[i].index   = atoi(nameptr) - 1;
       }
-      else
-      {
-       /*
-        * Insert variable or variable name (if element is NULL)...
-	*/
 
-	if ((nameptr = strrchr(name, '-')) != NULL && isdigit(nameptr[1] & 255))
-	{
-	  *nameptr++ = '\0';
-	  if ((value = cgiGetArray(name, atoi(nameptr) - 1)) == NULL)
-          {
-	    snprintf(outval, sizeof(outval), "{%s}", name);
-	    outptr = outval;
-	  }
-	  else
-	    outptr = value;
-	}
-	else if ((value = cgiGetArray(name, element)) == NULL)
-        {
-	  snprintf(outval, sizeof(outval), "{%s}", name);
-	  outptr = outval;
-	}
-	else
-	  outptr = value;
-      }
-
-     /*
-      * See if the terminating character requires another test...
-      */
+      if ((t->insts[i].text = cgi_add_string(t, name, strlen(name))) == (size_t)-1)
+        return (-2);
 
       if (ch == '}')
       {
@@ -408,15 +532,12 @@ cgi_copy(FILE *out,			/* I - Output file */
         * End of substitution...
         */
 
-	if (out)
-	{
-	  if (uriencode)
-	    cgi_puturi(outptr, out);
-	  else if (!_cups_strcasecmp(name, "?cupsdconf_default"))
-	    fputs(outptr, stdout);
-	  else
-	    cgi_puts(outptr, out);
-        }
+        if (uriencode)
+	  t->insts[i].mode = _CGI_MODE_URI;
+	else if (!_cups_strcasecmp(name, "?cupsdconf_default"))
+	  t->insts[i].mode = _CGI_MODE_RAW;
+	else
+	  t->insts[i].mode = _CGI_MODE_HTML;
 
         continue;
       }
@@ -432,208 +553,346 @@ cgi_copy(FILE *out,			/* I - Output file */
       *   {name~refex?true:false}    Regex match
       */
 
-      op = (char)ch;
+      t->insts[i].mode = (char)ch;
 
-      if (ch == '?')
+      if (ch != '?')
       {
        /*
-        * Test for existance...
+        * Compile the comparison string...
 	*/
 
-        if (name[0] == '?')
-	  result = cgiGetArray(name + 1, element) != NULL;
-	else if (name[0] == '#')
-	  result = cgiGetVariable(name + 1) != NULL;
-        else
-          result = cgiGetArray(name, element) != NULL;
+        int	ctext = -1;		/* Current comparison text */
 
-	result     = result && outptr[0];
-	compare[0] = '\0';
-      }
-      else
-      {
-       /*
-        * Compare to a string...
-	*/
+        while ((ch = cgi_getc(src)) != EOF && ch != '?')
+	{
+	  if (ch == '#')
+	  {
+	    if (cgi_add_inst(t, _CGI_OP_CELEMENT) < 0)
+	      return (-2);
 
-	for (s = compare; (ch = getc(in)) != EOF;)
-          if (ch == '?')
-            break;
-	  else if (s >= (compare + sizeof(compare) - 1))
+	    ctext = -1;
 	    continue;
-	  else if (ch == '#')
-	  {
-	    sprintf(s, "%d", element + 1);
-	    s += strlen(s);
 	  }
 	  else if (ch == '{')
 	  {
 	   /*
-	    * Grab the value of a variable...
+	    * Grab the name of a variable...
 	    */
 
-	    innerptr = innername;
-	    while ((ch = getc(in)) != EOF && ch != '}')
-	      if (innerptr < (innername + sizeof(innername) - 1))
-	        *innerptr++ = (char)ch;
-	    *innerptr = '\0';
+            int	cv;			/* Comparison value instruction */
+
+	    for (s = name; (ch = cgi_getc(src)) != EOF && ch != '}';)
+	      if (s < (name + sizeof(name) - 1))
+	        *s++ = (char)ch;
+	    *s = '\0';
+
+            if ((cv = cgi_add_inst(t, _CGI_OP_CVALUE)) < 0)
+	      return (-2);
 
-            if (innername[0] == '#')
-	      sprintf(s, "%d", cgiGetSize(innername + 1));
-	    else if ((innerptr = strrchr(innername, '-')) != NULL &&
-	             isdigit(innerptr[1] & 255))
+            inst = t->insts + cv;
+
+            if (name[0] == '#')
+	      inst->mode = _CGI_LOOKUP_SIZE;
+	    else if ((nameptr = strrchr(name, '-')) != NULL &&
+	             isdigit(nameptr[1] & 255))
             {
-	      *innerptr++ = '\0';
-	      if ((innerval = cgiGetArray(innername, atoi(innerptr) - 1)) == NULL)
-	        *s = '\0';
-	      else
-	        strlcpy(s, innerval, sizeof(compare) - (size_t)(s - compare));
+	      *nameptr++ = '\0';
+
+	      inst->mode    = _CGI_LOOKUP_INDEX;
+	      inst->indexed = 1;
+	      inst->index   = atoi(nameptr) - 1;
 	    }
-	    else if (innername[0] == '?')
-	    {
-	      if ((innerval = cgiGetArray(innername + 1, element)) == NULL)
-		*s = '\0';
-	      else
-	        strlcpy(s, innerval, sizeof(compare) - (size_t)(s - compare));
-            }
-	    else if ((innerval = cgiGetArray(innername, element)) == NULL)
-	      snprintf(s, sizeof(compare) - (size_t)(s - compare), "{%s}", innername);
+	    else if (name[0] == '?')
+	      inst->mode = _CGI_LOOKUP_EXISTS;
 	    else
-	      strlcpy(s, innerval, sizeof(compare) - (size_t)(s - compare));
+	      inst->mode = _CGI_LOOKUP_ELEMENT;
 
-            s += strlen(s);
+            if ((inst->text = cgi_add_string(t, name, strlen(name))) == (size_t)-1)
+	      return (-2);
+
+	    ctext = -1;
+	    continue;
 	  }
           else if (ch == '\\')
-	    *s++ = (char)getc(in);
+	    c = (char)cgi_getc(src);
 	  else
-            *s++ = (char)ch;
+            c = (char)ch;
 
-        *s = '\0';
+          if ((ctext = cgi_add_text(t, ctext, _CGI_OP_CTEXT, &c, 1)) < 0)
+	    return (-2);
+	}
 
         if (ch != '?')
 	{
-	  fprintf(stderr,
-	          "DEBUG2: %*sBad terminator '%c' at file position %ld...\n",
-	          indent, "", ch, ftell(in));
-	  return;
-	}
+	 /*
+	  * Truncated test, drop it...
+	  */
 
-       /*
-        * Do the comparison...
-	*/
+	  fprintf(stderr, "DEBUG2: Bad terminator '%c' in template...\n", ch);
 
-        switch (op)
-	{
-	  case '<' :
-	      result = _cups_strcasecmp(outptr, compare) < 0;
-	      break;
-	  case '>' :
-	      result = _cups_strcasecmp(outptr, compare) > 0;
-	      break;
-	  case '=' :
-	      result = _cups_strcasecmp(outptr, compare) == 0;
-	      break;
-	  case '!' :
-	      result = _cups_strcasecmp(outptr, compare) != 0;
-	      break;
-	  case '~' :
-	      fprintf(stderr, "DEBUG: Regular expression \"%s\"\n", compare);
-
-	      if (regcomp(&re, compare, REG_EXTENDED | REG_ICASE))
-	      {
-	        fprintf(stderr,
-		        "ERROR: Unable to compile regular expression \"%s\"!\n",
-			compare);
-		result = 0;
-	      }
-	      else
-	      {
-	        regmatch_t matches[10];
-
-		result = 0;
-
-	        if (!regexec(&re, outptr, 10, matches, 0))
-		{
-		  int i;
-		  for (i = 0; i < 10; i ++)
-		  {
-		    fprintf(stderr, "DEBUG: matches[%d].rm_so=%d\n", i,
-		            (int)matches[i].rm_so);
-		    if (matches[i].rm_so < 0)
-		      break;
-
-		    result ++;
-		  }
-		}
-
-		regfree(&re);
-	      }
-	      break;
-	  default :
-	      result = 1;
-	      break;
+          t->num_insts = start;
+	  return (EOF);
 	}
       }
 
-      fprintf(stderr,
-              "DEBUG2: %*sStarting \"{%s%c%s\" at %ld, result=%d...\n",
-	      indent, "", name, op, compare, ftell(in), result);
+     /*
+      * Compile the true and false parts...
+      */
 
-      if (result)
-      {
-       /*
-	* Comparison true; output first part and ignore second...
-	*/
+      t->insts[i].body = t->num_insts;
 
-        fprintf(stderr, "DEBUG2: %*sOutput first part...\n", indent, "");
-	cgi_copy(out, in, element, ':', indent + 2);
+      if (cgi_compile(t, src, ':') == -2)
+        return (-2);
 
-        fprintf(stderr, "DEBUG2: %*sSkip second part...\n", indent, "");
-	cgi_copy(NULL, in, element, '}', indent + 2);
-      }
-      else
-      {
-       /*
-	* Comparison false; ignore first part and output second...
-	*/
+      t->insts[i].alt = t->num_insts;
 
-        fprintf(stderr, "DEBUG2: %*sSkip first part...\n", indent, "");
-	cgi_copy(NULL, in, element, ':', indent + 2);
+      if ((ch = cgi_compile(t, src, '}')) == -2)
+        return (-2);
 
-        fprintf(stderr, "DEBUG2: %*sOutput second part...\n", indent, "");
-	cgi_copy(out, in, element, '}', indent + 2);
+      t->insts[i].end = t->num_insts;
+    }
+    else
+    {
+      if (ch == '\\')			/* Quoted char */
+      {
+        if ((ch = cgi_getc(src)) == EOF)
+	  break;
       }
 
-      fprintf(stderr, "DEBUG2: %*sFinished \"{%s%c%s\", out=%p...\n", indent, "",
-              name, op, compare, out);
+      c = (char)ch;
+
+      if ((text = cgi_add_text(t, text, _CGI_OP_TEXT, &c, 1)) < 0)
+        return (-2);
     }
-    else if (ch == '\\')	/* Quoted char */
+
+  if (ch == EOF && term)
+    fprintf(stderr, "ERROR: Saw EOF, expected '%c'!\n", term);
+
+  return (ch);
+}
+
+
+/*
+ * 'cgi_copy()' - Render instructions, substituting as needed...
+ */
+
+static void
+cgi_copy(_cgi_tmpl_t *t,		/* I - Template */
+         int         first,		/* I - First instruction */
+	 int         last,		/* I - Last instruction + 1 */
+	 int         element,		/* I - Element number (0 to N) */
+	 _cgi_out_t  *out)		/* I - Output buffer */
+{
+  int		i, j,		/* Looping vars */
+		count;			/* Number of elements */
+  _cgi_inst_t	*inst;			/* Current instruction */
+  const char	*name,			/* Name of variable */
+		*value;			/* Value of variable */
+  char		outval[1024];		/* Formatted output string */
+
+
+  for (i = first; i < last; i = inst->end)
+  {
+    inst = t->insts + i;
+
+    switch (inst->op)
     {
-      if (out)
-        putc(getc(in), out);
-      else
-        getc(in);
+      case _CGI_OP_TEXT :
+          cgi_put(out, t->pool + inst->text, inst->length);
+	  break;
+
+      case _CGI_OP_VALUE :
+          value = cgi_value(t, inst, element, outval, sizeof(outval));
+
+	  if (inst->mode == _CGI_MODE_URI)
+	    cgi_puturi(value, out);
+	  else if (inst->mode == _CGI_MODE_HTML)
+	    cgi_puts(value, out);
+	  else if (out->fp == stdout)
+	    cgi_put(out, value, strlen(value));
+	  else
+	    fputs(value, stdout);
+	  break;
+
+      case _CGI_OP_LOOP :
+          name = t->pool + inst->text;
+
+	  if (isdigit(name[1] & 255))
+	    count = atoi(name + 1);
+	  else
+	    count = cgiGetSize(name + 1);
+
+	  for (j = 0; j < count; j ++)
+	    cgi_copy(t, inst->body, inst->end, j, out);
+	  break;
+
+      case _CGI_OP_TEST :
+          value = cgi_value(t, inst, element, outval, sizeof(outval));
+
+          if (cgi_test(t, inst, element, value))
+	    cgi_copy(t, inst->body, inst->alt, element, out);
+	  else
+	    cgi_copy(t, inst->alt, inst->end, element, out);
+	  break;
+
+      default :
+          break;
     }
-    else if (out)
-      putc(ch, out);
+  }
+}
 
-  if (ch == EOF)
-    fprintf(stderr, "DEBUG2: %*sReturning at file position %ld on EOF...\n",
-	    indent, "", ftell(in));
-  else
-    fprintf(stderr,
-            "DEBUG2: %*sReturning at file position %ld on character '%c'...\n",
-	    indent, "", ftell(in), ch);
 
-  if (ch == EOF && term)
-    fprintf(stderr, "ERROR: %*sSaw EOF, expected '%c'!\n", indent, "", term);
+/*
+ * 'cgi_free_template()' - Free a compiled template.
+ */
+
+static void
+cgi_free_template(_cgi_tmpl_t *t)	/* I - Template */
+{
+  free(t->filename);
+  free(t->pool);
+  free(t->insts);
+  free(t);
+}
+
+
+/*
+ * 'cgi_get_template()' - Get a compiled template, loading it as needed.
+ */
+
+static _cgi_tmpl_t *			/* O - Template or NULL on error */
+cgi_get_template(const char *filename)	/* I - Template filename */
+{
+  _cgi_tmpl_t	key,			/* Search key */
+		*t;			/* Template */
+  struct stat	fileinfo;		/* File information */
+  FILE		*fp;			/* Template file */
+  char		*data;			/* File contents */
+  size_t	bytes;			/* Bytes read */
+  _cgi_src_t	src;			/* Template source */
+  int		error;			/* Error code */
+
 
  /*
-  * Flush any pending output...
+  * See if we have an up-to-date copy of the template...
   */
 
-  if (out)
-    fflush(out);
+  if (stat(filename, &fileinfo))
+    return (NULL);
+
+  if (!cgi_templates)
+    cgi_templates = cupsArrayNew((cups_array_func_t)cgi_compare_templates,
+                                 NULL);
+
+  key.filename = (char *)filename;
+
+  if ((t = (_cgi_tmpl_t *)cupsArrayFind(cgi_templates, &key)) != NULL)
+  {
+    if (t->mtime == fileinfo.st_mtime && t->size == fileinfo.st_size)
+      return (t);
+
+    cupsArrayRemove(cgi_templates, t);
+    cgi_free_template(t);
+  }
+
+ /*
+  * Read the template file...
+  */
+
+  if ((fp = fopen(filename, "r")) == NULL)
+    return (NULL);
+
+  if (fstat(fileno(fp), &fileinfo) ||
+      (data = malloc((size_t)fileinfo.st_size + 1)) == NULL)
+  {
+    error = errno;
+    fclose(fp);
+    errno = error;
+    return (NULL);
+  }
+
+  bytes = fread(data, 1, (size_t)fileinfo.st_size, fp);
+  fclose(fp);
+
+ /*
+  * Compile it...
+  */
+
+  if ((t = calloc(1, sizeof(_cgi_tmpl_t))) == NULL ||
+      (t->filename = strdup(filename)) == NULL)
+  {
+    free(t);
+    free(data);
+    errno = ENOMEM;
+    return (NULL);
+  }
+
+  t->mtime = fileinfo.st_mtime;
+  t->size  = fileinfo.st_size;
+
+  src.ptr = data;
+  src.end = data + bytes;
+
+  error = cgi_compile(t, &src, 0) == -2;
+
+  free(data);
+
+  if (error)
+  {
+    cgi_free_template(t);
+    errno = ENOMEM;
+    return (NULL);
+  }
+
+  fprintf(stderr, "DEBUG2: Compiled template \"%s\" into %d instructions.\n",
+          filename, t->num_insts);
+
+  cupsArrayAdd(cgi_templates, t);
+
+  return (t);
+}
+
+
+/*
+ * 'cgi_getc()' - Get a character from the template source.
+ */
+
+static int				/* O - Character or EOF */
+cgi_getc(_cgi_src_t *src)		/* I - Template source */
+{
+  if (src->ptr < src->end)
+    return (*(src->ptr)++ & 255);
+  else
+    return (EOF);
+}
+
+
+/*
+ * 'cgi_put()' - Write bytes to the output buffer.
+ */
+
+static void
+cgi_put(_cgi_out_t *out,		/* I - Output buffer */
+        const char *s,			/* I - Bytes to write */
+	size_t     len)			/* I - Number of bytes */
+{
+  if ((out->used + len) > sizeof(out->buffer))
+  {
+    if (out->used)
+    {
+      fwrite(out->buffer, 1, out->used, out->fp);
+      out->used = 0;
+    }
+
+    if (len > sizeof(out->buffer))
+    {
+      fwrite(s, 1, len, out->fp);
+      return;
+    }
+  }
+
+  memcpy(out->buffer + out->used, s, len);
+  out->used += len;
 }
 
 
@@ -643,22 +902,30 @@ cgi_copy(FILE *out,			/* I - Output file */
 
 static void
 cgi_puts(const char *s,			/* I - String to output */
-         FILE       *out)		/* I - Output file */
+         _cgi_out_t *out)		/* I - Output buffer */
 {
+  size_t	len;			/* Length of unquoted text */
+
+
   while (*s)
   {
+    if ((len = strcspn(s, "<>\"\'&")) > 0)
+    {
+      cgi_put(out, s, len);
+      s += len;
+      continue;
+    }
+
     if (*s == '<')
-      fputs("&lt;", out);
+      cgi_put(out, "&lt;", 4);
     else if (*s == '>')
-      fputs("&gt;", out);
+      cgi_put(out, "&gt;", 4);
     else if (*s == '\"')
-      fputs("&quot;", out);
+      cgi_put(out, "&quot;", 6);
     else if (*s == '\'')
-      fputs("&#39;", out);
-    else if (*s == '&')
-      fputs("&amp;", out);
+      cgi_put(out, "&#39;", 5);
     else
-      putc(*s, out);
+      cgi_put(out, "&amp;", 5);
 
     s ++;
   }
@@ -671,20 +938,288 @@ cgi_puts(const char *s,			/* I - String to output */
 
 static void
 cgi_puturi(const char *s,		/* I - String to output */
-           FILE       *out)		/* I - Output file */
+           _cgi_out_t *out)		/* I - Output buffer */
 {
+  char	hex[3];				/* Encoded character */
+  static const char *hexchars = "0123456789ABCDEF";
+					/* Hex digits */
+
+
   while (*s)
   {
     if (strchr("%@&+ <>#=", *s) || *s < ' ' || *s & 128)
-      fprintf(out, "%%%02X", *s & 255);
+    {
+      hex[0] = '%';
+      hex[1] = hexchars[(*s >> 4) & 15];
+      hex[2] = hexchars[*s & 15];
+
+      cgi_put(out, hex, 3);
+    }
     else
-      putc(*s, out);
+      cgi_put(out, s, 1);
 
     s ++;
   }
 }
 
 
+/*
+ * 'cgi_render()' - Render a compiled template to a file.
+ */
+
+static void
+cgi_render(FILE        *out,		/* I - Output file */
+           _cgi_tmpl_t *t)		/* I - Template */
+{
+  _cgi_out_t	*buf;			/* Output buffer */
+
+
+  if ((buf = malloc(sizeof(_cgi_out_t))) == NULL)
+    return;
+
+  buf->fp   = out;
+  buf->used = 0;
+
+  cgi_copy(t, 0, t->num_insts, 0, buf);
+
+  if (buf->used)
+    fwrite(buf->buffer, 1, buf->used, out);
+
+  fflush(out);
+  free(buf);
+}
+
+
+/*
+ * 'cgi_test()' - Evaluate a {name?true:false} test.
+ */
+
+static int				/* O - 1 if true, 0 if false */
+cgi_test(_cgi_tmpl_t *t,		/* I - Template */
+         _cgi_inst_t *inst,		/* I - Test instruction */
+	 int         element,		/* I - Element number (0 to N) */
+	 const char  *value)		/* I - Value of variable */
+{
+  int		i,			/* Looping var */
+		result;			/* Result of comparison */
+  _cgi_inst_t	*cinst;			/* Comparison instruction */
+  const char	*name,			/* Name of variable */
+		*innerval;		/* Inner value */
+  char		compare[1024],		/* Comparison string */
+		*s;			/* Pointer into comparison string */
+  size_t	len;			/* Length of text */
+  regex_t	re;			/* Regular expression to match */
+
+
+  name = t->pool + inst->text;
+
+  if (inst->mode == '?')
+  {
+   /*
+    * Test for existance...
+    */
+
+    if (name[0] == '?')
+      result = cgiGetArray(name + 1, element) != NULL;
+    else if (name[0] == '#')
+      result = cgiGetVariable(name + 1) != NULL;
+    else
+      result = cgiGetArray(name, element) != NULL;
+
+    return (result && value[0]);
+  }
+
+ /*
+  * Build the comparison string...
+  */
+
+  for (i = (int)(inst - t->insts) + 1, s = compare; i < inst->body; i ++)
+  {
+    if (s >= (compare + sizeof(compare) - 1))
+      break;
+
+    cinst = t->insts + i;
+
+    switch (cinst->op)
+    {
+      case _CGI_OP_CTEXT :
+          if ((len = cinst->length) > (size_t)(compare + sizeof(compare) - 1 - s))
+	    len = (size_t)(compare + sizeof(compare) - 1 - s);
+
+          memcpy(s, t->pool + cinst->text, len);
+	  s += len;
+	  break;
+
+      case _CGI_OP_CELEMENT :
+          snprintf(s, sizeof(compare) - (size_t)(s - compare), "%d",
+	           element + 1);
+	  s += strlen(s);
+	  break;
+
+      case _CGI_OP_CVALUE :
+          name = t->pool + cinst->text;
+
+          switch (cinst->mode)
+	  {
+	    case _CGI_LOOKUP_SIZE :
+	        snprintf(s, sizeof(compare) - (size_t)(s - compare), "%d",
+		         cgiGetSize(name + 1));
+		break;
+
+	    case _CGI_LOOKUP_INDEX :
+	        if ((innerval = cgiGetArray(name, cinst->index)) == NULL)
+		  *s = '\0';
+		else
+		  strlcpy(s, innerval, sizeof(compare) - (size_t)(s - compare));
+		break;
+
+	    case _CGI_LOOKUP_EXISTS :
+	        if ((innerval = cgiGetArray(name + 1, element)) == NULL)
+		  *s = '\0';
+		else
+		  strlcpy(s, innerval, sizeof(compare) - (size_t)(s - compare));
+		break;
+
+	    default :
+	        if ((innerval = cgiGetArray(name, element)) == NULL)
+		  snprintf(s, sizeof(compare) - (size_t)(s - compare), "{%s}",
+		           name);
+		else
+		  strlcpy(s, innerval, sizeof(compare) - (size_t)(s - compare));
+		break;
+	  }
+
+	  s += strlen(s);
+	  break;
+
+      default :
+          break;
+    }
+  }
+
+  *s = '\0';
+
+ /*
+  * Do the comparison...
+  */
+
+  switch (inst->mode)
+  {
+    case '<' :
+	result = _cups_strcasecmp(value, compare) < 0;
+	break;
+    case '>' :
+	result = _cups_strcasecmp(value, compare) > 0;
+	break;
+    case '=' :
+	result = _cups_strcasecmp(value, compare) == 0;
+	break;
+    case '!' :
+	result = _cups_strcasecmp(value, compare) != 0;
+	break;
+    case '~' :
+	fprintf(stderr, "DEBUG: Regular expression \"%s\"\n", compare);
+
+	if (regcomp(&re, compare, REG_EXTENDED | REG_ICASE))
+	{
+	  fprintf(stderr,
+		  "ERROR: Unable to compile regular expression \"%s\"!\n",
+		  compare);
+	  result = 0;
+	}
+	else
+	{
+	  regmatch_t matches[10];
+
+	  result = 0;
+
+	  if (!regexec(&re, value, 10, matches, 0))
+	  {
+	    for (i = 0; i < 10; i ++)
+	    {
+	      fprintf(stderr, "DEBUG: matches[%d].rm_so=%d\n", i,
+		      (int)matches[i].rm_so);
+	      if (matches[i].rm_so < 0)
+		break;
+
+	      result ++;
+	    }
+	  }
+
+	  regfree(&re);
+	}
+	break;
+    default :
+	result = 1;
+	break;
+  }
+
+  return (result);
+}
+
+
+/*
+ * 'cgi_value()' - Get the value for a {name} substitution or test.
+ */
+
+static const char *			/* O - Value */
+cgi_value(_cgi_tmpl_t *t,		/* I - Template */
+          _cgi_inst_t *inst,		/* I - Instruction */
+	  int         element,		/* I - Element number (0 to N) */
+	  char        *buffer,		/* I - Buffer for formatted values */
+	  size_t      bufsize)		/* I - Size of buffer */
+{
+  const char	*name,			/* Name of variable */
+		*value;			/* Value of variable */
+
+
+  name = t->pool + inst->text;
+
+  if (name[0] == '?')
+  {
+   /*
+    * Insert value only if it exists...
+    */
+
+    if ((value = cgiGetArray(name + 1, inst->indexed ? inst->index : element)) == NULL)
+      value = "";
+  }
+  else if (name[0] == '#')
+  {
+   /*
+    * Insert count...
+    */
+
+    if (name[1])
+      snprintf(buffer, bufsize, "%d", cgiGetSize(name + 1));
+    else
+      snprintf(buffer, bufsize, "%d", element + 1);
+
+    value = buffer;
+  }
+  else if (name[0] == '$')
+  {
+   /*
+    * Insert cookie value or nothing if not defined.
+    */
+
+    if ((value = cgiGetCookie(name + 1)) == NULL)
+      value = "";
+  }
+  else if ((value = cgiGetArray(name, inst->indexed ? inst->index : element)) == NULL)
+  {
+   /*
+    * Insert variable name if not defined...
+    */
+
+    snprintf(buffer, bufsize, "{%s}", name);
+    value = buffer;
+  }
+
+  return (value);
+}
+
+
 /*
  * End of "$Id: template.c 12700 2015-06-08 18:32:35Z msweet $".
  */
@@ -15,6 +15,7 @@
  * Contents:
  *
  *   main()       - Test the help index code.
+ *   benchmark()  - Time index building, loading, and searching.
  *   list_nodes() - List nodes in an array...
  */
 
@@ -23,12 +24,15 @@
  */
 
 #include "cgi.h"
+#include <sys/time.h>
 
 
 /*
  * Local functions...
  */
 
+static int	benchmark(const char *hifile, const char *directory,
+		          const char *query, int repeat);
 static void	list_nodes(const char *title, cups_array_t *nodes);
 
 
@@ -40,15 +44,39 @@ int					/* O - Exit status */
 main(int  argc,				/* I - Number of command-line arguments */
      char *argv[])			/* I - Command-line arguments */
 {
+  int		i;			/* Looping var */
   help_index_t	*hi,			/* Help index */
 		*search;		/* Search index */
+  const char	*directory = ".",	/* Directory to index */
+		*query = NULL,		/* Search query */
+		*filename = NULL;	/* Limit search to this file */
+  int		repeat = 0;		/* Number of benchmark iterations */
+
+
+ /*
+  * Parse command-line...
+  */
+
+  for (i = 1; i < argc; i ++)
+  {
+    if (!strcmp(argv[i], "-b") && (i + 1) < argc)
+      repeat = atoi(argv[++ i]);
+    else if (!strcmp(argv[i], "-d") && (i + 1) < argc)
+      directory = argv[++ i];
+    else if (!query)
+      query = argv[i];
+    else
+      filename = argv[i];
+  }
 
+  if (repeat > 0)
+    return (benchmark("testhi.index", directory, query, repeat));
 
  /*
   * Load the help index...
   */
 
-  hi = helpLoadIndex("testhi.index", ".");
+  hi = helpLoadIndex("testhi.index", directory);
 
   list_nodes("nodes", hi->nodes);
   list_nodes("sorted", hi->sorted);
@@ -57,17 +85,17 @@ main(int  argc,				/* I - Number of command-line arguments */
   * Do any searches...
   */
 
-  if (argc > 1)
+  if (query)
   {
-    search = helpSearchIndex(hi, argv[1], NULL, argv[2]);
+    search = helpSearchIndex(hi, query, NULL, filename);
 
     if (search)
     {
-      list_nodes(argv[1], search->sorted);
+      list_nodes(query, search->sorted);
       helpDeleteIndex(search);
     }
     else
-      printf("%s (0 nodes)\n", argv[1]);
+      printf("%s (0 nodes)\n", query);
   }
 
   helpDeleteIndex(hi);
@@ -80,6 +108,87 @@ main(int  argc,				/* I - Number of command-line arguments */
 }
 
 
+/*
+ * 'benchmark()' - Time index building, loading, and searching.
+ */
+
+static int				/* O - Exit status */
+benchmark(const char *hifile,		/* I - Index filename */
+          const char *directory,	/* I - Directory to index */
+	  const char *query,		/* I - Search query or NULL */
+	  int        repeat)		/* I - Number of iterations */
+{
+  int			i;		/* Looping var */
+  help_index_t		*hi,		/* Help index */
+			*search;	/* Search index */
+  int			matches = 0;	/* Number of matching nodes */
+  struct timeval	start,		/* Start time */
+			end;		/* End time */
+  double		secs;		/* Elapsed time */
+
+
+ /*
+  * Build the index from scratch...
+  */
+
+  unlink(hifile);
+
+  gettimeofday(&start, NULL);
+  if ((hi = helpLoadIndex(hifile, directory)) == NULL)
+  {
+    printf("helpLoadIndex(\"%s\", \"%s\") failed.\n", hifile, directory);
+    return (1);
+  }
+  gettimeofday(&end, NULL);
+
+  secs = end.tv_sec - start.tv_sec + 0.000001 * (end.tv_usec - start.tv_usec);
+  printf("build: %.3fms (%d nodes)\n", 1000.0 * secs,
+         cupsArrayCount(hi->nodes));
+
+  helpDeleteIndex(hi);
+
+ /*
+  * Load the up-to-date index...
+  */
+
+  gettimeofday(&start, NULL);
+  for (i = 0; i < repeat; i ++)
+    helpDeleteIndex(helpLoadIndex(hifile, directory));
+  gettimeofday(&end, NULL);
+
+  secs = end.tv_sec - start.tv_sec + 0.000001 * (end.tv_usec - start.tv_usec);
+  printf("load: %.3fms\n", 1000.0 * secs / repeat);
+
+ /*
+  * Search the index...
+  */
+
+  if (query)
+  {
+    hi = helpLoadIndex(hifile, directory);
+
+    gettimeofday(&start, NULL);
+    for (i = 0; i < repeat; i ++)
+    {
+      if ((search = helpSearchIndex(hi, query, NULL, NULL)) != NULL)
+      {
+        matches = cupsArrayCount(search->nodes);
+	helpDeleteIndex(search);
+      }
+    }
+    gettimeofday(&end, NULL);
+
+    secs = end.tv_sec - start.tv_sec + 0.000001 * (end.tv_usec - start.tv_usec);
+    printf("search \"%s\": %.3fms (%d nodes)\n", query,
+           1000.0 * secs / repeat, matches);
+
+    helpDeleteIndex(hi);
+  }
+
+  return (0);
+}
+
+
 /*
  * 'list_nodes()' - List nodes in an array...
  */
@@ -103,7 +212,10 @@ list_nodes(const char   *title,		/* I - Title string */
     else
       printf("    %d: %s \"%s\"", i, node->filename, node->text);
 
-    printf(" (%d words)\n", cupsArrayCount(node->words));
+    if (node->words)
+      printf(" (%d words)\n", cupsArrayCount(node->words));
+    else
+      putchar('\n');
   }
 }
 
@@ -22,6 +22,7 @@
  */
 
 #include "cgi.h"
+#include <sys/time.h>
 
 
 /*
@@ -32,9 +33,11 @@ int					/* O - Exit status */
 main(int  argc,				/* I - Number of command-line arguments */
      char *argv[])			/* I - Command-line arguments */
 {
-  int	i;				/* Looping var */
+  int	i, j;			/* Looping vars */
   char	*value;				/* Value in name=value */
   FILE	*out;				/* Where to send output */
+  int	count = 1,			/* Number of array elements */
+	repeat = 0;			/* Number of benchmark renders */
 
 
  /*
@@ -79,12 +82,77 @@ main(int  argc,				/* I - Number of command-line arguments */
 	}
       }
     }
+    else if (!strcmp(argv[i], "-b"))
+    {
+      i ++;
+
+      if (i < argc)
+        repeat = atoi(argv[i]);
+    }
+    else if (!strcmp(argv[i], "-n"))
+    {
+      i ++;
+
+      if (i < argc)
+        count = atoi(argv[i]);
+    }
     else if (!strcmp(argv[i], "-q"))
       freopen("/dev/null", "w", stderr);
     else if ((value = strchr(argv[i], '=')) != NULL)
     {
       *value++ = '\0';
-      cgiSetVariable(argv[i], value);
+
+      if (count > 1)
+      {
+        for (j = 0; j < count; j ++)
+	  cgiSetArray(argv[i], j, value);
+      }
+      else
+        cgiSetVariable(argv[i], value);
+    }
+    else if (repeat > 0)
+    {
+     /*
+      * Benchmark the template, separating the first (compile) pass from the
+      * cached passes...
+      */
+
+      FILE		*null;		/* Benchmark output */
+      struct timeval	start,		/* Start time */
+			first,		/* End of first render */
+			end;		/* End time */
+      double		firsttime,	/* Time for first render */
+			secs;		/* Time for remaining renders */
+
+      if ((null = fopen("/dev/null", "w")) == NULL)
+      {
+        perror("/dev/null");
+	return (1);
+      }
+
+      gettimeofday(&start, NULL);
+
+      cgiCopyTemplateFile(null, argv[i]);
+
+      gettimeofday(&first, NULL);
+
+      for (j = 1; j < repeat; j ++)
+        cgiCopyTemplateFile(null, argv[i]);
+
+      gettimeofday(&end, NULL);
+
+      fclose(null);
+
+      firsttime = first.tv_sec - start.tv_sec +
+                  0.000001 * (first.tv_usec - start.tv_usec);
+      secs      = end.tv_sec - first.tv_sec +
+                  0.000001 * (end.tv_usec - first.tv_usec);
+
+      printf("%s: first render %.3fms", argv[i], 1000.0 * firsttime);
+      if (repeat > 1)
+        printf(", %d more at %.3fms each", repeat - 1,
+	       1000.0 * secs / (repeat - 1));
+      putchar('\n');
     }
     else
       cgiCopyTemplateFile(out, argv[i]);
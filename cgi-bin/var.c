@@ -21,6 +21,8 @@
 #include "cgi-private.h"
 #include <cups/http.h>
 #include <cups/md5-private.h>
+#include <fcntl.h>
+#include <sys/socket.h>
 
 
 /*
@@ -30,6 +32,14 @@
 #define CUPS_SID	"org.cups.sid"
 
 
+/*
+ * Persistent worker channel...
+ */
+
+#define CGI_WORKER_FD	3		/* Request channel from cupsd */
+#define CGI_WORKER_MAX	262144		/* Maximum size of request environment */
+
+
 /*
  * Data structure to hold all the CGI form variables and arrays...
  */
@@ -55,6 +65,8 @@ static _cgi_var_t	*form_vars = NULL;
 					/* Form variables */
 static cgi_file_t	*form_file = NULL;
 					/* Uploaded file */
+static int		cgi_worker = -1;/* Running as a persistent worker? */
+static char		*cgi_env = NULL;/* Environment of current request */
 
 
 /*
@@ -66,17 +78,76 @@ static void		cgi_add_variable(const char *name, int element,
 static int		cgi_compare_variables(const _cgi_var_t *v1,
 			                      const _cgi_var_t *v2);
 static _cgi_var_t	*cgi_find_variable(const char *name);
+static void		cgi_end_request(void);
 static void		cgi_initialize_cookies(void);
 static int		cgi_initialize_get(void);
 static int		cgi_initialize_multipart(const char *boundary);
 static int		cgi_initialize_post(void);
 static int		cgi_initialize_string(const char *data);
 static const char	*cgi_passwd(const char *prompt);
+static int		cgi_read_request(void);
 static const char	*cgi_set_sid(void);
 static void		cgi_sort_variables(void);
 static void		cgi_unlink_file(void);
 
 
+/*
+ * 'cgiAcceptRequest()' - Wait for the next request to process.
+ *
+ * CGI programs call this function in a loop around their request handling.
+ * A normal CGI program gets a single request.  When cupsd runs the program
+ * as a persistent worker, this function finishes the previous request and
+ * waits for the next one, returning 0 when cupsd closes the worker channel.
+ */
+
+int					/* O - 1 if a request is ready, 0 to exit */
+cgiAcceptRequest(void)
+{
+  int	flags;				/* Channel flags */
+
+
+  if (cgi_worker < 0)
+  {
+   /*
+    * First call, see if we have been started as a worker...
+    */
+
+    if (getenv("CUPS_CGI_WORKER") &&
+        (flags = fcntl(CGI_WORKER_FD, F_GETFL)) >= 0)
+    {
+      fcntl(CGI_WORKER_FD, F_SETFL, flags & ~O_NONBLOCK);
+      fcntl(CGI_WORKER_FD, F_SETFD, FD_CLOEXEC);
+
+      cgi_worker = 1;
+    }
+    else
+    {
+      cgi_worker = 0;
+      return (1);
+    }
+  }
+  else if (!cgi_worker)
+  {
+   /*
+    * Normal CGI programs only process a single request...
+    */
+
+    _cgiResetIPPState(0);
+    return (0);
+  }
+  else
+    cgi_end_request();
+
+  if (!cgi_read_request())
+  {
+    _cgiResetIPPState(0);
+    return (0);
+  }
+
+  return (1);
+}
+
+
 /*
  * 'cgiCheckVariables()' - Check for the presence of "required" variables.
  *
@@ -146,6 +217,8 @@ cgiClearVariables(void)
     for (j = 0; j < v->nvalues; j ++)
       if (v->values[j])
         _cupsStrFree(v->values[j]);
+
+    free(v->values);
   }
 
   form_count = 0;
@@ -588,6 +661,63 @@ cgi_compare_variables(
 }
 
 
+/*
+ * 'cgi_end_request()' - Finish the current worker request.
+ */
+
+static void
+cgi_end_request(void)
+{
+  int	fd;				/* /dev/null */
+
+
+ /*
+  * Send any buffered output and discard unread form data...
+  */
+
+  fflush(stdout);
+
+  while (getchar() != EOF);
+
+ /*
+  * Close our copies of the request pipes so cupsd sees the end of the
+  * response...
+  */
+
+  if ((fd = open("/dev/null", O_RDWR)) >= 0)
+  {
+    dup2(fd, 0);
+    dup2(fd, 1);
+
+    if (fd > 1)
+      close(fd);
+  }
+
+  clearerr(stdin);
+  clearerr(stdout);
+
+ /*
+  * Reset the per-request state...
+  */
+
+  cgiClearVariables();
+
+  cupsFreeOptions(num_cookies, cookies);
+  num_cookies = 0;
+  cookies     = NULL;
+
+  _cgiResetIPPState(1);
+
+ /*
+  * Tell cupsd we are ready for another request...
+  */
+
+  if (write(CGI_WORKER_FD, "R", 1) < 1)
+    fprintf(stderr, "DEBUG: Unable to signal end of request: %s\n",
+            strerror(errno));
+}
+
+
 /*
  * 'cgi_find_variable()' - Find a variable.
  */
@@ -761,6 +891,7 @@ cgi_initialize_multipart(
   int		ch,			/* Character from file */
 		fd;			/* Temporary file descriptor */
   size_t	blen;			/* Length of boundary string */
+  static int	registered = 0;		/* Cleanup function registered? */
 
 
   DEBUG_printf(("cgi_initialize_multipart(boundary=\"%s\")\n", boundary));
@@ -815,7 +946,11 @@ cgi_initialize_multipart(
         if (fd < 0)
 	  return (0);
 
-        atexit(cgi_unlink_file);
+        if (!registered)
+	{
+	  atexit(cgi_unlink_file);
+	  registered = 1;
+	}
 
        /*
         * Copy file data to the temp file...
@@ -1197,6 +1332,148 @@ cgi_passwd(const char *prompt)		/* I - Prompt (not used) */
 }
 
 
+/*
+ * 'cgi_read_request()' - Read the next request from cupsd.
+ *
+ * Each request is a length, the standard input and output file descriptors,
+ * and the nul-separated "name=value" strings for the environment.
+ */
+
+static int				/* O - 1 on success, 0 on end-of-file */
+cgi_read_request(void)
+{
+  unsigned	length;			/* Length of environment */
+  ssize_t	bytes;			/* Bytes read */
+  size_t	total;			/* Total bytes read */
+  int		fds[2];			/* Standard input and output */
+  char		*env,			/* New environment */
+		*ptr,			/* Pointer into environment */
+		*end,			/* End of environment */
+		name[256];		/* Variable name */
+  struct iovec	iov;			/* I/O vector for length */
+  struct msghdr	msg;			/* Message header */
+  struct cmsghdr *cmsg;			/* Control message */
+  union
+  {
+    struct cmsghdr	hdr;		/* Alignment */
+    char		buf[CMSG_SPACE(2 * sizeof(int))];
+					/* Control buffer */
+  }		control;		/* Control message buffer */
+
+
+ /*
+  * Read the length and file descriptors...
+  */
+
+  fds[0] = fds[1] = -1;
+
+  iov.iov_base = &length;
+  iov.iov_len  = sizeof(length);
+
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov        = &iov;
+  msg.msg_iovlen     = 1;
+  msg.msg_control    = control.buf;
+  msg.msg_controllen = sizeof(control.buf);
+
+  while ((bytes = recvmsg(CGI_WORKER_FD, &msg, 0)) < 0 && errno == EINTR);
+
+  if (bytes <= 0)
+    return (0);
+
+  for (cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg))
+    if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS &&
+        cmsg->cmsg_len == CMSG_LEN(2 * sizeof(int)))
+      memcpy(fds, CMSG_DATA(cmsg), sizeof(fds));
+
+  for (total = (size_t)bytes; total < sizeof(length); total += (size_t)bytes)
+    if ((bytes = read(CGI_WORKER_FD, (char *)&length + total,
+                      sizeof(length) - total)) <= 0)
+    {
+      if (bytes < 0 && errno == EINTR)
+      {
+        bytes = 0;
+        continue;
+      }
+
+      break;
+    }
+
+  if (total < sizeof(length) || fds[0] < 0 || fds[1] < 0 || length == 0 ||
+      length > CGI_WORKER_MAX || (env = malloc(length + 1)) == NULL)
+  {
+    fputs("ERROR: Bad request from cupsd.\n", stderr);
+
+    if (fds[0] >= 0)
+      close(fds[0]);
+    if (fds[1] >= 0)
+      close(fds[1]);
+
+    return (0);
+  }
+
+ /*
+  * Read the environment...
+  */
+
+  for (total = 0; total < length; total += (size_t)bytes)
+    if ((bytes = read(CGI_WORKER_FD, env + total, length - total)) <= 0)
+    {
+      if (bytes < 0 && errno == EINTR)
+      {
+        bytes = 0;
+        continue;
+      }
+
+      free(env);
+      close(fds[0]);
+      close(fds[1]);
+
+      return (0);
+    }
+
+  env[length] = '\0';
+
+ /*
+  * Attach the request to standard input and output...
+  */
+
+  dup2(fds[0], 0);
+  dup2(fds[1], 1);
+  close(fds[0]);
+  close(fds[1]);
+
+ /*
+  * Replace the environment from the previous request; putenv() uses our
+  * strings directly, so the old block is freed only after it is removed...
+  */
+
+  if (cgi_env)
+  {
+    for (ptr = cgi_env; *ptr; ptr += strlen(ptr) + 1)
+    {
+      strlcpy(name, ptr, sizeof(name));
+
+      if ((end = strchr(name, '=')) != NULL)
+      {
+        *end = '\0';
+        unsetenv(name);
+      }
+    }
+
+    free(cgi_env);
+  }
+
+  for (ptr = env, end = env + length; ptr < end && *ptr; ptr += strlen(ptr) + 1)
+    if (strchr(ptr, '='))
+      putenv(ptr);
+
+  cgi_env = env;
+
+  return (1);
+}
+
+
 /*
  * 'cgi_set_sid()' - Set the CUPS session ID.
  */
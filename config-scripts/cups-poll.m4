@@ -17,6 +17,13 @@ AC_CHECK_FUNC(poll, AC_DEFINE(HAVE_POLL))
 AC_CHECK_FUNC(epoll_create, AC_DEFINE(HAVE_EPOLL))
 AC_CHECK_FUNC(kqueue, AC_DEFINE(HAVE_KQUEUE))
 
+dnl io_uring is only used when explicitly enabled...
+AC_ARG_ENABLE(io_uring, [  --enable-io-uring       use io_uring for the scheduler main loop on Linux])
+
+if test x$enable_io_uring = xyes; then
+	AC_CHECK_HEADER(linux/io_uring.h, AC_DEFINE(HAVE_IO_URING))
+fi
+
 dnl
 dnl End of "$Id: cups-poll.m4 11324 2013-10-04 03:11:42Z msweet $".
 dnl
@@ -433,6 +433,13 @@
 /* #undef HAVE_GETIFADDRS */
 
 
+/*
+ * Do we have accept4()?
+ */
+
+#define HAVE_ACCEPT4 1
+
+
 /*
  * Do we have hstrerror()?
  */
@@ -599,6 +606,7 @@
 #define HAVE_POLL 1
 #define HAVE_EPOLL 1
 /* #undef HAVE_KQUEUE */
+/* #undef HAVE_IO_URING */
 
 
 /*
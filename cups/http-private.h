@@ -345,6 +345,12 @@ struct _http_s				/**** HTTP connection structure ****/
   z_stream		stream;		/* (De)compression stream */
   Bytef			*sbuffer;	/* (De)compression buffer */
 #  endif /* HAVE_LIBZ */
+
+  /**** New in CUPS 2.2 ****/
+  int			sent_response;	/* Non-zero if response header sent */
+  char			*etag,		/* ETag field */
+			*if_none_match,	/* If-None-Match field */
+			*vary;		/* Vary field */
 };
 #  endif /* !_HTTP_NO_PRIVATE */
 
@@ -405,15 +411,20 @@ extern void	_cups_freeifaddrs(struct ifaddrs *addrs);
  * Prototypes...
  */
 
+extern int		_httpAddrListen(http_addr_t *addr, int port, int backlog,
+			                int reuseport);
 extern void		_httpAddrSetPort(http_addr_t *addr, int port);
 extern http_tls_credentials_t
 			_httpCreateCredentials(cups_array_t *credentials);
+extern http_t		*_httpCreateServer(int fd, http_addr_t *addr,
+			                   const char *hostname, int blocking);
 extern char		*_httpDecodeURI(char *dst, const char *src,
 			                size_t dstsize);
 extern void		_httpDisconnect(http_t *http);
 extern char		*_httpEncodeURI(char *dst, const char *src,
 			                size_t dstsize);
 extern void		_httpFreeCredentials(http_tls_credentials_t credentials);
+extern int		_httpReleaseSocket(http_t *http);
 extern const char	*_httpResolveURI(const char *uri, char *resolved_uri,
 			                 size_t resolved_size, int options,
 					 int (*cb)(void *context),
@@ -107,7 +107,10 @@ static const char * const http_fields[] =
 			  "WWW-Authenticate",
 			  "Accept-Encoding",
 			  "Allow",
-			  "Server"
+			  "Server",
+			  "ETag",
+			  "If-None-Match",
+			  "Vary"
 			};
 
 
@@ -124,9 +127,10 @@ httpAcceptConnection(int fd,		/* I - Listen socket file descriptor */
         				       blocking, 0 otherwise */
 {
   http_t		*http;		/* HTTP connection */
-  http_addrlist_t	addrlist;	/* Dummy address list */
+  http_addr_t		addr;		/* Address of client */
   socklen_t		addrlen;	/* Length of address */
-  int			val;		/* Socket option value */
+  int			cfd,		/* Client socket */
+			val;		/* Socket option value */
 
 
  /*
@@ -136,46 +140,31 @@ httpAcceptConnection(int fd,		/* I - Listen socket file descriptor */
   if (fd < 0)
     return (NULL);
 
- /*
-  * Create the client connection...
-  */
-
-  memset(&addrlist, 0, sizeof(addrlist));
-
-  if ((http = http_create(NULL, 0, &addrlist, AF_UNSPEC,
-                          HTTP_ENCRYPTION_IF_REQUESTED, blocking,
-                          _HTTP_MODE_SERVER)) == NULL)
-    return (NULL);
-
  /*
   * Accept the client and get the remote address...
   */
 
+  memset(&addr, 0, sizeof(addr));
   addrlen = sizeof(http_addr_t);
 
-  if ((http->fd = accept(fd, (struct sockaddr *)&(http->addrlist->addr),
-			 &addrlen)) < 0)
+#ifdef HAVE_ACCEPT4
+  if ((cfd = accept4(fd, (struct sockaddr *)&addr, &addrlen,
+                     SOCK_CLOEXEC)) < 0)
+#else
+  if ((cfd = accept(fd, (struct sockaddr *)&addr, &addrlen)) < 0)
+#endif /* HAVE_ACCEPT4 */
   {
     _cupsSetHTTPError(HTTP_STATUS_ERROR);
-    httpClose(http);
-
     return (NULL);
   }
 
-  http->hostaddr = &(http->addrlist->addr);
-
-  if (httpAddrLocalhost(http->hostaddr))
-    strlcpy(http->hostname, "localhost", sizeof(http->hostname));
-  else
-    httpAddrString(http->hostaddr, http->hostname, sizeof(http->hostname));
-
 #ifdef SO_NOSIGPIPE
  /*
   * Disable SIGPIPE for this socket.
   */
 
   val = 1;
-  setsockopt(http->fd, SOL_SOCKET, SO_NOSIGPIPE, CUPS_SOCAST &val, sizeof(val));
+  setsockopt(cfd, SOL_SOCKET, SO_NOSIGPIPE, CUPS_SOCAST &val, sizeof(val));
 #endif /* SO_NOSIGPIPE */
 
  /*
@@ -186,15 +175,22 @@ httpAcceptConnection(int fd,		/* I - Listen socket file descriptor */
   */
 
   val = 1;
-  setsockopt(http->fd, IPPROTO_TCP, TCP_NODELAY, CUPS_SOCAST &val, sizeof(val));
+  setsockopt(cfd, IPPROTO_TCP, TCP_NODELAY, CUPS_SOCAST &val, sizeof(val));
 
-#ifdef FD_CLOEXEC
+#if defined(FD_CLOEXEC) && !defined(HAVE_ACCEPT4)
  /*
   * Close this socket when starting another process...
   */
 
-  fcntl(http->fd, F_SETFD, FD_CLOEXEC);
-#endif /* FD_CLOEXEC */
+  fcntl(cfd, F_SETFD, FD_CLOEXEC);
+#endif /* FD_CLOEXEC && !HAVE_ACCEPT4 */
+
+ /*
+  * Create the client connection...
+  */
+
+  if ((http = _httpCreateServer(cfd, &addr, NULL, blocking)) == NULL)
+    httpAddrClose(NULL, cfd);
 
   return (http);
 }
@@ -327,7 +323,26 @@ httpClearFields(http_t *http)		/* I - HTTP connection */
       http->server = NULL;
     }
 
-    http->expect = (http_status_t)0;
+    if (http->etag)
+    {
+      _cupsStrFree(http->etag);
+      http->etag = NULL;
+    }
+
+    if (http->if_none_match)
+    {
+      _cupsStrFree(http->if_none_match);
+      http->if_none_match = NULL;
+    }
+
+    if (http->vary)
+    {
+      _cupsStrFree(http->vary);
+      http->vary = NULL;
+    }
+
+    http->expect        = (http_status_t)0;
+    http->sent_response = 0;
   }
 }
 
@@ -503,6 +518,50 @@ httpConnectEncrypt(
 }
 
 
+/*
+ * '_httpCreateServer()' - Create a server connection for an accepted socket.
+ *
+ * This is used by the scheduler to re-create the connection for an idle
+ * client socket whose connection was freed.  If "hostname" is @code NULL@,
+ * the numeric address is used.
+ */
+
+http_t *				/* O - HTTP connection or @code NULL@ */
+_httpCreateServer(int         fd,	/* I - Client socket */
+                  http_addr_t *addr,	/* I - Address of client */
+                  const char  *hostname,/* I - Hostname of client or @code NULL@ */
+                  int         blocking)	/* I - 1 if the connection should be
+        				       blocking, 0 otherwise */
+{
+  http_t		*http;		/* HTTP connection */
+  http_addrlist_t	addrlist;	/* Dummy address list */
+
+
+  if (fd < 0 || !addr)
+    return (NULL);
+
+  memset(&addrlist, 0, sizeof(addrlist));
+  addrlist.addr = *addr;
+
+  if ((http = http_create(NULL, 0, &addrlist, AF_UNSPEC,
+                          HTTP_ENCRYPTION_IF_REQUESTED, blocking,
+                          _HTTP_MODE_SERVER)) == NULL)
+    return (NULL);
+
+  http->fd       = fd;
+  http->hostaddr = &(http->addrlist->addr);
+
+  if (hostname)
+    strlcpy(http->hostname, hostname, sizeof(http->hostname));
+  else if (httpAddrLocalhost(http->hostaddr))
+    strlcpy(http->hostname, "localhost", sizeof(http->hostname));
+  else
+    httpAddrString(http->hostaddr, http->hostname, sizeof(http->hostname));
+
+  return (http);
+}
+
+
 /*
  * 'httpDelete()' - Send a DELETE request to the server.
  */
@@ -975,6 +1034,15 @@ httpGetField(http_t       *http,	/* I - HTTP connection */
     case HTTP_FIELD_SERVER :
         return (http->server);
 
+    case HTTP_FIELD_ETAG :
+        return (http->etag);
+
+    case HTTP_FIELD_IF_NONE_MATCH :
+        return (http->if_none_match);
+
+    case HTTP_FIELD_VARY :
+        return (http->vary);
+
     case HTTP_FIELD_AUTHORIZATION :
         if (http->field_authorization)
 	{
@@ -2482,6 +2550,31 @@ httpReconnect2(http_t *http,		/* I - HTTP connection */
 }
 
 
+/*
+ * '_httpReleaseSocket()' - Free a HTTP connection without closing its socket.
+ *
+ * The returned socket can be given to _httpCreateServer() later.  Encrypted
+ * connections cannot be released.
+ */
+
+int					/* O - Socket or -1 on error */
+_httpReleaseSocket(http_t *http)	/* I - HTTP connection */
+{
+  int	fd;				/* Socket */
+
+
+  if (!http || http->tls)
+    return (-1);
+
+  fd       = http->fd;
+  http->fd = -1;
+
+  httpClose(http);
+
+  return (fd);
+}
+
+
 /*
  * 'httpSetAuthString()' - Set the current authorization string.
  *
@@ -2702,6 +2795,27 @@ httpSetField(http_t       *http,	/* I - HTTP connection */
         http->server = _cupsStrAlloc(value);
         break;
 
+    case HTTP_FIELD_ETAG :
+        if (http->etag)
+          _cupsStrFree(http->etag);
+
+        http->etag = _cupsStrAlloc(value);
+        break;
+
+    case HTTP_FIELD_IF_NONE_MATCH :
+        if (http->if_none_match)
+          _cupsStrFree(http->if_none_match);
+
+        http->if_none_match = _cupsStrAlloc(value);
+        break;
+
+    case HTTP_FIELD_VARY :
+        if (http->vary)
+          _cupsStrFree(http->vary);
+
+        http->vary = _cupsStrAlloc(value);
+        break;
+
     case HTTP_FIELD_WWW_AUTHENTICATE :
        /* CUPS STR #4503 - don't override WWW-Authenticate for unknown auth schemes */
         if (http->fields[HTTP_FIELD_WWW_AUTHENTICATE][0] &&
@@ -2772,8 +2886,16 @@ httpSetField(http_t       *http,	/* I - HTTP connection */
   }
 #ifdef HAVE_LIBZ
   else if (field == HTTP_FIELD_CONTENT_ENCODING &&
-           http->data_encoding != HTTP_ENCODING_FIELDS)
+           http->data_encoding != HTTP_ENCODING_FIELDS &&
+           (http->mode == _HTTP_MODE_CLIENT || http->sent_response ||
+            (http->state != HTTP_STATE_GET_SEND &&
+             http->state != HTTP_STATE_POST_SEND)))
   {
+   /*
+    * Servers start content coding for a response in httpWriteResponse, after
+    * the response header has been written...
+    */
+
     DEBUG_puts("1httpSetField: Calling http_content_coding_start.");
     http_content_coding_start(http, value);
   }
@@ -3682,6 +3804,8 @@ httpWriteResponse(http_t        *http,	/* I - HTTP connection */
     * headers...
     */
 
+    http->sent_response = 1;
+
     http_set_length(http);
 
     if (http->data_encoding == HTTP_ENCODING_LENGTH && http->data_remaining == 0)
@@ -3694,12 +3818,17 @@ httpWriteResponse(http_t        *http,	/* I - HTTP connection */
 
 #ifdef HAVE_LIBZ
    /*
-    * Then start any content encoding...
+    * Then start any content encoding.  The length of encoded content isn't
+    * known until it has been written, so a response with a Content-Length is
+    * already encoded and is sent as-is...
     */
 
-    DEBUG_puts("1httpWriteResponse: Calling http_content_coding_start.");
-    http_content_coding_start(http,
-			      httpGetField(http, HTTP_FIELD_CONTENT_ENCODING));
+    if (http->data_encoding == HTTP_ENCODING_CHUNKED)
+    {
+      DEBUG_puts("1httpWriteResponse: Calling http_content_coding_start.");
+      http_content_coding_start(http,
+				httpGetField(http, HTTP_FIELD_CONTENT_ENCODING));
+    }
 #endif /* HAVE_LIBZ */
 
   }
@@ -3855,13 +3984,22 @@ http_content_coding_start(
        /*
         * Window size for compression is 11 bits - optimal based on PWG Raster
         * sample files on pwg.org.  -11 is raw deflate, 27 is gzip, per ZLIB
-        * documentation.
+        * documentation.  Server responses (IPP and HTML) repeat over much
+        * longer distances, so use the maximum 15 bit window for them.
         */
 
-        if ((zerr = deflateInit2(&(http->stream), Z_DEFAULT_COMPRESSION,
-                                 Z_DEFLATED,
-				 coding == _HTTP_CODING_DEFLATE ? -11 : 27, 7,
-				 Z_DEFAULT_STRATEGY)) < Z_OK)
+        if (http->mode == _HTTP_MODE_SERVER)
+          zerr = deflateInit2(&(http->stream), Z_DEFAULT_COMPRESSION,
+                              Z_DEFLATED,
+                              coding == _HTTP_CODING_DEFLATE ? -15 : 31, 8,
+                              Z_DEFAULT_STRATEGY);
+        else
+          zerr = deflateInit2(&(http->stream), Z_DEFAULT_COMPRESSION,
+                              Z_DEFLATED,
+                              coding == _HTTP_CODING_DEFLATE ? -11 : 27, 7,
+                              Z_DEFAULT_STRATEGY);
+
+        if (zerr < Z_OK)
         {
           http->status = HTTP_STATUS_ERROR;
           http->error  = zerr == Z_MEM_ERROR ? ENOMEM : EINVAL;
@@ -3966,7 +4104,7 @@ http_create(
   if ((http = calloc(sizeof(http_t), 1)) == NULL)
   {
     _cupsSetError(IPP_STATUS_ERROR_INTERNAL, strerror(errno), 0);
-    httpAddrFreeList(addrlist);
+    httpAddrFreeList(myaddrlist);
     return (NULL);
   }
 
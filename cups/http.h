@@ -183,6 +183,9 @@ typedef enum http_field_e		/**** HTTP field names ****/
   HTTP_FIELD_ACCEPT_ENCODING,		/* Accepting-Encoding field @since CUPS 1.7/OS X 10.9@ */
   HTTP_FIELD_ALLOW,			/* Allow field @since CUPS 1.7/OS X 10.9@ */
   HTTP_FIELD_SERVER,			/* Server field @since CUPS 1.7/OS X 10.9@ */
+  HTTP_FIELD_ETAG,			/* ETag field @since CUPS 2.2@ */
+  HTTP_FIELD_IF_NONE_MATCH,		/* If-None-Match field @since CUPS 2.2@ */
+  HTTP_FIELD_VARY,			/* Vary field @since CUPS 2.2@ */
   HTTP_FIELD_MAX			/* Maximum field index */
 } http_field_t;
 
@@ -187,7 +187,10 @@ enum cups_mode_e			/**** cupsRasterOpen modes ****/
   CUPS_RASTER_READ = 0,			/* Open stream for reading */
   CUPS_RASTER_WRITE = 1,		/* Open stream for writing */
   CUPS_RASTER_WRITE_COMPRESSED = 2,	/* Open stream for compressed writing @since CUPS 1.3/OS X 10.5@ */
-  CUPS_RASTER_WRITE_PWG = 3		/* Open stream for compressed writing in PWG mode @since CUPS 1.5/OS X 10.7@ */
+  CUPS_RASTER_WRITE_PWG = 3,		/* Open stream for compressed writing in PWG mode @since CUPS 1.5/OS X 10.7@ */
+  CUPS_RASTER_WRITE_COMPRESSED_THREADED = 4,
+					/* Open stream for compressed writing using background threads @since CUPS 2.2@ */
+  CUPS_RASTER_WRITE_PWG_THREADED = 5	/* Open stream for compressed writing in PWG mode using background threads @since CUPS 2.2@ */
 };
 
 typedef enum cups_mode_e cups_mode_t;	/**** cupsRasterOpen modes ****/
@@ -394,6 +397,10 @@ extern const char	*cupsRasterErrorString(void) _CUPS_API_1_3;
 extern cups_raster_t	*cupsRasterOpenIO(cups_raster_iocb_t iocb, void *ctx,
 			                  cups_mode_t mode);
 
+/**** New in CUPS 2.2 ****/
+extern const unsigned char *cupsRasterReadPixelsPtr(cups_raster_t *r,
+			                            unsigned len);
+
 #  ifdef __cplusplus
 }
 #  endif /* __cplusplus */
@@ -702,6 +702,15 @@ cupsSendRequest(http_t     *http,	/* I - Connection to server or @code CUPS_HTTP
     httpSetField(http, HTTP_FIELD_CONTENT_TYPE, "application/ipp");
     httpSetLength(http, length);
 
+#ifdef HAVE_LIBZ
+   /*
+    * Let the server compress large responses...
+    */
+
+    if (!http->default_accept_encoding)
+      httpSetField(http, HTTP_FIELD_ACCEPT_ENCODING, "deflate, gzip, identity");
+#endif /* HAVE_LIBZ */
+
 #ifdef HAVE_GSSAPI
     if (http->authstring && !strncmp(http->authstring, "Negotiate", 9))
     {
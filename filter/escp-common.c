@@ -0,0 +1,257 @@
+/*
+ * "$Id$"
+ *
+ * Common ESC/P raster routines for CUPS.
+ *
+ * Copyright 2007-2016 by Apple Inc.
+ * Copyright 1993-2007 by Easy Software Products.
+ *
+ * These coded instructions, statements, and computer programs are the
+ * property of Apple Inc. and are protected by Federal copyright
+ * law.  Distribution and use rights are outlined in the file "LICENSE.txt"
+ * which should have been included with this file.  If this file is
+ * file is missing or damaged, see the license at "http://www.cups.org/".
+ *
+ * This file is subject to the Apple OS-Developed Software exception.
+ */
+
+/*
+ * Include necessary headers...
+ */
+
+#include "escp-common.h"
+#include <string.h>
+#include <stdint.h>
+
+#if defined(__GNUC__) && defined(__SSE2__)
+#  include <emmintrin.h>
+#  define ESCP_SSE2			/* Transpose 16 blocks at a time */
+#endif /* __GNUC__ && __SSE2__ */
+
+
+/*
+ * Local globals...
+ */
+
+static const unsigned char escp_deplete[256] =
+{					/* Depleted byte values */
+  0x00, 0x01, 0x02, 0x02, 0x04, 0x05, 0x04, 0x05, 0x08, 0x09, 0x0a, 0x0a,
+  0x08, 0x09, 0x0a, 0x0a, 0x10, 0x11, 0x12, 0x12, 0x14, 0x15, 0x14, 0x15,
+  0x10, 0x11, 0x12, 0x12, 0x14, 0x15, 0x14, 0x15, 0x20, 0x21, 0x22, 0x22,
+  0x24, 0x25, 0x24, 0x25, 0x28, 0x29, 0x2a, 0x2a, 0x28, 0x29, 0x2a, 0x2a,
+  0x20, 0x21, 0x22, 0x22, 0x24, 0x25, 0x24, 0x25, 0x28, 0x29, 0x2a, 0x2a,
+  0x28, 0x29, 0x2a, 0x2a, 0x40, 0x41, 0x42, 0x42, 0x44, 0x45, 0x44, 0x45,
+  0x48, 0x49, 0x4a, 0x4a, 0x48, 0x49, 0x4a, 0x4a, 0x50, 0x51, 0x52, 0x52,
+  0x54, 0x55, 0x54, 0x55, 0x50, 0x51, 0x52, 0x52, 0x54, 0x55, 0x54, 0x55,
+  0x40, 0x41, 0x42, 0x42, 0x44, 0x45, 0x44, 0x45, 0x48, 0x49, 0x4a, 0x4a,
+  0x48, 0x49, 0x4a, 0x4a, 0x50, 0x51, 0x52, 0x52, 0x54, 0x55, 0x54, 0x55,
+  0x50, 0x51, 0x52, 0x52, 0x54, 0x55, 0x54, 0x55, 0x80, 0x81, 0x82, 0x82,
+  0x84, 0x85, 0x84, 0x85, 0x88, 0x89, 0x8a, 0x8a, 0x88, 0x89, 0x8a, 0x8a,
+  0x90, 0x91, 0x92, 0x92, 0x94, 0x95, 0x94, 0x95, 0x90, 0x91, 0x92, 0x92,
+  0x94, 0x95, 0x94, 0x95, 0xa0, 0xa1, 0xa2, 0xa2, 0xa4, 0xa5, 0xa4, 0xa5,
+  0xa8, 0xa9, 0xaa, 0xaa, 0xa8, 0xa9, 0xaa, 0xaa, 0xa0, 0xa1, 0xa2, 0xa2,
+  0xa4, 0xa5, 0xa4, 0xa5, 0xa8, 0xa9, 0xaa, 0xaa, 0xa8, 0xa9, 0xaa, 0xaa,
+  0x80, 0x81, 0x82, 0x82, 0x84, 0x85, 0x84, 0x85, 0x88, 0x89, 0x8a, 0x8a,
+  0x88, 0x89, 0x8a, 0x8a, 0x90, 0x91, 0x92, 0x92, 0x94, 0x95, 0x94, 0x95,
+  0x90, 0x91, 0x92, 0x92, 0x94, 0x95, 0x94, 0x95, 0xa0, 0xa1, 0xa2, 0xa2,
+  0xa4, 0xa5, 0xa4, 0xa5, 0xa8, 0xa9, 0xaa, 0xaa, 0xa8, 0xa9, 0xaa, 0xaa,
+  0xa0, 0xa1, 0xa2, 0xa2, 0xa4, 0xa5, 0xa4, 0xa5, 0xa8, 0xa9, 0xaa, 0xaa,
+  0xa8, 0xa9, 0xaa, 0xaa
+};
+
+
+/*
+ * Local functions...
+ */
+
+static uint64_t	escp_transpose(uint64_t x);
+
+
+/*
+ * 'ESCPDeplete()' - Remove adjacent dots for 720 DPI printing.
+ *
+ * The second, fourth, etc. dot of each horizontal run of dots is removed,
+ * including runs that span bytes.
+ */
+
+void
+ESCPDeplete(unsigned char *line,	/* I - Line to deplete */
+            unsigned      length)	/* I - Number of bytes */
+{
+  unsigned char	*end,			/* End of line */
+		carry;			/* Was the last dot kept? */
+  uint64_t	word;			/* 8 bytes of data */
+
+
+  for (end = line + length, carry = 0; line < end; line ++)
+  {
+    if (!carry)
+    {
+     /*
+      * Skip blank data 8 bytes at a time...
+      */
+
+      for (; (line + 8) <= end; line += 8)
+      {
+        memcpy(&word, line, sizeof(word));
+	if (word)
+	  break;
+      }
+
+      if (line >= end)
+        break;
+
+      *line = escp_deplete[*line];
+    }
+    else
+      *line = escp_deplete[*line & 0x7f];
+
+    carry = *line & 1;
+  }
+}
+
+
+/*
+ * 'ESCPTransposeBand()' - Convert a band of 8 lines to dot columns.
+ *
+ * The band holds 8 lines of 1-bit pixels, "bytes" apart.  Each of the "width"
+ * bytes in "cols" gets the dots for one column, with the first line in the
+ * most significant bit.
+ */
+
+void
+ESCPTransposeBand(
+    const unsigned char *band,		/* I - 8 lines of pixels */
+    unsigned            bytes,		/* I - Bytes per line */
+    unsigned            width,		/* I - Number of columns */
+    unsigned char       *cols)		/* O - Dot columns */
+{
+  unsigned	i = 0,			/* Current byte in line */
+		full = width / 8,	/* Number of whole bytes */
+		b;			/* Looping var */
+  uint64_t	x;			/* 8x8 block of dots */
+
+
+#ifdef ESCP_SSE2
+ /*
+  * Interleave 16 bytes from each line into 16 8x8 blocks and transpose them
+  * two at a time...
+  */
+
+  const __m128i	k1 = _mm_set1_epi64x((long long)0xaa00aa00aa00aa00ULL),
+		k2 = _mm_set1_epi64x((long long)0xcccc0000cccc0000ULL),
+		k4 = _mm_set1_epi64x((long long)0xf0f0f0f00f0f0f0fULL);
+  __m128i	r[8],			/* Bytes from each line */
+		v[8],			/* Interleaved blocks */
+		t;			/* Temporary value */
+
+
+  for (; (i + 16) <= full; i += 16, cols += 128)
+  {
+    for (b = 0, t = _mm_setzero_si128(); b < 8; b ++)
+    {
+      r[b] = _mm_loadu_si128((const __m128i *)(band + b * bytes + i));
+      t    = _mm_or_si128(t, r[b]);
+    }
+
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(t, _mm_setzero_si128())) == 0xffff)
+    {
+      memset(cols, 0, 128);
+      continue;
+    }
+
+    for (b = 0; b < 8; b += 2)
+    {
+      t        = r[b];
+      r[b]     = _mm_unpacklo_epi8(t, r[b + 1]);
+      r[b + 1] = _mm_unpackhi_epi8(t, r[b + 1]);
+    }
+
+    for (b = 0; b < 2; b ++)
+    {
+      v[b]     = _mm_unpacklo_epi16(r[b], r[b + 2]);
+      v[b + 2] = _mm_unpackhi_epi16(r[b], r[b + 2]);
+      v[b + 4] = _mm_unpacklo_epi16(r[b + 4], r[b + 6]);
+      v[b + 6] = _mm_unpackhi_epi16(r[b + 4], r[b + 6]);
+    }
+
+    r[0] = _mm_unpacklo_epi32(v[0], v[4]);
+    r[1] = _mm_unpackhi_epi32(v[0], v[4]);
+    r[2] = _mm_unpacklo_epi32(v[2], v[6]);
+    r[3] = _mm_unpackhi_epi32(v[2], v[6]);
+    r[4] = _mm_unpacklo_epi32(v[1], v[5]);
+    r[5] = _mm_unpackhi_epi32(v[1], v[5]);
+    r[6] = _mm_unpacklo_epi32(v[3], v[7]);
+    r[7] = _mm_unpackhi_epi32(v[3], v[7]);
+
+    for (b = 0; b < 8; b ++)
+    {
+      t    = _mm_xor_si128(r[b], _mm_slli_epi64(r[b], 36));
+      r[b] = _mm_xor_si128(r[b], _mm_and_si128(k4, _mm_xor_si128(t, _mm_srli_epi64(r[b], 36))));
+      t    = _mm_and_si128(k2, _mm_xor_si128(r[b], _mm_slli_epi64(r[b], 18)));
+      r[b] = _mm_xor_si128(r[b], _mm_xor_si128(t, _mm_srli_epi64(t, 18)));
+      t    = _mm_and_si128(k1, _mm_xor_si128(r[b], _mm_slli_epi64(r[b], 9)));
+      r[b] = _mm_xor_si128(r[b], _mm_xor_si128(t, _mm_srli_epi64(t, 9)));
+
+      _mm_storeu_si128((__m128i *)(cols + 16 * b), r[b]);
+    }
+  }
+#endif /* ESCP_SSE2 */
+
+ /*
+  * Transpose the remaining blocks one at a time...
+  */
+
+  for (; i < full; i ++, cols += 8)
+  {
+    for (b = 0, x = 0; b < 8; b ++)
+      x |= (uint64_t)band[b * bytes + i] << (8 * b);
+
+    if (x)
+      x = escp_transpose(x);
+
+    for (b = 0; b < 8; b ++)
+      cols[b] = (unsigned char)(x >> (8 * b));
+  }
+
+  if (width & 7)
+  {
+    for (b = 0, x = 0; b < 8; b ++)
+      x |= (uint64_t)band[b * bytes + i] << (8 * b);
+
+    x = escp_transpose(x);
+
+    for (b = 0; b < (width & 7); b ++)
+      cols[b] = (unsigned char)(x >> (8 * b));
+  }
+}
+
+
+/*
+ * 'escp_transpose()' - Transpose an 8x8 block of dots.
+ *
+ * Byte N of the block holds line N with the leftmost dot in the most
+ * significant bit.  On return byte N holds column N with the first line in
+ * the most significant bit.
+ */
+
+static uint64_t				/* O - Transposed block */
+escp_transpose(uint64_t x)		/* I - Block of dots */
+{
+  uint64_t	t;			/* Temporary value */
+
+
+  t = x ^ (x << 36);
+  x ^= 0xf0f0f0f00f0f0f0fULL & (t ^ (x >> 36));
+  t = 0xcccc0000cccc0000ULL & (x ^ (x << 18));
+  x ^= t ^ (t >> 18);
+  t = 0xaa00aa00aa00aa00ULL & (x ^ (x << 9));
+  x ^= t ^ (t >> 9);
+
+  return (x);
+}
+
+
+/*
+ * End of "$Id$".
+ */
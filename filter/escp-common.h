@@ -0,0 +1,46 @@
+/*
+ * "$Id$"
+ *
+ * Common ESC/P raster definitions for CUPS.
+ *
+ * Copyright 2007-2016 by Apple Inc.
+ *
+ * These coded instructions, statements, and computer programs are the
+ * property of Apple Inc. and are protected by Federal copyright
+ * law.  Distribution and use rights are outlined in the file "LICENSE.txt"
+ * which should have been included with this file.  If this file is
+ * file is missing or damaged, see the license at "http://www.cups.org/".
+ *
+ * This file is subject to the Apple OS-Developed Software exception.
+ */
+
+/*
+ * C++ magic...
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+
+/*
+ * Prototypes...
+ */
+
+extern void	ESCPDeplete(unsigned char *line, unsigned length);
+extern void	ESCPTransposeBand(const unsigned char *band, unsigned bytes,
+		                  unsigned width, unsigned char *cols);
+
+
+/*
+ * C++ magic...
+ */
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+
+/*
+ * End of "$Id$".
+ */
@@ -0,0 +1,401 @@
+/*
+ * "$Id$"
+ *
+ * Common PCL raster compression routines for CUPS.
+ *
+ * Copyright 2007-2016 by Apple Inc.
+ * Copyright 1993-2007 by Easy Software Products.
+ *
+ * These coded instructions, statements, and computer programs are the
+ * property of Apple Inc. and are protected by Federal copyright
+ * law.  Distribution and use rights are outlined in the file "LICENSE.txt"
+ * which should have been included with this file.  If this file is
+ * file is missing or damaged, see the license at "http://www.cups.org/".
+ *
+ * This file is subject to the Apple OS-Developed Software exception.
+ */
+
+/*
+ * Include necessary headers...
+ */
+
+#include "pcl-common.h"
+#include <string.h>
+#include <stdint.h>
+
+#if defined(__GNUC__) && defined(__SSE2__)
+#  include <emmintrin.h>
+#  define PCL_SSE2			/* Compare 16 bytes at a time */
+#elif defined(__GNUC__) && defined(__BYTE_ORDER__) && \
+      __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#  define PCL_SWAR			/* Compare 8 bytes at a time */
+#endif /* __GNUC__ && __SSE2__ */
+
+
+/*
+ * Local functions...
+ */
+
+static unsigned	pcl_match(const unsigned char *a, const unsigned char *b,
+		          unsigned n);
+static unsigned	pcl_mismatch(const unsigned char *a, const unsigned char *b,
+		             unsigned n);
+
+
+/*
+ * 'PCLCompressDelta()' - Compress a line using delta row (mode 3) compression.
+ *
+ * Each command replaces up to 8 bytes of the seed row.  When "seed" is NULL
+ * the printer's seed row is unknown, so every byte of the line is replaced.
+ * The "comp" buffer must hold at least "length" * 9 / 8 + 1 bytes.
+ */
+
+unsigned				/* O - Number of compressed bytes */
+PCLCompressDelta(
+    const unsigned char *line,		/* I - Line to compress */
+    const unsigned char *seed,		/* I - Seed row or NULL */
+    unsigned            length,		/* I - Length of line */
+    unsigned char       *comp)		/* O - Compressed data */
+{
+  unsigned	pos,			/* Current position in line */
+		start,			/* Start of replacement bytes */
+		count,			/* Number of replacement bytes */
+		offset;			/* Offset from previous replacement */
+  unsigned char	*comp_ptr;		/* Pointer into compressed data */
+
+
+  for (pos = 0, comp_ptr = comp; pos < length; pos += count)
+  {
+    start = pos;
+
+    if (!seed)
+    {
+     /*
+      * The seed row is invalid, so do the next 8 bytes, max...
+      */
+
+      offset = 0;
+
+      if ((count = length - pos) > 8)
+        count = 8;
+    }
+    else
+    {
+     /*
+      * Skip the bytes that match the seed row and then replace up to 8
+      * bytes that don't...
+      */
+
+      pos += pcl_mismatch(line + pos, seed + pos, length - pos);
+
+      if (pos >= length)
+        break;
+
+      offset = pos - start;
+      start  = pos;
+      count  = pcl_match(line + pos, seed + pos,
+                         length - pos < 8 ? length - pos : 8);
+    }
+
+   /*
+    * Place mode 3 compression data in the buffer; see HP manuals for
+    * details...
+    */
+
+    if (offset >= 31)
+    {
+     /*
+      * Output multi-byte offset...
+      */
+
+      *comp_ptr++ = (unsigned char)(((count - 1) << 5) | 31);
+
+      for (offset -= 31; offset >= 255; offset -= 255)
+        *comp_ptr++ = 255;
+
+      *comp_ptr++ = (unsigned char)offset;
+    }
+    else
+    {
+     /*
+      * Output single-byte offset...
+      */
+
+      *comp_ptr++ = (unsigned char)(((count - 1) << 5) | offset);
+    }
+
+    memcpy(comp_ptr, line + start, count);
+    comp_ptr += count;
+  }
+
+  return ((unsigned)(comp_ptr - comp));
+}
+
+
+/*
+ * 'PCLCompressTIFF()' - Compress a line using TIFF PackBits (mode 2)
+ *                       compression.
+ *
+ * The "comp" buffer must hold at least "length" * 2 bytes.
+ */
+
+unsigned				/* O - Number of compressed bytes */
+PCLCompressTIFF(
+    const unsigned char *line,		/* I - Line to compress */
+    unsigned            length,		/* I - Length of line */
+    unsigned char       *comp)		/* O - Compressed data */
+{
+  unsigned	pos,			/* Current position in line */
+		count;			/* Count of bytes for output */
+  unsigned char	*comp_ptr;		/* Pointer into compressed data */
+
+
+  for (pos = 0, comp_ptr = comp; pos < length; pos += count)
+  {
+    if ((pos + 1) >= length)
+    {
+     /*
+      * Single byte on the end...
+      */
+
+      *comp_ptr++ = 0x00;
+      *comp_ptr++ = line[pos];
+      count       = 1;
+    }
+    else if (line[pos] == line[pos + 1])
+    {
+     /*
+      * Repeated sequence of up to 127 bytes...
+      */
+
+      count = pcl_mismatch(line + pos + 1, line + pos + 2,
+                           length - pos - 2 < 125 ? length - pos - 2 : 125) + 2;
+
+      *comp_ptr++ = (unsigned char)(257 - count);
+      *comp_ptr++ = line[pos];
+    }
+    else
+    {
+     /*
+      * Non-repeated sequence of up to 127 bytes, ending before the next
+      * repeated sequence or the last byte...
+      */
+
+      count = pcl_match(line + pos + 1, line + pos + 2,
+                        length - pos - 2 < 126 ? length - pos - 2 : 126) + 1;
+
+      *comp_ptr++ = (unsigned char)(count - 1);
+
+      memcpy(comp_ptr, line + pos, count);
+      comp_ptr += count;
+    }
+  }
+
+  return ((unsigned)(comp_ptr - comp));
+}
+
+
+/*
+ * 'PCLSeparateBits()' - Separate 2-bit pixels into low and high bit planes.
+ *
+ * Each pair of input bytes becomes one byte in each plane, so "bit0" and
+ * "bit1" must hold ("length" + 1) / 2 bytes.
+ */
+
+void
+PCLSeparateBits(
+    const unsigned char *line,		/* I - 2-bit pixels */
+    unsigned            length,		/* I - Number of bytes */
+    unsigned char       *bit0,		/* O - Low bits */
+    unsigned char       *bit1)		/* O - High bits */
+{
+  unsigned char	bit,			/* Current plane data */
+		lo,			/* Current low bit data */
+		hi;			/* Current high bit data */
+
+
+#ifdef PCL_SSE2
+ /*
+  * Gather the even and odd bits of each byte into a nibble and pack pairs of
+  * nibbles, 16 bytes at a time...
+  */
+
+  const __m128i	m55 = _mm_set1_epi8(0x55),
+		m33 = _mm_set1_epi8(0x33),
+		m0f = _mm_set1_epi8(0x0f),
+		m000f = _mm_set1_epi16(0x000f);
+  __m128i	v, even, odd;		/* Pixels, low bits, high bits */
+
+  for (; length >= 16; length -= 16, line += 16, bit0 += 8, bit1 += 8)
+  {
+    v    = _mm_loadu_si128((const __m128i *)line);
+    even = _mm_and_si128(v, m55);
+    odd  = _mm_and_si128(_mm_srli_epi64(v, 1), m55);
+
+    even = _mm_and_si128(_mm_or_si128(even, _mm_srli_epi64(even, 1)), m33);
+    odd  = _mm_and_si128(_mm_or_si128(odd, _mm_srli_epi64(odd, 1)), m33);
+    even = _mm_and_si128(_mm_or_si128(even, _mm_srli_epi64(even, 2)), m0f);
+    odd  = _mm_and_si128(_mm_or_si128(odd, _mm_srli_epi64(odd, 2)), m0f);
+
+    even = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(even, m000f), 4),
+                        _mm_srli_epi16(even, 8));
+    odd  = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(odd, m000f), 4),
+                        _mm_srli_epi16(odd, 8));
+
+    v = _mm_packus_epi16(even, odd);
+
+    _mm_storel_epi64((__m128i *)bit0, v);
+    _mm_storel_epi64((__m128i *)bit1, _mm_srli_si128(v, 8));
+  }
+
+#elif defined(PCL_SWAR)
+ /*
+  * Same thing, 8 bytes at a time...
+  */
+
+  uint64_t	v, even, odd;		/* Pixels, low bits, high bits */
+  uint32_t	out;			/* Output bytes */
+
+  for (; length >= 8; length -= 8, line += 8, bit0 += 4, bit1 += 4)
+  {
+    memcpy(&v, line, sizeof(v));
+
+    even = v & 0x5555555555555555ULL;
+    odd  = (v >> 1) & 0x5555555555555555ULL;
+
+    even = (even | (even >> 1)) & 0x3333333333333333ULL;
+    odd  = (odd | (odd >> 1)) & 0x3333333333333333ULL;
+    even = (even | (even >> 2)) & 0x0f0f0f0f0f0f0f0fULL;
+    odd  = (odd | (odd >> 2)) & 0x0f0f0f0f0f0f0f0fULL;
+
+    even = ((even & 0x000f000f000f000fULL) << 4) |
+           ((even >> 8) & 0x000f000f000f000fULL);
+    odd  = ((odd & 0x000f000f000f000fULL) << 4) |
+           ((odd >> 8) & 0x000f000f000f000fULL);
+
+    even = (even | (even >> 8)) & 0x0000ffff0000ffffULL;
+    odd  = (odd | (odd >> 8)) & 0x0000ffff0000ffffULL;
+
+    out = (uint32_t)(even | (even >> 16));
+    memcpy(bit0, &out, sizeof(out));
+    out = (uint32_t)(odd | (odd >> 16));
+    memcpy(bit1, &out, sizeof(out));
+  }
+#endif /* PCL_SSE2 */
+
+ /*
+  * Do any remaining bytes one pair at a time...
+  */
+
+  for (; length > 0; line += 2, bit0 ++, bit1 ++)
+  {
+    bit = line[0];
+
+    lo = (unsigned char)(((bit & 64) << 1) | ((bit & 16) << 2) | ((bit & 4) << 3) | ((bit & 1) << 4));
+    hi = (unsigned char)((bit & 128) | ((bit & 32) << 1) | ((bit & 8) << 2) | ((bit & 2) << 3));
+
+    if (length > 1)
+    {
+      bit = line[1];
+
+      lo |= (unsigned char)((bit & 1) | ((bit & 4) >> 1) | ((bit & 16) >> 2) | ((bit & 64) >> 3));
+      hi |= (unsigned char)(((bit & 2) >> 1) | ((bit & 8) >> 2) | ((bit & 32) >> 3) | ((bit & 128) >> 4));
+
+      length -= 2;
+    }
+    else
+      length = 0;
+
+    *bit0 = lo;
+    *bit1 = hi;
+  }
+}
+
+
+/*
+ * 'pcl_match()' - Find the first byte that is the same in both buffers.
+ */
+
+static unsigned				/* O - Index of first match or "n" */
+pcl_match(const unsigned char *a,	/* I - First buffer */
+          const unsigned char *b,	/* I - Second buffer */
+	  unsigned            n)	/* I - Number of bytes */
+{
+  unsigned	i = 0;			/* Current index */
+
+
+#ifdef PCL_SSE2
+  int		mask;			/* Comparison mask */
+
+  for (; (i + 16) <= n; i += 16)
+    if ((mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(a + i)), _mm_loadu_si128((const __m128i *)(b + i))))) != 0)
+      return (i + (unsigned)__builtin_ctz((unsigned)mask));
+
+#elif defined(PCL_SWAR)
+  uint64_t	va, vb,			/* Bytes from each buffer */
+		zero;			/* Zero byte mask */
+
+  for (; (i + 8) <= n; i += 8)
+  {
+    memcpy(&va, a + i, sizeof(va));
+    memcpy(&vb, b + i, sizeof(vb));
+
+    va ^= vb;
+    zero = (va - 0x0101010101010101ULL) & ~va & 0x8080808080808080ULL;
+
+    if (zero)
+      return (i + (unsigned)__builtin_ctzll(zero) / 8);
+  }
+#endif /* PCL_SSE2 */
+
+  for (; i < n; i ++)
+    if (a[i] == b[i])
+      break;
+
+  return (i);
+}
+
+
+/*
+ * 'pcl_mismatch()' - Find the first byte that differs between the buffers.
+ */
+
+static unsigned				/* O - Index of first mismatch or "n" */
+pcl_mismatch(const unsigned char *a,	/* I - First buffer */
+             const unsigned char *b,	/* I - Second buffer */
+	     unsigned            n)	/* I - Number of bytes */
+{
+  unsigned	i = 0;			/* Current index */
+
+
+#ifdef PCL_SSE2
+  int		mask;			/* Comparison mask */
+
+  for (; (i + 16) <= n; i += 16)
+    if ((mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(a + i)), _mm_loadu_si128((const __m128i *)(b + i))))) != 0xffff)
+      return (i + (unsigned)__builtin_ctz((unsigned)~mask));
+
+#elif defined(PCL_SWAR)
+  uint64_t	va, vb;			/* Bytes from each buffer */
+
+  for (; (i + 8) <= n; i += 8)
+  {
+    memcpy(&va, a + i, sizeof(va));
+    memcpy(&vb, b + i, sizeof(vb));
+
+    if (va != vb)
+      return (i + (unsigned)__builtin_ctzll(va ^ vb) / 8);
+  }
+#endif /* PCL_SSE2 */
+
+  for (; i < n; i ++)
+    if (a[i] != b[i])
+      break;
+
+  return (i);
+}
+
+
+/*
+ * End of "$Id$".
+ */
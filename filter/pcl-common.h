@@ -0,0 +1,50 @@
+/*
+ * "$Id$"
+ *
+ * Common PCL raster compression definitions for CUPS.
+ *
+ * Copyright 2007-2016 by Apple Inc.
+ *
+ * These coded instructions, statements, and computer programs are the
+ * property of Apple Inc. and are protected by Federal copyright
+ * law.  Distribution and use rights are outlined in the file "LICENSE.txt"
+ * which should have been included with this file.  If this file is
+ * file is missing or damaged, see the license at "http://www.cups.org/".
+ *
+ * This file is subject to the Apple OS-Developed Software exception.
+ */
+
+/*
+ * C++ magic...
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+
+/*
+ * Prototypes...
+ */
+
+extern unsigned	PCLCompressDelta(const unsigned char *line,
+		                 const unsigned char *seed, unsigned length,
+				 unsigned char *comp);
+extern unsigned	PCLCompressTIFF(const unsigned char *line, unsigned length,
+		                unsigned char *comp);
+extern void	PCLSeparateBits(const unsigned char *line, unsigned length,
+		                unsigned char *bit0, unsigned char *bit1);
+
+
+/*
+ * C++ magic...
+ */
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+
+/*
+ * End of "$Id$".
+ */
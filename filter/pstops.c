@@ -26,6 +26,8 @@
 #include <cups/array.h>
 #include <cups/language-private.h>
 #include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 
 /*
@@ -67,6 +69,14 @@ typedef struct				/**** Page information ****/
   cups_option_t	*options;		/* Options for this page */
 } pstops_page_t;
 
+typedef struct				/**** Span of saved document data ****/
+{
+  off_t		pos,			/* Position in saved data */
+		offset;			/* Offset in input or temporary file */
+  size_t	length;			/* Number of bytes */
+  int		input;			/* Data is in the input file? */
+} pstops_span_t;
+
 typedef struct				/**** Document information ****/
 {
   int		page;			/* Current page */
@@ -83,6 +93,15 @@ typedef struct				/**** Document information ****/
   cups_array_t	*pages;			/* Pages in document */
   cups_file_t	*temp;			/* Temporary file, if any */
   char		tempfile[1024];		/* Temporary filename */
+  off_t		length;			/* Length of saved document data */
+  int		num_spans,		/* Number of saved data spans */
+		alloc_spans;		/* Allocated saved data spans */
+  pstops_span_t	*spans;			/* Saved data spans */
+  int		index_input,		/* Index the input file? */
+		input_fd;		/* Input file descriptor */
+  off_t		input_base;		/* Offset of print data in input file */
+  char		*input_map;		/* Mapped input file, if any */
+  size_t	input_mapsize;		/* Size of mapped input file */
   int		job_id;			/* Job ID */
   const char	*user,			/* User name */
 		*title;			/* Job name */
@@ -139,7 +158,7 @@ static int		JobCanceled = 0;/* Set to 1 on SIGTERM */
 static pstops_page_t	*add_page(pstops_doc_t *doc, const char *label);
 static void		cancel_job(int sig);
 static int		check_range(pstops_doc_t *doc, int page);
-static void		copy_bytes(cups_file_t *fp, off_t offset,
+static void		copy_bytes(pstops_doc_t *doc, off_t offset,
 			           size_t length);
 static ssize_t		copy_comments(cups_file_t *fp, pstops_doc_t *doc,
 			              ppd_file_t *ppd, char *line,
@@ -164,14 +183,20 @@ static ssize_t		copy_trailer(cups_file_t *fp, pstops_doc_t *doc,
 				     ssize_t linelen, size_t linesize);
 static void		do_prolog(pstops_doc_t *doc, ppd_file_t *ppd);
 static void 		do_setup(pstops_doc_t *doc, ppd_file_t *ppd);
+static void		doc_copy(pstops_doc_t *doc, cups_file_t *fp,
+			         const char *s, size_t len);
 static void		doc_printf(pstops_doc_t *doc, const char *format, ...)
 			__attribute__ ((__format__ (__printf__, 2, 3)));
 static void		doc_puts(pstops_doc_t *doc, const char *s);
+static void		doc_save(pstops_doc_t *doc, cups_file_t *fp,
+			         const char *s, size_t len);
 static void		doc_write(pstops_doc_t *doc, const char *s, size_t len);
 static void		end_nup(pstops_doc_t *doc, int number);
 static int		include_feature(ppd_file_t *ppd, const char *line,
 			                int num_options,
 					cups_option_t **options);
+static void		index_input(pstops_doc_t *doc, cups_file_t *fp,
+			            off_t base);
 static char		*parse_text(const char *start, char **end, char *buffer,
 			            size_t bufsize);
 static void		set_pstops_options(pstops_doc_t *doc, ppd_file_t *ppd,
@@ -204,6 +229,7 @@ main(int  argc,				/* I - Number of command-line args */
   cups_option_t	*options;		/* Print options */
   char		line[8192];		/* Line buffer */
   ssize_t	len;			/* Length of line buffer */
+  off_t		base;			/* Offset of print data in file */
 #if defined(HAVE_SIGACTION) && !defined(HAVE_SIGSET)
   struct sigaction action;		/* Actions for POSIX signals */
 #endif /* HAVE_SIGACTION && !HAVE_SIGSET */
@@ -274,6 +300,8 @@ main(int  argc,				/* I - Number of command-line args */
     }
   }
 
+  base = lseek(cupsFileNumber(fp), 0, SEEK_CUR);
+
  /*
   * Read the first line to see if we have DSC comments...
   */
@@ -294,6 +322,13 @@ main(int  argc,				/* I - Number of command-line args */
 
   set_pstops_options(&doc, ppd, argv, num_options, options);
 
+ /*
+  * Copy pages from a regular file by offset rather than saving them...
+  */
+
+  if (doc.temp)
+    index_input(&doc, fp, base);
+
  /*
   * Write any "exit server" options that have been selected...
   */
@@ -389,6 +424,11 @@ main(int  argc,				/* I - Number of command-line args */
     unlink(doc.tempfile);
   }
 
+  if (doc.input_map)
+    munmap(doc.input_map, doc.input_mapsize);
+
+  free(doc.spans);
+
   ppdClose(ppd);
   cupsFreeOptions(num_options, options);
 
@@ -425,7 +465,7 @@ add_page(pstops_doc_t *doc,		/* I - Document information */
   }
 
   pageinfo->label  = strdup(label);
-  pageinfo->offset = cupsFileTell(doc->temp);
+  pageinfo->offset = doc->length;
 
   cupsArrayAdd(doc->pages, pageinfo);
 
@@ -515,40 +555,97 @@ check_range(pstops_doc_t *doc,		/* I - Document information */
 
 
 /*
- * 'copy_bytes()' - Copy bytes from the input file to stdout.
+ * 'copy_bytes()' - Copy saved document data to stdout.
+ *
+ * The saved data is a list of spans in the input and temporary files.  A
+ * length of 0 copies everything from the offset to the end.
  */
 
 static void
-copy_bytes(cups_file_t *fp,		/* I - File to read from */
-           off_t       offset,		/* I - Offset to page data */
-           size_t      length)		/* I - Length of page data */
+copy_bytes(pstops_doc_t *doc,		/* I - Document information */
+           off_t        offset,		/* I - Offset to page data */
+           size_t       length)		/* I - Length of page data */
 {
   char		buffer[8192];		/* Data buffer */
   ssize_t	nbytes;			/* Number of bytes read */
   size_t	nleft;			/* Number of bytes left/remaining */
+  off_t		end,			/* End of data to copy */
+		src;			/* Offset in input or temporary file */
+  pstops_span_t	*span,			/* Current span */
+		*last;			/* Last span */
+  int		left,			/* Left side of binary search */
+		center,			/* Center of binary search */
+		right;			/* Right side of binary search */
 
 
-  nleft = length;
+  if (length == 0)
+    end = doc->length;
+  else
+    end = offset + (off_t)length;
+
+ /*
+  * Find the span containing the offset...
+  */
 
-  if (cupsFileSeek(fp, offset) < 0)
+  for (left = 0, right = doc->num_spans - 1; left < right;)
   {
-    _cupsLangPrintError("ERROR", _("Unable to see in file"));
-    return;
+    center = (left + right + 1) / 2;
+
+    if (doc->spans[center].pos <= offset)
+      left = center;
+    else
+      right = center - 1;
   }
 
-  while (nleft > 0 || length == 0)
+ /*
+  * Then copy each span...
+  */
+
+  for (span = doc->spans + left, last = doc->spans + doc->num_spans;
+       span < last && offset < end;
+       span ++)
   {
-    if (nleft > sizeof(buffer) || length == 0)
-      nbytes = sizeof(buffer);
-    else
-      nbytes = (ssize_t)nleft;
+    src   = span->offset + offset - span->pos;
+    nleft = (size_t)(span->pos + (off_t)span->length - offset);
+
+    if ((off_t)nleft > end - offset)
+      nleft = (size_t)(end - offset);
 
-    if ((nbytes = cupsFileRead(fp, buffer, (size_t)nbytes)) < 1)
+    offset += (off_t)nleft;
+
+    if (span->input && doc->input_map &&
+        src + (off_t)nleft <= (off_t)doc->input_mapsize)
+    {
+      fwrite(doc->input_map + src, 1, nleft, stdout);
+      continue;
+    }
+
+    if (!span->input && cupsFileSeek(doc->temp, src) < 0)
+    {
+      _cupsLangPrintError("ERROR", _("Unable to see in file"));
       return;
+    }
+
+    while (nleft > 0)
+    {
+      if (nleft > sizeof(buffer))
+	nbytes = sizeof(buffer);
+      else
+	nbytes = (ssize_t)nleft;
+
+      if (span->input)
+        nbytes = pread(doc->input_fd, buffer, (size_t)nbytes, src);
+      else
+        nbytes = cupsFileRead(doc->temp, buffer, (size_t)nbytes);
+
+      if (nbytes < 1)
+	return;
 
-    nleft -= (size_t)nbytes;
+      nleft -= (size_t)nbytes;
+      src   += nbytes;
 
-    fwrite(buffer, 1, (size_t)nbytes, stdout);
+      fwrite(buffer, 1, (size_t)nbytes, stdout);
+    }
   }
 }
 
@@ -832,7 +929,7 @@ copy_dsc(cups_file_t  *fp,		/* I - File to read from */
 
   while (strncmp(line, "%%Page:", 7) && strncmp(line, "%%Trailer", 9))
   {
-    doc_write(doc, line, (size_t)linelen);
+    doc_copy(doc, fp, line, (size_t)linelen);
 
     if ((linelen = (ssize_t)cupsFileGetLine(fp, line, linesize)) == 0)
       break;
@@ -877,7 +974,7 @@ copy_dsc(cups_file_t  *fp,		/* I - File to read from */
     doc_puts(doc, "showpage\n");
     end_nup(doc, doc->number_up);
 
-    pageinfo->length = (ssize_t)(cupsFileTell(doc->temp) - pageinfo->offset);
+    pageinfo->length = (ssize_t)(doc->length - pageinfo->offset);
   }
 
   if (doc->slow_duplex && (doc->page & 1))
@@ -901,7 +998,7 @@ copy_dsc(cups_file_t  *fp,		/* I - File to read from */
     doc_puts(doc, "showpage\n");
     end_nup(doc, doc->number_up);
 
-    pageinfo->length = (ssize_t)(cupsFileTell(doc->temp) - pageinfo->offset);
+    pageinfo->length = (ssize_t)(doc->length - pageinfo->offset);
   }
 
  /*
@@ -978,7 +1075,7 @@ copy_dsc(cups_file_t  *fp,		/* I - File to read from */
       if (!number)
       {
         pageinfo = (pstops_page_t *)cupsArrayFirst(doc->pages);
-	copy_bytes(doc->temp, 0, (size_t)pageinfo->offset);
+	copy_bytes(doc, 0, (size_t)pageinfo->offset);
       }
 
      /*
@@ -1013,7 +1110,7 @@ copy_dsc(cups_file_t  *fp,		/* I - File to read from */
 		 pageinfo->bounding_box[2], pageinfo->bounding_box[3]);
 	}
 
-	copy_bytes(doc->temp, pageinfo->offset, (size_t)pageinfo->length);
+	copy_bytes(doc, pageinfo->offset, (size_t)pageinfo->length);
 
 	pageinfo = doc->slow_order ? (pstops_page_t *)cupsArrayPrev(doc->pages) :
                                      (pstops_page_t *)cupsArrayNext(doc->pages);
@@ -1152,14 +1249,14 @@ copy_non_dsc(cups_file_t  *fp,		/* I - File to read from */
   fwrite(line, (size_t)linelen, 1, stdout);
 
   if (doc->temp)
-    cupsFileWrite(doc->temp, line, (size_t)linelen);
+    doc_save(doc, fp, line, (size_t)linelen);
 
   while ((bytes = cupsFileRead(fp, buffer, sizeof(buffer))) > 0)
   {
     fwrite(buffer, 1, (size_t)bytes, stdout);
 
     if (doc->temp)
-      cupsFileWrite(doc->temp, buffer, (size_t)bytes);
+      doc_save(doc, fp, buffer, (size_t)bytes);
   }
 
   puts("%%EndDocument");
@@ -1198,7 +1295,7 @@ copy_non_dsc(cups_file_t  *fp,		/* I - File to read from */
       puts("%%EndPageSetup");
       puts("%%BeginDocument: nondsc");
 
-      copy_bytes(doc->temp, 0, 0);
+      copy_bytes(doc, 0, 0);
 
       puts("%%EndDocument");
 
@@ -1556,7 +1653,7 @@ copy_page(cups_file_t  *fp,		/* I - File to read from */
         break;
 
       if (!feature || (doc->number_up == 1 && !doc->fit_to_page))
-	doc_write(doc, line, (size_t)linelen);
+	doc_copy(doc, fp, line, (size_t)linelen);
     }
 
    /*
@@ -1613,14 +1710,14 @@ copy_page(cups_file_t  *fp,		/* I - File to read from */
     else if (!strncmp(line, "%%BeginDocument", 15) ||
 	     !strncmp(line, "%ADO_BeginApplication", 21))
     {
-      doc_write(doc, line, (size_t)linelen);
+      doc_copy(doc, fp, line, (size_t)linelen);
 
       level ++;
     }
     else if ((!strncmp(line, "%%EndDocument", 13) ||
 	      !strncmp(line, "%ADO_EndApplication", 19)) && level > 0)
     {
-      doc_write(doc, line, (size_t)linelen);
+      doc_copy(doc, fp, line, (size_t)linelen);
 
       level --;
     }
@@ -1635,7 +1732,7 @@ copy_page(cups_file_t  *fp,		/* I - File to read from */
       int	bytes;			/* Bytes of data */
 
 
-      doc_write(doc, line, (size_t)linelen);
+      doc_copy(doc, fp, line, (size_t)linelen);
 
       bytes = atoi(strchr(line, ':') + 1);
 
@@ -1653,13 +1750,13 @@ copy_page(cups_file_t  *fp,		/* I - File to read from */
 	  return (0);
 	}
 
-        doc_write(doc, line, (size_t)linelen);
+        doc_copy(doc, fp, line, (size_t)linelen);
 
 	bytes -= linelen;
       }
     }
     else
-      doc_write(doc, line, (size_t)linelen);
+      doc_copy(doc, fp, line, (size_t)linelen);
   }
   while ((linelen = (ssize_t)cupsFileGetLine(fp, line, linesize)) > 0);
 
@@ -1669,7 +1766,7 @@ copy_page(cups_file_t  *fp,		/* I - File to read from */
 
   end_nup(doc, number);
 
-  pageinfo->length = (ssize_t)(cupsFileTell(doc->temp) - pageinfo->offset);
+  pageinfo->length = (ssize_t)(doc->length - pageinfo->offset);
 
   return (linelen);
 }
@@ -1695,7 +1792,7 @@ copy_prolog(cups_file_t  *fp,		/* I - File to read from */
     if (!strncmp(line, "%%BeginSetup", 12) || !strncmp(line, "%%Page:", 7))
       break;
 
-    doc_write(doc, line, (size_t)linelen);
+    doc_copy(doc, fp, line, (size_t)linelen);
 
     if ((linelen = (ssize_t)cupsFileGetLine(fp, line, linesize)) == 0)
       break;
@@ -1714,7 +1811,7 @@ copy_prolog(cups_file_t  *fp,		/* I - File to read from */
           !strncmp(line, "%%Page:", 7))
         break;
 
-      doc_write(doc, line, (size_t)linelen);
+      doc_copy(doc, fp, line, (size_t)linelen);
     }
 
     if (!strncmp(line, "%%EndProlog", 11))
@@ -1753,7 +1850,7 @@ copy_setup(cups_file_t  *fp,		/* I - File to read from */
     if (!strncmp(line, "%%Page:", 7))
       break;
 
-    doc_write(doc, line, (size_t)linelen);
+    doc_copy(doc, fp, line, (size_t)linelen);
 
     if ((linelen = (ssize_t)cupsFileGetLine(fp, line, linesize)) == 0)
       break;
@@ -1782,7 +1879,7 @@ copy_setup(cups_file_t  *fp,		/* I - File to read from */
 	  num_options = include_feature(ppd, line, num_options, &options);
       }
       else if (strncmp(line, "%%BeginSetup", 12))
-        doc_write(doc, line, (size_t)linelen);
+        doc_copy(doc, fp, line, (size_t)linelen);
 
       if ((linelen = (ssize_t)cupsFileGetLine(fp, line, linesize)) == 0)
 	break;
@@ -2007,6 +2104,26 @@ do_setup(pstops_doc_t *doc,		/* I - Document information */
 }
 
 
+/*
+ * 'doc_copy()' - Send data from the input file to stdout and/or the temp file.
+ *
+ * The data must be the last bytes read from the input file.
+ */
+
+static void
+doc_copy(pstops_doc_t *doc,		/* I - Document information */
+         cups_file_t  *fp,		/* I - File data was read from */
+         const char   *s,		/* I - Data to send */
+	 size_t       len)		/* I - Number of bytes to send */
+{
+  if (!doc->slow_order)
+    fwrite(s, 1, len, stdout);
+
+  if (doc->temp)
+    doc_save(doc, fp, s, len);
+}
+
+
 /*
  * 'doc_printf()' - Send a formatted string to stdout and/or the temp file.
  *
@@ -2054,6 +2171,78 @@ doc_puts(pstops_doc_t *doc,		/* I - Document information */
 }
 
 
+/*
+ * 'doc_save()' - Save data for later copies or pages.
+ *
+ * Data from an indexed input file is recorded by offset, everything else is
+ * written to the temp file.
+ */
+
+static void
+doc_save(pstops_doc_t *doc,		/* I - Document information */
+         cups_file_t  *fp,		/* I - File data was read from or NULL */
+         const char   *s,		/* I - Data to save */
+	 size_t       len)		/* I - Number of bytes to save */
+{
+  pstops_span_t	*span;			/* Current span */
+  off_t		offset;			/* Offset of data */
+  int		input;			/* Data is in the input file? */
+
+
+  if (len == 0)
+    return;
+
+  if (fp && doc->index_input)
+  {
+    input  = 1;
+    offset = doc->input_base + cupsFileTell(fp) - (off_t)len;
+  }
+  else
+  {
+    input  = 0;
+    offset = cupsFileTell(doc->temp);
+
+    cupsFileWrite(doc->temp, s, len);
+  }
+
+ /*
+  * Extend the last span or add a new one...
+  */
+
+  span = doc->num_spans > 0 ? doc->spans + doc->num_spans - 1 : NULL;
+
+  if (span && span->input == input &&
+      span->offset + (off_t)span->length == offset)
+    span->length += len;
+  else
+  {
+    if (doc->num_spans >= doc->alloc_spans)
+    {
+      if ((span = realloc(doc->spans, (size_t)(doc->alloc_spans + 1024) *
+                                      sizeof(pstops_span_t))) == NULL)
+      {
+	_cupsLangPrintError("EMERG",
+	                    _("Unable to allocate memory for page info"));
+	exit(1);
+      }
+
+      doc->spans       = span;
+      doc->alloc_spans += 1024;
+    }
+
+    span = doc->spans + doc->num_spans;
+    doc->num_spans ++;
+
+    span->pos    = doc->length;
+    span->offset = offset;
+    span->length = len;
+    span->input  = input;
+  }
+
+  doc->length += (off_t)len;
+}
+
+
 /*
  * 'doc_write()' - Send data to stdout and/or the temp file.
  */
@@ -2067,7 +2256,7 @@ doc_write(pstops_doc_t *doc,		/* I - Document information */
     fwrite(s, 1, len, stdout);
 
   if (doc->temp)
-    cupsFileWrite(doc->temp, s, len);
+    doc_save(doc, NULL, s, len);
 }
 
 
@@ -2200,6 +2389,59 @@ include_feature(
 }
 
 
+/*
+ * 'index_input()' - Index the pages in a regular input file.
+ *
+ * Uncompressed regular files are copied by offset for reverse order and
+ * collated copies so that only the generated commands are written to the
+ * temp file.  Pipes and compressed files are still copied to the temp file.
+ */
+
+static void
+index_input(pstops_doc_t *doc,		/* I - Document information */
+            cups_file_t  *fp,		/* I - Print file */
+	    off_t        base)		/* I - Offset of print data in file */
+{
+  int		fd = cupsFileNumber(fp);/* File descriptor */
+  struct stat	fileinfo;		/* File information */
+  unsigned char	header[2];		/* First bytes of print data */
+  void		*map;			/* Mapped file */
+
+
+  if (base < 0 || fstat(fd, &fileinfo) || !S_ISREG(fileinfo.st_mode))
+    return;
+
+ /*
+  * Check for gzip data ourselves - cupsFileCompression() reports 0 once a
+  * small compressed file has been completely decompressed...
+  */
+
+  if (pread(fd, header, sizeof(header), base) == sizeof(header) &&
+      header[0] == 0x1f && header[1] == 0x8b)
+    return;
+
+  doc->index_input = 1;
+  doc->input_fd    = fd;
+  doc->input_base  = base;
+
+ /*
+  * Map the file if possible, otherwise data is read as needed...
+  */
+
+  if (fileinfo.st_size > 0 &&
+      (off_t)(size_t)fileinfo.st_size == fileinfo.st_size &&
+      (map = mmap(NULL, (size_t)fileinfo.st_size, PROT_READ, MAP_PRIVATE, fd,
+                  0)) != MAP_FAILED)
+  {
+    doc->input_map     = (char *)map;
+    doc->input_mapsize = (size_t)fileinfo.st_size;
+  }
+
+  fprintf(stderr, "DEBUG: Indexing pages in print file (%s).\n",
+          doc->input_map ? "mapped" : "not mapped");
+}
+
+
 /*
  * 'parse_text()' - Parse a text value in a comment.
  *
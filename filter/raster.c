@@ -25,6 +25,70 @@
 #ifdef HAVE_STDINT_H
 #  include <stdint.h>
 #endif /* HAVE_STDINT_H */
+#if defined(__GNUC__) && defined(__SSE2__)
+#  include <emmintrin.h>
+#  if defined(__x86_64__) && (defined(__clang__) || __GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+#    define CUPS_RASTER_AVX2 1		/* AVX2 code selected at run-time */
+#    include <immintrin.h>
+#  endif /* __x86_64__ && ... */
+#  define CUPS_RASTER_SSE2 1		/* SSE2 code is always available */
+#elif defined(__GNUC__) && defined(__aarch64__)
+#  include <arm_neon.h>
+#  define CUPS_RASTER_NEON 1		/* NEON code is always available */
+#endif /* __GNUC__ && __SSE2__ */
+#ifndef WIN32
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  define CUPS_RASTER_MMAP 1		/* Map regular files for reading */
+#endif /* !WIN32 */
+#ifdef HAVE_PTHREAD_H
+#  include <pthread.h>
+#  define CUPS_RASTER_THREADS 1		/* Background compression threads */
+#endif /* HAVE_PTHREAD_H */
+
+
+/*
+ * Constants...
+ */
+
+#define _CUPS_RASTER_BAND_SIZE	262144	/* Target size of a band of lines */
+#define _CUPS_RASTER_MAX_THREADS 64	/* Maximum compression threads */
+
+
+/*
+ * Private types...
+ */
+
+typedef size_t (*_cups_raster_match_t)(const unsigned char *a,
+                                       const unsigned char *b, size_t n,
+				       unsigned bpp);
+					/**** Pixel matching function ****/
+typedef size_t (*_cups_raster_mismatch_t)(const unsigned char *a,
+                                          const unsigned char *b, size_t n);
+					/**** Byte mismatch function ****/
+
+#ifdef CUPS_RASTER_THREADS
+typedef enum _cups_raster_bstate_e	/**** Band states ****/
+{
+  _CUPS_RASTER_BAND_QUEUED,		/* Waiting for a thread */
+  _CUPS_RASTER_BAND_COMPRESSING,	/* Being compressed */
+  _CUPS_RASTER_BAND_DONE		/* Ready to write */
+} _cups_raster_bstate_t;
+
+typedef struct _cups_raster_band_s	/**** Band of lines for compression ****/
+{
+  struct _cups_raster_band_s *next;	/* Next band in output order */
+  _cups_raster_bstate_t	state;		/* Band state */
+  unsigned		bpp,		/* Bytes per pixel */
+			bytes;		/* Bytes per line */
+  unsigned char		*data;		/* Repeat counts and lines */
+  size_t		datalen,	/* Bytes of line data */
+			datasize;	/* Size of line data buffer */
+  unsigned char		*out;		/* Compressed data */
+  size_t		outlen,		/* Bytes of compressed data */
+			outsize;	/* Size of compressed data buffer */
+} _cups_raster_band_t;
+#endif /* CUPS_RASTER_THREADS */
 
 
 /*
@@ -50,6 +114,27 @@ struct _cups_raster_s			/**** Raster stream data ****/
 			*bufptr,	/* Current (read) position in buffer */
 			*bufend;	/* End of current (read) buffer */
   size_t		bufsize;	/* Buffer size */
+  unsigned char		*map;		/* Mapped file or NULL */
+  size_t		mapsize;	/* Size of mapped file */
+  unsigned char		*line;		/* Line for cupsRasterReadPixelsPtr */
+  size_t		linesize;	/* Size of line buffer */
+  _cups_raster_match_t	match;		/* Find first matching pixel */
+  _cups_raster_mismatch_t mismatch;	/* Find first differing byte */
+#ifdef CUPS_RASTER_THREADS
+  int			num_threads;	/* Number of compression threads */
+  pthread_t		threads[_CUPS_RASTER_MAX_THREADS];
+					/* Compression threads */
+  pthread_mutex_t	band_mutex;	/* Mutex for band list */
+  pthread_cond_t	band_cond,	/* Condition for queued bands */
+			done_cond;	/* Condition for compressed bands */
+  _cups_raster_band_t	*band,		/* Band being filled */
+			*first_band,	/* First band to write */
+			*last_band,	/* Last band to write */
+			*free_bands;	/* Bands that can be reused */
+  int			num_bands,	/* Number of bands to write */
+			band_error,	/* Non-zero on compression/write error */
+			shutdown;	/* Non-zero to stop threads */
+#endif /* CUPS_RASTER_THREADS */
 #ifdef DEBUG
   size_t		iocount;	/* Number of bytes read/written */
 #endif /* DEBUG */
@@ -60,10 +145,61 @@ struct _cups_raster_s			/**** Raster stream data ****/
  * Local functions...
  */
 
+static size_t	cups_match_c(const unsigned char *a, const unsigned char *b,
+		             size_t n, unsigned bpp);
+static size_t	cups_mismatch_c(const unsigned char *a,
+		                const unsigned char *b, size_t n);
+#if defined(CUPS_RASTER_SSE2) || defined(CUPS_RASTER_AVX2)
+static size_t	cups_match_mask(const unsigned char *a,
+		                const unsigned char *b, size_t i, size_t n,
+				unsigned bpp, unsigned mask);
+#endif /* CUPS_RASTER_SSE2 || CUPS_RASTER_AVX2 */
+#ifdef CUPS_RASTER_AVX2
+static size_t	cups_match_avx2(const unsigned char *a,
+		                const unsigned char *b, size_t n, unsigned bpp)
+		                __attribute__((target("avx2")));
+static size_t	cups_mismatch_avx2(const unsigned char *a,
+		                   const unsigned char *b, size_t n)
+		                   __attribute__((target("avx2")));
+#endif /* CUPS_RASTER_AVX2 */
+#ifdef CUPS_RASTER_NEON
+static size_t	cups_match_neon(const unsigned char *a,
+		                const unsigned char *b, size_t n, unsigned bpp);
+static size_t	cups_mismatch_neon(const unsigned char *a,
+		                   const unsigned char *b, size_t n);
+#endif /* CUPS_RASTER_NEON */
+#ifdef CUPS_RASTER_SSE2
+static size_t	cups_match_sse2(const unsigned char *a,
+		                const unsigned char *b, size_t n, unsigned bpp);
+static size_t	cups_mismatch_sse2(const unsigned char *a,
+		                   const unsigned char *b, size_t n);
+#endif /* CUPS_RASTER_SSE2 */
+#ifdef CUPS_RASTER_THREADS
+static int	cups_raster_band_add(cups_raster_t *r,
+		                     const unsigned char *pixels, int swap);
+static void	cups_raster_band_close(cups_raster_t *r);
+static int	cups_raster_band_flush(cups_raster_t *r, int max_bands);
+static _cups_raster_band_t *cups_raster_band_new(cups_raster_t *r,
+		                                 size_t datasize);
+static int	cups_raster_band_queue(cups_raster_t *r,
+		                       _cups_raster_band_t *band);
+static void	cups_raster_band_start(cups_raster_t *r);
+static void	*cups_raster_band_thread(cups_raster_t *r);
+#endif /* CUPS_RASTER_THREADS */
+static unsigned char *cups_raster_encode(cups_raster_t *r,
+		                         const unsigned char *pixels,
+					 unsigned bytes, unsigned bpp,
+					 unsigned char *wptr);
 static ssize_t	cups_raster_io(cups_raster_t *r, unsigned char *buf, size_t bytes);
+#ifdef CUPS_RASTER_MMAP
+static void	cups_raster_map(cups_raster_t *r);
+#endif /* CUPS_RASTER_MMAP */
+static ssize_t	cups_raster_out(cups_raster_t *r, unsigned char *buf,
+		                size_t bytes);
 static unsigned	cups_raster_read_header(cups_raster_t *r);
 static ssize_t	cups_raster_read(cups_raster_t *r, unsigned char *buf,
 		                 size_t bytes);
+static void	cups_raster_simd(cups_raster_t *r);
 static int	cups_raster_update(cups_raster_t *r);
 static ssize_t	cups_raster_write(cups_raster_t *r,
 		                  const unsigned char *pixels);
@@ -84,12 +220,34 @@ cupsRasterClose(cups_raster_t *r)	/* I - Stream to close */
 {
   if (r != NULL)
   {
+#ifdef CUPS_RASTER_THREADS
+    if (r->num_threads)
+      cups_raster_band_close(r);
+#endif /* CUPS_RASTER_THREADS */
+
+#ifdef CUPS_RASTER_MMAP
+    if (r->map)
+    {
+     /*
+      * Leave the file positioned after the data that was read...
+      */
+
+      if (r->bufptr >= r->map && r->bufptr <= r->map + r->mapsize)
+        lseek((int)((intptr_t)r->ctx), (off_t)(r->bufptr - r->map), SEEK_SET);
+
+      munmap(r->map, r->mapsize);
+    }
+#endif /* CUPS_RASTER_MMAP */
+
     if (r->buffer)
       free(r->buffer);
 
     if (r->pixels)
       free(r->pixels);
 
+    if (r->line)
+      free(r->line);
+
     free(r);
   }
 }
@@ -107,6 +265,14 @@ cupsRasterClose(cups_raster_t *r)	/* I - Stream to close */
  * @code CUPS_RASTER_WRITE_COMPRESS@, or @code CUPS_RASTER_WRITE_PWG@ mode can
  * be used - compressed and PWG output is generally 25-50% smaller but adds a
  * 100-300% execution time overhead.
+ *
+ * The @code CUPS_RASTER_WRITE_COMPRESSED_THREADED@ and
+ * @code CUPS_RASTER_WRITE_PWG_THREADED@ modes produce the same output but
+ * compress bands of lines on background threads while the caller renders the
+ * following lines.  The "CUPS_RASTER_THREADS" environment variable sets the
+ * number of threads (default is one less than the number of processors, 0
+ * disables the threads).  Write errors in these modes may be reported by a
+ * later call than the one that supplied the failing data.
  */
 
 cups_raster_t *				/* O - New stream */
@@ -114,7 +280,9 @@ cupsRasterOpen(int         fd,		/* I - File descriptor */
                cups_mode_t mode)	/* I - Mode - @code CUPS_RASTER_READ@,
 	                                       @code CUPS_RASTER_WRITE@,
 					       @code CUPS_RASTER_WRITE_COMPRESSED@,
-					       or @code CUPS_RASTER_WRITE_PWG@ */
+					       @code CUPS_RASTER_WRITE_PWG@,
+					       @code CUPS_RASTER_WRITE_COMPRESSED_THREADED@,
+					       or @code CUPS_RASTER_WRITE_PWG_THREADED@ */
 {
   if (mode == CUPS_RASTER_READ)
     return (cupsRasterOpenIO(cups_read_fd, (void *)((intptr_t)fd), mode));
@@ -133,6 +301,14 @@ cupsRasterOpen(int         fd,		/* I - File descriptor */
  * @code CUPS_RASTER_WRITE_COMPRESS@, or @code CUPS_RASTER_WRITE_PWG@ mode can
  * be used - compressed and PWG output is generally 25-50% smaller but adds a
  * 100-300% execution time overhead.
+ *
+ * The @code CUPS_RASTER_WRITE_COMPRESSED_THREADED@ and
+ * @code CUPS_RASTER_WRITE_PWG_THREADED@ modes produce the same output but
+ * compress bands of lines on background threads while the caller renders the
+ * following lines.  The "CUPS_RASTER_THREADS" environment variable sets the
+ * number of threads (default is one less than the number of processors, 0
+ * disables the threads).  Write errors in these modes may be reported by a
+ * later call than the one that supplied the failing data.
  */
 
 cups_raster_t *				/* O - New stream */
@@ -142,9 +318,12 @@ cupsRasterOpenIO(
     cups_mode_t        mode)		/* I - Mode - @code CUPS_RASTER_READ@,
 	                                       @code CUPS_RASTER_WRITE@,
 					       @code CUPS_RASTER_WRITE_COMPRESSED@,
-					       or @code CUPS_RASTER_WRITE_PWG@ */
+					       @code CUPS_RASTER_WRITE_PWG@,
+					       @code CUPS_RASTER_WRITE_COMPRESSED_THREADED@,
+					       or @code CUPS_RASTER_WRITE_PWG_THREADED@ */
 {
   cups_raster_t	*r;			/* New stream */
+  int		threaded = 0;		/* Compress using threads? */
 
 
   _cupsRasterClearError();
@@ -160,8 +339,20 @@ cupsRasterOpenIO(
   r->iocb = iocb;
   r->mode = mode;
 
+  cups_raster_simd(r);
+
   if (mode == CUPS_RASTER_READ)
   {
+#ifdef CUPS_RASTER_MMAP
+   /*
+    * Regular files opened with cupsRasterOpen are read from a memory
+    * mapping...
+    */
+
+    if (iocb == cups_read_fd)
+      cups_raster_map(r);
+#endif /* CUPS_RASTER_MMAP */
+
    /*
     * Open for read - get sync word...
     */
@@ -171,7 +362,7 @@ cupsRasterOpenIO(
     {
       _cupsRasterAddError("Unable to read header from raster stream: %s\n",
                           strerror(errno));
-      free(r);
+      cupsRasterClose(r);
       return (NULL);
     }
 
@@ -183,7 +374,7 @@ cupsRasterOpenIO(
         r->sync != CUPS_RASTER_REVSYNCv2)
     {
       _cupsRasterAddError("Unknown raster format %08x!\n", r->sync);
-      free(r);
+      cupsRasterClose(r);
       return (NULL);
     }
 
@@ -221,6 +412,21 @@ cupsRasterOpenIO(
           r->sync       = htonl(CUPS_RASTER_SYNC_PWG);
           r->swapped    = r->sync != CUPS_RASTER_SYNC_PWG;
 	  break;
+
+      case CUPS_RASTER_WRITE_COMPRESSED_THREADED :
+          threaded      = 1;
+          r->mode       = CUPS_RASTER_WRITE_COMPRESSED;
+          r->compressed = 1;
+          r->sync       = CUPS_RASTER_SYNCv2;
+	  break;
+
+      case CUPS_RASTER_WRITE_PWG_THREADED :
+          threaded      = 1;
+          r->mode       = CUPS_RASTER_WRITE_PWG;
+          r->compressed = 1;
+          r->sync       = htonl(CUPS_RASTER_SYNC_PWG);
+          r->swapped    = r->sync != CUPS_RASTER_SYNC_PWG;
+	  break;
     }
 
     if (cups_raster_io(r, (unsigned char *)&(r->sync), sizeof(r->sync)) < (ssize_t)sizeof(r->sync))
@@ -230,6 +436,13 @@ cupsRasterOpenIO(
       free(r);
       return (NULL);
     }
+
+#ifdef CUPS_RASTER_THREADS
+    if (threaded)
+      cups_raster_band_start(r);
+#else
+    (void)threaded;
+#endif /* CUPS_RASTER_THREADS */
   }
 
   return (r);
@@ -395,10 +608,14 @@ cupsRasterReadPixels(cups_raster_t *r,	/* I - Raster stream */
 	ptr = r->pixels;
 
      /*
-      * Read using a modified PackBits compression...
+      * Read using a modified PackBits compression; control bytes and short
+      * runs are taken straight from the read buffer when they are already
+      * there...
       */
 
-      if (!cups_raster_read(r, &byte, 1))
+      if (r->bufptr < r->bufend)
+        byte = *(r->bufptr)++;
+      else if (!cups_raster_read(r, &byte, 1))
       {
 	DEBUG_puts("1cupsRasterReadPixels: Read error, returning 0.");
 	return (0);
@@ -418,7 +635,9 @@ cupsRasterReadPixels(cups_raster_t *r,	/* I - Raster stream */
 	* Get a new repeat count...
 	*/
 
-        if (!cups_raster_read(r, &byte, 1))
+        if (r->bufptr < r->bufend)
+          byte = *(r->bufptr)++;
+        else if (!cups_raster_read(r, &byte, 1))
 	{
 	  DEBUG_puts("1cupsRasterReadPixels: Read error, returning 0.");
 	  return (0);
@@ -435,7 +654,12 @@ cupsRasterReadPixels(cups_raster_t *r,	/* I - Raster stream */
           if (count > (unsigned)bytes)
 	    count = (unsigned)bytes;
 
-          if (!cups_raster_read(r, temp, count))
+          if ((size_t)(r->bufend - r->bufptr) >= count)
+          {
+            memcpy(temp, r->bufptr, count);
+            r->bufptr += count;
+          }
+          else if (!cups_raster_read(r, temp, count))
 	  {
 	    DEBUG_puts("1cupsRasterReadPixels: Read error, returning 0.");
 	    return (0);
@@ -459,7 +683,12 @@ cupsRasterReadPixels(cups_raster_t *r,	/* I - Raster stream */
 
 	  bytes -= count;
 
-          if (!cups_raster_read(r, temp, r->bpp))
+          if ((size_t)(r->bufend - r->bufptr) >= r->bpp)
+          {
+            memcpy(temp, r->bufptr, r->bpp);
+            r->bufptr += r->bpp;
+          }
+          else if (!cups_raster_read(r, temp, r->bpp))
 	  {
 	    DEBUG_puts("1cupsRasterReadPixels: Read error, returning 0.");
 	    return (0);
@@ -468,11 +697,36 @@ cupsRasterReadPixels(cups_raster_t *r,	/* I - Raster stream */
 	  temp  += r->bpp;
 	  count -= r->bpp;
 
-	  while (count > 0)
-	  {
-	    memcpy(temp, temp - r->bpp, r->bpp);
-	    temp  += r->bpp;
-	    count -= r->bpp;
+          if (r->bpp == 1)
+          {
+           /*
+            * Single byte pixels are a plain fill...
+            */
+
+            memset(temp, temp[-1], count);
+            temp += count;
+          }
+          else
+          {
+           /*
+            * Otherwise double the copied run until the repeat is filled...
+            */
+
+            unsigned char	*run = temp - r->bpp;
+					/* Start of run */
+            unsigned		copied = r->bpp,
+					/* Bytes copied so far */
+			        copy;	/* Bytes to copy this time */
+
+	    while (count > 0)
+	    {
+	      copy = copied < count ? copied : count;
+
+	      memcpy(temp, run, copy);
+	      temp   += copy;
+	      copied += copy;
+	      count  -= copy;
+	    }
           }
 	}
       }
@@ -485,7 +739,7 @@ cupsRasterReadPixels(cups_raster_t *r,	/* I - Raster stream */
            r->header.cupsBitsPerPixel == 12 ||
            r->header.cupsBitsPerPixel == 16) &&
           r->swapped)
-        cups_swap(ptr, (size_t)bytes);
+        cups_swap(ptr, (size_t)cupsBytesPerLine);
 
      /*
       * Update pointers...
@@ -541,6 +795,78 @@ cupsRasterReadPixels(cups_raster_t *r,	/* I - Raster stream */
 }
 
 
+/*
+ * 'cupsRasterReadPixelsPtr()' - Read raster pixels without copying them.
+ *
+ * This function reads "len" bytes of raster data like
+ * @link cupsRasterReadPixels@ but returns a pointer to the pixels instead of
+ * copying them into a caller-supplied buffer.  When an uncompressed raster
+ * stream is read from a regular file using @link cupsRasterOpen@, the
+ * pointer refers directly to the file data.  Otherwise the pixels are
+ * decoded into a buffer that belongs to the raster stream.
+ *
+ * The returned pointer remains valid until the next call to
+ * @code cupsRasterReadPixelsPtr@, @link cupsRasterReadPixels@,
+ * @link cupsRasterReadHeader2@, or @link cupsRasterClose@.  The pixels must
+ * not be modified.
+ *
+ * @since CUPS 2.2@
+ */
+
+const unsigned char *			/* O - Pointer to pixels or @code NULL@ on error */
+cupsRasterReadPixelsPtr(
+    cups_raster_t *r,			/* I - Raster stream */
+    unsigned      len)			/* I - Number of bytes to read */
+{
+  unsigned char	*ptr;			/* Pointer to pixels */
+
+
+  DEBUG_printf(("cupsRasterReadPixelsPtr(r=%p, len=%u)", r, len));
+
+  if (r == NULL || r->mode != CUPS_RASTER_READ || r->remaining == 0 ||
+      r->header.cupsBytesPerLine == 0 || len == 0)
+    return (NULL);
+
+  if (r->map && !r->compressed &&
+      (size_t)(r->bufend - r->bufptr) >= len &&
+      r->bufptr >= r->map && r->bufptr < r->map + r->mapsize &&
+      !(r->swapped &&
+        (r->header.cupsBitsPerColor == 16 ||
+         r->header.cupsBitsPerPixel == 12 ||
+         r->header.cupsBitsPerPixel == 16)))
+  {
+   /*
+    * Return the mapped data directly...
+    */
+
+    r->remaining -= len / r->header.cupsBytesPerLine;
+
+    ptr       = r->bufptr;
+    r->bufptr += len;
+
+    return (ptr);
+  }
+
+ /*
+  * Otherwise read into the line buffer...
+  */
+
+  if (len > r->linesize)
+  {
+    if ((ptr = realloc(r->line, len)) == NULL)
+      return (NULL);
+
+    r->line     = ptr;
+    r->linesize = len;
+  }
+
+  if (cupsRasterReadPixels(r, r->line, len) != len)
+    return (NULL);
+
+  return (r->line);
+}
+
+
 /*
  * 'cupsRasterWriteHeader()' - Write a raster page header from a version 1 page
  *                             header structure.
@@ -651,10 +977,10 @@ cupsRasterWriteHeader(
     strlcpy(fh.cupsPageSizeName, r->header.cupsPageSizeName,
             sizeof(fh.cupsPageSizeName));
 
-    return (cups_raster_io(r, (unsigned char *)&fh, sizeof(fh)) == sizeof(fh));
+    return (cups_raster_out(r, (unsigned char *)&fh, sizeof(fh)) == sizeof(fh));
   }
   else
-    return (cups_raster_io(r, (unsigned char *)&(r->header), sizeof(r->header))
+    return (cups_raster_out(r, (unsigned char *)&(r->header), sizeof(r->header))
 		== sizeof(r->header));
 }
 
@@ -745,10 +1071,10 @@ cupsRasterWriteHeader2(
     fh.cupsInteger[6]        = htonl((unsigned)(r->header.cupsImagingBBox[3] * r->header.HWResolution[1] / 72.0));
     fh.cupsInteger[7]        = htonl(0xffffff);
 
-    return (cups_raster_io(r, (unsigned char *)&fh, sizeof(fh)) == sizeof(fh));
+    return (cups_raster_out(r, (unsigned char *)&fh, sizeof(fh)) == sizeof(fh));
   }
   else
-    return (cups_raster_io(r, (unsigned char *)&(r->header), sizeof(r->header))
+    return (cups_raster_out(r, (unsigned char *)&(r->header), sizeof(r->header))
 		== sizeof(r->header));
 }
 
@@ -858,7 +1184,7 @@ cupsRasterWritePixels(cups_raster_t *r,	/* I - Raster stream */
       * Check to see if this line is the same as the previous line...
       */
 
-      if (memcmp(p, r->pcurrent, (size_t)bytes))
+      if ((*r->mismatch)(p, r->pcurrent, (size_t)bytes) < (size_t)bytes)
       {
         if (cups_raster_write(r, r->pixels) <= 0)
 	  return (0);
@@ -946,6 +1272,115 @@ cupsRasterWritePixels(cups_raster_t *r,	/* I - Raster stream */
 }
 
 
+#ifdef CUPS_RASTER_MMAP
+/*
+ * 'cups_raster_map()' - Map a regular file for reading.
+ *
+ * The buffer pointers are set to the mapped data after the current file
+ * position and the file is positioned after the mapped data, so reads
+ * continue normally if the file grows.
+ */
+
+static void
+cups_raster_map(cups_raster_t *r)	/* I - Raster stream */
+{
+  int		fd = (int)((intptr_t)r->ctx);
+					/* File descriptor */
+  struct stat	fileinfo;		/* File information */
+  off_t		pos;			/* Current position */
+  void		*map;			/* Mapped file */
+
+
+  if (fstat(fd, &fileinfo) || !S_ISREG(fileinfo.st_mode) ||
+      (off_t)(size_t)fileinfo.st_size != fileinfo.st_size ||
+      (pos = lseek(fd, 0, SEEK_CUR)) < 0 || pos >= fileinfo.st_size)
+    return;
+
+  if ((map = mmap(NULL, (size_t)fileinfo.st_size, PROT_READ, MAP_PRIVATE, fd,
+                  0)) == MAP_FAILED)
+    return;
+
+  if (lseek(fd, fileinfo.st_size, SEEK_SET) < 0)
+  {
+    munmap(map, (size_t)fileinfo.st_size);
+    return;
+  }
+
+#  ifdef MADV_SEQUENTIAL
+  madvise(map, (size_t)fileinfo.st_size, MADV_SEQUENTIAL);
+#  endif /* MADV_SEQUENTIAL */
+
+  r->map     = (unsigned char *)map;
+  r->mapsize = (size_t)fileinfo.st_size;
+  r->bufptr  = r->map + pos;
+  r->bufend  = r->map + r->mapsize;
+
+  DEBUG_printf(("4cups_raster_map: Mapped " CUPS_LLFMT " bytes, starting at " CUPS_LLFMT ".", CUPS_LLCAST r->mapsize, CUPS_LLCAST pos));
+}
+#endif /* CUPS_RASTER_MMAP */
+
+
+/*
+ * 'cups_raster_out()' - Write uncompressed data such as a page header.
+ *
+ * When compression threads are used, the data is queued behind the bands
+ * that are still being compressed.
+ */
+
+static ssize_t				/* O - Bytes written or -1 */
+cups_raster_out(cups_raster_t *r,	/* I - Raster stream */
+                unsigned char *buf,	/* I - Buffer */
+                size_t        bytes)	/* I - Number of bytes to write */
+{
+#ifdef CUPS_RASTER_THREADS
+  if (r->num_threads)
+  {
+    _cups_raster_band_t	*band;		/* Band for data */
+    unsigned char	*out;		/* New output buffer */
+
+
+    if ((band = r->band) != NULL)
+    {
+     /*
+      * Queue the partial band from the previous page first...
+      */
+
+      r->band     = NULL;
+      band->state = _CUPS_RASTER_BAND_QUEUED;
+
+      if (!cups_raster_band_queue(r, band))
+        return (-1);
+    }
+
+    if ((band = cups_raster_band_new(r, 0)) == NULL)
+      return (-1);
+
+    if (bytes > band->outsize)
+    {
+      if ((out = realloc(band->out, bytes)) == NULL)
+      {
+        band->next    = r->free_bands;
+	r->free_bands = band;
+
+        return (-1);
+      }
+
+      band->out     = out;
+      band->outsize = bytes;
+    }
+
+    memcpy(band->out, buf, bytes);
+    band->outlen = bytes;
+    band->state  = _CUPS_RASTER_BAND_DONE;
+
+    return (cups_raster_band_queue(r, band) ? (ssize_t)bytes : -1);
+  }
+#endif /* CUPS_RASTER_THREADS */
+
+  return (cups_raster_io(r, buf, bytes));
+}
+
+
 /*
  * 'cups_raster_read_header()' - Read a raster page header.
  */
@@ -1026,148 +1461,936 @@ cups_raster_read_header(
 }
 
 
+#ifdef CUPS_RASTER_AVX2
 /*
- * 'cups_raster_io()' - Read/write bytes from a context, handling interruptions.
+ * 'cups_match_avx2()' - Find the first matching pixel using AVX2.
  */
 
-static ssize_t				/* O - Bytes read/write or -1 */
-cups_raster_io(cups_raster_t *r,	/* I - Raster stream */
-               unsigned char *buf,	/* I - Buffer for read/write */
-               size_t        bytes)	/* I - Number of bytes to read/write */
+static size_t				/* O - Offset of match or "n" */
+cups_match_avx2(const unsigned char *a,	/* I - First buffer */
+                const unsigned char *b,	/* I - Second buffer */
+		size_t              n,	/* I - Number of bytes to compare */
+		unsigned            bpp)/* I - Bytes per pixel */
 {
-  ssize_t	count,			/* Number of bytes read/written */
-		total;			/* Total bytes read/written */
-
+  size_t	i,			/* Offset in buffers */
+		match;			/* Offset of match */
 
-  DEBUG_printf(("5cups_raster_io(r=%p, buf=%p, bytes=" CUPS_LLFMT ")", r, buf, CUPS_LLCAST bytes));
-
-  for (total = 0; total < (ssize_t)bytes; total += count, buf += count)
-  {
-    count = (*r->iocb)(r->ctx, buf, bytes - (size_t)total);
-
-    DEBUG_printf(("6cups_raster_io: count=%d, total=%d", (int)count, (int)total));
-    if (count == 0)
-    {
-      DEBUG_puts("6cups_raster_io: Returning 0.");
-      return (0);
-    }
-    else if (count < 0)
-    {
-      DEBUG_puts("6cups_raster_io: Returning -1 on error.");
-      return (-1);
-    }
 
-#ifdef DEBUG
-    r->iocount += (size_t)count;
-#endif /* DEBUG */
-  }
+  for (i = 0; i + 32 <= n; i += 32)
+    if ((match = cups_match_mask(a, b, i, n, bpp, (unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)(a + i)), _mm256_loadu_si256((const __m256i *)(b + i)))))) < n)
+      return (match);
 
-  DEBUG_printf(("6cups_raster_io: Returning " CUPS_LLFMT ".", CUPS_LLCAST total));
+  i -= i % bpp;
 
-  return (total);
+  return (i + cups_match_c(a + i, b + i, n - i, bpp));
 }
+#endif /* CUPS_RASTER_AVX2 */
 
 
 /*
- * 'cups_raster_read()' - Read through the raster buffer.
+ * 'cups_match_c()' - Find the first matching pixel.
  */
 
-static ssize_t				/* O - Number of bytes read */
-cups_raster_read(cups_raster_t *r,	/* I - Raster stream */
-                 unsigned char *buf,	/* I - Buffer */
-                 size_t        bytes)	/* I - Number of bytes to read */
+static size_t				/* O - Offset of match or "n" */
+cups_match_c(const unsigned char *a,	/* I - First buffer */
+             const unsigned char *b,	/* I - Second buffer */
+	     size_t              n,	/* I - Number of bytes to compare */
+	     unsigned            bpp)	/* I - Bytes per pixel */
 {
-  ssize_t	count,			/* Number of bytes read */
-		remaining,		/* Remaining bytes in buffer */
-		total;			/* Total bytes read */
-
-
-  DEBUG_printf(("5cups_raster_read(r=%p, buf=%p, bytes=" CUPS_LLFMT ")\n", r, buf, CUPS_LLCAST bytes));
+  size_t	i;			/* Offset in buffers */
+  unsigned	j;			/* Offset in pixel */
 
-  if (!r->compressed)
-    return (cups_raster_io(r, buf, bytes));
 
- /*
-  * Allocate a read buffer as needed...
-  */
+  for (i = 0; i < n; i += bpp)
+  {
+    for (j = 0; j < bpp && a[i + j] == b[i + j]; j ++);
 
-  count = (ssize_t)(2 * r->header.cupsBytesPerLine);
-  if (count < 65536)
-    count = 65536;
+    if (j == bpp)
+      break;
+  }
 
-  if ((size_t)count > r->bufsize)
-  {
-    ssize_t offset = r->bufptr - r->buffer;
-					/* Offset to current start of buffer */
-    ssize_t end = r->bufend - r->buffer;/* Offset to current end of buffer */
-    unsigned char *rptr;		/* Pointer in read buffer */
+  return (i < n ? i : n);
+}
 
-    if (r->buffer)
-      rptr = realloc(r->buffer, (size_t)count);
-    else
-      rptr = malloc((size_t)count);
 
-    if (!rptr)
-      return (0);
+#if defined(CUPS_RASTER_SSE2) || defined(CUPS_RASTER_AVX2)
+/*
+ * 'cups_match_mask()' - Find the first matching pixel from a vector
+ *                       comparison mask.
+ *
+ * Bit N of "mask" is set when byte "i" + N matches.  The common pixel sizes
+ * are folded into one bit per pixel; other sizes check each candidate pixel.
+ */
 
-    r->buffer  = rptr;
-    r->bufptr  = rptr + offset;
-    r->bufend  = rptr + end;
-    r->bufsize = (size_t)count;
-  }
+static size_t				/* O - Offset of match or "n" */
+cups_match_mask(const unsigned char *a,	/* I - First buffer */
+                const unsigned char *b,	/* I - Second buffer */
+		size_t              i,	/* I - Offset of mask in buffers */
+		size_t              n,	/* I - Number of bytes to compare */
+		unsigned            bpp,/* I - Bytes per pixel */
+		unsigned            mask)/* I - Byte comparison mask */
+{
+  size_t	pixel;			/* Offset of candidate pixel */
 
- /*
-  * Loop until we have read everything...
-  */
 
-  for (total = 0, remaining = (int)(r->bufend - r->bufptr);
-       total < (ssize_t)bytes;
-       total += count, buf += count)
+  switch (bpp)
   {
-    count = (ssize_t)bytes - total;
+    case 1 :
+        break;
+
+    case 2 :
+        mask &= (mask >> 1) & 0x55555555;
+        break;
+
+    case 4 :
+        mask &= mask >> 1;
+        mask &= (mask >> 2) & 0x11111111;
+        break;
+
+    case 8 :
+        mask &= mask >> 1;
+        mask &= mask >> 2;
+        mask &= (mask >> 4) & 0x01010101;
+        break;
+
+    default :
+        while (mask)
+	{
+	  pixel = i + (size_t)__builtin_ctz(mask);
+	  pixel -= pixel % bpp;
 
-    DEBUG_printf(("6cups_raster_read: count=" CUPS_LLFMT ", remaining=" CUPS_LLFMT ", buf=%p, bufptr=%p, bufend=%p", CUPS_LLCAST count, CUPS_LLCAST remaining, buf, r->bufptr, r->bufend));
+	  if (!memcmp(a + pixel, b + pixel, bpp))
+	    return (pixel);
 
-    if (remaining == 0)
-    {
-      if (count < 16)
-      {
-       /*
-        * Read into the raster buffer and then copy...
-	*/
+          if (pixel + bpp - i >= 32)
+	    break;
 
-        remaining = (*r->iocb)(r->ctx, r->buffer, r->bufsize);
-	if (remaining <= 0)
-	  return (0);
+          mask &= ~0U << (pixel + bpp - i);
+	}
 
-	r->bufptr = r->buffer;
-	r->bufend = r->buffer + remaining;
+        return (n);
+  }
 
-#ifdef DEBUG
-        r->iocount += (size_t)remaining;
-#endif /* DEBUG */
-      }
-      else
-      {
-       /*
-        * Read directly into "buf"...
-	*/
+  return (mask ? i + (size_t)__builtin_ctz(mask) : n);
+}
+#endif /* CUPS_RASTER_SSE2 || CUPS_RASTER_AVX2 */
 
-	count = (*r->iocb)(r->ctx, buf, (size_t)count);
 
-	if (count <= 0)
-	  return (0);
+#ifdef CUPS_RASTER_NEON
+/*
+ * 'cups_match_neon()' - Find the first matching pixel using NEON.
+ */
 
-#ifdef DEBUG
-        r->iocount += (size_t)count;
-#endif /* DEBUG */
+static size_t				/* O - Offset of match or "n" */
+cups_match_neon(const unsigned char *a,	/* I - First buffer */
+                const unsigned char *b,	/* I - Second buffer */
+		size_t              n,	/* I - Number of bytes to compare */
+		unsigned            bpp)/* I - Bytes per pixel */
+{
+  size_t	i,			/* Offset in buffers */
+		pixel,			/* Offset of first pixel in block */
+		end,			/* Offset after last pixel in block */
+		match;			/* Offset of match */
 
-	continue;
-      }
-    }
+
+  for (i = 0; i + 16 <= n; i += 16)
+  {
+    if (!vmaxvq_u8(vceqq_u8(vld1q_u8(a + i), vld1q_u8(b + i))))
+      continue;
 
    /*
-    * Copy bytes from raster buffer to "buf"...
+    * Some bytes match, check the pixels in this block...
+    */
+
+    pixel = i - i % bpp;
+    if ((end = i + 16 + bpp - 1) > n)
+      end = n;
+    end -= end % bpp;
+
+    if ((match = cups_match_c(a + pixel, b + pixel, end - pixel, bpp)) < end - pixel)
+      return (pixel + match);
+  }
+
+  i -= i % bpp;
+
+  return (i + cups_match_c(a + i, b + i, n - i, bpp));
+}
+#endif /* CUPS_RASTER_NEON */
+
+
+#ifdef CUPS_RASTER_SSE2
+/*
+ * 'cups_match_sse2()' - Find the first matching pixel using SSE2.
+ */
+
+static size_t				/* O - Offset of match or "n" */
+cups_match_sse2(const unsigned char *a,	/* I - First buffer */
+                const unsigned char *b,	/* I - Second buffer */
+		size_t              n,	/* I - Number of bytes to compare */
+		unsigned            bpp)/* I - Bytes per pixel */
+{
+  size_t	i,			/* Offset in buffers */
+		match;			/* Offset of match */
+
+
+  for (i = 0; i + 16 <= n; i += 16)
+    if ((match = cups_match_mask(a, b, i, n, bpp, (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(a + i)), _mm_loadu_si128((const __m128i *)(b + i)))))) < n)
+      return (match);
+
+  i -= i % bpp;
+
+  return (i + cups_match_c(a + i, b + i, n - i, bpp));
+}
+#endif /* CUPS_RASTER_SSE2 */
+
+
+#ifdef CUPS_RASTER_AVX2
+/*
+ * 'cups_mismatch_avx2()' - Find the first differing byte using AVX2.
+ */
+
+static size_t				/* O - Offset of difference or "n" */
+cups_mismatch_avx2(
+    const unsigned char *a,		/* I - First buffer */
+    const unsigned char *b,		/* I - Second buffer */
+    size_t              n)		/* I - Number of bytes to compare */
+{
+  size_t	i;			/* Offset in buffers */
+  unsigned	mask;			/* Comparison mask */
+
+
+  for (i = 0; i + 32 <= n; i += 32)
+  {
+    mask = (unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)(a + i)), _mm256_loadu_si256((const __m256i *)(b + i))));
+
+    if (mask != 0xffffffff)
+      return (i + (size_t)__builtin_ctz(~mask));
+  }
+
+  if (i + 16 <= n)
+  {
+    mask = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(a + i)), _mm_loadu_si128((const __m128i *)(b + i))));
+
+    if (mask != 0xffff)
+      return (i + (size_t)__builtin_ctz(~mask));
+
+    i += 16;
+  }
+
+  return (i + cups_mismatch_c(a + i, b + i, n - i));
+}
+#endif /* CUPS_RASTER_AVX2 */
+
+
+/*
+ * 'cups_mismatch_c()' - Find the first differing byte.
+ */
+
+static size_t				/* O - Offset of difference or "n" */
+cups_mismatch_c(const unsigned char *a,	/* I - First buffer */
+                const unsigned char *b,	/* I - Second buffer */
+	        size_t              n)	/* I - Number of bytes to compare */
+{
+  size_t	i;			/* Offset in buffers */
+
+
+  for (i = 0; i < n && a[i] == b[i]; i ++);
+
+  return (i);
+}
+
+
+#ifdef CUPS_RASTER_NEON
+/*
+ * 'cups_mismatch_neon()' - Find the first differing byte using NEON.
+ */
+
+static size_t				/* O - Offset of difference or "n" */
+cups_mismatch_neon(
+    const unsigned char *a,		/* I - First buffer */
+    const unsigned char *b,		/* I - Second buffer */
+    size_t              n)		/* I - Number of bytes to compare */
+{
+  size_t	i;			/* Offset in buffers */
+
+
+  for (i = 0; i + 16 <= n; i += 16)
+    if (vminvq_u8(vceqq_u8(vld1q_u8(a + i), vld1q_u8(b + i))) != 0xff)
+      break;
+
+  return (i + cups_mismatch_c(a + i, b + i, n - i));
+}
+#endif /* CUPS_RASTER_NEON */
+
+
+#ifdef CUPS_RASTER_SSE2
+/*
+ * 'cups_mismatch_sse2()' - Find the first differing byte using SSE2.
+ */
+
+static size_t				/* O - Offset of difference or "n" */
+cups_mismatch_sse2(
+    const unsigned char *a,		/* I - First buffer */
+    const unsigned char *b,		/* I - Second buffer */
+    size_t              n)		/* I - Number of bytes to compare */
+{
+  size_t	i;			/* Offset in buffers */
+  unsigned	mask;			/* Comparison mask */
+
+
+  for (i = 0; i + 16 <= n; i += 16)
+  {
+    mask = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(a + i)), _mm_loadu_si128((const __m128i *)(b + i))));
+
+    if (mask != 0xffff)
+      return (i + (size_t)__builtin_ctz(~mask));
+  }
+
+  return (i + cups_mismatch_c(a + i, b + i, n - i));
+}
+#endif /* CUPS_RASTER_SSE2 */
+
+
+#ifdef CUPS_RASTER_THREADS
+/*
+ * 'cups_raster_band_add()' - Add a row to the current band.
+ */
+
+static int				/* O - 1 on success, 0 on failure */
+cups_raster_band_add(
+    cups_raster_t       *r,		/* I - Raster stream */
+    const unsigned char *pixels,	/* I - Pixel data to add */
+    int                 swap)		/* I - Swap bytes in the copy? */
+{
+  _cups_raster_band_t	*band;		/* Current band */
+  unsigned		bytes = r->header.cupsBytesPerLine;
+					/* Bytes per line */
+  size_t		datasize;	/* Size of band data */
+
+
+  if ((band = r->band) == NULL)
+  {
+   /*
+    * Start a new band...
+    */
+
+    if ((datasize = _CUPS_RASTER_BAND_SIZE) < bytes + 1)
+      datasize = bytes + 1;
+
+    if ((band = cups_raster_band_new(r, datasize)) == NULL)
+      return (0);
+
+    band->bpp   = r->bpp;
+    band->bytes = bytes;
+    r->band     = band;
+  }
+
+ /*
+  * Each row is stored as the repeat count followed by the pixels...
+  */
+
+  band->data[band->datalen ++] = (unsigned char)(r->count - 1);
+  memcpy(band->data + band->datalen, pixels, bytes);
+  if (swap)
+    cups_swap(band->data + band->datalen, bytes);
+  band->datalen += bytes;
+
+ /*
+  * Queue the band once it is full or the page is done...
+  */
+
+  if (r->remaining == 0 || band->datalen + bytes + 1 > band->datasize)
+  {
+    r->band     = NULL;
+    band->state = _CUPS_RASTER_BAND_QUEUED;
+
+    return (cups_raster_band_queue(r, band));
+  }
+
+  return (1);
+}
+
+
+/*
+ * 'cups_raster_band_close()' - Write any remaining bands and stop the
+ *                              compression threads.
+ */
+
+static void
+cups_raster_band_close(cups_raster_t *r)/* I - Raster stream */
+{
+  int			i;		/* Looping var */
+  _cups_raster_band_t	*band;		/* Current band */
+
+
+  if ((band = r->band) != NULL)
+  {
+    r->band     = NULL;
+    band->state = _CUPS_RASTER_BAND_QUEUED;
+
+    cups_raster_band_queue(r, band);
+  }
+
+  cups_raster_band_flush(r, 0);
+
+  pthread_mutex_lock(&r->band_mutex);
+  r->shutdown = 1;
+  pthread_cond_broadcast(&r->band_cond);
+  pthread_mutex_unlock(&r->band_mutex);
+
+  for (i = 0; i < r->num_threads; i ++)
+    pthread_join(r->threads[i], NULL);
+
+  pthread_cond_destroy(&r->band_cond);
+  pthread_cond_destroy(&r->done_cond);
+  pthread_mutex_destroy(&r->band_mutex);
+
+  while ((band = r->free_bands) != NULL)
+  {
+    r->free_bands = band->next;
+
+    if (band->data)
+      free(band->data);
+    if (band->out)
+      free(band->out);
+
+    free(band);
+  }
+
+  r->num_threads = 0;
+}
+
+
+/*
+ * 'cups_raster_band_flush()' - Write compressed bands in order.
+ *
+ * Bands are written as long as the first band is done.  If more than
+ * "max_bands" bands remain, wait for the threads to finish some more.
+ */
+
+static int				/* O - 1 on success, 0 on failure */
+cups_raster_band_flush(
+    cups_raster_t *r,			/* I - Raster stream */
+    int           max_bands)		/* I - Maximum bands left pending */
+{
+  _cups_raster_band_t	*band;		/* Current band */
+  int			error,		/* Write error? */
+			status;		/* Return status */
+
+
+  pthread_mutex_lock(&r->band_mutex);
+
+  for (;;)
+  {
+    while ((band = r->first_band) != NULL &&
+           band->state == _CUPS_RASTER_BAND_DONE)
+    {
+      if ((r->first_band = band->next) == NULL)
+        r->last_band = NULL;
+
+      r->num_bands --;
+      error = r->band_error;
+
+     /*
+      * Only this thread writes, so the output stays in order...
+      */
+
+      pthread_mutex_unlock(&r->band_mutex);
+
+      if (!error && cups_raster_io(r, band->out, band->outlen) < (ssize_t)band->outlen)
+        error = 1;
+
+      band->next    = r->free_bands;
+      r->free_bands = band;
+
+      pthread_mutex_lock(&r->band_mutex);
+
+      if (error)
+        r->band_error = 1;
+    }
+
+    if (r->num_bands <= max_bands)
+      break;
+
+    pthread_cond_wait(&r->done_cond, &r->band_mutex);
+  }
+
+  status = !r->band_error;
+
+  pthread_mutex_unlock(&r->band_mutex);
+
+  return (status);
+}
+
+
+/*
+ * 'cups_raster_band_new()' - Get an empty band.
+ */
+
+static _cups_raster_band_t *		/* O - Band or NULL on error */
+cups_raster_band_new(
+    cups_raster_t *r,			/* I - Raster stream */
+    size_t        datasize)		/* I - Size of line data */
+{
+  _cups_raster_band_t	*band;		/* New band */
+  unsigned char		*data;		/* New line data buffer */
+
+
+  if ((band = r->free_bands) != NULL)
+    r->free_bands = band->next;
+  else if ((band = calloc(1, sizeof(_cups_raster_band_t))) == NULL)
+    return (NULL);
+
+  if (datasize > band->datasize)
+  {
+    if ((data = realloc(band->data, datasize)) == NULL)
+    {
+      band->next    = r->free_bands;
+      r->free_bands = band;
+
+      return (NULL);
+    }
+
+    band->data     = data;
+    band->datasize = datasize;
+  }
+
+  band->next    = NULL;
+  band->datalen = 0;
+  band->outlen  = 0;
+
+  return (band);
+}
+
+
+/*
+ * 'cups_raster_band_queue()' - Queue a band for compression and output.
+ */
+
+static int				/* O - 1 on success, 0 on failure */
+cups_raster_band_queue(
+    cups_raster_t       *r,		/* I - Raster stream */
+    _cups_raster_band_t *band)		/* I - Band to queue */
+{
+  pthread_mutex_lock(&r->band_mutex);
+
+  if (r->last_band)
+    r->last_band->next = band;
+  else
+    r->first_band = band;
+
+  r->last_band = band;
+  r->num_bands ++;
+
+  if (band->state == _CUPS_RASTER_BAND_QUEUED)
+    pthread_cond_signal(&r->band_cond);
+
+  pthread_mutex_unlock(&r->band_mutex);
+
+ /*
+  * Write what is ready, and keep each thread busy with at most two bands so
+  * that memory use stays bounded...
+  */
+
+  return (cups_raster_band_flush(r, 2 * r->num_threads));
+}
+
+
+/*
+ * 'cups_raster_band_start()' - Start the compression threads.
+ */
+
+static void
+cups_raster_band_start(cups_raster_t *r)/* I - Raster stream */
+{
+  int		i,			/* Looping var */
+		num_threads;		/* Number of threads */
+  const char	*value;			/* Environment variable */
+
+
+  if ((value = getenv("CUPS_RASTER_THREADS")) != NULL)
+    num_threads = atoi(value);
+  else
+  {
+#ifdef _SC_NPROCESSORS_ONLN
+    if ((num_threads = (int)sysconf(_SC_NPROCESSORS_ONLN) - 1) < 1)
+#endif /* _SC_NPROCESSORS_ONLN */
+    num_threads = 1;
+  }
+
+  if (num_threads <= 0)
+    return;				/* Compress in the caller's thread */
+  else if (num_threads > _CUPS_RASTER_MAX_THREADS)
+    num_threads = _CUPS_RASTER_MAX_THREADS;
+
+  pthread_mutex_init(&r->band_mutex, NULL);
+  pthread_cond_init(&r->band_cond, NULL);
+  pthread_cond_init(&r->done_cond, NULL);
+
+  for (i = 0; i < num_threads; i ++)
+    if (pthread_create(r->threads + i, NULL, (void *(*)(void *))cups_raster_band_thread, r))
+      break;
+
+  DEBUG_printf(("4cups_raster_band_start: Started %d of %d threads.", i, num_threads));
+
+  if ((r->num_threads = i) == 0)
+  {
+    pthread_cond_destroy(&r->band_cond);
+    pthread_cond_destroy(&r->done_cond);
+    pthread_mutex_destroy(&r->band_mutex);
+  }
+}
+
+
+/*
+ * 'cups_raster_band_thread()' - Compress queued bands.
+ */
+
+static void *				/* O - Exit status (unused) */
+cups_raster_band_thread(
+    cups_raster_t *r)			/* I - Raster stream */
+{
+  _cups_raster_band_t	*band;		/* Current band */
+  unsigned char		*ptr,		/* Pointer into line data */
+			*end,		/* End of line data */
+			*wptr;		/* Pointer into compressed data */
+  size_t		outsize;	/* Size needed for compressed data */
+  int			error;		/* Non-zero on error */
+
+
+  pthread_mutex_lock(&r->band_mutex);
+
+  while (!r->shutdown)
+  {
+   /*
+    * Find the oldest band that needs compressing...
+    */
+
+    for (band = r->first_band; band; band = band->next)
+      if (band->state == _CUPS_RASTER_BAND_QUEUED)
+        break;
+
+    if (!band)
+    {
+      pthread_cond_wait(&r->band_cond, &r->band_mutex);
+      continue;
+    }
+
+    band->state = _CUPS_RASTER_BAND_COMPRESSING;
+
+    pthread_mutex_unlock(&r->band_mutex);
+
+   /*
+    * Compress each row - the compressed row is never more than twice the
+    * size of the row plus the repeat count...
+    */
+
+    outsize = band->datalen / (band->bytes + 1) * (2 * band->bytes + 2);
+    error   = 0;
+
+    if (outsize > band->outsize)
+    {
+      if ((wptr = realloc(band->out, outsize)) != NULL)
+      {
+        band->out     = wptr;
+	band->outsize = outsize;
+      }
+      else
+        error = 1;
+    }
+
+    if (!error)
+    {
+      for (ptr = band->data, end = band->data + band->datalen, wptr = band->out;
+	   ptr < end;
+	   ptr += band->bytes + 1)
+      {
+	*wptr++ = *ptr;
+	wptr    = cups_raster_encode(r, ptr + 1, band->bytes, band->bpp, wptr);
+      }
+
+      band->outlen = (size_t)(wptr - band->out);
+    }
+
+    pthread_mutex_lock(&r->band_mutex);
+
+    if (error)
+      r->band_error = 1;
+
+    band->state = _CUPS_RASTER_BAND_DONE;
+    pthread_cond_signal(&r->done_cond);
+  }
+
+  pthread_mutex_unlock(&r->band_mutex);
+
+  return (NULL);
+}
+#endif /* CUPS_RASTER_THREADS */
+
+
+/*
+ * 'cups_raster_encode()' - Compress a row of raster data.
+ *
+ * The output buffer must hold at least twice "bytes" bytes.
+ */
+
+static unsigned char *			/* O - End of compressed data */
+cups_raster_encode(
+    cups_raster_t       *r,		/* I - Raster stream */
+    const unsigned char *pixels,	/* I - Pixel data to compress */
+    unsigned            bytes,		/* I - Bytes per line */
+    unsigned            bpp,		/* I - Bytes per pixel */
+    unsigned char       *wptr)		/* I - Output buffer */
+{
+  const unsigned char	*start,		/* Start of sequence */
+			*ptr,		/* Current pointer in sequence */
+			*pend,		/* End of raster buffer */
+			*plast;		/* Pointer to last pixel */
+  unsigned		count;		/* Count */
+  size_t		avail,		/* Bytes that can be compared */
+			length,		/* Bytes to scan */
+			offset;		/* Offset of first (mis)match */
+  int			shift;		/* Bytes per pixel as a shift or -1 */
+
+
+  pend  = pixels + bytes;
+  plast = pend - bpp;
+
+  for (shift = 0; (1U << shift) < bpp; shift ++);
+
+  if ((1U << shift) != bpp)
+    shift = -1;				/* Not a power of 2, need to divide */
+
+ /*
+  * Write using a modified PackBits compression...
+  */
+
+  for (ptr = pixels; ptr < pend;)
+  {
+    start = ptr;
+    ptr += bpp;
+
+    if (ptr == pend)
+    {
+     /*
+      * Encode a single pixel at the end...
+      */
+
+      *wptr++ = 0;
+      for (count = bpp; count > 0; count --)
+        *wptr++ = *start++;
+
+      continue;
+    }
+
+    avail = (size_t)(plast - start);
+
+    if (bpp == 1 ? *start == *ptr : !memcmp(start, ptr, bpp))
+    {
+     /*
+      * Encode a sequence of repeating pixels - a pixel repeats as long as
+      * every byte matches the byte "bpp" bytes later...
+      */
+
+      length = avail > 127 * bpp ? 127 * bpp : avail;
+      offset = bpp + (*r->mismatch)(ptr, ptr + bpp, length - bpp);
+      count  = (unsigned)(shift >= 0 ? offset >> shift : offset / bpp) + 1;
+
+      *wptr++ = (unsigned char)(count - 1);
+      memcpy(wptr, start, bpp);
+      wptr += bpp;
+      ptr  = start + count * bpp;
+    }
+    else
+    {
+     /*
+      * Encode a sequence of non-repeating pixels, ending just before the
+      * first pixel that matches the next one...
+      */
+
+      length = avail > 128 * bpp ? 127 * bpp : avail - bpp;
+
+      if ((offset = (*r->match)(ptr, ptr + bpp, length, bpp)) >= length)
+        offset = avail;			/* No repeats, take the rest of the line */
+
+      if ((count = (unsigned)(shift >= 0 ? offset >> shift : offset / bpp) + 1) > 128)
+        count = 128;
+
+      *wptr++ = (unsigned char)(257 - count);
+
+      count *= bpp;
+      memcpy(wptr, start, count);
+      wptr += count;
+      ptr  = start + count;
+    }
+  }
+
+  return (wptr);
+}
+
+
+/*
+ * 'cups_raster_io()' - Read/write bytes from a context, handling interruptions.
+ */
+
+static ssize_t				/* O - Bytes read/write or -1 */
+cups_raster_io(cups_raster_t *r,	/* I - Raster stream */
+               unsigned char *buf,	/* I - Buffer for read/write */
+               size_t        bytes)	/* I - Number of bytes to read/write */
+{
+  ssize_t	count,			/* Number of bytes read/written */
+		total;			/* Total bytes read/written */
+
+
+  DEBUG_printf(("5cups_raster_io(r=%p, buf=%p, bytes=" CUPS_LLFMT ")", r, buf, CUPS_LLCAST bytes));
+
+  total = 0;
+
+  if (r->mode == CUPS_RASTER_READ && r->bufptr < r->bufend)
+  {
+   /*
+    * Use any buffered (or mapped) data first...
+    */
+
+    if ((total = r->bufend - r->bufptr) > (ssize_t)bytes)
+      total = (ssize_t)bytes;
+
+    memcpy(buf, r->bufptr, (size_t)total);
+    r->bufptr += total;
+    buf       += total;
+  }
+
+  for (; total < (ssize_t)bytes; total += count, buf += count)
+  {
+    count = (*r->iocb)(r->ctx, buf, bytes - (size_t)total);
+
+    DEBUG_printf(("6cups_raster_io: count=%d, total=%d", (int)count, (int)total));
+    if (count == 0)
+    {
+      DEBUG_puts("6cups_raster_io: Returning 0.");
+      return (0);
+    }
+    else if (count < 0)
+    {
+      DEBUG_puts("6cups_raster_io: Returning -1 on error.");
+      return (-1);
+    }
+
+#ifdef DEBUG
+    r->iocount += (size_t)count;
+#endif /* DEBUG */
+  }
+
+  DEBUG_printf(("6cups_raster_io: Returning " CUPS_LLFMT ".", CUPS_LLCAST total));
+
+  return (total);
+}
+
+
+/*
+ * 'cups_raster_read()' - Read through the raster buffer.
+ */
+
+static ssize_t				/* O - Number of bytes read */
+cups_raster_read(cups_raster_t *r,	/* I - Raster stream */
+                 unsigned char *buf,	/* I - Buffer */
+                 size_t        bytes)	/* I - Number of bytes to read */
+{
+  ssize_t	count,			/* Number of bytes read */
+		remaining,		/* Remaining bytes in buffer */
+		total;			/* Total bytes read */
+
+
+  DEBUG_printf(("5cups_raster_read(r=%p, buf=%p, bytes=" CUPS_LLFMT ")\n", r, buf, CUPS_LLCAST bytes));
+
+  if (!r->compressed)
+    return (cups_raster_io(r, buf, bytes));
+
+ /*
+  * Allocate a read buffer as needed...
+  */
+
+  count = (ssize_t)(2 * r->header.cupsBytesPerLine);
+  if (count < 65536)
+    count = 65536;
+
+  if ((size_t)count > r->bufsize)
+  {
+    ssize_t offset = r->bufptr - r->buffer;
+					/* Offset to current start of buffer */
+    ssize_t end = r->bufend - r->buffer;/* Offset to current end of buffer */
+    unsigned char *rptr;		/* Pointer in read buffer */
+
+    if (r->buffer)
+      rptr = realloc(r->buffer, (size_t)count);
+    else
+      rptr = malloc((size_t)count);
+
+    if (!rptr)
+      return (0);
+
+    if (!r->map || r->bufptr < r->map || r->bufptr > r->map + r->mapsize)
+    {
+      r->bufptr = rptr + offset;
+      r->bufend = rptr + end;
+    }
+
+    r->buffer  = rptr;
+    r->bufsize = (size_t)count;
+  }
+
+ /*
+  * Loop until we have read everything...
+  */
+
+  for (total = 0, remaining = (int)(r->bufend - r->bufptr);
+       total < (ssize_t)bytes;
+       total += count, buf += count)
+  {
+    count = (ssize_t)bytes - total;
+
+    DEBUG_printf(("6cups_raster_read: count=" CUPS_LLFMT ", remaining=" CUPS_LLFMT ", buf=%p, bufptr=%p, bufend=%p", CUPS_LLCAST count, CUPS_LLCAST remaining, buf, r->bufptr, r->bufend));
+
+    if (remaining == 0)
+    {
+      if (count < 16)
+      {
+       /*
+        * Read into the raster buffer and then copy...
+	*/
+
+        remaining = (*r->iocb)(r->ctx, r->buffer, r->bufsize);
+	if (remaining <= 0)
+	  return (0);
+
+	r->bufptr = r->buffer;
+	r->bufend = r->buffer + remaining;
+
+#ifdef DEBUG
+        r->iocount += (size_t)remaining;
+#endif /* DEBUG */
+      }
+      else
+      {
+       /*
+        * Read directly into "buf"...
+	*/
+
+	count = (*r->iocb)(r->ctx, buf, (size_t)count);
+
+	if (count <= 0)
+	  return (0);
+
+#ifdef DEBUG
+        r->iocount += (size_t)count;
+#endif /* DEBUG */
+
+	continue;
+      }
+    }
+
+   /*
+    * Copy bytes from raster buffer to "buf"...
     */
 
     if (count > remaining)
@@ -1217,6 +2440,48 @@ cups_raster_read(cups_raster_t *r,	/* I - Raster stream */
 }
 
 
+/*
+ * 'cups_raster_simd()' - Choose the byte scanning functions for a stream.
+ *
+ * The fastest vector code supported by the CPU is used unless the
+ * CUPS_RASTER_SIMD environment variable names another one ("none", "sse2",
+ * "avx2", or "neon").  All of them produce identical output.
+ */
+
+static void
+cups_raster_simd(cups_raster_t *r)	/* I - Raster stream */
+{
+  const char	*simd = getenv("CUPS_RASTER_SIMD");
+					/* Requested vector code */
+
+
+  r->match    = cups_match_c;
+  r->mismatch = cups_mismatch_c;
+
+  if (simd && !strcmp(simd, "none"))
+    return;
+
+#ifdef CUPS_RASTER_SSE2
+  r->match    = cups_match_sse2;
+  r->mismatch = cups_mismatch_sse2;
+
+#  ifdef CUPS_RASTER_AVX2
+  if ((!simd || strcmp(simd, "sse2")) && __builtin_cpu_supports("avx2"))
+  {
+    r->match    = cups_match_avx2;
+    r->mismatch = cups_mismatch_avx2;
+  }
+#  endif /* CUPS_RASTER_AVX2 */
+
+#elif defined(CUPS_RASTER_NEON)
+  r->match    = cups_match_neon;
+  r->mismatch = cups_mismatch_neon;
+#endif /* CUPS_RASTER_SSE2 */
+
+  DEBUG_printf(("4cups_raster_simd: simd=\"%s\", match=%p", simd ? simd : "(null)", r->match));
+}
+
+
 /*
  * 'cups_raster_update()' - Update the raster header and row count for the
  *                          current page.
@@ -1367,108 +2632,82 @@ cups_raster_write(
     cups_raster_t       *r,		/* I - Raster stream */
     const unsigned char *pixels)	/* I - Pixel data to write */
 {
-  const unsigned char	*start,		/* Start of sequence */
-			*ptr,		/* Current pointer in sequence */
-			*pend,		/* End of raster buffer */
-			*plast;		/* Pointer to last pixel */
   unsigned char		*wptr;		/* Pointer into write buffer */
-  unsigned		bpp,		/* Bytes per pixel */
-			count;		/* Count */
+  unsigned		count,		/* Count */
+			bufsize;	/* Size of write buffer */
+  int			swap;		/* Swap bytes? */
 
 
   DEBUG_printf(("3cups_raster_write(r=%p, pixels=%p)\n", r, pixels));
 
  /*
-  * Allocate a write buffer as needed...
+  * Bytes are swapped in a copy of the pixels - the line buffer may still be
+  * partially filled by cupsRasterWritePixels and compared with the next
+  * line...
   */
 
-  count = r->header.cupsBytesPerLine * 2;
-  if (count < 65536)
-    count = 65536;
+  swap = (r->header.cupsBitsPerColor == 16 ||
+          r->header.cupsBitsPerPixel == 12 ||
+          r->header.cupsBitsPerPixel == 16) && r->swapped;
 
-  if ((size_t)count > r->bufsize)
+#ifdef CUPS_RASTER_THREADS
+  if (r->num_threads)
   {
-    if (r->buffer)
-      wptr = realloc(r->buffer, count);
-    else
-      wptr = malloc(count);
+   /*
+    * Add the row to the current band for the compression threads...
+    */
 
-    if (!wptr)
-    {
-      DEBUG_printf(("4cups_raster_write: Unable to allocate " CUPS_LLFMT " bytes for raster buffer: %s", CUPS_LLCAST count, strerror(errno)));
+    if (!cups_raster_band_add(r, pixels, swap))
       return (-1);
-    }
 
-    r->buffer  = wptr;
-    r->bufsize = count;
+    return ((ssize_t)r->header.cupsBytesPerLine);
   }
+#endif /* CUPS_RASTER_THREADS */
 
  /*
-  * Write the row repeat count...
+  * Allocate a write buffer as needed, with room after it for the swapped
+  * pixels...
   */
 
-  bpp     = r->bpp;
-  pend    = pixels + r->header.cupsBytesPerLine;
-  plast   = pend - bpp;
-  wptr    = r->buffer;
-  *wptr++ = (unsigned char)(r->count - 1);
+  count = r->header.cupsBytesPerLine * 2;
+  if (count < 65536)
+    count = 65536;
 
- /*
-  * Write using a modified PackBits compression...
-  */
+  bufsize = count + (swap ? r->header.cupsBytesPerLine : 0);
 
-  for (ptr = pixels; ptr < pend;)
+  if ((size_t)bufsize > r->bufsize)
   {
-    start = ptr;
-    ptr += bpp;
+    if (r->buffer)
+      wptr = realloc(r->buffer, bufsize);
+    else
+      wptr = malloc(bufsize);
 
-    if (ptr == pend)
+    if (!wptr)
     {
-     /*
-      * Encode a single pixel at the end...
-      */
-
-      *wptr++ = 0;
-      for (count = bpp; count > 0; count --)
-        *wptr++ = *start++;
+      DEBUG_printf(("4cups_raster_write: Unable to allocate " CUPS_LLFMT " bytes for raster buffer: %s", CUPS_LLCAST bufsize, strerror(errno)));
+      return (-1);
     }
-    else if (!memcmp(start, ptr, bpp))
-    {
-     /*
-      * Encode a sequence of repeating pixels...
-      */
-
-      for (count = 2; count < 128 && ptr < plast; count ++, ptr += bpp)
-        if (memcmp(ptr, ptr + bpp, bpp))
-	  break;
 
-      *wptr++ = (unsigned char)(count - 1);
-      for (count = bpp; count > 0; count --)
-        *wptr++ = *ptr++;
-    }
-    else
-    {
-     /*
-      * Encode a sequence of non-repeating pixels...
-      */
+    r->buffer  = wptr;
+    r->bufsize = bufsize;
+  }
 
-      for (count = 1; count < 128 && ptr < plast; count ++, ptr += bpp)
-        if (!memcmp(ptr, ptr + bpp, bpp))
-	  break;
+  if (swap)
+  {
+    memcpy(r->buffer + count, pixels, r->header.cupsBytesPerLine);
+    cups_swap(r->buffer + count, r->header.cupsBytesPerLine);
 
-      if (ptr >= plast && count < 128)
-      {
-        count ++;
-	ptr += bpp;
-      }
+    pixels = r->buffer + count;
+  }
 
-      *wptr++ = (unsigned char)(257 - count);
+ /*
+  * Write the row repeat count and the compressed row...
+  */
 
-      count *= bpp;
-      memcpy(wptr, start, count);
-      wptr += count;
-    }
-  }
+  wptr    = r->buffer;
+  *wptr++ = (unsigned char)(r->count - 1);
+  wptr    = cups_raster_encode(r, pixels, r->header.cupsBytesPerLine, r->bpp,
+                               wptr);
 
   DEBUG_printf(("4cups_raster_write: Writing " CUPS_LLFMT " bytes.", CUPS_LLCAST (wptr - r->buffer)));
 
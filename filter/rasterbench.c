@@ -21,11 +21,16 @@
 
 #include <config.h>
 #include <cups/raster.h>
+#include <stddef.h>
 #include <stdlib.h>
 #include <sys/time.h>
 #include <signal.h>
 #include <unistd.h>
 #include <sys/wait.h>
+#include "escp-common.h"
+#include "pcl-common.h"
+#include "test-common.h"
+#include "zpl-common.h"
 
 
 /*
@@ -37,18 +42,101 @@
 #define TEST_PAGES	16
 #define TEST_PASSES	20
 
+#define SUITE_LINES	64		/* Number of distinct lines per page */
+#define SUITE_PAGES	2		/* Number of pages per document */
+#define SUITE_PASSES	5		/* Number of passes per case */
+#define SUITE_SEED	1		/* Seed for generated content */
+
+#define LABEL_LINES	1218		/* Lines in a 4x6 label at 203 DPI */
+#define LABEL_WIDTH	102		/* Bytes in a 4x6 label line */
+
+
+/*
+ * Local types...
+ */
+
+typedef enum suite_content_e		/**** Page content ****/
+{
+  SUITE_BLANK,				/* Blank page */
+  SUITE_TEXT,				/* Text-like page */
+  SUITE_PHOTO				/* Photo-like page */
+} suite_content_t;
+
+typedef struct suite_buffer_s		/**** Memory buffer for raster data ****/
+{
+  unsigned char	*data;			/* Data */
+  size_t	datalen,		/* Number of bytes in buffer */
+		datasize,		/* Size of buffer */
+		dataptr;		/* Current read position */
+} suite_buffer_t;
+
+typedef struct suite_page_s		/**** Page size and type ****/
+{
+  const char	*media,			/* PWG media size name */
+		*type;			/* PWG raster type name */
+  unsigned	width,			/* Width in points */
+		length,			/* Length in points */
+		resolution,		/* Resolution in DPI */
+		bits;			/* Bits per color */
+  cups_cspace_t	cspace;			/* Color space */
+  unsigned	num_colors;		/* Number of colors */
+} suite_page_t;
+
 
 /*
  * Local functions...
  */
 
-static double	compute_median(double *secs);
+static double	compute_median(double *secs, int num_secs);
+static void	filter_escp(void);
+static void	filter_pcl(void);
+static void	filter_result(const char *name, double *secs, size_t bytes);
+static void	filter_zpl(void);
 static double	get_time(void);
+static void	make_label(unsigned char *label);
+static void	make_lines(const suite_page_t *page, unsigned bytes,
+		           suite_content_t content, unsigned char *lines);
+static ssize_t	mem_read_cb(void *ctx, unsigned char *data, size_t bytes);
+static ssize_t	mem_write_cb(void *ctx, unsigned char *data, size_t bytes);
 static void	read_test(int fd);
+static int	run_filters(void);
+static double	run_passes(cups_mode_t mode);
 static int	run_read_test(void);
+static int	run_suite(void);
+static int	run_threads(void);
+static void	set_pixel(const suite_page_t *page, unsigned char *line,
+		          unsigned x, unsigned red, unsigned green,
+			  unsigned blue);
+static unsigned	suite_rand(void);
+static int	suite_read(suite_buffer_t *buffer, unsigned char *line);
+static void	suite_result(int first, const char *mode,
+		             const suite_page_t *page, const char *content,
+			     const char *byte_order, int swapped,
+			     double raster_bytes, size_t stream_bytes,
+			     double write_secs, double read_secs);
+static int	suite_write(suite_buffer_t *buffer, cups_mode_t mode,
+		            const suite_page_t *page, unsigned bytes,
+			    unsigned char *lines);
+static int	swap_stream(const suite_buffer_t *src, suite_buffer_t *dst);
 static void	write_test(int fd, cups_mode_t mode);
 
 
+/*
+ * Local globals...
+ */
+
+static const suite_page_t suite_pages[] =
+{					/* Page sizes and types to test */
+  { "na_letter_8.5x11in", "black_1", 612, 792, 600, 1, CUPS_CSPACE_K, 1 },
+  { "iso_a4_210x297mm", "sgray_8", 595, 842, 300, 8, CUPS_CSPACE_SW, 1 },
+  { "na_letter_8.5x11in", "srgb_8", 612, 792, 300, 8, CUPS_CSPACE_SRGB, 3 },
+  { "iso_a4_210x297mm", "srgb_16", 595, 842, 300, 16, CUPS_CSPACE_SRGB, 3 },
+  { "na_letter_8.5x11in", "cmyk_8", 612, 792, 300, 8, CUPS_CSPACE_CMYK, 4 }
+};
+static unsigned		suite_seed = SUITE_SEED;
+					/* Current random number state */
+
+
 /*
  * 'main()' - Benchmark the raster read/write functions.
  */
@@ -58,63 +146,87 @@ main(int  argc,				/* I - Number of command-line args */
      char *argv[])			/* I - Command-line arguments */
 {
   int		i;			/* Looping var */
-  int		ras_fd,			/* File descriptor for read process */
-		status;			/* Exit status of read process */
-  double	start_secs,		/* Start time */
-		write_secs,		/* Write time */
-		read_secs,		/* Read time */
-		pass_secs[TEST_PASSES];	/* Total test times */
-  cups_mode_t	mode;			/* Write mode */
+  int		filters = 0,		/* Time the filter routines? */
+		simd = 0,		/* Compare scalar and SIMD code? */
+		suite = 0,		/* Run the benchmark suite? */
+		threads = 0;		/* Compare thread counts? */
+  double	scalar_secs,		/* Median time without SIMD */
+		simd_secs;		/* Median time with SIMD */
+  cups_mode_t	mode = CUPS_RASTER_WRITE;
+					/* Write mode */
 
 
  /*
   * See if we have anything on the command-line...
   */
 
-  if (argc > 2 || (argc == 2 && strcmp(argv[1], "-z")))
+  for (i = 1; i < argc; i ++)
   {
-    puts("Usage: rasterbench [-z]");
-    return (1);
+    if (!strcmp(argv[i], "-f"))
+      filters = 1;
+    else if (!strcmp(argv[i], "-j"))
+      suite = 1;
+    else if (!strcmp(argv[i], "-s"))
+      simd = 1;
+    else if (!strcmp(argv[i], "-t"))
+      threads = 1;
+    else if (!strcmp(argv[i], "-z"))
+      mode = CUPS_RASTER_WRITE_COMPRESSED;
+    else
+    {
+      puts("Usage: rasterbench [-f] [-j] [-s] [-t] [-z]");
+      return (1);
+    }
   }
 
-  mode = argc > 1 ? CUPS_RASTER_WRITE_COMPRESSED : CUPS_RASTER_WRITE;
-
  /*
   * Ignore SIGPIPE...
   */
 
   signal(SIGPIPE, SIG_IGN);
 
+ /*
+  * The benchmark suite writes JSON to stdout...
+  */
+
+  if (suite)
+    return (run_suite());
+
+  if (filters)
+    return (run_filters());
+
  /*
   * Run the tests several times to get a good average...
   */
 
   printf("Test read/write speed of %d pages, %dx%d pixels...\n\n",
          TEST_PAGES, TEST_WIDTH, TEST_HEIGHT);
-  for (i = 0; i < TEST_PASSES; i ++)
-  {
-    printf("PASS %2d: ", i + 1);
-    fflush(stdout);
 
-    ras_fd     = run_read_test();
-    start_secs = get_time();
+  if (threads)
+    return (run_threads());
 
-    write_test(ras_fd, mode);
+  if (!simd)
+  {
+    printf("\nMedian Total Time: %.3f seconds per document\n",
+	   run_passes(mode));
+    return (0);
+  }
 
-    write_secs = get_time();
-    printf(" %.3f write,", write_secs - start_secs);
-    fflush(stdout);
+ /*
+  * Compare the scalar code with the default (fastest) SIMD code...
+  */
 
-    close(ras_fd);
-    wait(&status);
+  puts("Scalar:");
+  setenv("CUPS_RASTER_SIMD", "none", 1);
+  scalar_secs = run_passes(mode);
 
-    read_secs    = get_time();
-    pass_secs[i] = read_secs - start_secs;
-    printf(" %.3f read, %.3f total\n", read_secs - write_secs, pass_secs[i]);
-  }
+  puts("\nSIMD:");
+  unsetenv("CUPS_RASTER_SIMD");
+  simd_secs = run_passes(mode);
 
-  printf("\nMedian Total Time: %.3f seconds per document\n",
-         compute_median(pass_secs));
+  printf("\nMedian Total Time: %.3f seconds per document scalar, %.3f SIMD "
+         "(%.2fx)\n", scalar_secs, simd_secs,
+	 simd_secs > 0.0 ? scalar_secs / simd_secs : 0.0);
 
   return (0);
 }
@@ -125,7 +237,8 @@ main(int  argc,				/* I - Number of command-line args */
  */
 
 static double				/* O - Median time in seconds */
-compute_median(double *secs)		/* I - Array of time samples */
+compute_median(double *secs,		/* I - Array of time samples */
+               int    num_secs)		/* I - Number of time samples */
 {
   int		i, j;			/* Looping vars */
   double	temp;			/* Swap variable */
@@ -135,8 +248,8 @@ compute_median(double *secs)		/* I - Array of time samples */
   * Sort the array into ascending order using a quicky bubble sort...
   */
 
-  for (i = 0; i < (TEST_PASSES - 1); i ++)
-    for (j = i + 1; j < TEST_PASSES; j ++)
+  for (i = 0; i < (num_secs - 1); i ++)
+    for (j = i + 1; j < num_secs; j ++)
       if (secs[i] > secs[j])
       {
         temp    = secs[i];
@@ -145,109 +258,1406 @@ compute_median(double *secs)		/* I - Array of time samples */
       }
 
  /*
-  * Return the average of the middle two samples...
+  * Return the middle sample or the average of the middle two samples...
   */
 
-  return (0.5 * (secs[TEST_PASSES / 2 - 1] + secs[TEST_PASSES / 2]));
+  if (num_secs & 1)
+    return (secs[num_secs / 2]);
+  else
+    return (0.5 * (secs[num_secs / 2 - 1] + secs[num_secs / 2]));
 }
 
 
 /*
- * 'get_time()' - Get the current time in seconds.
+ * 'filter_escp()' - Time the band and depletion routines used by
+ *                   rastertoepson.
  */
 
-static double				/* O - Time in seconds */
-get_time(void)
+static void
+filter_escp(void)
 {
-  struct timeval	curtime;	/* Current time */
+  int		i,			/* Current test */
+		pass;			/* Current pass */
+  unsigned	y,			/* Current line */
+		width,			/* Width in columns */
+		height,			/* Number of lines */
+		bytes = 6120 / 8;	/* Bytes per line */
+  unsigned char	*lines,			/* Lines of page content */
+		*band,			/* Band of lines */
+		*cols;			/* Dot columns */
+  size_t	out_bytes = 0;		/* Output bytes per page */
+  double	start,			/* Start time */
+		secs[SUITE_PASSES];	/* Times for each pass */
+  static const char * const names[] =	/* Test names */
+  {
+    "ESC/P 24-pin band, 360dpi Letter",
+    "ESC/P 24-pin band, 180dpi Letter",
+    "ESC/P2 depletion, 720dpi Letter CMYK",
+    "ESC/P2 depletion, 720dpi Letter photo"
+  };
 
 
-  gettimeofday(&curtime, NULL);
-  return (curtime.tv_sec + 0.000001 * curtime.tv_usec);
+  lines = malloc(64 * bytes);
+  band  = malloc(8 * bytes);
+  cols  = calloc(8, bytes);
+
+  if (!lines || !band || !cols)
+  {
+    perror("Unable to allocate memory");
+    free(lines);
+    free(band);
+    free(cols);
+    return;
+  }
+
+  for (i = 0; i < 4; i ++)
+  {
+   /*
+    * Use text-like content followed by blank lines, or random dots for
+    * photos...
+    */
+
+    _cupsTestSeed(SUITE_SEED);
+
+    for (y = 0; y < 64; y ++)
+      _cupsTestMakeLine(lines + y * bytes, bytes,
+                        i == 3 ? _CUPS_TEST_LINE_RANDOM :
+			    y < 48 ? _CUPS_TEST_LINE_TEXT :
+			    _CUPS_TEST_LINE_BLANK);
+
+    for (pass = 0; pass < SUITE_PASSES; pass ++)
+    {
+      start = get_time();
+
+      if (i < 2)
+      {
+       /*
+        * Collect 11 inches of lines into bands of dot columns...
+	*/
+
+	width     = i == 0 ? 3060 : 1530;
+	height    = i == 0 ? 3960 : 1980;
+	out_bytes = (size_t)width * height / 8;
+
+	for (y = 0; y < height; y ++)
+	{
+	  memcpy(band + (y & 7) * bytes, lines + (y & 63) * bytes, bytes);
+
+	  if ((y & 7) == 7)
+	    ESCPTransposeBand(band, bytes, width, cols);
+	}
+      }
+      else
+      {
+       /*
+        * Deplete 11 inches of 4 color planes...
+	*/
+
+	out_bytes = (size_t)4 * 7920 * bytes;
+
+	for (y = 0; y < 4 * 7920; y ++)
+	{
+	  memcpy(band, lines + (y & 63) * bytes, bytes);
+	  ESCPDeplete(band, bytes);
+	}
+      }
+
+      secs[pass] = get_time() - start;
+    }
+
+    filter_result(names[i], secs, out_bytes);
+  }
+
+  free(lines);
+  free(band);
+  free(cols);
 }
 
 
 /*
- * 'read_test()' - Benchmark the raster read functions.
+ * 'filter_pcl()' - Time the PCL compression routines used by rastertohp and
+ *                  rastertolabel.
  */
 
 static void
-read_test(int fd)			/* I - File descriptor to read from */
+filter_pcl(void)
 {
-  unsigned		y;		/* Looping var */
-  cups_raster_t		*r;		/* Raster stream */
-  cups_page_header2_t	header;		/* Page header */
-  unsigned char		buffer[8 * TEST_WIDTH];
-					/* Read buffer */
+  int		i,			/* Current test */
+		pass;			/* Current pass */
+  unsigned	y,			/* Current line */
+		plane,			/* Current color plane */
+		bytes = 5100 / 8 + 1,	/* Bytes per 600 DPI line */
+		pbytes = (2550 + 7) / 8;/* Bytes per 300 DPI plane */
+  unsigned char	*lines,			/* Lines of page content */
+		*line,			/* Current line */
+		*comp,			/* Compressed line */
+		*bits,			/* Separated bits */
+		*seed;			/* Seed rows */
+  size_t	comp_bytes = 0;		/* Compressed bytes per page */
+  double	start,			/* Start time */
+		secs[SUITE_PASSES];	/* Times for each pass */
+  static const char * const names[] =	/* Test names */
+  {
+    "PCL mode 2, 600dpi Letter mono",
+    "PCL mode 3, 600dpi Letter mono",
+    "PCL mode 2, 300dpi Letter CMYK 2-bit",
+    "PCL mode 3, 300dpi Letter CMYK 2-bit"
+  };
 
 
  /*
-  * Test read speed...
+  * Use 64 lines of text-like content followed by blank lines...
   */
 
-  if ((r = cupsRasterOpen(fd, CUPS_RASTER_READ)) == NULL)
+  lines = malloc(64 * 2 * bytes);
+  comp  = malloc(4 * bytes + 16);
+  bits  = malloc(2 * bytes);
+  seed  = malloc(8 * bytes);
+
+  if (!lines || !comp || !bits || !seed)
   {
-    perror("Unable to create raster input stream");
+    perror("Unable to allocate memory");
+    free(lines);
+    free(comp);
+    free(bits);
+    free(seed);
     return;
   }
 
-  while (cupsRasterReadHeader2(r, &header))
+  _cupsTestSeed(SUITE_SEED);
+
+  for (y = 0; y < 64; y ++)
+    _cupsTestMakeLine(lines + y * 2 * bytes, 2 * bytes,
+                      y < 48 ? _CUPS_TEST_LINE_TEXT : _CUPS_TEST_LINE_BLANK);
+
+  for (i = 0; i < 4; i ++)
   {
-    for (y = 0; y < header.cupsHeight; y ++)
-      cupsRasterReadPixels(r, buffer, header.cupsBytesPerLine);
+    for (pass = 0; pass < SUITE_PASSES; pass ++)
+    {
+      memset(seed, 0, 8 * bytes);
+
+      comp_bytes = 0;
+      start      = get_time();
+
+      if (i < 2)
+      {
+       /*
+        * 6600 lines of 1-bit black, 5100 pixels wide...
+	*/
+
+	for (y = 0; y < 6600; y ++)
+	{
+	  line = lines + (y & 63) * 2 * bytes;
+
+	  if (i == 0)
+	    comp_bytes += PCLCompressTIFF(line, bytes, comp);
+	  else
+	  {
+	    comp_bytes += PCLCompressDelta(line, seed, bytes, comp);
+	    memcpy(seed, line, bytes);
+	  }
+	}
+      }
+      else
+      {
+       /*
+        * 3300 lines of 4 planes of 2-bit color, 2550 pixels wide...
+	*/
+
+	for (y = 0; y < 3300; y ++)
+	  for (plane = 0; plane < 4; plane ++)
+	  {
+	    unsigned char *pseed = seed + plane * 2 * pbytes;
+					/* Seed rows for plane */
+
+	    line = lines + ((y + plane * 16) & 63) * 2 * bytes;
+
+	    PCLSeparateBits(line, 2 * pbytes, bits, bits + pbytes);
+
+	    if (i == 2)
+	    {
+	      comp_bytes += PCLCompressTIFF(bits, pbytes, comp);
+	      comp_bytes += PCLCompressTIFF(bits + pbytes, pbytes, comp);
+	    }
+	    else
+	    {
+	      comp_bytes += PCLCompressDelta(bits, pseed, pbytes, comp);
+	      comp_bytes += PCLCompressDelta(bits + pbytes, pseed + pbytes,
+	                                     pbytes, comp);
+
+	      memcpy(pseed, bits, 2 * pbytes);
+	    }
+	  }
+      }
+
+      secs[pass] = get_time() - start;
+    }
+
+    filter_result(names[i], secs, comp_bytes);
   }
 
-  cupsRasterClose(r);
+  free(lines);
+  free(comp);
+  free(bits);
+  free(seed);
 }
 
 
 /*
- * 'run_read_test()' - Run the read test as a child process via pipes.
+ * 'filter_result()' - Show the median time for a filter test.
  */
 
-static int				/* O - Standard input of child */
-run_read_test(void)
+static void
+filter_result(const char *name,		/* I - Name of test */
+              double     *secs,		/* I - Times for each pass */
+	      size_t     bytes)		/* I - Bytes of output per page */
 {
-  int	ras_pipes[2];			/* Raster data pipes */
-  int	pid;				/* Child process ID */
+  double	median;			/* Median time */
 
 
-  if (pipe(ras_pipes))
-    return (-1);
+  median = compute_median(secs, SUITE_PASSES);
 
-  if ((pid = fork()) < 0)
+  printf("%-40s %9.2f %9.1f %10lu\n", name, 1000.0 * median,
+         median > 0.0 ? 1.0 / median : 0.0, (unsigned long)bytes);
+}
+
+
+/*
+ * 'filter_zpl()' - Time the ZPL graphics encoders used by rastertolabel.
+ */
+
+static void
+filter_zpl(void)
+{
+  int		i,			/* Current test */
+		pass;			/* Current pass */
+  unsigned	y,			/* Current line */
+		comp_length;		/* Compressed length */
+  unsigned char	*label,			/* Label image */
+		*line,			/* Current line */
+		*last,			/* Previous line */
+		comp[2 * LABEL_WIDTH + 1];
+					/* Compressed line */
+  FILE		*fp;			/* Output file */
+  long		bytes = 0;		/* Bytes per label */
+  double	start,			/* Start time */
+		secs[SUITE_PASSES];	/* Times for each pass */
+  static const char * const names[] =	/* Test names */
   {
-   /*
-    * Fork error - return -1 on error...
-    */
+    "ZPL hex, 203dpi 4x6 label",
+    "ZPL Z64 level 1, 203dpi 4x6 label",
+    "ZPL Z64 level 6, 203dpi 4x6 label"
+  };
 
-    close(ras_pipes[0]);
-    close(ras_pipes[1]);
 
-    return (-1);
+  if ((label = malloc(LABEL_LINES * LABEL_WIDTH)) == NULL)
+  {
+    perror("Unable to allocate memory");
+    return;
   }
-  else if (pid == 0)
+
+  if ((fp = tmpfile()) == NULL)
+  {
+    perror("Unable to create temporary file");
+    free(label);
+    return;
+  }
+
+  make_label(label);
+
+  for (i = 0; i < 3; i ++)
+  {
+#ifndef HAVE_LIBZ
+    if (i > 0)
+      break;
+#endif /* !HAVE_LIBZ */
+
+    for (pass = 0; pass < SUITE_PASSES; pass ++)
+    {
+      rewind(fp);
+
+      start = get_time();
+
+      if (i == 0)
+      {
+       /*
+        * Hex with alternate data compression and ":" for repeated lines...
+	*/
+
+	for (y = 0, last = NULL; y < LABEL_LINES; y ++, last = line)
+	{
+	  line = label + y * LABEL_WIDTH;
+
+	  if (last && !memcmp(line, last, LABEL_WIDTH))
+	  {
+	    putc(':', fp);
+	    continue;
+	  }
+
+	  comp_length = ZPLCompressHex(line, LABEL_WIDTH, comp);
+	  fwrite(comp, 1, comp_length, fp);
+	}
+      }
+#ifdef HAVE_LIBZ
+      else
+      {
+	zpl_z64_t *z64 = ZPLZ64Open(fp, i == 1 ? 1 : 6);
+					/* Z64 encoder */
+
+	for (y = 0; y < LABEL_LINES; y ++)
+	  ZPLZ64Write(z64, label + y * LABEL_WIDTH, LABEL_WIDTH);
+
+	ZPLZ64Close(z64, 1);
+      }
+#endif /* HAVE_LIBZ */
+
+      fflush(fp);
+
+      secs[pass] = get_time() - start;
+      bytes      = ftell(fp);
+    }
+
+    filter_result(names[i], secs, (size_t)bytes);
+  }
+
+  fclose(fp);
+  free(label);
+}
+
+
+/*
+ * 'get_time()' - Get the current time in seconds.
+ */
+
+static double				/* O - Time in seconds */
+get_time(void)
+{
+  struct timeval	curtime;	/* Current time */
+
+
+  gettimeofday(&curtime, NULL);
+  return (curtime.tv_sec + 0.000001 * curtime.tv_usec);
+}
+
+
+/*
+ * 'make_label()' - Make a shipping label image.
+ */
+
+static void
+make_label(unsigned char *label)	/* I - Label image */
+{
+  unsigned	x, y;			/* Looping vars */
+  unsigned char	*line,			/* Current line */
+		text[LABEL_WIDTH],	/* Characters for line of text */
+		font[16][20];		/* Glyphs */
+
+
+  _cupsTestSeed(SUITE_SEED);
+  _cupsTestMakeLine(font[0], sizeof(font), _CUPS_TEST_LINE_RANDOM);
+
+  for (y = 0, line = label; y < LABEL_LINES; y ++, line += LABEL_WIDTH)
   {
+    if (y < 40 || y >= LABEL_LINES - 40)
+      memset(line, 0, LABEL_WIDTH);	/* Margins */
+    else if ((y % 300) < 4)
+      memset(line, 0xff, LABEL_WIDTH);	/* Box rules */
+    else if (y >= 600 && y < 900)
+    {
+     /*
+      * Barcode, with each bar a few bytes wide...
+      */
+
+      if (y == 600)
+        _cupsTestMakeLine(line, LABEL_WIDTH, _CUPS_TEST_LINE_SOLID);
+      else
+        memcpy(line, line - LABEL_WIDTH, LABEL_WIDTH);
+    }
+    else if (y >= 920 && y < 1100)
+    {
+     /*
+      * 2D barcode, with each module 3 lines tall...
+      */
+
+      if (y % 3)
+        memcpy(line, line - LABEL_WIDTH, LABEL_WIDTH);
+      else
+      {
+        memset(line, 0, LABEL_WIDTH);
+	_cupsTestMakeLine(line + 30, 40, _CUPS_TEST_LINE_RANDOM);
+      }
+    }
+    else if ((y % 30) < 20)
+    {
+     /*
+      * Text, using 16 random 8x20 glyphs...
+      */
+
+      if ((y % 30) == 0)
+        _cupsTestMakeLine(text, LABEL_WIDTH, _CUPS_TEST_LINE_WORDS);
+
+      for (x = 0; x < LABEL_WIDTH; x ++)
+        line[x] = text[x] ? font[(text[x] >> 4) & 15][y % 30] : 0;
+    }
+    else
+      memset(line, 0, LABEL_WIDTH);	/* Space between text lines */
+
    /*
-    * Child comes here - read data from the input pipe...
+    * Vertical box rules...
     */
 
-    close(ras_pipes[1]);
-    read_test(ras_pipes[0]);
-    exit(0);
+    if (y >= 40 && y < LABEL_LINES - 40)
+    {
+      line[0]               |= 0x3c;
+      line[LABEL_WIDTH - 1] |= 0x3c;
+    }
   }
-  else
+}
+
+
+/*
+ * 'make_lines()' - Generate lines of page content.
+ */
+
+static void
+make_lines(
+    const suite_page_t *page,		/* I - Page size and type */
+    unsigned           bytes,		/* I - Bytes per line */
+    suite_content_t    content,		/* I - Page content */
+    unsigned char      *lines)		/* O - Lines */
+{
+  unsigned	i, x, y,		/* Looping vars */
+		width,			/* Width in pixels */
+		margin,			/* Left and right margins in pixels */
+		count;			/* Pixels left in current run */
+  int		rgb[3];			/* Photo color */
+  unsigned char	*line;			/* Current line */
+
+
+ /*
+  * Always generate the same content for a given page...
+  */
+
+  suite_seed = SUITE_SEED;
+  width      = page->width * page->resolution / 72;
+  margin     = page->resolution / 4;
+
+  for (y = 0, line = lines; y < SUITE_LINES; y ++, line += bytes)
   {
    /*
-    * Parent comes here - return the output pipe...
+    * Start with white, which is 0 for black and CMYK and 255 otherwise...
     */
 
-    close(ras_pipes[0]);
-    return (ras_pipes[1]);
+    memset(line, (page->cspace == CUPS_CSPACE_K ||
+                  page->cspace == CUPS_CSPACE_CMYK) ? 0 : 255, bytes);
+
+    if (content == SUITE_TEXT && y < (SUITE_LINES * 3 / 4))
+    {
+     /*
+      * Text is short runs of black between the margins with gaps between
+      * the strokes and words, and a few blank lines of leading...
+      */
+
+      x = margin + suite_rand() % 64;
+
+      while (x < (width - margin))
+      {
+        for (count = (suite_rand() & 7) + 1;
+	     count > 0 && x < (width - margin);
+	     count --, x ++)
+	  set_pixel(page, line, x, 0, 0, 0);
+
+        x += (suite_rand() & 7) + 1;
+
+        if ((suite_rand() & 7) == 0)
+	  x += (suite_rand() & 15) + 8;
+      }
+    }
+    else if (content == SUITE_PHOTO)
+    {
+     /*
+      * Photos are smooth gradients with some sensor noise...
+      */
+
+      for (x = 0; x < width; x ++)
+      {
+        rgb[0] = (int)(x * 65535 / width);
+	rgb[1] = (int)(y * 65535 / SUITE_LINES);
+	rgb[2] = 65535 - (rgb[0] + rgb[1]) / 2;
+
+        for (i = 0; i < 3; i ++)
+	{
+	  rgb[i] += (int)(suite_rand() & 4095) - 2048;
+
+	  if (rgb[i] < 0)
+	    rgb[i] = 0;
+	  else if (rgb[i] > 65535)
+	    rgb[i] = 65535;
+	}
+
+        set_pixel(page, line, x, (unsigned)rgb[0], (unsigned)rgb[1],
+	          (unsigned)rgb[2]);
+      }
+    }
   }
 }
 
 
+/*
+ * 'mem_read_cb()' - Read raster data from a memory buffer.
+ */
+
+static ssize_t				/* O - Bytes read */
+mem_read_cb(void          *ctx,		/* I - Memory buffer */
+            unsigned char *data,	/* I - Data buffer */
+	    size_t        bytes)	/* I - Number of bytes to read */
+{
+  suite_buffer_t	*buffer = (suite_buffer_t *)ctx;
+					/* Memory buffer */
+
+
+  if (bytes > (buffer->datalen - buffer->dataptr))
+    bytes = buffer->datalen - buffer->dataptr;
+
+  memcpy(data, buffer->data + buffer->dataptr, bytes);
+  buffer->dataptr += bytes;
+
+  return ((ssize_t)bytes);
+}
+
+
+/*
+ * 'mem_write_cb()' - Write raster data to a memory buffer.
+ */
+
+static ssize_t				/* O - Bytes written */
+mem_write_cb(void          *ctx,	/* I - Memory buffer */
+             unsigned char *data,	/* I - Data buffer */
+	     size_t        bytes)	/* I - Number of bytes to write */
+{
+  suite_buffer_t	*buffer = (suite_buffer_t *)ctx;
+					/* Memory buffer */
+  size_t		datasize;	/* New size of buffer */
+  unsigned char		*temp;		/* New buffer */
+
+
+  if ((buffer->datalen + bytes) > buffer->datasize)
+  {
+    for (datasize = buffer->datasize ? buffer->datasize : 1048576;
+         datasize < (buffer->datalen + bytes);
+	 datasize *= 2);
+
+    if ((temp = realloc(buffer->data, datasize)) == NULL)
+      return (-1);
+
+    buffer->data     = temp;
+    buffer->datasize = datasize;
+  }
+
+  memcpy(buffer->data + buffer->datalen, data, bytes);
+  buffer->datalen += bytes;
+
+  return ((ssize_t)bytes);
+}
+
+
+/*
+ * 'read_test()' - Benchmark the raster read functions.
+ */
+
+static void
+read_test(int fd)			/* I - File descriptor to read from */
+{
+  unsigned		y;		/* Looping var */
+  cups_raster_t		*r;		/* Raster stream */
+  cups_page_header2_t	header;		/* Page header */
+  unsigned char		buffer[8 * TEST_WIDTH];
+					/* Read buffer */
+
+
+ /*
+  * Test read speed...
+  */
+
+  if ((r = cupsRasterOpen(fd, CUPS_RASTER_READ)) == NULL)
+  {
+    perror("Unable to create raster input stream");
+    return;
+  }
+
+  while (cupsRasterReadHeader2(r, &header))
+  {
+    for (y = 0; y < header.cupsHeight; y ++)
+      cupsRasterReadPixels(r, buffer, header.cupsBytesPerLine);
+  }
+
+  cupsRasterClose(r);
+}
+
+
+/*
+ * 'run_read_test()' - Run the read test as a child process via pipes.
+ */
+
+static int				/* O - Standard input of child */
+run_read_test(void)
+{
+  int	ras_pipes[2];			/* Raster data pipes */
+  int	pid;				/* Child process ID */
+
+
+  if (pipe(ras_pipes))
+    return (-1);
+
+  if ((pid = fork()) < 0)
+  {
+   /*
+    * Fork error - return -1 on error...
+    */
+
+    close(ras_pipes[0]);
+    close(ras_pipes[1]);
+
+    return (-1);
+  }
+  else if (pid == 0)
+  {
+   /*
+    * Child comes here - read data from the input pipe...
+    */
+
+    close(ras_pipes[1]);
+    read_test(ras_pipes[0]);
+    exit(0);
+  }
+  else
+  {
+   /*
+    * Parent comes here - return the output pipe...
+    */
+
+    close(ras_pipes[0]);
+    return (ras_pipes[1]);
+  }
+}
+
+
+/*
+ * 'run_filters()' - Show the time needed to encode a page with the printer
+ *                   driver filters.
+ */
+
+static int				/* O - Exit status */
+run_filters(void)
+{
+  printf("%-40s %9s %9s %10s\n", "Test", "ms/page", "Pages/sec",
+         "Bytes/page");
+
+  filter_pcl();
+  filter_escp();
+  filter_zpl();
+
+  return (0);
+}
+
+
+/*
+ * 'run_passes()' - Run all of the test passes and return the median time.
+ */
+
+static double				/* O - Median time in seconds */
+run_passes(cups_mode_t mode)		/* I - Write mode */
+{
+  int		i;			/* Looping var */
+  int		ras_fd,			/* File descriptor for read process */
+		status;			/* Exit status of read process */
+  double	start_secs,		/* Start time */
+		write_secs,		/* Write time */
+		read_secs,		/* Read time */
+		pass_secs[TEST_PASSES];	/* Total test times */
+
+
+  for (i = 0; i < TEST_PASSES; i ++)
+  {
+    printf("PASS %2d: ", i + 1);
+    fflush(stdout);
+
+    ras_fd     = run_read_test();
+    start_secs = get_time();
+
+    write_test(ras_fd, mode);
+
+    write_secs = get_time();
+    printf(" %.3f write,", write_secs - start_secs);
+    fflush(stdout);
+
+    close(ras_fd);
+    wait(&status);
+
+    read_secs    = get_time();
+    pass_secs[i] = read_secs - start_secs;
+    printf(" %.3f read, %.3f total\n", read_secs - write_secs, pass_secs[i]);
+  }
+
+  return (compute_median(pass_secs, TEST_PASSES));
+}
+
+
+/*
+ * 'run_suite()' - Run the benchmark suite and write the results as JSON.
+ */
+
+static int				/* O - Exit status */
+run_suite(void)
+{
+  int		i, m, c,		/* Looping vars */
+		pass,			/* Current pass */
+		first = 1;		/* First result? */
+  const suite_page_t *page;		/* Current page size and type */
+  unsigned	width,			/* Width in pixels */
+		height,			/* Height in pixels */
+		bytes;			/* Bytes per line */
+  unsigned char	*lines,			/* Lines of page content */
+		*line;			/* Line buffer for reading */
+  suite_buffer_t native,		/* Stream in native byte order */
+		swapped;		/* Stream in the other byte order */
+  double	start,			/* Start time */
+		raster_bytes,		/* Bytes of raster data per document */
+		write_secs[SUITE_PASSES],/* Write times */
+		read_secs[SUITE_PASSES];/* Read times */
+  const char	*host_order,		/* Byte order of this host */
+		*other_order,		/* Other byte order */
+		*simd;			/* SIMD setting */
+  union
+  {
+    unsigned		word;		/* Word */
+    unsigned char	bytes[4];	/* Bytes of word */
+  }		order;			/* Byte order test */
+  static const cups_mode_t modes[] =	/* Write modes */
+  {
+    CUPS_RASTER_WRITE,
+    CUPS_RASTER_WRITE_COMPRESSED,
+    CUPS_RASTER_WRITE_PWG
+  };
+  static const char * const mode_names[] =
+  {					/* Write mode names */
+    "CUPS_RASTER_WRITE",
+    "CUPS_RASTER_WRITE_COMPRESSED",
+    "CUPS_RASTER_WRITE_PWG"
+  };
+  static const char * const contents[] =
+  {					/* Page content names */
+    "blank",
+    "text",
+    "photo"
+  };
+
+
+ /*
+  * CUPS raster streams are written in the byte order of the host while PWG
+  * raster streams are always big-endian.  Streams in the other byte order
+  * are made by converting the native streams since the library cannot write
+  * them directly...
+  */
+
+  order.word = 1;
+
+  if (order.bytes[0])
+  {
+    host_order  = "little-endian";
+    other_order = "big-endian";
+  }
+  else
+  {
+    host_order  = "big-endian";
+    other_order = "little-endian";
+  }
+
+  if ((simd = getenv("CUPS_RASTER_SIMD")) == NULL)
+    simd = "auto";
+
+  memset(&native, 0, sizeof(native));
+  memset(&swapped, 0, sizeof(swapped));
+
+  printf("{\n"
+         "  \"benchmark\": \"rasterbench\",\n"
+	 "  \"byte_order\": \"%s\",\n"
+	 "  \"simd\": \"%s\",\n"
+	 "  \"pages\": %d,\n"
+	 "  \"passes\": %d,\n"
+	 "  \"seed\": %d,\n"
+	 "  \"results\": [", host_order, simd, SUITE_PAGES, SUITE_PASSES,
+	 SUITE_SEED);
+
+  for (i = 0, page = suite_pages;
+       i < (int)(sizeof(suite_pages) / sizeof(suite_pages[0]));
+       i ++, page ++)
+  {
+    width        = page->width * page->resolution / 72;
+    height       = page->length * page->resolution / 72;
+    bytes        = (width * page->bits * page->num_colors + 7) / 8;
+    raster_bytes = (double)bytes * height * SUITE_PAGES;
+
+    if ((lines = malloc(bytes * SUITE_LINES)) == NULL ||
+        (line = malloc(bytes)) == NULL)
+    {
+      perror("Unable to allocate memory for page");
+      return (1);
+    }
+
+    for (c = SUITE_BLANK; c <= SUITE_PHOTO; c ++)
+    {
+      make_lines(page, bytes, (suite_content_t)c, lines);
+
+      for (m = 0; m < (int)(sizeof(modes) / sizeof(modes[0])); m ++)
+      {
+       /*
+        * Time writing and reading in the byte order the library writes...
+	*/
+
+        for (pass = 0; pass < SUITE_PASSES; pass ++)
+	{
+	  start = get_time();
+
+	  if (!suite_write(&native, modes[m], page, bytes, lines))
+	  {
+	    fprintf(stderr, "Unable to write %s %s %s page: %s\n",
+	            mode_names[m], page->type, contents[c],
+		    cupsRasterErrorString());
+	    return (1);
+	  }
+
+	  write_secs[pass] = get_time() - start;
+	  start            = get_time();
+
+	  if (suite_read(&native, line) != SUITE_PAGES)
+	  {
+	    fprintf(stderr, "Unable to read %s %s %s page: %s\n",
+	            mode_names[m], page->type, contents[c],
+		    cupsRasterErrorString());
+	    return (1);
+	  }
+
+	  read_secs[pass] = get_time() - start;
+	}
+
+        suite_result(first, mode_names[m], page, contents[c],
+	             modes[m] == CUPS_RASTER_WRITE_PWG ? "big-endian" :
+		                                         host_order,
+	             modes[m] == CUPS_RASTER_WRITE_PWG &&
+		         strcmp(host_order, "big-endian"),
+		     raster_bytes, native.datalen,
+		     compute_median(write_secs, SUITE_PASSES),
+		     compute_median(read_secs, SUITE_PASSES));
+	first = 0;
+
+        if (modes[m] == CUPS_RASTER_WRITE_PWG)
+	  continue;
+
+       /*
+        * Then time reading the same stream in the other byte order...
+	*/
+
+        if (!swap_stream(&native, &swapped))
+	{
+	  fprintf(stderr, "Unable to swap %s %s %s stream.\n", mode_names[m],
+	          page->type, contents[c]);
+	  return (1);
+	}
+
+        for (pass = 0; pass < SUITE_PASSES; pass ++)
+	{
+	  start = get_time();
+
+	  if (suite_read(&swapped, line) != SUITE_PAGES)
+	  {
+	    fprintf(stderr, "Unable to read swapped %s %s %s page: %s\n",
+	            mode_names[m], page->type, contents[c],
+		    cupsRasterErrorString());
+	    return (1);
+	  }
+
+	  read_secs[pass] = get_time() - start;
+	}
+
+        suite_result(first, mode_names[m], page, contents[c], other_order, 1,
+	             raster_bytes, swapped.datalen, -1.0,
+		     compute_median(read_secs, SUITE_PASSES));
+      }
+    }
+
+    free(lines);
+    free(line);
+  }
+
+  puts("\n  ]\n}");
+
+  free(native.data);
+  free(swapped.data);
+
+  return (0);
+}
+
+
+/*
+ * 'run_threads()' - Compare compressed writing with different numbers of
+ *                   compression threads.
+ */
+
+static int				/* O - Exit status */
+run_threads(void)
+{
+  int		i,			/* Looping var */
+		num_counts,		/* Number of thread counts */
+		counts[8];		/* Thread counts to test */
+  long		cpus;			/* Number of processors */
+  double	secs[8];		/* Median times */
+  char		value[16];		/* Environment variable value */
+
+
+ /*
+  * Test without threads and then with 1, 2, 4, ... threads up to the number
+  * of processors...
+  */
+
+  if ((cpus = sysconf(_SC_NPROCESSORS_ONLN)) < 2)
+    cpus = 2;
+
+  counts[0] = 0;
+  for (num_counts = 1; num_counts < 8 && (1 << (num_counts - 1)) <= cpus; num_counts ++)
+    counts[num_counts] = 1 << (num_counts - 1);
+
+  for (i = 0; i < num_counts; i ++)
+  {
+    printf("%s%d thread%s:\n", i ? "\n" : "", counts[i],
+           counts[i] == 1 ? "" : "s");
+
+    snprintf(value, sizeof(value), "%d", counts[i]);
+    setenv("CUPS_RASTER_THREADS", value, 1);
+
+    secs[i] = run_passes(CUPS_RASTER_WRITE_COMPRESSED_THREADED);
+  }
+
+  puts("\nThreads  Seconds  Pages/Second");
+  for (i = 0; i < num_counts; i ++)
+    printf("%7d  %7.3f  %12.1f\n", counts[i], secs[i],
+           secs[i] > 0.0 ? TEST_PAGES / secs[i] : 0.0);
+
+  return (0);
+}
+
+
+/*
+ * 'set_pixel()' - Set a pixel to a color.
+ */
+
+static void
+set_pixel(const suite_page_t *page,	/* I - Page size and type */
+          unsigned char      *line,	/* I - Line */
+	  unsigned           x,		/* I - Column */
+	  unsigned           red,	/* I - Red (0 to 65535) */
+	  unsigned           green,	/* I - Green (0 to 65535) */
+	  unsigned           blue)	/* I - Blue (0 to 65535) */
+{
+  unsigned	i,			/* Looping var */
+		values[4];		/* Color values */
+
+
+  switch (page->cspace)
+  {
+    case CUPS_CSPACE_K :
+        values[0] = 65535 - (red * 30 + green * 59 + blue * 11) / 100;
+        break;
+
+    case CUPS_CSPACE_SW :
+        values[0] = (red * 30 + green * 59 + blue * 11) / 100;
+        break;
+
+    case CUPS_CSPACE_CMYK :
+        values[0] = 65535 - red;
+	values[1] = 65535 - green;
+	values[2] = 65535 - blue;
+	values[3] = values[0];
+
+	if (values[1] < values[3])
+	  values[3] = values[1];
+	if (values[2] < values[3])
+	  values[3] = values[2];
+
+	values[0] -= values[3];
+	values[1] -= values[3];
+	values[2] -= values[3];
+        break;
+
+    default :
+        values[0] = red;
+	values[1] = green;
+	values[2] = blue;
+        break;
+  }
+
+  if (page->bits == 1)
+  {
+   /*
+    * Dither bitmaps with a random threshold...
+    */
+
+    if (values[0] > (suite_rand() % 65535))
+      line[x / 8] |= (unsigned char)(0x80 >> (x & 7));
+  }
+  else if (page->bits == 8)
+  {
+    for (i = 0, line += x * page->num_colors; i < page->num_colors; i ++)
+      *line++ = (unsigned char)(values[i] >> 8);
+  }
+  else
+  {
+    unsigned short *sline = (unsigned short *)line + x * page->num_colors;
+					/* 16-bit pixel */
+
+    for (i = 0; i < page->num_colors; i ++)
+      *sline++ = (unsigned short)values[i];
+  }
+}
+
+
+/*
+ * 'suite_rand()' - Return a reproducible pseudo-random number.
+ */
+
+static unsigned				/* O - Random number */
+suite_rand(void)
+{
+  suite_seed = suite_seed * 1103515245 + 12345;
+
+  return ((suite_seed >> 16) & 32767);
+}
+
+
+/*
+ * 'suite_read()' - Read a raster stream from a memory buffer.
+ */
+
+static int				/* O - Number of pages read */
+suite_read(suite_buffer_t *buffer,	/* I - Memory buffer */
+           unsigned char  *line)	/* I - Line buffer */
+{
+  int			pages = 0;	/* Number of pages */
+  unsigned		y;		/* Looping var */
+  cups_raster_t		*r;		/* Raster stream */
+  cups_page_header2_t	header;		/* Page header */
+
+
+  buffer->dataptr = 0;
+
+  if ((r = cupsRasterOpenIO(mem_read_cb, buffer, CUPS_RASTER_READ)) == NULL)
+    return (0);
+
+  while (cupsRasterReadHeader2(r, &header))
+  {
+    for (y = 0; y < header.cupsHeight; y ++)
+      if (!cupsRasterReadPixels(r, line, header.cupsBytesPerLine))
+        break;
+
+    if (y < header.cupsHeight)
+      break;
+
+    pages ++;
+  }
+
+  cupsRasterClose(r);
+
+  return (pages);
+}
+
+
+/*
+ * 'suite_result()' - Write a benchmark result as JSON.
+ */
+
+static void
+suite_result(
+    int                first,		/* I - First result? */
+    const char         *mode,		/* I - Write mode name */
+    const suite_page_t *page,		/* I - Page size and type */
+    const char         *content,	/* I - Page content name */
+    const char         *byte_order,	/* I - Byte order of stream */
+    int                swapped,		/* I - Stream swapped on this host? */
+    double             raster_bytes,	/* I - Bytes of raster data */
+    size_t             stream_bytes,	/* I - Bytes in stream */
+    double             write_secs,	/* I - Write time or -1 if not written */
+    double             read_secs)	/* I - Read time */
+{
+  printf("%s\n    {\n"
+         "      \"mode\": \"%s\",\n"
+	 "      \"media\": \"%s\",\n"
+	 "      \"type\": \"%s\",\n"
+	 "      \"resolution\": %u,\n"
+	 "      \"width\": %u,\n"
+	 "      \"height\": %u,\n"
+	 "      \"content\": \"%s\",\n"
+	 "      \"byte_order\": \"%s\",\n"
+	 "      \"swapped\": %s,\n"
+	 "      \"raster_bytes\": %.0f,\n"
+	 "      \"stream_bytes\": %lu,\n", first ? "" : ",", mode, page->media,
+	 page->type, page->resolution, page->width * page->resolution / 72,
+	 page->length * page->resolution / 72, content, byte_order,
+	 swapped ? "true" : "false", raster_bytes,
+	 (unsigned long)stream_bytes);
+
+  if (write_secs < 0.0)
+    puts("      \"write_seconds\": null,\n"
+         "      \"write_mb_per_second\": null,");
+  else
+    printf("      \"write_seconds\": %.6f,\n"
+           "      \"write_mb_per_second\": %.1f,\n", write_secs,
+	   write_secs > 0.0 ? raster_bytes / write_secs / 1048576.0 : 0.0);
+
+  printf("      \"read_seconds\": %.6f,\n"
+         "      \"read_mb_per_second\": %.1f\n"
+	 "    }", read_secs,
+	 read_secs > 0.0 ? raster_bytes / read_secs / 1048576.0 : 0.0);
+}
+
+
+/*
+ * 'suite_write()' - Write a raster stream to a memory buffer.
+ */
+
+static int				/* O - 1 on success, 0 on error */
+suite_write(suite_buffer_t     *buffer,	/* I - Memory buffer */
+            cups_mode_t        mode,	/* I - Write mode */
+	    const suite_page_t *page,	/* I - Page size and type */
+	    unsigned           bytes,	/* I - Bytes per line */
+	    unsigned char      *lines)	/* I - Lines of page content */
+{
+  int			status = 1;	/* Return status */
+  unsigned		p, y;		/* Looping vars */
+  cups_raster_t		*r;		/* Raster stream */
+  cups_page_header2_t	header;		/* Page header */
+
+
+  buffer->datalen = 0;
+
+  if ((r = cupsRasterOpenIO(mem_write_cb, buffer, mode)) == NULL)
+    return (0);
+
+  memset(&header, 0, sizeof(header));
+  snprintf(header.cupsPageSizeName, sizeof(header.cupsPageSizeName), "%s",
+           page->media);
+  header.HWResolution[0]  = page->resolution;
+  header.HWResolution[1]  = page->resolution;
+  header.PageSize[0]      = page->width;
+  header.PageSize[1]      = page->length;
+  header.cupsWidth        = page->width * page->resolution / 72;
+  header.cupsHeight       = page->length * page->resolution / 72;
+  header.cupsBitsPerColor = page->bits;
+  header.cupsBitsPerPixel = page->bits * page->num_colors;
+  header.cupsBytesPerLine = bytes;
+  header.cupsColorOrder   = CUPS_ORDER_CHUNKED;
+  header.cupsColorSpace   = page->cspace;
+  header.cupsNumColors    = page->num_colors;
+
+  for (p = 0; p < SUITE_PAGES && status; p ++)
+  {
+    if (!cupsRasterWriteHeader2(r, &header))
+    {
+      status = 0;
+      break;
+    }
+
+    for (y = 0; y < header.cupsHeight; y ++)
+      if (!cupsRasterWritePixels(r, lines + (y % SUITE_LINES) * bytes, bytes))
+      {
+        status = 0;
+	break;
+      }
+  }
+
+  cupsRasterClose(r);
+
+  return (status);
+}
+
+
+/*
+ * 'swap_stream()' - Convert a CUPS raster stream to the other byte order.
+ *
+ * Only chunked pixels are supported, which is all the suite writes.
+ */
+
+static int				/* O - 1 on success, 0 on error */
+swap_stream(const suite_buffer_t *src,	/* I - Stream in native byte order */
+            suite_buffer_t       *dst)	/* O - Stream in other byte order */
+{
+  const unsigned char	*sptr,		/* Pointer into source */
+			*send;		/* End of source */
+  unsigned char		*dptr,		/* Pointer into destination */
+			*temp;		/* New buffer */
+  unsigned		sync,		/* Sync word */
+			i,		/* Looping var */
+			y,		/* Current line */
+			bpp,		/* Bytes per pixel */
+			bytes,		/* Bytes in current line */
+			count,		/* Bytes to copy */
+			repeat;		/* Line repeat count */
+  int			compressed,	/* Compressed stream? */
+			swap16;		/* Swap 16-bit values? */
+  cups_page_header2_t	header;		/* Page header */
+
+
+ /*
+  * The converted stream is the same size as the original...
+  */
+
+  if (src->datalen < sizeof(sync))
+    return (0);
+
+  if (dst->datasize < src->datalen)
+  {
+    if ((temp = realloc(dst->data, src->datalen)) == NULL)
+      return (0);
+
+    dst->data     = temp;
+    dst->datasize = src->datalen;
+  }
+
+  sptr = src->data;
+  send = src->data + src->datalen;
+  dptr = dst->data;
+
+  memcpy(&sync, sptr, sizeof(sync));
+
+  if (sync == CUPS_RASTER_SYNC)
+    compressed = 0;
+  else if (sync == CUPS_RASTER_SYNCv2)
+    compressed = 1;
+  else
+    return (0);
+
+  for (i = 0; i < 4; i ++)
+    dptr[i] = sptr[3 - i];
+
+  sptr += 4;
+  dptr += 4;
+
+  while (sptr < send)
+  {
+   /*
+    * Swap the numeric fields of the page header...
+    */
+
+    if ((size_t)(send - sptr) < sizeof(header))
+      return (0);
+
+    memcpy(&header, sptr, sizeof(header));
+    memcpy(dptr, sptr, sizeof(header));
+
+    for (i = offsetof(cups_page_header2_t, AdvanceDistance);
+         i < offsetof(cups_page_header2_t, cupsString);
+	 i += 4)
+    {
+      dptr[i]     = sptr[i + 3];
+      dptr[i + 1] = sptr[i + 2];
+      dptr[i + 2] = sptr[i + 1];
+      dptr[i + 3] = sptr[i];
+    }
+
+    sptr += sizeof(header);
+    dptr += sizeof(header);
+
+    swap16 = header.cupsBitsPerColor == 16;
+    bpp    = (header.cupsBitsPerPixel + 7) / 8;
+
+    if (!compressed)
+    {
+     /*
+      * Uncompressed pixels are copied as-is unless they are 16-bit...
+      */
+
+      count = header.cupsBytesPerLine * header.cupsHeight;
+
+      if ((size_t)(send - sptr) < count)
+        return (0);
+
+      if (swap16)
+      {
+        for (i = 0; i < count; i += 2)
+	{
+	  dptr[i]     = sptr[i + 1];
+	  dptr[i + 1] = sptr[i];
+	}
+      }
+      else
+        memcpy(dptr, sptr, count);
+
+      sptr += count;
+      dptr += count;
+      continue;
+    }
+
+   /*
+    * Compressed lines start with a line repeat count followed by runs of
+    * repeated or literal pixels...
+    */
+
+    for (y = 0; y < header.cupsHeight; y += repeat)
+    {
+      if (sptr >= send)
+        return (0);
+
+      repeat  = *sptr + 1u;
+      *dptr++ = *sptr++;
+
+      for (bytes = 0; bytes < header.cupsBytesPerLine;)
+      {
+        if (sptr >= send)
+	  return (0);
+
+        if (*sptr & 128)
+	{
+	  count = (257u - *sptr) * bpp;
+
+	  if (count > (header.cupsBytesPerLine - bytes))
+	    count = header.cupsBytesPerLine - bytes;
+
+	  bytes += count;
+	}
+	else
+	{
+	  bytes += (*sptr + 1u) * bpp;
+	  count = bpp;
+	}
+
+        *dptr++ = *sptr++;
+
+        if ((size_t)(send - sptr) < count)
+	  return (0);
+
+	if (swap16)
+	{
+	  for (; count > 1; count -= 2, sptr += 2, dptr += 2)
+	  {
+	    dptr[0] = sptr[1];
+	    dptr[1] = sptr[0];
+	  }
+	}
+	else
+	{
+	  memcpy(dptr, sptr, count);
+	  sptr += count;
+	  dptr += count;
+	}
+      }
+    }
+  }
+
+  dst->datalen = (size_t)(dptr - dst->data);
+
+  return (1);
+}
+
+
 /*
  * 'write_test()' - Benchmark the raster write functions.
  */
@@ -24,6 +24,8 @@
 #include <cups/string-private.h>
 #include <cups/language-private.h>
 #include <cups/raster.h>
+#include "escp-common.h"
+#include "pcl-common.h"
 #include <unistd.h>
 #include <fcntl.h>
 #include <signal.h>
@@ -54,6 +56,7 @@
 
 unsigned char	*Planes[6],		/* Output buffers */
 		*CompBuffer,		/* Compression buffer */
+		*BandBuffer,		/* Band of 8 lines */
 		*LineBuffers[2];	/* Line bitmap buffers */
 int		Model,			/* Model number */
 		EjectPage,		/* Eject the page when done? */
@@ -61,7 +64,7 @@ int		Model,			/* Model number */
 		Canceled;		/* Has the current job been canceled? */
 unsigned	NumPlanes,		/* Number of color planes */
 		Feed,			/* Number of lines to skip */
-		DotBit,			/* Bit in buffers */
+		BandLine,		/* Current line in band */
 		DotBytes,		/* # bytes in a dot column */
 		DotColumns,		/* # columns in 1/60 inch */
 		LineCount,		/* # of lines processed */
@@ -309,14 +312,15 @@ StartPage(
 
   if (DotBytes)
   {
-    if ((LineBuffers[0] = calloc((size_t)DotBytes, header->cupsWidth * (size_t)(Shingling + 1))) == NULL)
+    if ((LineBuffers[0] = calloc((size_t)DotBytes, header->cupsWidth * (size_t)(Shingling + 1))) == NULL ||
+        (BandBuffer = malloc(8 * header->cupsBytesPerLine)) == NULL)
     {
       fputs("ERROR: Unable to allocate memory\n", stderr);
       exit(1);
     }
 
     LineBuffers[1] = LineBuffers[0] + DotBytes * header->cupsWidth;
-    DotBit         = 128;
+    BandLine       = 0;
     LineCount      = 0;
     EvenOffset     = 0;
     OddOffset      = 0;
@@ -340,7 +344,7 @@ EndPage(
 
     if (!Shingling)
     {
-      if (DotBit < 128 || EvenOffset)
+      if (BandLine > 0 || EvenOffset)
         OutputRows(header, 0);
     }
     else if (OddOffset > EvenOffset)
@@ -372,7 +376,10 @@ EndPage(
     free(CompBuffer);
 
   if (DotBytes)
+  {
     free(LineBuffers[0]);
+    free(BandBuffer);
+  }
 }
 
 
@@ -417,11 +424,7 @@ CompressData(const unsigned char *line,	/* I - Data to compress */
 	     unsigned            ystep)	/* I - Y resolution */
 {
   const unsigned char	*line_ptr,	/* Current byte pointer */
-        		*line_end,	/* End-of-line byte pointer */
-        		*start;		/* Start of compression sequence */
-  unsigned char      	*comp_ptr,	/* Pointer into compression buffer */
-			temp;		/* Current byte */
-  int   	        count;		/* Count of bytes for output */
+        		*line_end;	/* End-of-line byte pointer */
   static int		ctable[6] = { 0, 2, 1, 4, 18, 17 };
 					/* KCMYcm color values */
 
@@ -438,45 +441,7 @@ CompressData(const unsigned char *line,	/* I - Data to compress */
   */
 
   if (ystep == 5)
-  {
-    for (comp_ptr = (unsigned char *)line; comp_ptr < line_end;)
-    {
-     /*
-      * Grab the current byte...
-      */
-
-      temp = *comp_ptr;
-
-     /*
-      * Check adjacent bits...
-      */
-
-      if ((temp & 0xc0) == 0xc0)
-        temp &= 0xbf;
-      if ((temp & 0x60) == 0x60)
-        temp &= 0xdf;
-      if ((temp & 0x30) == 0x30)
-        temp &= 0xef;
-      if ((temp & 0x18) == 0x18)
-        temp &= 0xf7;
-      if ((temp & 0x0c) == 0x0c)
-        temp &= 0xfb;
-      if ((temp & 0x06) == 0x06)
-        temp &= 0xfd;
-      if ((temp & 0x03) == 0x03)
-        temp &= 0xfe;
-
-      *comp_ptr++ = temp;
-
-     /*
-      * Check the last bit in the current byte and the first bit in the
-      * next byte...
-      */
-
-      if ((temp & 0x01) && comp_ptr < line_end && *comp_ptr & 0x80)
-        *comp_ptr &= 0x7f;
-    }
-  }
+    ESCPDeplete((unsigned char *)line, length);
 
   switch (type)
   {
@@ -491,66 +456,8 @@ CompressData(const unsigned char *line,	/* I - Data to compress */
         * Do TIFF pack-bits encoding...
         */
 
-	comp_ptr = CompBuffer;
-
-	while (line_ptr < line_end)
-	{
-	  if ((line_ptr + 1) >= line_end)
-	  {
-	   /*
-	    * Single byte on the end...
-	    */
-
-	    *comp_ptr++ = 0x00;
-	    *comp_ptr++ = *line_ptr++;
-	  }
-	  else if (line_ptr[0] == line_ptr[1])
-	  {
-	   /*
-	    * Repeated sequence...
-	    */
-
-	    line_ptr ++;
-	    count = 2;
-
-	    while (line_ptr < (line_end - 1) &&
-        	   line_ptr[0] == line_ptr[1] &&
-        	   count < 127)
-	    {
-              line_ptr ++;
-              count ++;
-	    }
-
-	    *comp_ptr++ = (unsigned char)(257 - count);
-	    *comp_ptr++ = *line_ptr++;
-	  }
-	  else
-	  {
-	   /*
-	    * Non-repeated sequence...
-	    */
-
-	    start    = line_ptr;
-	    line_ptr ++;
-	    count    = 1;
-
-	    while (line_ptr < (line_end - 1) &&
-        	   line_ptr[0] != line_ptr[1] &&
-        	   count < 127)
-	    {
-              line_ptr ++;
-              count ++;
-	    }
-
-	    *comp_ptr++ = (unsigned char)(count - 1);
-
-	    memcpy(comp_ptr, start, (size_t)count);
-	    comp_ptr += count;
-	  }
-	}
-
         line_ptr = CompBuffer;
-        line_end = comp_ptr;
+        line_end = CompBuffer + PCLCompressTIFF(line, length, CompBuffer);
 	break;
   }
 
@@ -626,39 +533,26 @@ OutputLine(
     unsigned char	*tempptr,
 			*evenptr,
 			*oddptr;
-    unsigned int	x;
-    unsigned char	bit;
-    const unsigned char	*pixel;
-    unsigned char 	*temp;
 
 
    /*
-    * Collect bitmap data in the line buffers and write after each buffer.
+    * Collect 8 lines of bitmap data in the band buffer and copy the dot
+    * columns to the line buffers after each band, writing the line buffers
+    * as they fill up.
     */
 
-    for (x = header->cupsWidth, bit = 128, pixel = Planes[0],
-             temp = CompBuffer;
-	 x > 0;
-	 x --, temp ++)
-    {
-      if (*pixel & bit)
-        *temp |= DotBit;
-
-      if (bit > 1)
-	bit >>= 1;
-      else
-      {
-	bit = 128;
-	pixel ++;
-      }
-    }
+    memcpy(BandBuffer + BandLine * header->cupsBytesPerLine, Planes[0],
+           header->cupsBytesPerLine);
 
-    if (DotBit > 1)
-      DotBit >>= 1;
+    if (BandLine < 7)
+      BandLine ++;
     else
     {
+      ESCPTransposeBand(BandBuffer, header->cupsBytesPerLine,
+                        header->cupsWidth, CompBuffer);
+
      /*
-      * Copy the holding buffer to the output buffer, shingling as necessary...
+      * Copy the dot columns to the output buffer, shingling as necessary...
       */
 
       if (Shingling && LineCount != 0)
@@ -688,10 +582,7 @@ OutputLine(
         }
 
         if (width == 1)
-        {
           evenptr[0] = tempptr[0];
-          oddptr[0]  = tempptr[1];
-        }
       }
       else
       {
@@ -734,10 +625,8 @@ OutputLine(
 	}
       }
 
-      DotBit = 128;
+      BandLine = 0;
       LineCount ++;
-
-      memset(CompBuffer, 0, header->cupsWidth);
     }
   }
   else
@@ -24,6 +24,7 @@
 #include <cups/string-private.h>
 #include <cups/language-private.h>
 #include <cups/raster.h>
+#include "pcl-common.h"
 #include <unistd.h>
 #include <fcntl.h>
 #include <signal.h>
@@ -35,10 +36,12 @@
 
 unsigned char	*Planes[4],		/* Output buffers */
 		*CompBuffer,		/* Compression buffer */
-		*BitBuffer;		/* Buffer for output bits */
+		*BitBuffer,		/* Buffer for output bits */
+		*SeedBuffer;		/* Seed rows for delta compression */
 unsigned 	NumPlanes,		/* Number of color planes */
 		ColorBits,		/* Number of bits per color */
-		Feed;			/* Number of lines to skip */
+		Feed,			/* Number of lines to skip */
+		SeedValid;		/* Do the seed rows match the printer? */
 int		Duplex,			/* Current duplex mode */
 		Page,			/* Current page number */
 		Canceled;		/* Has the current job been canceled? */
@@ -54,7 +57,7 @@ void	EndPage(void);
 void	Shutdown(void);
 
 void	CancelJob(int sig);
-void	CompressData(unsigned char *line, unsigned length, unsigned plane, unsigned type);
+void	CompressData(unsigned char *line, unsigned length, unsigned plane, unsigned type, unsigned char *seed);
 void	OutputLine(cups_page_header2_t *header);
 
 
@@ -348,6 +351,17 @@ StartPage(ppd_file_t         *ppd,	/* I - PPD file */
     CompBuffer = malloc(header->cupsBytesPerLine * 2 + 2);
   else
     CompBuffer = NULL;
+
+ /*
+  * Delta row compression needs a seed row for each plane of bits we send...
+  */
+
+  if (header->cupsCompression == 3)
+    SeedBuffer = calloc(NumPlanes * ColorBits, (header->cupsWidth + 7) / 8);
+  else
+    SeedBuffer = NULL;
+
+  SeedValid = 0;
 }
 
 
@@ -390,6 +404,9 @@ EndPage(void)
 
   if (CompBuffer)
     free(CompBuffer);
+
+  if (SeedBuffer)
+    free(SeedBuffer);
 }
 
 
@@ -430,12 +447,12 @@ void
 CompressData(unsigned char *line,	/* I - Data to compress */
              unsigned      length,	/* I - Number of bytes */
 	     unsigned      plane,	/* I - Color plane */
-	     unsigned      type)	/* I - Type of compression */
+	     unsigned      type,	/* I - Type of compression */
+	     unsigned char *seed)	/* I - Seed row for plane */
 {
   unsigned char	*line_ptr,		/* Current byte pointer */
         	*line_end,		/* End-of-line byte pointer */
-        	*comp_ptr,		/* Pointer into compression buffer */
-        	*start;			/* Start of compression sequence */
+        	*comp_ptr;		/* Pointer into compression buffer */
   unsigned	count;			/* Count of bytes for output */
 
 
@@ -479,68 +496,21 @@ CompressData(unsigned char *line,	/* I - Data to compress */
         * Do TIFF pack-bits encoding...
         */
 
-	line_ptr = line;
-	line_end = line + length;
-	comp_ptr = CompBuffer;
+        line_ptr = CompBuffer;
+        line_end = CompBuffer + PCLCompressTIFF(line, length, CompBuffer);
+	break;
 
-	while (line_ptr < line_end)
-	{
-	  if ((line_ptr + 1) >= line_end)
-	  {
-	   /*
-	    * Single byte on the end...
-	    */
-
-	    *comp_ptr++ = 0x00;
-	    *comp_ptr++ = *line_ptr++;
-	  }
-	  else if (line_ptr[0] == line_ptr[1])
-	  {
-	   /*
-	    * Repeated sequence...
-	    */
-
-	    line_ptr ++;
-	    count = 2;
-
-	    while (line_ptr < (line_end - 1) &&
-        	   line_ptr[0] == line_ptr[1] &&
-        	   count < 127)
-	    {
-              line_ptr ++;
-              count ++;
-	    }
-
-	    *comp_ptr++ = (unsigned char)(257 - count);
-	    *comp_ptr++ = *line_ptr++;
-	  }
-	  else
-	  {
-	   /*
-	    * Non-repeated sequence...
-	    */
-
-	    start    = line_ptr;
-	    line_ptr ++;
-	    count    = 1;
-
-	    while (line_ptr < (line_end - 1) &&
-        	   line_ptr[0] != line_ptr[1] &&
-        	   count < 127)
-	    {
-              line_ptr ++;
-              count ++;
-	    }
-
-	    *comp_ptr++ = (unsigned char)(count - 1);
-
-	    memcpy(comp_ptr, start, count);
-	    comp_ptr += count;
-	  }
-	}
+    case 3 :
+       /*
+        * Do delta row encoding against the previous line of this plane, then
+	* make this line the new seed row...
+        */
 
         line_ptr = CompBuffer;
-        line_end = comp_ptr;
+        line_end = CompBuffer + PCLCompressDelta(line, SeedValid ? seed : NULL,
+	                                         length, CompBuffer);
+
+        memcpy(seed, line, length);
 	break;
   }
 
@@ -561,23 +531,20 @@ void
 OutputLine(cups_page_header2_t *header)	/* I - Page header */
 {
   unsigned	plane,			/* Current plane */
-		bytes,			/* Bytes to write */
-		count;			/* Bytes to convert */
-  unsigned char	bit,			/* Current plane data */
-		bit0,			/* Current low bit data */
-		bit1,			/* Current high bit data */
-		*plane_ptr,		/* Pointer into Planes */
-		*bit_ptr;		/* Pointer into BitBuffer */
+		bytes;			/* Bytes to write */
+  unsigned char	*seed;			/* Seed row for current plane */
 
 
  /*
-  * Output whitespace as needed...
+  * Output whitespace as needed; skipping lines resets the printer's seed
+  * rows...
   */
 
   if (Feed > 0)
   {
     printf("\033*b%dY", Feed);
-    Feed = 0;
+    Feed      = 0;
+    SeedValid = 0;
   }
 
  /*
@@ -585,6 +552,7 @@ OutputLine(cups_page_header2_t *header)	/* I - Page header */
   */
 
   bytes = (header->cupsWidth + 7) / 8;
+  seed  = SeedBuffer;
 
   for (plane = 0; plane < NumPlanes; plane ++)
     if (ColorBits == 1)
@@ -594,7 +562,10 @@ OutputLine(cups_page_header2_t *header)	/* I - Page header */
       */
 
       CompressData(Planes[plane], bytes, plane < (NumPlanes - 1) ? 'V' : 'W',
-		   header->cupsCompression);
+		   header->cupsCompression, seed);
+
+      if (seed)
+        seed += bytes;
     }
     else
     {
@@ -602,37 +573,23 @@ OutputLine(cups_page_header2_t *header)	/* I - Page header */
       * Separate low and high bit data into separate buffers.
       */
 
-      for (count = header->cupsBytesPerLine / NumPlanes,
-               plane_ptr = Planes[plane], bit_ptr = BitBuffer;
-	   count > 0;
-	   count -= 2, plane_ptr += 2, bit_ptr ++)
-      {
-        bit = plane_ptr[0];
-
-        bit0 = (unsigned char)(((bit & 64) << 1) | ((bit & 16) << 2) | ((bit & 4) << 3) | ((bit & 1) << 4));
-        bit1 = (unsigned char)((bit & 128) | ((bit & 32) << 1) | ((bit & 8) << 2) | ((bit & 2) << 3));
-
-        if (count > 1)
-	{
-	  bit = plane_ptr[1];
-
-          bit0 |= (unsigned char)((bit & 1) | ((bit & 4) >> 1) | ((bit & 16) >> 2) | ((bit & 64) >> 3));
-          bit1 |= (unsigned char)(((bit & 2) >> 1) | ((bit & 8) >> 2) | ((bit & 32) >> 3) | ((bit & 128) >> 4));
-	}
-
-        bit_ptr[0]     = bit0;
-	bit_ptr[bytes] = bit1;
-      }
+      PCLSeparateBits(Planes[plane], header->cupsBytesPerLine / NumPlanes,
+                      BitBuffer, BitBuffer + bytes);
 
      /*
       * Send low and high bits...
       */
 
-      CompressData(BitBuffer, bytes, 'V', header->cupsCompression);
+      CompressData(BitBuffer, bytes, 'V', header->cupsCompression, seed);
       CompressData(BitBuffer + bytes, bytes, plane < (NumPlanes - 1) ? 'V' : 'W',
-		   header->cupsCompression);
+		   header->cupsCompression, seed ? seed + bytes : NULL);
+
+      if (seed)
+        seed += 2 * bytes;
     }
 
+  SeedValid = 1;
+
   fflush(stdout);
 }
 
@@ -24,6 +24,8 @@
 #include <cups/string-private.h>
 #include <cups/language-private.h>
 #include <cups/raster.h>
+#include "pcl-common.h"
+#include "zpl-common.h"
 #include <unistd.h>
 #include <fcntl.h>
 #include <signal.h>
@@ -60,6 +62,13 @@
 #define INTELLITECH_PCL	0x20		/* Intellitech PCL-based printers */
 
 
+/*
+ * Other constants...
+ */
+
+#define EPL_BAND_LINES	64		/* Maximum lines per EPL GW command */
+
+
 /*
  * Globals...
  */
@@ -68,6 +77,9 @@ unsigned char	*Buffer;		/* Output buffer */
 unsigned char	*CompBuffer;		/* Compression buffer */
 unsigned char	*LastBuffer;		/* Last buffer */
 unsigned	Feed;			/* Number of lines to skip */
+unsigned	BandLines,		/* Number of lines in EPL band */
+		BandY;			/* First line in EPL band */
+zpl_z64_t	*Z64;			/* ZPL Z64 graphic encoder */
 int		LastSet;		/* Number of repeat characters */
 int		ModelNumber,		/* cupsModelNumber attribute */
 		Page,			/* Current page */
@@ -82,9 +94,9 @@ void	Setup(ppd_file_t *ppd);
 void	StartPage(ppd_file_t *ppd, cups_page_header2_t *header);
 void	EndPage(ppd_file_t *ppd, cups_page_header2_t *header);
 void	CancelJob(int sig);
+void	EPLFlush(cups_page_header2_t *header);
 void	OutputLine(ppd_file_t *ppd, cups_page_header2_t *header, unsigned y);
 void	PCLCompress(unsigned char *line, unsigned length);
-void	ZPLCompress(unsigned char repeat_char, unsigned repeat_count);
 
 
 /*
@@ -271,6 +283,19 @@ StartPage(ppd_file_t         *ppd,	/* I - PPD file */
 	*/
 
         printf("q%u\n", (header->cupsWidth + 7) & ~7U);
+
+       /*
+        * Allocate the band buffer...
+	*/
+
+	if ((CompBuffer = malloc(EPL_BAND_LINES * header->cupsBytesPerLine)) == NULL)
+	{
+	  _cupsLangPrintFilter(stderr, "ERROR",
+	                       _("Unable to allocate memory for page info"));
+	  exit(1);
+	}
+
+	BandLines = 0;
         break;
 
     case ZEBRA_ZPL :
@@ -282,13 +307,24 @@ StartPage(ppd_file_t         *ppd,	/* I - PPD file */
 	  printf("~SD%02u\n", 30 * header->cupsCompression / 100);
 
        /*
-        * Start bitmap graphics...
+        * Start bitmap graphics, using Z64 (zlib + Base64) encoding if
+	* requested and available...
 	*/
 
-        printf("~DGR:CUPS.GRF,%u,%u,\n",
+        printf("~DGR:CUPS.GRF,%u,%u,",
 	       header->cupsHeight * header->cupsBytesPerLine,
 	       header->cupsBytesPerLine);
 
+	if ((choice = ppdFindMarkedChoice(ppd, "zeCompression")) != NULL &&
+	    !strcmp(choice->choice, "Z64") &&
+	    (Z64 = ZPLZ64Open(stdout, 1)) != NULL)
+	{
+	  fputs(":Z64:", stdout);
+	  break;
+	}
+
+	putchar('\n');
+
        /*
         * Allocate compression buffers...
 	*/
@@ -467,9 +503,11 @@ EndPage(ppd_file_t *ppd,		/* I - PPD file */
 
     case ZEBRA_EPL_PAGE :
        /*
-        * Print the label...
+        * Write any remaining graphics and print the label...
 	*/
 
+        EPLFlush(header);
+
         puts("P1");
 
        /*
@@ -481,6 +519,16 @@ EndPage(ppd_file_t *ppd,		/* I - PPD file */
 	break;
 
     case ZEBRA_ZPL :
+        if (Z64)
+	{
+	 /*
+	  * Finish the Z64 data...
+	  */
+
+	  ZPLZ64Close(Z64, !Canceled);
+	  Z64 = NULL;
+	}
+
         if (Canceled)
 	{
 	 /*
@@ -716,6 +764,24 @@ CancelJob(int sig)			/* I - Signal */
 }
 
 
+/*
+ * 'EPLFlush()' - Write the current band of EPL graphics...
+ */
+
+void
+EPLFlush(cups_page_header2_t *header)	/* I - Page header */
+{
+  if (BandLines == 0)
+    return;
+
+  printf("GW0,%u,%u,%u\n", BandY, header->cupsBytesPerLine, BandLines);
+  fwrite(CompBuffer, header->cupsBytesPerLine, BandLines, stdout);
+  putchar('\n');
+
+  BandLines = 0;
+}
+
+
 /*
  * 'OutputLine()' - Output a line of graphics...
  */
@@ -728,10 +794,6 @@ OutputLine(ppd_file_t         *ppd,	/* I - PPD file */
   unsigned	i;			/* Looping var */
   unsigned char	*ptr;			/* Pointer into buffer */
   unsigned char	*compptr;		/* Pointer into compression buffer */
-  unsigned char	repeat_char;		/* Repeated character */
-  unsigned	repeat_count;		/* Number of repeated characters */
-  static const unsigned char *hex = (const unsigned char *)"0123456789ABCDEF";
-					/* Hex digits */
 
 
   (void)ppd;
@@ -773,17 +835,43 @@ OutputLine(ppd_file_t         *ppd,	/* I - PPD file */
         break;
 
     case ZEBRA_EPL_PAGE :
-        if (Buffer[0] || memcmp(Buffer, Buffer + 1, header->cupsBytesPerLine))
+       /*
+        * Collect runs of non-blank lines so that each band is sent with a
+	* single GW command...
+	*/
+
+        if (Buffer[0] ||
+	    memcmp(Buffer, Buffer + 1, header->cupsBytesPerLine - 1))
 	{
-          printf("GW0,%d,%d,1\n", y, header->cupsBytesPerLine);
-	  for (i = header->cupsBytesPerLine, ptr = Buffer; i > 0; i --, ptr ++)
-	    putchar(~*ptr);
-	  putchar('\n');
-	  fflush(stdout);
+	  if (BandLines == 0)
+	    BandY = y;
+
+	  for (i = header->cupsBytesPerLine, ptr = Buffer,
+	           compptr = CompBuffer + BandLines * header->cupsBytesPerLine;
+	       i > 0;
+	       i --, ptr ++, compptr ++)
+	    *compptr = (unsigned char)~*ptr;
+
+	  BandLines ++;
+
+	  if (BandLines == EPL_BAND_LINES)
+	    EPLFlush(header);
 	}
+	else
+	  EPLFlush(header);
         break;
 
     case ZEBRA_ZPL :
+        if (Z64)
+	{
+	 /*
+	  * Z64 graphics compress the whole image, so just add the line...
+	  */
+
+	  ZPLZ64Write(Z64, Buffer, header->cupsBytesPerLine);
+	  break;
+	}
+
        /*
 	* Determine if this row is the same as the previous line.
         * If so, output a ':' and return...
@@ -799,54 +887,12 @@ OutputLine(ppd_file_t         *ppd,	/* I - PPD file */
 	}
 
        /*
-        * Convert the line to hex digits...
-	*/
-
-	for (ptr = Buffer, compptr = CompBuffer, i = header->cupsBytesPerLine;
-	     i > 0;
-	     i --, ptr ++)
-        {
-	  *compptr++ = hex[*ptr >> 4];
-	  *compptr++ = hex[*ptr & 15];
-	}
-
-        *compptr = '\0';
-
-       /*
-        * Run-length compress the graphics...
+        * Convert the line to run-length compressed hex digits...
 	*/
 
-	for (compptr = CompBuffer + 1, repeat_char = CompBuffer[0], repeat_count = 1;
-	     *compptr;
-	     compptr ++)
-	  if (*compptr == repeat_char)
-	    repeat_count ++;
-	  else
-	  {
-	    ZPLCompress(repeat_char, repeat_count);
-	    repeat_char  = *compptr;
-	    repeat_count = 1;
-	  }
-
-        if (repeat_char == '0')
-	{
-	 /*
-	  * Handle 0's on the end of the line...
-	  */
-
-	  if (repeat_count & 1)
-	  {
-	    repeat_count --;
-	    putchar('0');
-	  }
-
-          if (repeat_count > 0)
-	    putchar(',');
-	}
-	else
-	  ZPLCompress(repeat_char, repeat_count);
-
-	fflush(stdout);
+	fwrite(CompBuffer, 1,
+	       ZPLCompressHex(Buffer, header->cupsBytesPerLine, CompBuffer),
+	       stdout);
 
        /*
         * Save this line for the next round...
@@ -894,121 +940,22 @@ void
 PCLCompress(unsigned char *line,	/* I - Line to compress */
             unsigned      length)	/* I - Length of line */
 {
-  unsigned char	*line_ptr,		/* Current byte pointer */
-        	*line_end,		/* End-of-line byte pointer */
-        	*comp_ptr,		/* Pointer into compression buffer */
-        	*start,			/* Start of compression sequence */
-		*seed;			/* Seed buffer pointer */
-  unsigned	count,			/* Count of bytes for output */
-		offset;			/* Offset of bytes for output */
+  unsigned	bytes;			/* Number of compressed bytes */
 
 
  /*
   * Do delta-row compression...
   */
 
-  line_ptr = line;
-  line_end = line + length;
-
-  comp_ptr = CompBuffer;
-  seed     = LastBuffer;
-
-  while (line_ptr < line_end)
-  {
-   /*
-    * Find the next non-matching sequence...
-    */
-
-    start = line_ptr;
-
-    if (!LastSet)
-    {
-     /*
-      * The seed buffer is invalid, so do the next 8 bytes, max...
-      */
-
-      offset = 0;
-
-      if ((count = (unsigned)(line_end - line_ptr)) > 8)
-	count = 8;
-
-      line_ptr += count;
-    }
-    else
-    {
-     /*
-      * The seed buffer is valid, so compare against it...
-      */
-
-      while (*line_ptr == *seed &&
-             line_ptr < line_end)
-      {
-        line_ptr ++;
-        seed ++;
-      }
-
-      if (line_ptr == line_end)
-        break;
-
-      offset = (unsigned)(line_ptr - start);
-
-     /*
-      * Find up to 8 non-matching bytes...
-      */
-
-      start = line_ptr;
-      count = 0;
-      while (*line_ptr != *seed &&
-             line_ptr < line_end &&
-             count < 8)
-      {
-        line_ptr ++;
-        seed ++;
-        count ++;
-      }
-    }
-
-   /*
-    * Place mode 3 compression data in the buffer; see HP manuals
-    * for details...
-    */
-
-    if (offset >= 31)
-    {
-     /*
-      * Output multi-byte offset...
-      */
-
-      *comp_ptr++ = (unsigned char)(((count - 1) << 5) | 31);
-
-      offset -= 31;
-      while (offset >= 255)
-      {
-        *comp_ptr++ = 255;
-        offset    -= 255;
-      }
-
-      *comp_ptr++ = (unsigned char)offset;
-    }
-    else
-    {
-     /*
-      * Output single-byte offset...
-      */
-
-      *comp_ptr++ = (unsigned char)(((count - 1) << 5) | offset);
-    }
-
-    memcpy(comp_ptr, start, count);
-    comp_ptr += count;
-  }
+  bytes = PCLCompressDelta(line, LastSet ? LastBuffer : NULL, length,
+                           CompBuffer);
 
  /*
   * Set the length of the data and write it...
   */
 
-  printf("\033*b%dW", (int)(comp_ptr - CompBuffer));
-  fwrite(CompBuffer, (size_t)(comp_ptr - CompBuffer), 1, stdout);
+  printf("\033*b%uW", bytes);
+  fwrite(CompBuffer, bytes, 1, stdout);
 
  /*
   * Save this line as a "seed" buffer for the next...
@@ -1019,53 +966,6 @@ PCLCompress(unsigned char *line,	/* I - Line to compress */
 }
 
 
-/*
- * 'ZPLCompress()' - Output a run-length compression sequence.
- */
-
-void
-ZPLCompress(unsigned char repeat_char,	/* I - Character to repeat */
-	    unsigned      repeat_count)	/* I - Number of repeated characters */
-{
-  if (repeat_count > 1)
-  {
-   /*
-    * Print as many z's as possible - they are the largest denomination
-    * representing 400 characters (zC stands for 400 adjacent C's)
-    */
-
-    while (repeat_count >= 400)
-    {
-      putchar('z');
-      repeat_count -= 400;
-    }
-
-   /*
-    * Then print 'g' through 'y' as multiples of 20 characters...
-    */
-
-    if (repeat_count >= 20)
-    {
-      putchar((int)('f' + repeat_count / 20));
-      repeat_count %= 20;
-    }
-
-   /*
-    * Finally, print 'G' through 'Y' as 1 through 19 characters...
-    */
-
-    if (repeat_count > 0)
-      putchar((int)('F' + repeat_count));
-  }
-
- /*
-  * Then the character to be repeated...
-  */
-
-  putchar((int)repeat_char);
-}
-
-
 /*
  * 'main()' - Main entry and processing of driver.
  */
@@ -75,7 +75,7 @@ main(int  argc,				/* I - Number of command-line args */
     fd = 0;
 
   inras  = cupsRasterOpen(fd, CUPS_RASTER_READ);
-  outras = cupsRasterOpen(1, CUPS_RASTER_WRITE_PWG);
+  outras = cupsRasterOpen(1, CUPS_RASTER_WRITE_PWG_THREADED);
 
   ppd   = ppdOpenFile(getenv("PPD"));
   back  = ppdFindAttr(ppd, "cupsBackSide", NULL);
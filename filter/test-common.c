@@ -0,0 +1,136 @@
+/*
+ * "$Id$"
+ *
+ * Test data routines for the CUPS raster filter unit tests and benchmarks.
+ *
+ * Copyright 2007-2016 by Apple Inc.
+ *
+ * These coded instructions, statements, and computer programs are the
+ * property of Apple Inc. and are protected by Federal copyright
+ * law.  Distribution and use rights are outlined in the file "LICENSE.txt"
+ * which should have been included with this file.  If this file is
+ * file is missing or damaged, see the license at "http://www.cups.org/".
+ *
+ * This file is subject to the Apple OS-Developed Software exception.
+ */
+
+/*
+ * Include necessary headers...
+ */
+
+#include "test-common.h"
+#include <string.h>
+
+
+/*
+ * Local globals...
+ */
+
+static unsigned	test_seed = 1;		/* Random number state */
+
+
+/*
+ * '_cupsTestMakeLine()' - Make a line of test data.
+ */
+
+void
+_cupsTestMakeLine(
+    unsigned char     *line,		/* I - Line */
+    unsigned          length,		/* I - Length of line */
+    _cups_test_line_t kind)		/* I - Kind of line */
+{
+  unsigned	x,			/* Current byte */
+		count,			/* Bytes in current run */
+		maxrun;			/* Maximum long run */
+  unsigned char	byte;			/* Byte to repeat */
+
+
+  maxrun = length / 4 + 4;
+
+  switch (kind)
+  {
+    case _CUPS_TEST_LINE_BLANK :
+        memset(line, 0, length);
+	break;
+
+    case _CUPS_TEST_LINE_TEXT :
+        memset(line, 0, length);
+
+        for (x = _cupsTestRand() % 16; x < length;
+	     x += 1 + _cupsTestRand() % 12)
+	  for (count = 1 + _cupsTestRand() % 3; count > 0 && x < length;
+	       count --, x ++)
+	    line[x] = (unsigned char)_cupsTestRand();
+	break;
+
+    case _CUPS_TEST_LINE_RANDOM :
+        for (x = 0; x < length; x ++)
+	  line[x] = (unsigned char)_cupsTestRand();
+	break;
+
+    case _CUPS_TEST_LINE_RUNS :
+    case _CUPS_TEST_LINE_SOLID :
+        for (x = 0; x < length; x += count)
+	{
+	  if (kind == _CUPS_TEST_LINE_RUNS)
+	    byte = (unsigned char)(_cupsTestRand() & 3);
+	  else
+	    byte = (_cupsTestRand() & 1) ? 0xff : 0x00;
+
+	  count = 1 + _cupsTestRand() % ((_cupsTestRand() & 1) ? 4 : maxrun);
+
+	  if (count > (length - x))
+	    count = length - x;
+
+	  memset(line + x, byte, count);
+	}
+	break;
+
+    case _CUPS_TEST_LINE_FEW :
+        for (x = 0; x < length; x ++)
+	  line[x] = (unsigned char)(_cupsTestRand() & 1);
+	break;
+
+    case _CUPS_TEST_LINE_SPARSE :
+        for (x = 0; x < length; x ++)
+	  line[x] = (unsigned char)(_cupsTestRand() & _cupsTestRand() &
+	                            _cupsTestRand());
+	break;
+
+    case _CUPS_TEST_LINE_WORDS :
+        for (x = 0; x < length; x ++)
+	  line[x] = (unsigned char)((x % 12) < 8 ?
+	                                0x11 * (_cupsTestRand() & 15) : 0);
+	break;
+  }
+}
+
+
+/*
+ * '_cupsTestRand()' - Return a reproducible pseudo-random number from 0 to
+ *                     32767.
+ */
+
+unsigned				/* O - Random number */
+_cupsTestRand(void)
+{
+  test_seed = test_seed * 1103515245 + 12345;
+
+  return ((test_seed >> 16) & 32767);
+}
+
+
+/*
+ * '_cupsTestSeed()' - Reset the pseudo-random number sequence.
+ */
+
+void
+_cupsTestSeed(unsigned seed)		/* I - Seed value */
+{
+  test_seed = seed;
+}
+
+
+/*
+ * End of "$Id$".
+ */
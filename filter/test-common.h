@@ -0,0 +1,65 @@
+/*
+ * "$Id$"
+ *
+ * Test data definitions for the CUPS raster filter unit tests and
+ * benchmarks.
+ *
+ * Copyright 2007-2016 by Apple Inc.
+ *
+ * These coded instructions, statements, and computer programs are the
+ * property of Apple Inc. and are protected by Federal copyright
+ * law.  Distribution and use rights are outlined in the file "LICENSE.txt"
+ * which should have been included with this file.  If this file is
+ * file is missing or damaged, see the license at "http://www.cups.org/".
+ *
+ * This file is subject to the Apple OS-Developed Software exception.
+ */
+
+/*
+ * C++ magic...
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+
+/*
+ * Types...
+ */
+
+typedef enum _cups_test_line_e		/**** Kinds of test lines ****/
+{
+  _CUPS_TEST_LINE_BLANK,		/* All zeros */
+  _CUPS_TEST_LINE_TEXT,			/* Small clusters of random bytes */
+  _CUPS_TEST_LINE_RANDOM,		/* Random bytes */
+  _CUPS_TEST_LINE_RUNS,			/* Runs of the values 0 to 3 */
+  _CUPS_TEST_LINE_SOLID,		/* Runs of 0x00 and 0xff */
+  _CUPS_TEST_LINE_FEW,			/* Random 0's and 1's */
+  _CUPS_TEST_LINE_SPARSE,		/* Sparse dots */
+  _CUPS_TEST_LINE_WORDS			/* Words of repeated hex digits */
+} _cups_test_line_t;
+
+
+/*
+ * Prototypes...
+ */
+
+extern void	_cupsTestMakeLine(unsigned char *line, unsigned length,
+		                  _cups_test_line_t kind);
+extern unsigned	_cupsTestRand(void);
+extern void	_cupsTestSeed(unsigned seed);
+
+
+/*
+ * C++ magic...
+ */
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+
+/*
+ * End of "$Id$".
+ */
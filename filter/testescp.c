@@ -0,0 +1,275 @@
+/*
+ * "$Id$"
+ *
+ * ESC/P raster test program for CUPS.
+ *
+ * Copyright 2007-2016 by Apple Inc.
+ *
+ * These coded instructions, statements, and computer programs are the
+ * property of Apple Inc. and are protected by Federal copyright
+ * law.  Distribution and use rights are outlined in the file "LICENSE.txt"
+ * which should have been included with this file.  If this file is
+ * file is missing or damaged, see the license at "http://www.cups.org/".
+ *
+ * This file is subject to the Apple OS-Developed Software exception.
+ *
+ * Usage:
+ *
+ *   ./testescp
+ *
+ * Checks the depletion and band transposition routines against known
+ * output, and against the original bit-at-a-time versions from
+ * rastertoepson for random lines of all lengths and alignments.
+ */
+
+/*
+ * Include necessary headers...
+ */
+
+#include <cups/string-private.h>
+#include "escp-common.h"
+#include "test-common.h"
+
+
+/*
+ * Constants...
+ */
+
+#define TEST_LENGTH	2048		/* Maximum test line length */
+#define TEST_RUNS	20000		/* Number of random lines per test */
+
+
+/*
+ * Local functions...
+ */
+
+static void	ref_deplete(unsigned char *line, unsigned length);
+static void	ref_line(const unsigned char *line, unsigned width,
+		         unsigned char dotbit, unsigned char *cols);
+
+
+/*
+ * Local globals...
+ */
+
+static const _cups_test_line_t escp_kinds[5] =
+{					/* Kinds of test lines */
+  _CUPS_TEST_LINE_BLANK,
+  _CUPS_TEST_LINE_TEXT,
+  _CUPS_TEST_LINE_RANDOM,
+  _CUPS_TEST_LINE_SOLID,
+  _CUPS_TEST_LINE_SPARSE
+};
+
+
+/*
+ * 'main()' - Test the ESC/P raster routines.
+ */
+
+int					/* O - Exit status */
+main(void)
+{
+  int		errors = 0;		/* Number of errors */
+  unsigned	run,			/* Current run */
+		length,			/* Line length */
+		width,			/* Band width in columns */
+		bytes,			/* Bytes per band line */
+		offset,			/* Alignment offset */
+		kind,			/* Kind of line */
+		y;			/* Current band line */
+  unsigned char	line[TEST_LENGTH + 16],	/* Line */
+		ref[TEST_LENGTH + 16],	/* Reference line */
+		band[8 * TEST_LENGTH + 16],
+					/* Band of lines */
+		cols[8 * TEST_LENGTH + 16],
+					/* Dot columns */
+		ref_cols[8 * TEST_LENGTH + 16];
+					/* Reference dot columns */
+  static const unsigned char deplete_line[] = { 0xff, 0xff, 0x01, 0x80, 0x7e },
+					/* Known depletion input */
+		deplete_out[] = { 0xaa, 0xaa, 0x01, 0x00, 0x54 },
+					/* Known depletion output */
+		band_in[] = { 0xff, 0, 0, 0, 0, 0, 0, 0x01 },
+					/* Known band input */
+		band_out[] = { 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x81 };
+					/* Known band output */
+
+
+ /*
+  * Check known output...
+  */
+
+  fputs("ESCPDeplete (known output): ", stdout);
+
+  memcpy(line, deplete_line, sizeof(deplete_line));
+  ESCPDeplete(line, sizeof(deplete_line));
+
+  if (memcmp(line, deplete_out, sizeof(deplete_out)))
+  {
+    puts("FAIL");
+    errors ++;
+  }
+  else
+    puts("PASS");
+
+  fputs("ESCPTransposeBand (known output): ", stdout);
+
+  ESCPTransposeBand(band_in, 1, 8, cols);
+
+  if (memcmp(cols, band_out, sizeof(band_out)))
+  {
+    puts("FAIL");
+    errors ++;
+  }
+  else
+    puts("PASS");
+
+ /*
+  * Compare against the original code with random lines of all lengths and
+  * alignments...
+  */
+
+  fputs("ESCPDeplete: ", stdout);
+  fflush(stdout);
+
+  for (run = 0; run < TEST_RUNS; run ++)
+  {
+    length = 1 + _cupsTestRand() % (run < 1000 ? 48 : TEST_LENGTH);
+    offset = _cupsTestRand() & 15;
+    kind   = _cupsTestRand() % 5;
+
+    _cupsTestMakeLine(line + offset, length, escp_kinds[kind]);
+    memcpy(ref, line + offset, length);
+
+    ESCPDeplete(line + offset, length);
+    ref_deplete(ref, length);
+
+    if (memcmp(line + offset, ref, length))
+    {
+      printf("FAIL (run %u, length %u, kind %u)\n", run, length, kind);
+      errors ++;
+      break;
+    }
+  }
+
+  if (run == TEST_RUNS)
+    puts("PASS");
+
+  fputs("ESCPTransposeBand: ", stdout);
+  fflush(stdout);
+
+  for (run = 0; run < TEST_RUNS; run ++)
+  {
+    width  = 1 + _cupsTestRand() % (run < 1000 ? 400 : 8 * TEST_LENGTH);
+    bytes  = (width + 7) / 8 + _cupsTestRand() % 4;
+    offset = _cupsTestRand() & 15;
+
+    if (bytes > TEST_LENGTH)
+      bytes = TEST_LENGTH;
+
+    for (y = 0, kind = _cupsTestRand() % 5; y < 8; y ++)
+      _cupsTestMakeLine(band + offset + y * bytes, bytes,
+                        (y & 1) ? escp_kinds[kind] : _CUPS_TEST_LINE_TEXT);
+
+    memset(cols, 0xaa, sizeof(cols));
+    memset(ref_cols, 0xaa, sizeof(ref_cols));
+    memset(ref_cols, 0, width);
+
+    ESCPTransposeBand(band + offset, bytes, width, cols);
+
+    for (y = 0; y < 8; y ++)
+      ref_line(band + offset + y * bytes, width, (unsigned char)(128 >> y),
+               ref_cols);
+
+    if (memcmp(cols, ref_cols, sizeof(cols)))
+    {
+      printf("FAIL (run %u, width %u, kind %u)\n", run, width, kind);
+      errors ++;
+      break;
+    }
+  }
+
+  if (run == TEST_RUNS)
+    puts("PASS");
+
+  return (errors > 0);
+}
+
+
+/*
+ * 'ref_deplete()' - Depletion from the original rastertoepson code.
+ */
+
+static void
+ref_deplete(unsigned char *line,	/* I - Line to deplete */
+            unsigned      length)	/* I - Number of bytes */
+{
+  unsigned char	*comp_ptr,		/* Current byte pointer */
+		*line_end,		/* End-of-line byte pointer */
+		temp;			/* Current byte */
+
+
+  for (comp_ptr = line, line_end = line + length; comp_ptr < line_end;)
+  {
+    temp = *comp_ptr;
+
+    if ((temp & 0xc0) == 0xc0)
+      temp &= 0xbf;
+    if ((temp & 0x60) == 0x60)
+      temp &= 0xdf;
+    if ((temp & 0x30) == 0x30)
+      temp &= 0xef;
+    if ((temp & 0x18) == 0x18)
+      temp &= 0xf7;
+    if ((temp & 0x0c) == 0x0c)
+      temp &= 0xfb;
+    if ((temp & 0x06) == 0x06)
+      temp &= 0xfd;
+    if ((temp & 0x03) == 0x03)
+      temp &= 0xfe;
+
+    *comp_ptr++ = temp;
+
+    if ((temp & 0x01) && comp_ptr < line_end && *comp_ptr & 0x80)
+      *comp_ptr &= 0x7f;
+  }
+}
+
+
+/*
+ * 'ref_line()' - Add a line of dots from the original rastertoepson code.
+ */
+
+static void
+ref_line(const unsigned char *line,	/* I - Line of pixels */
+         unsigned            width,	/* I - Number of columns */
+	 unsigned char       dotbit,	/* I - Bit for this line */
+	 unsigned char       *cols)	/* IO - Dot columns */
+{
+  unsigned		x;		/* Current column */
+  unsigned char		bit;		/* Current pixel bit */
+  const unsigned char	*pixel;		/* Current pixel byte */
+  unsigned char		*temp;		/* Current dot column */
+
+
+  for (x = width, bit = 128, pixel = line, temp = cols;
+       x > 0;
+       x --, temp ++)
+  {
+    if (*pixel & bit)
+      *temp |= dotbit;
+
+    if (bit > 1)
+      bit >>= 1;
+    else
+    {
+      bit = 128;
+      pixel ++;
+    }
+  }
+}
+
+
+/*
+ * End of "$Id$".
+ */
@@ -0,0 +1,435 @@
+/*
+ * "$Id$"
+ *
+ * PCL compression test program for CUPS.
+ *
+ * Copyright 2007-2016 by Apple Inc.
+ *
+ * These coded instructions, statements, and computer programs are the
+ * property of Apple Inc. and are protected by Federal copyright
+ * law.  Distribution and use rights are outlined in the file "LICENSE.txt"
+ * which should have been included with this file.  If this file is
+ * file is missing or damaged, see the license at "http://www.cups.org/".
+ *
+ * This file is subject to the Apple OS-Developed Software exception.
+ *
+ * Usage:
+ *
+ *   ./testpcl
+ *
+ * Checks the compression and plane separation routines against the output
+ * of the original rastertohp and rastertolabel code for known lines, and
+ * decodes the output for random lines of all lengths and alignments.
+ */
+
+/*
+ * Include necessary headers...
+ */
+
+#include <cups/string-private.h>
+#include "pcl-common.h"
+#include "test-common.h"
+
+
+/*
+ * Constants...
+ */
+
+#define TEST_LENGTH	2048		/* Maximum test line length */
+#define TEST_RUNS	20000		/* Number of random lines per test */
+
+
+/*
+ * Local functions...
+ */
+
+static unsigned	decode_delta(const unsigned char *comp, unsigned comp_length,
+		             unsigned char *line, unsigned length);
+static unsigned	decode_tiff(const unsigned char *comp, unsigned comp_length,
+		            unsigned char *line, unsigned length);
+static int	test_known(const char *name, const unsigned char *comp,
+		           unsigned comp_length, const unsigned char *expected,
+			   unsigned expected_length);
+static void	test_line(unsigned char *line, unsigned *length,
+		          unsigned *kind, unsigned run);
+
+
+/*
+ * Local globals...
+ */
+
+static const _cups_test_line_t pcl_kinds[5] =
+{					/* Kinds of test lines */
+  _CUPS_TEST_LINE_BLANK,
+  _CUPS_TEST_LINE_TEXT,
+  _CUPS_TEST_LINE_RANDOM,
+  _CUPS_TEST_LINE_RUNS,
+  _CUPS_TEST_LINE_FEW
+};
+
+
+/*
+ * 'main()' - Test the PCL compression routines.
+ */
+
+int					/* O - Exit status */
+main(void)
+{
+  int		errors = 0;		/* Number of errors */
+  unsigned	i,			/* Looping var */
+		run,			/* Current run */
+		length,			/* Line length */
+		kind,			/* Kind of line */
+		comp_length,		/* Compressed length */
+		bit;			/* Current pixel bit */
+  unsigned char	*line,			/* Line */
+		seed[TEST_LENGTH + 16],	/* Seed row */
+		buffer[TEST_LENGTH + 16],
+					/* Line buffer */
+		decoded[TEST_LENGTH],	/* Decoded line */
+		comp[TEST_LENGTH * 2 + 16],
+					/* Compressed line */
+		bits[2][TEST_LENGTH / 2 + 16];
+					/* Separated bits */
+  static const unsigned char tiff_comp[] =
+  {					/* "AAAAABCDEE" in mode 2 */
+    0xfc, 'A', 0x02, 'B', 'C', 'D', 0xff, 'E'
+  },
+		tiff_ab[] =		/* "AB" in mode 2 */
+  {
+    0x00, 'A', 0x00, 'B'
+  },
+		tiff_run[] =		/* 130 "A"s in mode 2 */
+  {
+    0x82, 'A', 0xfe, 'A'
+  },
+		delta_comp[] =		/* "AAXAAAAAYZ" from "AAAAAAAAAA" */
+  {
+    0x02, 'X', 0x25, 'Y', 'Z'
+  },
+		delta_offset[] =	/* Changes at 40 and 299 in 300 bytes */
+  {
+    0x1f, 0x09, 0x01, 0x1f, 0xe3, 0x02
+  },
+		delta_noseed[] =	/* "ABCDEFGHIJ" without a seed row */
+  {
+    0xe0, 'A', 'B', 'C', 'D', 'E', 'F', 'G', 'H', 0x20, 'I', 'J'
+  },
+		sep_line[] =		/* 2-bit pixels 0-3, 3-0, 3 */
+  {
+    0x1b, 0xe4, 0xc0
+  },
+		sep_bits[] =		/* Separated low and high bits */
+  {
+    0x5a, 0x80, 0x3c, 0x80
+  };
+
+
+ /*
+  * Check known output...
+  */
+
+  memset(buffer, 'A', 130);
+
+  errors += test_known("PCLCompressTIFF(\"AAAAABCDEE\")", comp,
+                       PCLCompressTIFF((const unsigned char *)"AAAAABCDEE",
+		                       10, comp),
+		       tiff_comp, sizeof(tiff_comp));
+  errors += test_known("PCLCompressTIFF(\"AB\")", comp,
+                       PCLCompressTIFF((const unsigned char *)"AB", 2, comp),
+		       tiff_ab, sizeof(tiff_ab));
+  errors += test_known("PCLCompressTIFF(130 bytes)", comp,
+                       PCLCompressTIFF(buffer, 130, comp),
+		       tiff_run, sizeof(tiff_run));
+  errors += test_known("PCLCompressDelta(\"AAXAAAAAYZ\")", comp,
+                       PCLCompressDelta((const unsigned char *)"AAXAAAAAYZ",
+		                        (const unsigned char *)"AAAAAAAAAA",
+					10, comp),
+		       delta_comp, sizeof(delta_comp));
+
+  memset(seed, 0, 300);
+  memset(buffer, 0, 300);
+  buffer[40]  = 1;
+  buffer[299] = 2;
+
+  errors += test_known("PCLCompressDelta(300 bytes)", comp,
+                       PCLCompressDelta(buffer, seed, 300, comp),
+		       delta_offset, sizeof(delta_offset));
+  errors += test_known("PCLCompressDelta(no seed)", comp,
+                       PCLCompressDelta((const unsigned char *)"ABCDEFGHIJ",
+		                        NULL, 10, comp),
+		       delta_noseed, sizeof(delta_noseed));
+
+  PCLSeparateBits(sep_line, 3, comp, comp + 2);
+
+  errors += test_known("PCLSeparateBits(3 bytes)", comp, 4, sep_bits,
+                       sizeof(sep_bits));
+
+ /*
+  * Decode random lines of all lengths and alignments...
+  */
+
+  fputs("PCLCompressTIFF: ", stdout);
+  fflush(stdout);
+
+  for (run = 0; run < TEST_RUNS; run ++)
+  {
+    line = buffer + (_cupsTestRand() & 15);
+
+    test_line(line, &length, &kind, run);
+
+    comp_length = PCLCompressTIFF(line, length, comp);
+
+    if (decode_tiff(comp, comp_length, decoded, length) != length ||
+        memcmp(decoded, line, length))
+    {
+      printf("FAIL (run %u, length %u, kind %u)\n", run, length, kind);
+      errors ++;
+      break;
+    }
+  }
+
+  if (run == TEST_RUNS)
+    puts("PASS");
+
+  fputs("PCLCompressDelta: ", stdout);
+  fflush(stdout);
+
+  for (run = 0; run < TEST_RUNS; run ++)
+  {
+    line = buffer + (_cupsTestRand() & 15);
+
+    test_line(seed, &length, &kind, run);
+    memcpy(line, seed, length);
+
+   /*
+    * Change a few bytes or runs of bytes from the seed row...
+    */
+
+    for (i = _cupsTestRand() % 8; i > 0; i --)
+    {
+      unsigned start = _cupsTestRand() % length,
+	       count = 1 + _cupsTestRand() % (i == 1 ? 600 : 12);
+
+      for (; count > 0 && start < length; count --, start ++)
+        line[start] = (unsigned char)_cupsTestRand();
+    }
+
+    comp_length = PCLCompressDelta(line, seed, length, comp);
+    memcpy(decoded, seed, length);
+
+    if (decode_delta(comp, comp_length, decoded, length) != length ||
+        memcmp(decoded, line, length))
+    {
+      printf("FAIL (run %u, length %u, kind %u)\n", run, length, kind);
+      errors ++;
+      break;
+    }
+
+   /*
+    * Without a seed row every byte is replaced...
+    */
+
+    comp_length = PCLCompressDelta(line, NULL, length, comp);
+    memset(decoded, 0xaa, length);
+
+    if (decode_delta(comp, comp_length, decoded, length) != length ||
+        memcmp(decoded, line, length))
+    {
+      printf("FAIL (run %u, length %u, kind %u, no seed)\n", run, length,
+             kind);
+      errors ++;
+      break;
+    }
+  }
+
+  if (run == TEST_RUNS)
+    puts("PASS");
+
+  fputs("PCLSeparateBits: ", stdout);
+  fflush(stdout);
+
+  for (run = 0; run < TEST_RUNS; run ++)
+  {
+    line = buffer + (_cupsTestRand() & 15);
+
+    test_line(line, &length, &kind, run);
+
+    memset(bits, 0xaa, sizeof(bits));
+
+    PCLSeparateBits(line, length, bits[0], bits[1]);
+
+   /*
+    * Each 2-bit pixel becomes one bit in each plane, and nothing is written
+    * past the (length + 1) / 2 bytes of each plane...
+    */
+
+    for (bit = 0; bit < 4 * length; bit ++)
+    {
+      unsigned pixel = (line[bit / 4] >> (6 - 2 * (bit & 3))) & 3,
+	       mask  = 128 >> (bit & 7);
+
+      if (((bits[0][bit / 8] & mask) != 0) != (pixel & 1) ||
+          ((bits[1][bit / 8] & mask) != 0) != (pixel >> 1))
+        break;
+    }
+
+    if (bit < 4 * length || ((length & 1) && (bits[0][length / 2] & 15)) ||
+        bits[0][(length + 1) / 2] != 0xaa || bits[1][(length + 1) / 2] != 0xaa)
+    {
+      printf("FAIL (run %u, length %u, kind %u)\n", run, length, kind);
+      errors ++;
+      break;
+    }
+  }
+
+  if (run == TEST_RUNS)
+    puts("PASS");
+
+  return (errors > 0);
+}
+
+
+/*
+ * 'decode_delta()' - Decode a delta row (mode 3) compressed line.
+ */
+
+static unsigned				/* O - Number of bytes decoded */
+decode_delta(
+    const unsigned char *comp,		/* I - Compressed data */
+    unsigned            comp_length,	/* I - Length of compressed data */
+    unsigned char       *line,		/* IO - Seed row/decoded line */
+    unsigned            length)		/* I - Length of line */
+{
+  const unsigned char	*comp_end = comp + comp_length;
+					/* End of compressed data */
+  unsigned		pos = 0,	/* Position in line */
+			count,		/* Number of bytes to replace */
+			offset;		/* Offset to replacement bytes */
+
+
+  while (comp < comp_end)
+  {
+    count  = (unsigned)(*comp >> 5) + 1;
+    offset = *comp++ & 31;
+
+    if (offset == 31)
+    {
+      do
+      {
+        if (comp >= comp_end)
+	  return (0);
+
+        offset += *comp;
+      }
+      while (*comp++ == 255);
+    }
+
+    pos += offset;
+
+    if ((pos + count) > length || (comp + count) > comp_end)
+      return (0);
+
+    memcpy(line + pos, comp, count);
+
+    comp += count;
+    pos  += count;
+  }
+
+  return (length);
+}
+
+
+/*
+ * 'decode_tiff()' - Decode a TIFF PackBits (mode 2) compressed line.
+ */
+
+static unsigned				/* O - Number of bytes decoded */
+decode_tiff(
+    const unsigned char *comp,		/* I - Compressed data */
+    unsigned            comp_length,	/* I - Length of compressed data */
+    unsigned char       *line,		/* O - Decoded line */
+    unsigned            length)		/* I - Length of line */
+{
+  const unsigned char	*comp_end = comp + comp_length;
+					/* End of compressed data */
+  unsigned		pos = 0,	/* Position in line */
+			count;		/* Number of bytes */
+
+
+  while (comp < comp_end)
+  {
+    if (*comp & 128)
+    {
+      count = 257 - *comp++;
+
+      if ((pos + count) > length || comp >= comp_end)
+        return (0);
+
+      memset(line + pos, *comp++, count);
+    }
+    else
+    {
+      count = *comp++ + 1u;
+
+      if ((pos + count) > length || (comp + count) > comp_end)
+        return (0);
+
+      memcpy(line + pos, comp, count);
+      comp += count;
+    }
+
+    pos += count;
+  }
+
+  return (pos);
+}
+
+
+/*
+ * 'test_known()' - Compare output with the known output.
+ */
+
+static int				/* O - 1 on failure, 0 on success */
+test_known(
+    const char          *name,		/* I - Name of test */
+    const unsigned char *comp,		/* I - Output */
+    unsigned            comp_length,	/* I - Length of output */
+    const unsigned char *expected,	/* I - Expected output */
+    unsigned            expected_length)/* I - Length of expected output */
+{
+  printf("%s: ", name);
+
+  if (comp_length != expected_length || memcmp(comp, expected, comp_length))
+  {
+    puts("FAIL");
+    return (1);
+  }
+
+  puts("PASS");
+  return (0);
+}
+
+
+/*
+ * 'test_line()' - Make a random test line.
+ *
+ * The first 1000 runs use short lines to cover the scalar code paths.
+ */
+
+static void
+test_line(unsigned char *line,		/* I - Line buffer */
+          unsigned      *length,	/* O - Length of line */
+	  unsigned      *kind,		/* O - Kind of line */
+	  unsigned      run)		/* I - Current run */
+{
+  *length = 1 + _cupsTestRand() % (run < 1000 ? 48 : TEST_LENGTH);
+  *kind   = _cupsTestRand() % 5;
+
+  _cupsTestMakeLine(line, *length, pcl_kinds[*kind]);
+}
+
+
+/*
+ * End of "$Id$".
+ */
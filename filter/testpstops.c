@@ -0,0 +1,247 @@
+/*
+ * "$Id$"
+ *
+ * PostScript filter page ordering test program for CUPS.
+ *
+ * Copyright 2007-2016 by Apple Inc.
+ *
+ * These coded instructions, statements, and computer programs are the
+ * property of Apple Inc. and are protected by Federal copyright
+ * law.  Distribution and use rights are outlined in the file "LICENSE.txt"
+ * which should have been included with this file.  If this file is
+ * file is missing or damaged, see the license at "http://www.cups.org/".
+ *
+ * This file is subject to the Apple OS-Developed Software exception.
+ *
+ * Usage:
+ *
+ *   ./testpstops
+ *
+ * Runs ./pstops with reverse order and collated copies on the same document
+ * read from a regular file, a gzip-compressed file, and a pipe, and checks
+ * that the output is the same.  Regular files are copied by offset while
+ * compressed files and pipes are copied through a temporary file.
+ */
+
+/*
+ * Include necessary headers...
+ */
+
+#include <cups/string-private.h>
+#include <cups/file.h>
+#include <unistd.h>
+
+
+/*
+ * Local functions...
+ */
+
+static int	compare_files(const char *name1, const char *name2);
+static int	make_document(const char *filename, const char *mode,
+		              int pages);
+static int	run_pstops(const char *input, const char *copies,
+		           const char *options, const char *output);
+
+
+/*
+ * 'main()' - Test the pstops page ordering code.
+ */
+
+int					/* O - Exit status */
+main(void)
+{
+  int		i, j,			/* Looping vars */
+		errors = 0;		/* Number of errors */
+  char		plain[256],		/* Plain document */
+		gzfile[1024],		/* Compressed document */
+		pipecmd[1024],		/* Pipe input */
+		plainout[1024],		/* Output for plain document */
+		gzout[1024],		/* Output for compressed document */
+		pipeout[1024];		/* Output for pipe */
+  static const int pages[] =		/* Document sizes */
+  {
+    3,					/* Decompresses on the first read */
+    200					/* Needs several reads */
+  };
+  static const char * const tests[][2] =/* Copies and options */
+  {
+    { "1", "outputorder=reverse" },
+    { "2", "Collate=True" },
+    { "2", "Collate=True outputorder=reverse" }
+  };
+
+
+  unsetenv("PPD");
+
+  snprintf(plain, sizeof(plain), "testpstops-%d.ps", (int)getpid());
+  snprintf(gzfile, sizeof(gzfile), "%s.gz", plain);
+  snprintf(pipecmd, sizeof(pipecmd), "<%s", plain);
+  snprintf(plainout, sizeof(plainout), "%s.out1", plain);
+  snprintf(gzout, sizeof(gzout), "%s.out2", plain);
+  snprintf(pipeout, sizeof(pipeout), "%s.out3", plain);
+
+  for (i = 0; i < (int)(sizeof(pages) / sizeof(pages[0])); i ++)
+  {
+    if (make_document(plain, "w", pages[i]) ||
+        make_document(gzfile, "w9", pages[i]))
+    {
+      errors ++;
+      break;
+    }
+
+    for (j = 0; j < (int)(sizeof(tests) / sizeof(tests[0])); j ++)
+    {
+      printf("pstops %d pages, copies=%s %s: ", pages[i], tests[j][0],
+             tests[j][1]);
+
+      if (run_pstops(plain, tests[j][0], tests[j][1], plainout) ||
+          run_pstops(gzfile, tests[j][0], tests[j][1], gzout) ||
+          run_pstops(pipecmd, tests[j][0], tests[j][1], pipeout))
+      {
+        puts("FAIL (unable to run pstops)");
+        errors ++;
+      }
+      else if (compare_files(plainout, pipeout))
+      {
+        puts("FAIL (file and pipe output differ)");
+        errors ++;
+      }
+      else if (compare_files(gzout, pipeout))
+      {
+        puts("FAIL (gzip and pipe output differ)");
+        errors ++;
+      }
+      else
+        puts("PASS");
+    }
+  }
+
+  unlink(plain);
+  unlink(gzfile);
+  unlink(plainout);
+  unlink(gzout);
+  unlink(pipeout);
+
+  return (errors != 0);
+}
+
+
+/*
+ * 'compare_files()' - Compare two files.
+ */
+
+static int				/* O - 0 if the same, 1 otherwise */
+compare_files(const char *name1,	/* I - First file */
+              const char *name2)	/* I - Second file */
+{
+  FILE		*fp1,			/* First file */
+		*fp2;			/* Second file */
+  int		ch;			/* Character from first file */
+  int		status = 0;		/* Comparison status */
+
+
+  if ((fp1 = fopen(name1, "rb")) == NULL)
+    return (1);
+
+  if ((fp2 = fopen(name2, "rb")) == NULL)
+  {
+    fclose(fp1);
+    return (1);
+  }
+
+  do
+  {
+    ch = getc(fp1);
+
+    if (ch != getc(fp2))
+    {
+      status = 1;
+      break;
+    }
+  }
+  while (ch != EOF);
+
+  fclose(fp1);
+  fclose(fp2);
+
+  return (status);
+}
+
+
+/*
+ * 'make_document()' - Write a DSC-conforming test document.
+ */
+
+static int				/* O - 0 on success, -1 on error */
+make_document(const char *filename,	/* I - File to create */
+              const char *mode,		/* I - Open mode */
+              int        pages)		/* I - Number of pages */
+{
+  cups_file_t	*fp;			/* Document file */
+  int		page,			/* Current page */
+		i;			/* Looping var */
+
+
+  if ((fp = cupsFileOpen(filename, mode)) == NULL)
+  {
+    perror(filename);
+    return (-1);
+  }
+
+  cupsFilePrintf(fp, "%%!PS-Adobe-3.0\n"
+                     "%%%%Pages: %d\n"
+		     "%%%%BoundingBox: 0 0 612 792\n"
+		     "%%%%EndComments\n"
+		     "%%%%BeginProlog\n"
+		     "/Helvetica findfont 12 scalefont setfont\n"
+		     "%%%%EndProlog\n", pages);
+
+  for (page = 1; page <= pages; page ++)
+  {
+    cupsFilePrintf(fp, "%%%%Page: %d %d\n", page, page);
+
+    for (i = 0; i < 10; i ++)
+      cupsFilePrintf(fp, "72 %d moveto (Page %d, line %d) show\n",
+                     720 - 12 * i, page, i);
+
+    cupsFilePuts(fp, "showpage\n");
+  }
+
+  cupsFilePuts(fp, "%%Trailer\n"
+                   "%%EOF\n");
+
+  return (cupsFileClose(fp));
+}
+
+
+/*
+ * 'run_pstops()' - Run the pstops filter.
+ *
+ * Input names starting with "<" are sent to the filter on a pipe.
+ */
+
+static int				/* O - 0 on success, -1 on error */
+run_pstops(const char *input,		/* I - Input file */
+           const char *copies,		/* I - Number of copies */
+           const char *options,		/* I - Options */
+           const char *output)		/* I - Output file */
+{
+  char	command[2048];			/* Command to run */
+
+
+  if (*input == '<')
+    snprintf(command, sizeof(command),
+             "cat %s | ./pstops 1 user title %s \"%s\" >%s 2>/dev/null",
+	     input + 1, copies, options, output);
+  else
+    snprintf(command, sizeof(command),
+             "./pstops 1 user title %s \"%s\" %s >%s 2>/dev/null", copies,
+	     options, input, output);
+
+  return (system(command) ? -1 : 0);
+}
+
+
+/*
+ * End of "$Id$".
+ */
@@ -182,6 +182,8 @@ static cups_page_header2_t setpagedevice_header =
  * Local functions...
  */
 
+static int	do_byte_order_tests(cups_mode_t mode);
+static int	do_chunk_tests(cups_mode_t mode);
 static int	do_ppd_tests(const char *filename, int num_options,
 		             cups_option_t *options);
 static int	do_ps_tests(void);
@@ -209,6 +211,17 @@ main(int  argc,				/* I - Number of command-line args */
     errors += do_raster_tests(CUPS_RASTER_WRITE);
     errors += do_raster_tests(CUPS_RASTER_WRITE_COMPRESSED);
     errors += do_raster_tests(CUPS_RASTER_WRITE_PWG);
+    errors += do_raster_tests(CUPS_RASTER_WRITE_COMPRESSED_THREADED);
+    errors += do_raster_tests(CUPS_RASTER_WRITE_PWG_THREADED);
+    errors += do_byte_order_tests(CUPS_RASTER_WRITE);
+    errors += do_byte_order_tests(CUPS_RASTER_WRITE_COMPRESSED);
+    errors += do_byte_order_tests(CUPS_RASTER_WRITE_PWG);
+    errors += do_byte_order_tests(CUPS_RASTER_WRITE_COMPRESSED_THREADED);
+    errors += do_byte_order_tests(CUPS_RASTER_WRITE_PWG_THREADED);
+    errors += do_chunk_tests(CUPS_RASTER_WRITE_COMPRESSED);
+    errors += do_chunk_tests(CUPS_RASTER_WRITE_PWG);
+    errors += do_chunk_tests(CUPS_RASTER_WRITE_COMPRESSED_THREADED);
+    errors += do_chunk_tests(CUPS_RASTER_WRITE_PWG_THREADED);
   }
   else
   {
@@ -267,6 +280,262 @@ main(int  argc,				/* I - Number of command-line args */
 }
 
 
+/*
+ * 'do_byte_order_tests()' - Test the byte order of 16-bit raster data.
+ *
+ * CUPS raster streams hold 16-bit samples in the byte order of the host
+ * that wrote them, as they always have.  PWG raster streams are always
+ * big-endian, so the samples 0x0102 and 0x0304 must be stored as the bytes
+ * 01 02 03 04 on every host and read back as the same values.
+ */
+
+static int				/* O - Number of errors */
+do_byte_order_tests(cups_mode_t mode)	/* I - Write mode */
+{
+  FILE			*fp;		/* Raster file */
+  cups_raster_t		*r;		/* Raster stream */
+  cups_page_header2_t	header;		/* Page header */
+  long			length;		/* Length of file */
+  int			pwg;		/* PWG raster stream? */
+  unsigned short	pixels[2],	/* Pixels to write */
+			data[2];	/* Pixels read back */
+  unsigned char		bytes[4];	/* Pixel bytes in file */
+  static const unsigned char be_bytes[4] = { 0x01, 0x02, 0x03, 0x04 },
+					/* Big-endian pixel bytes */
+		patch_bytes[4] = { 0x0a, 0x0b, 0x0c, 0x0d };
+					/* Big-endian bytes to read */
+
+
+  printf("cupsRasterWritePixels(%s, 16-bit byte order): ",
+         mode == CUPS_RASTER_WRITE ? "CUPS_RASTER_WRITE" :
+	     mode == CUPS_RASTER_WRITE_COMPRESSED ?
+	         "CUPS_RASTER_WRITE_COMPRESSED" :
+	     mode == CUPS_RASTER_WRITE_PWG ? "CUPS_RASTER_WRITE_PWG" :
+	     mode == CUPS_RASTER_WRITE_COMPRESSED_THREADED ?
+	         "CUPS_RASTER_WRITE_COMPRESSED_THREADED" :
+	         "CUPS_RASTER_WRITE_PWG_THREADED");
+  fflush(stdout);
+
+  pwg = mode == CUPS_RASTER_WRITE_PWG || mode == CUPS_RASTER_WRITE_PWG_THREADED;
+
+  memset(&header, 0, sizeof(header));
+  header.cupsWidth        = 2;
+  header.cupsHeight       = 1;
+  header.cupsBytesPerLine = 4;
+  header.cupsBitsPerColor = 16;
+  header.cupsBitsPerPixel = 16;
+  header.cupsColorSpace   = CUPS_CSPACE_K;
+  header.cupsColorOrder   = CUPS_ORDER_CHUNKED;
+  header.cupsNumColors    = 1;
+
+  pixels[0] = 0x0102;
+  pixels[1] = 0x0304;
+
+ /*
+  * Write a single line; the pixels end the file in every write mode...
+  */
+
+  if ((fp = fopen("test.raster", "wb")) == NULL ||
+      (r = cupsRasterOpen(fileno(fp), mode)) == NULL ||
+      !cupsRasterWriteHeader2(r, &header) ||
+      cupsRasterWritePixels(r, (unsigned char *)pixels, 4) != 4)
+  {
+    printf("FAIL (%s)\n", strerror(errno));
+    return (1);
+  }
+
+  cupsRasterClose(r);
+  fclose(fp);
+
+  if ((fp = fopen("test.raster", "r+b")) == NULL ||
+      fseek(fp, -4, SEEK_END) || (length = ftell(fp)) < 0 ||
+      fread(bytes, 1, 4, fp) != 4)
+  {
+    printf("FAIL (%s)\n", strerror(errno));
+    return (1);
+  }
+
+  if (memcmp(bytes, pwg ? be_bytes : (unsigned char *)pixels, 4))
+  {
+    printf("FAIL (wrote %02X %02X %02X %02X)\n", bytes[0], bytes[1],
+           bytes[2], bytes[3]);
+    fclose(fp);
+    return (1);
+  }
+
+ /*
+  * Read the pixels back, both as written and with big-endian values from
+  * another PWG raster writer patched in...
+  */
+
+  if (pwg)
+  {
+    fseek(fp, length, SEEK_SET);
+    fwrite(patch_bytes, 1, 4, fp);
+
+    pixels[0] = 0x0a0b;
+    pixels[1] = 0x0c0d;
+  }
+
+  fclose(fp);
+
+  if ((fp = fopen("test.raster", "rb")) == NULL ||
+      (r = cupsRasterOpen(fileno(fp), CUPS_RASTER_READ)) == NULL ||
+      !cupsRasterReadHeader2(r, &header))
+  {
+    printf("FAIL (%s)\n", strerror(errno));
+    return (1);
+  }
+
+  memset(data, 0, sizeof(data));
+
+  if (cupsRasterReadPixels(r, (unsigned char *)data, 4) != 4 ||
+      data[0] != pixels[0] || data[1] != pixels[1])
+  {
+    printf("FAIL (read %04X %04X, expected %04X %04X)\n", data[0], data[1],
+           pixels[0], pixels[1]);
+    cupsRasterClose(r);
+    fclose(fp);
+    return (1);
+  }
+
+  cupsRasterClose(r);
+  fclose(fp);
+
+  puts("PASS");
+
+  return (0);
+}
+
+
+/*
+ * 'do_chunk_tests()' - Test writing 16-bit lines in partial-line chunks.
+ *
+ * Lines repeat or differ from the previous line part way through a chunk so
+ * that the repeat detection flushes partially copied lines.
+ */
+
+static int				/* O - Number of errors */
+do_chunk_tests(cups_mode_t mode)	/* I - Write mode */
+{
+  unsigned		page, x, y,	/* Looping vars */
+			bytes,		/* Bytes in chunk */
+			count;		/* Bytes written */
+  FILE			*fp;		/* Raster file */
+  cups_raster_t		*r;		/* Raster stream */
+  cups_page_header2_t	header;		/* Page header */
+  unsigned char		data[200];	/* Raster data */
+  static unsigned char	image[200][200];/* Page image */
+  int			errors = 0;	/* Number of errors */
+
+
+  printf("cupsRasterWritePixels(%s, partial lines): ",
+         mode == CUPS_RASTER_WRITE_COMPRESSED ? "CUPS_RASTER_WRITE_COMPRESSED" :
+	     mode == CUPS_RASTER_WRITE_PWG ? "CUPS_RASTER_WRITE_PWG" :
+	     mode == CUPS_RASTER_WRITE_COMPRESSED_THREADED ?
+	         "CUPS_RASTER_WRITE_COMPRESSED_THREADED" :
+	         "CUPS_RASTER_WRITE_PWG_THREADED");
+  fflush(stdout);
+
+  memset(&header, 0, sizeof(header));
+  header.cupsWidth        = 100;
+  header.cupsHeight       = 200;
+  header.cupsBytesPerLine = 200;
+  header.cupsBitsPerColor = 16;
+  header.cupsBitsPerPixel = 16;
+  header.cupsColorSpace   = CUPS_CSPACE_K;
+  header.cupsColorOrder   = CUPS_ORDER_CHUNKED;
+  header.cupsNumColors    = 1;
+
+  for (page = 0; page < 20 && !errors; page ++)
+  {
+   /*
+    * Make a page with repeated, nearly repeated, and random lines...
+    */
+
+    srand(page + 1);
+
+    for (y = 0; y < 200; y ++)
+    {
+      switch (y ? rand() & 3 : 3)
+      {
+        case 0 :
+        case 1 :
+	    memcpy(image[y], image[y - 1], 200);
+	    break;
+	case 2 :
+	    memcpy(image[y], image[y - 1], 200);
+	    image[y][rand() % 200] ^= (unsigned char)(1 + rand() % 255);
+	    break;
+	default :
+	    for (x = 0; x < 200; x ++)
+	      image[y][x] = (unsigned char)rand();
+	    break;
+      }
+    }
+
+   /*
+    * Write it in random chunks...
+    */
+
+    if ((fp = fopen("test.raster", "wb")) == NULL ||
+        (r = cupsRasterOpen(fileno(fp), mode)) == NULL ||
+	!cupsRasterWriteHeader2(r, &header))
+    {
+      printf("FAIL (%s)\n", strerror(errno));
+      return (1);
+    }
+
+    for (y = 0; y < 200; y ++)
+      for (x = 0; x < 200; x += bytes)
+      {
+        if ((bytes = 1 + (unsigned)rand() % 64) > 200 - x)
+	  bytes = 200 - x;
+
+        if ((count = cupsRasterWritePixels(r, image[y] + x, bytes)) != bytes)
+	  errors ++;
+      }
+
+    cupsRasterClose(r);
+    fclose(fp);
+
+    if (errors)
+    {
+      puts("FAIL (write error)");
+      break;
+    }
+
+   /*
+    * Then read it back...
+    */
+
+    if ((fp = fopen("test.raster", "rb")) == NULL ||
+        (r = cupsRasterOpen(fileno(fp), CUPS_RASTER_READ)) == NULL ||
+	!cupsRasterReadHeader2(r, &header))
+    {
+      printf("FAIL (%s)\n", strerror(errno));
+      return (1);
+    }
+
+    for (y = 0; y < 200 && !errors; y ++)
+      if (cupsRasterReadPixels(r, data, 200) != 200 ||
+          memcmp(data, image[y], 200))
+      {
+        printf("FAIL (page %u raster line %u corrupt)\n", page, y);
+	errors ++;
+      }
+
+    cupsRasterClose(r);
+    fclose(fp);
+  }
+
+  if (!errors)
+    puts("PASS");
+
+  return (errors);
+}
+
+
 /*
  * 'do_ppd_tests()' - Test the default option commands in a PPD file.
  */
@@ -527,8 +796,11 @@ do_raster_tests(cups_mode_t mode)	/* O - Write mode */
 
   printf("cupsRasterOpen(%s): ",
          mode == CUPS_RASTER_WRITE ? "CUPS_RASTER_WRITE" :
-	     mode == CUPS_RASTER_WRITE ? "CUPS_RASTER_WRITE_COMPRESSED" :
-	                                 "CUPS_RASTER_WRITE_PWG");
+	     mode == CUPS_RASTER_WRITE_COMPRESSED ? "CUPS_RASTER_WRITE_COMPRESSED" :
+	     mode == CUPS_RASTER_WRITE_PWG ? "CUPS_RASTER_WRITE_PWG" :
+	     mode == CUPS_RASTER_WRITE_COMPRESSED_THREADED ?
+	         "CUPS_RASTER_WRITE_COMPRESSED_THREADED" :
+	         "CUPS_RASTER_WRITE_PWG_THREADED");
   fflush(stdout);
 
   if ((fp = fopen("test.raster", "wb")) == NULL)
@@ -679,7 +951,7 @@ do_raster_tests(cups_mode_t mode)	/* O - Write mode */
     expected.cupsHeight       = 256;
     expected.cupsBytesPerLine = 256;
 
-    if (mode == CUPS_RASTER_WRITE_PWG)
+    if (mode == CUPS_RASTER_WRITE_PWG || mode == CUPS_RASTER_WRITE_PWG_THREADED)
     {
       strlcpy(expected.MediaClass, "PwgRaster", sizeof(expected.MediaClass));
       expected.cupsInteger[7] = 0xffffff;
@@ -823,6 +1095,87 @@ do_raster_tests(cups_mode_t mode)	/* O - Write mode */
   cupsRasterClose(r);
   fclose(fp);
 
+ /*
+  * Test reading without copying...
+  */
+
+  fputs("cupsRasterReadPixelsPtr: ", stdout);
+  fflush(stdout);
+
+  if ((fp = fopen("test.raster", "rb")) == NULL)
+  {
+    printf("FAIL (%s)\n", strerror(errno));
+    return (errors + 1);
+  }
+
+  if ((r = cupsRasterOpen(fileno(fp), CUPS_RASTER_READ)) == NULL)
+  {
+    printf("FAIL (%s)\n", strerror(errno));
+    fclose(fp);
+    return (errors + 1);
+  }
+
+  for (page = 0; page < 4; page ++)
+  {
+    const unsigned char	*ptr;		/* Pointer to raster data */
+    unsigned		value;		/* Expected value */
+
+    if (!cupsRasterReadHeader2(r, &header))
+    {
+      puts("FAIL (read error)");
+      errors ++;
+      break;
+    }
+
+    for (y = 0; y < 256; y ++)
+    {
+      if ((ptr = cupsRasterReadPixelsPtr(r, header.cupsBytesPerLine)) == NULL)
+      {
+        puts("FAIL (read error)");
+	errors ++;
+	break;
+      }
+
+      for (x = 0; x < header.cupsBytesPerLine; x ++)
+      {
+        switch (y / 64)
+	{
+	  case 0 :
+	      value = 0;
+	      break;
+	  case 1 :
+	      value = x & 255;
+	      break;
+	  case 2 :
+	      value = 255;
+	      break;
+	  default :
+	      value = (x / 4) & 255;
+	      break;
+	}
+
+        if (ptr[x] != value)
+	  break;
+      }
+
+      if (x < header.cupsBytesPerLine)
+      {
+	printf("FAIL (page %u raster line %u corrupt)\n", page, y);
+	errors ++;
+	break;
+      }
+    }
+
+    if (y < 256)
+      break;
+  }
+
+  if (page == 4)
+    puts("PASS");
+
+  cupsRasterClose(r);
+  fclose(fp);
+
   return (errors);
 }
 
@@ -0,0 +1,408 @@
+/*
+ * "$Id$"
+ *
+ * ZPL graphics test program for CUPS.
+ *
+ * Copyright 2007-2016 by Apple Inc.
+ *
+ * These coded instructions, statements, and computer programs are the
+ * property of Apple Inc. and are protected by Federal copyright
+ * law.  Distribution and use rights are outlined in the file "LICENSE.txt"
+ * which should have been included with this file.  If this file is
+ * file is missing or damaged, see the license at "http://www.cups.org/".
+ *
+ * This file is subject to the Apple OS-Developed Software exception.
+ *
+ * Usage:
+ *
+ *   ./testzpl
+ *
+ * Checks the hex and Z64 graphics encoders against known output and by
+ * decoding the output for random lines.
+ */
+
+/*
+ * Include necessary headers...
+ */
+
+#include <cups/string-private.h>
+#include "zpl-common.h"
+#include "test-common.h"
+#ifdef HAVE_LIBZ
+#  include <zlib.h>
+#endif /* HAVE_LIBZ */
+
+
+/*
+ * Constants...
+ */
+
+#define TEST_LENGTH	256		/* Maximum test line length */
+#define TEST_RUNS	20000		/* Number of random lines per test */
+#define TEST_SIZE	65536		/* Maximum Z64 test data size */
+
+
+/*
+ * Local functions...
+ */
+
+static unsigned	decode_hex(const unsigned char *comp, unsigned comp_length,
+		           unsigned char *line, unsigned length);
+static unsigned	test_crc(const unsigned char *text, unsigned length);
+#ifdef HAVE_LIBZ
+static int	test_z64(const unsigned char *data, unsigned length,
+		         unsigned line_length);
+#endif /* HAVE_LIBZ */
+
+
+/*
+ * Local globals...
+ */
+
+static const _cups_test_line_t zpl_kinds[5] =
+{					/* Kinds of test lines */
+  _CUPS_TEST_LINE_BLANK,
+  _CUPS_TEST_LINE_TEXT,
+  _CUPS_TEST_LINE_RANDOM,
+  _CUPS_TEST_LINE_SOLID,
+  _CUPS_TEST_LINE_WORDS
+};
+
+
+/*
+ * 'main()' - Test the ZPL graphics routines.
+ */
+
+int					/* O - Exit status */
+main(void)
+{
+  int		i,			/* Looping var */
+		errors = 0;		/* Number of errors */
+  unsigned	run,			/* Current run */
+		length,			/* Line length */
+		kind,			/* Kind of line */
+		comp_length;		/* Compressed length */
+  unsigned char	line[TEST_LENGTH],	/* Line */
+		decoded[TEST_LENGTH],	/* Decoded line */
+		comp[TEST_LENGTH * 2 + 1];
+					/* Compressed line */
+  static const struct
+  {
+    unsigned		length;		/* Length of line */
+    unsigned char	line[4];	/* Line */
+    const char		*comp;		/* Compressed line */
+  }		known[] =		/* Known hex output */
+  {
+    { 4, { 0x00, 0x00, 0x00, 0x00 }, "," },
+    { 4, { 0x12, 0x22, 0x22, 0xf0 }, "1K2F0" },
+    { 4, { 0xab, 0xab, 0xab, 0x00 }, "ABABAB," },
+    { 3, { 0xa0, 0x00, 0x00 },       "A0," },
+    { 3, { 0xff, 0xff, 0xff },       "!" },
+    { 2, { 0x0f, 0xff },             "0F!" },
+    { 3, { 0x01, 0x11, 0x1f },       "0J1F" }
+  };
+
+
+ /*
+  * Check known output...
+  */
+
+  fputs("ZPLCompressHex (known output): ", stdout);
+
+  for (i = 0; i < (int)(sizeof(known) / sizeof(known[0])); i ++)
+  {
+    comp_length = ZPLCompressHex(known[i].line, known[i].length, comp);
+
+    if (comp_length != strlen(known[i].comp) ||
+        memcmp(comp, known[i].comp, comp_length))
+    {
+      printf("FAIL (got \"%.*s\", expected \"%s\")\n", (int)comp_length, comp,
+             known[i].comp);
+      errors ++;
+      break;
+    }
+  }
+
+  if (i == (int)(sizeof(known) / sizeof(known[0])))
+    puts("PASS");
+
+  fputs("Z64 CRC (known output): ", stdout);
+
+  if (test_crc((const unsigned char *)"123456789", 9) != 0x31c3)
+  {
+    puts("FAIL");
+    errors ++;
+  }
+  else
+    puts("PASS");
+
+ /*
+  * Decode random lines...
+  */
+
+  fputs("ZPLCompressHex: ", stdout);
+  fflush(stdout);
+
+  for (run = 0; run < TEST_RUNS; run ++)
+  {
+    length = 1 + _cupsTestRand() % (run < 1000 ? 16 : TEST_LENGTH);
+    kind   = _cupsTestRand() % 5;
+
+    _cupsTestMakeLine(line, length, zpl_kinds[kind]);
+
+    comp_length = ZPLCompressHex(line, length, comp);
+
+    memset(decoded, 0xaa, sizeof(decoded));
+
+    if (comp_length > 2 * length ||
+        decode_hex(comp, comp_length, decoded, length) != length ||
+        memcmp(decoded, line, length))
+    {
+      printf("FAIL (run %u, length %u, kind %u)\n", run, length, kind);
+      errors ++;
+      break;
+    }
+  }
+
+  if (run == TEST_RUNS)
+    puts("PASS");
+
+#ifdef HAVE_LIBZ
+  fputs("ZPLZ64Write: ", stdout);
+  fflush(stdout);
+
+  if (test_z64(known[1].line, 0, 1) || test_z64(known[1].line, 1, 1) ||
+      test_z64(known[1].line, 2, 1) || test_z64(known[1].line, 4, 3))
+  {
+    errors ++;
+  }
+  else
+  {
+    unsigned char *data = malloc(TEST_SIZE);
+					/* Test data */
+
+   /*
+    * Encode random data written in random sized pieces...
+    */
+
+    for (i = 0; i < 16; i ++)
+    {
+      length = 1 + _cupsTestRand() * 7 % TEST_SIZE;
+
+      _cupsTestMakeLine(data, length, zpl_kinds[i % 5]);
+
+      if (test_z64(data, length, 1 + _cupsTestRand() % 200))
+      {
+        errors ++;
+	break;
+      }
+    }
+
+    if (i == 16)
+      puts("PASS");
+
+    free(data);
+  }
+#endif /* HAVE_LIBZ */
+
+  return (errors > 0);
+}
+
+
+/*
+ * 'decode_hex()' - Decode a ZPL hex line with alternate data compression.
+ */
+
+static unsigned				/* O - Number of bytes decoded */
+decode_hex(
+    const unsigned char *comp,		/* I - Compressed data */
+    unsigned            comp_length,	/* I - Length of compressed data */
+    unsigned char       *line,		/* O - Decoded line */
+    unsigned            length)		/* I - Length of line */
+{
+  const unsigned char	*comp_end = comp + comp_length;
+					/* End of compressed data */
+  unsigned		digits = 0,	/* Number of hex digits decoded */
+			count = 0,	/* Repeat count */
+			nibble;		/* Value of hex digit */
+
+
+  for (; comp < comp_end; comp ++)
+  {
+    if (*comp >= 'G' && *comp <= 'Y')
+      count += (unsigned)(*comp - 'F');
+    else if (*comp >= 'g' && *comp <= 'z')
+      count += 20 * (unsigned)(*comp - 'f');
+    else if (*comp == ',' || *comp == '!')
+    {
+      if ((digits & 1) || count || comp + 1 < comp_end)
+        return (0);
+
+      for (; digits < 2 * length; digits += 2)
+        line[digits / 2] = *comp == ',' ? 0x00 : 0xff;
+    }
+    else
+    {
+      if (*comp >= '0' && *comp <= '9')
+        nibble = (unsigned)(*comp - '0');
+      else if (*comp >= 'A' && *comp <= 'F')
+        nibble = (unsigned)(*comp - 'A' + 10);
+      else
+        return (0);
+
+      if (count == 0)
+        count = 1;
+
+      for (; count > 0; count --, digits ++)
+      {
+        if (digits >= 2 * length)
+	  return (0);
+
+        if (digits & 1)
+	  line[digits / 2] = (unsigned char)((line[digits / 2] & 0xf0) | nibble);
+	else
+	  line[digits / 2] = (unsigned char)(nibble << 4);
+      }
+    }
+  }
+
+  return (digits / 2);
+}
+
+
+/*
+ * 'test_crc()' - Compute the CRC-16 (XMODEM) of a string.
+ */
+
+static unsigned				/* O - CRC-16 */
+test_crc(const unsigned char *text,	/* I - Text */
+         unsigned            length)	/* I - Length of text */
+{
+  unsigned	crc = 0,		/* CRC-16 */
+		bit;			/* Current bit */
+
+
+  for (; length > 0; length --, text ++)
+    for (bit = 0x80; bit; bit >>= 1)
+    {
+      unsigned carry = ((crc >> 15) ^ ((*text & bit) ? 1 : 0)) & 1;
+					/* Feedback bit */
+
+      crc = ((crc << 1) & 0xffff) ^ (carry ? 0x1021 : 0);
+    }
+
+  return (crc);
+}
+
+
+#ifdef HAVE_LIBZ
+/*
+ * 'test_z64()' - Encode data as Z64 and verify the decoded result.
+ */
+
+static int				/* O - 0 on success, -1 on error */
+test_z64(const unsigned char *data,	/* I - Data to encode */
+         unsigned            length,	/* I - Length of data */
+	 unsigned            line_length)
+					/* I - Length of each written line */
+{
+  FILE		*fp;			/* Temporary file */
+  zpl_z64_t	*z64;			/* Z64 encoder */
+  unsigned	pos,			/* Position in data */
+		bytes,			/* Bytes to write */
+		crc,			/* CRC from text */
+		bits = 0,		/* Base64 bits */
+		num_bits = 0;		/* Number of Base64 bits */
+  long		text_length;		/* Length of text */
+  char		*text,			/* Z64 text */
+		*ptr,			/* Pointer into text */
+		*end;			/* End of Base64 text */
+  unsigned char	*comp,			/* Compressed data */
+		*decoded;		/* Decoded data */
+  uLongf	comp_length = 0,	/* Length of compressed data */
+		decoded_length;		/* Length of decoded data */
+  static const char base64[] =		/* Base64 characters */
+		"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+
+  if ((fp = tmpfile()) == NULL || (z64 = ZPLZ64Open(fp, 6)) == NULL)
+  {
+    puts("FAIL (unable to create encoder)");
+    return (-1);
+  }
+
+  for (pos = 0; pos < length; pos += bytes)
+  {
+    if ((bytes = length - pos) > line_length)
+      bytes = line_length;
+
+    ZPLZ64Write(z64, data + pos, bytes);
+  }
+
+  ZPLZ64Close(z64, 1);
+
+  text_length = ftell(fp);
+  text        = calloc(1, (size_t)text_length + 1);
+  comp        = malloc((size_t)text_length);
+  decoded     = malloc(length + 1);
+
+  rewind(fp);
+  if (fread(text, 1, (size_t)text_length, fp) != (size_t)text_length)
+    text[0] = '\0';
+  fclose(fp);
+
+ /*
+  * Check the CRC of the Base64 text...
+  */
+
+  if ((end = strchr(text, ':')) == NULL ||
+      sscanf(end + 1, "%4x", &crc) != 1 ||
+      crc != test_crc((unsigned char *)text, (unsigned)(end - text)))
+  {
+    printf("FAIL (length %u, bad CRC)\n", length);
+    free(text);
+    free(comp);
+    free(decoded);
+    return (-1);
+  }
+
+ /*
+  * Decode the Base64 text and decompress it...
+  */
+
+  for (ptr = text; ptr < end && *ptr != '='; ptr ++)
+  {
+    bits     = (bits << 6) | (unsigned)(strchr(base64, *ptr) - base64);
+    num_bits += 6;
+
+    if (num_bits >= 8)
+    {
+      num_bits -= 8;
+      comp[comp_length ++] = (unsigned char)(bits >> num_bits);
+    }
+  }
+
+  decoded_length = length;
+
+  if (uncompress(decoded, &decoded_length, comp, comp_length) != Z_OK ||
+      decoded_length != length || memcmp(decoded, data, length))
+  {
+    printf("FAIL (length %u, bad data)\n", length);
+    free(text);
+    free(comp);
+    free(decoded);
+    return (-1);
+  }
+
+  free(text);
+  free(comp);
+  free(decoded);
+
+  return (0);
+}
+#endif /* HAVE_LIBZ */
+
+
+/*
+ * End of "$Id$".
+ */
@@ -0,0 +1,390 @@
+/*
+ * "$Id$"
+ *
+ * Common ZPL graphics routines for CUPS.
+ *
+ * Copyright 2007-2016 by Apple Inc.
+ * Copyright 2001-2007 by Easy Software Products.
+ *
+ * These coded instructions, statements, and computer programs are the
+ * property of Apple Inc. and are protected by Federal copyright
+ * law.  Distribution and use rights are outlined in the file "LICENSE.txt"
+ * which should have been included with this file.  If this file is
+ * file is missing or damaged, see the license at "http://www.cups.org/".
+ *
+ * This file is subject to the Apple OS-Developed Software exception.
+ */
+
+/*
+ * Include necessary headers...
+ */
+
+#include <config.h>
+#include "zpl-common.h"
+#include <stdlib.h>
+#include <string.h>
+#ifdef HAVE_LIBZ
+#  include <zlib.h>
+#endif /* HAVE_LIBZ */
+
+
+/*
+ * Local types...
+ */
+
+struct zpl_z64_s			/**** Z64 graphic encoder ****/
+{
+  FILE		*fp;			/* Output file */
+#ifdef HAVE_LIBZ
+  z_stream	stream;			/* Deflate stream */
+#endif /* HAVE_LIBZ */
+  unsigned	crc;			/* CRC-16 of Base64 text */
+  unsigned char	comp[3072],		/* Compressed data */
+		text[4096];		/* Base64 text */
+};
+
+
+/*
+ * Local functions...
+ */
+
+static unsigned char	*zpl_repeat(unsigned char *comp,
+			            unsigned char repeat_char,
+				    unsigned repeat_count);
+#ifdef HAVE_LIBZ
+static void		zpl_z64_flush(zpl_z64_t *z64, unsigned length);
+#endif /* HAVE_LIBZ */
+
+
+/*
+ * 'ZPLCompressHex()' - Compress a line using ZPL hex with alternate data
+ *                      compression.
+ *
+ * Runs of hex digits use the repeat count characters, trailing zeros and
+ * ones are replaced with the "," and "!" fill characters.  The "comp" buffer
+ * must hold at least "length" * 2 + 1 bytes.
+ */
+
+unsigned				/* O - Number of compressed bytes */
+ZPLCompressHex(
+    const unsigned char *line,		/* I - Line to compress */
+    unsigned            length,		/* I - Length of line */
+    unsigned char       *comp)		/* O - Compressed data */
+{
+  const unsigned char	*line_end;	/* End of line */
+  unsigned char		*comp_ptr,	/* Pointer into compressed data */
+			digits[2],	/* Hex digits for current byte */
+			repeat_char;	/* Repeated character */
+  unsigned		repeat_count,	/* Number of repeated characters */
+			i;		/* Looping var */
+  static const unsigned char *hex = (const unsigned char *)"0123456789ABCDEF";
+					/* Hex digits */
+
+
+  if (length == 0)
+    return (0);
+
+  comp_ptr     = comp;
+  line_end     = line + length;
+  repeat_char  = hex[*line >> 4];
+  repeat_count = 0;
+
+  for (; line < line_end; line ++)
+  {
+   /*
+    * Blank and solid bytes extend the current run without any lookups...
+    */
+
+    if ((*line == 0x00 && repeat_char == '0') ||
+        (*line == 0xff && repeat_char == 'F'))
+    {
+      repeat_count += 2;
+      continue;
+    }
+
+    digits[0] = hex[*line >> 4];
+    digits[1] = hex[*line & 15];
+
+    for (i = 0; i < 2; i ++)
+    {
+      if (digits[i] == repeat_char)
+        repeat_count ++;
+      else
+      {
+        comp_ptr     = zpl_repeat(comp_ptr, repeat_char, repeat_count);
+	repeat_char  = digits[i];
+	repeat_count = 1;
+      }
+    }
+  }
+
+  if (repeat_char == '0' || repeat_char == 'F')
+  {
+   /*
+    * Handle 0's and F's on the end of the line, finishing the last byte
+    * before filling...
+    */
+
+    if (repeat_count & 1)
+    {
+      repeat_count --;
+      *comp_ptr++ = repeat_char;
+    }
+
+    if (repeat_count > 0)
+      *comp_ptr++ = repeat_char == '0' ? ',' : '!';
+  }
+  else
+    comp_ptr = zpl_repeat(comp_ptr, repeat_char, repeat_count);
+
+  return ((unsigned)(comp_ptr - comp));
+}
+
+
+/*
+ * 'ZPLZ64Close()' - Finish a Z64 graphic and free the encoder.
+ *
+ * When "finish" is 0 the remaining data is discarded so the caller can abort
+ * the download.
+ */
+
+void
+ZPLZ64Close(zpl_z64_t *z64,		/* I - Z64 encoder */
+            int       finish)		/* I - 1 to finish graphic, 0 to discard */
+{
+#ifdef HAVE_LIBZ
+  int	status;				/* Deflate status */
+
+
+  if (!z64)
+    return;
+
+  if (finish)
+  {
+    z64->stream.next_in  = NULL;
+    z64->stream.avail_in = 0;
+
+    do
+    {
+      status = deflate(&(z64->stream), Z_FINISH);
+
+      if (z64->stream.avail_out == 0 || status == Z_STREAM_END)
+      {
+        zpl_z64_flush(z64, sizeof(z64->comp) - z64->stream.avail_out);
+
+        z64->stream.next_out  = z64->comp;
+        z64->stream.avail_out = sizeof(z64->comp);
+      }
+    }
+    while (status == Z_OK);
+
+    fprintf(z64->fp, ":%04X\n", z64->crc);
+  }
+
+  deflateEnd(&(z64->stream));
+#else
+  (void)finish;
+#endif /* HAVE_LIBZ */
+
+  free(z64);
+}
+
+
+/*
+ * 'ZPLZ64Open()' - Start a Z64 (zlib and Base64) graphic.
+ *
+ * The caller writes the download command up to and including the ":Z64:"
+ * prefix.  NULL is returned when zlib is not available.
+ */
+
+zpl_z64_t *				/* O - Z64 encoder or NULL */
+ZPLZ64Open(FILE *fp,			/* I - Output file */
+           int  level)			/* I - Compression level (1-9) */
+{
+#ifdef HAVE_LIBZ
+  zpl_z64_t	*z64;			/* Z64 encoder */
+
+
+  if ((z64 = calloc(1, sizeof(zpl_z64_t))) == NULL)
+    return (NULL);
+
+  if (deflateInit(&(z64->stream), level) != Z_OK)
+  {
+    free(z64);
+    return (NULL);
+  }
+
+  z64->fp               = fp;
+  z64->stream.next_out  = z64->comp;
+  z64->stream.avail_out = sizeof(z64->comp);
+
+  return (z64);
+
+#else
+  (void)fp;
+  (void)level;
+
+  return (NULL);
+#endif /* HAVE_LIBZ */
+}
+
+
+/*
+ * 'ZPLZ64Write()' - Add a line to a Z64 graphic.
+ *
+ * Base64 text is written as each 3k block of compressed data fills up.
+ */
+
+int					/* O - 0 on success, -1 on error */
+ZPLZ64Write(zpl_z64_t          *z64,	/* I - Z64 encoder */
+            const unsigned char *line,	/* I - Line of graphics */
+	    unsigned            length)	/* I - Length of line */
+{
+#ifdef HAVE_LIBZ
+  z64->stream.next_in  = (Bytef *)line;
+  z64->stream.avail_in = length;
+
+  while (z64->stream.avail_in > 0)
+  {
+    if (deflate(&(z64->stream), Z_NO_FLUSH) != Z_OK)
+      return (-1);
+
+    if (z64->stream.avail_out == 0)
+    {
+      zpl_z64_flush(z64, sizeof(z64->comp));
+
+      z64->stream.next_out  = z64->comp;
+      z64->stream.avail_out = sizeof(z64->comp);
+    }
+  }
+
+  return (0);
+
+#else
+  (void)z64;
+  (void)line;
+  (void)length;
+
+  return (-1);
+#endif /* HAVE_LIBZ */
+}
+
+
+/*
+ * 'zpl_repeat()' - Add a run-length compression sequence.
+ */
+
+static unsigned char *			/* O - New end of compressed data */
+zpl_repeat(unsigned char *comp,		/* I - End of compressed data */
+           unsigned char repeat_char,	/* I - Character to repeat */
+	   unsigned      repeat_count)	/* I - Number of repeated characters */
+{
+  if (repeat_count > 1)
+  {
+   /*
+    * Print as many z's as possible - they are the largest denomination
+    * representing 400 characters (zC stands for 400 adjacent C's)
+    */
+
+    while (repeat_count >= 400)
+    {
+      *comp++ = 'z';
+      repeat_count -= 400;
+    }
+
+   /*
+    * Then print 'g' through 'y' as multiples of 20 characters...
+    */
+
+    if (repeat_count >= 20)
+    {
+      *comp++ = (unsigned char)('f' + repeat_count / 20);
+      repeat_count %= 20;
+    }
+
+   /*
+    * Finally, print 'G' through 'Y' as 1 through 19 characters...
+    */
+
+    if (repeat_count > 0)
+      *comp++ = (unsigned char)('F' + repeat_count);
+  }
+
+ /*
+  * Then the character to be repeated...
+  */
+
+  *comp++ = repeat_char;
+
+  return (comp);
+}
+
+
+#ifdef HAVE_LIBZ
+/*
+ * 'zpl_z64_flush()' - Write compressed data as Base64 text.
+ *
+ * Only the final block may have a length that is not a multiple of 3, so
+ * padding only appears at the end of the text.
+ */
+
+static void
+zpl_z64_flush(zpl_z64_t *z64,		/* I - Z64 encoder */
+              unsigned  length)		/* I - Number of compressed bytes */
+{
+  const unsigned char	*comp;		/* Pointer into compressed data */
+  unsigned char		*text,		/* Pointer into Base64 text */
+			*text_end;	/* End of Base64 text */
+  unsigned		bits,		/* 24 bits of data */
+			crc;		/* CRC-16 */
+  int			i;		/* Looping var */
+  static const char	base64[] =	/* Base64 characters */
+			"ABCDEFGHIJKLMNOPQRSTUVWXYZ"
+			"abcdefghijklmnopqrstuvwxyz"
+			"0123456789+/";
+
+
+  for (comp = z64->comp, text = z64->text; length >= 3; length -= 3, comp += 3)
+  {
+    bits    = ((unsigned)comp[0] << 16) | ((unsigned)comp[1] << 8) | comp[2];
+    *text++ = (unsigned char)base64[bits >> 18];
+    *text++ = (unsigned char)base64[(bits >> 12) & 63];
+    *text++ = (unsigned char)base64[(bits >> 6) & 63];
+    *text++ = (unsigned char)base64[bits & 63];
+  }
+
+  if (length > 0)
+  {
+    bits    = (unsigned)comp[0] << 16;
+    if (length > 1)
+      bits |= (unsigned)comp[1] << 8;
+
+    *text++ = (unsigned char)base64[bits >> 18];
+    *text++ = (unsigned char)base64[(bits >> 12) & 63];
+    *text++ = length > 1 ? (unsigned char)base64[(bits >> 6) & 63] : '=';
+    *text++ = '=';
+  }
+
+ /*
+  * Update the CRC-16 (CCITT polynomial, initial value 0) of the text and
+  * write it...
+  */
+
+  for (text_end = text, text = z64->text, crc = z64->crc; text < text_end; text ++)
+  {
+    crc ^= (unsigned)*text << 8;
+
+    for (i = 0; i < 8; i ++)
+      crc = (crc & 0x8000) ? ((crc << 1) ^ 0x1021) & 0xffff : (crc << 1) & 0xffff;
+  }
+
+  z64->crc = crc;
+
+  fwrite(z64->text, 1, (size_t)(text_end - z64->text), z64->fp);
+}
+#endif /* HAVE_LIBZ */
+
+
+/*
+ * End of "$Id$".
+ */
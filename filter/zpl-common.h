@@ -0,0 +1,63 @@
+/*
+ * "$Id$"
+ *
+ * Common ZPL graphics definitions for CUPS.
+ *
+ * Copyright 2007-2016 by Apple Inc.
+ *
+ * These coded instructions, statements, and computer programs are the
+ * property of Apple Inc. and are protected by Federal copyright
+ * law.  Distribution and use rights are outlined in the file "LICENSE.txt"
+ * which should have been included with this file.  If this file is
+ * file is missing or damaged, see the license at "http://www.cups.org/".
+ *
+ * This file is subject to the Apple OS-Developed Software exception.
+ */
+
+/*
+ * Include necessary headers...
+ */
+
+#include <stdio.h>
+
+
+/*
+ * C++ magic...
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+
+/*
+ * Types...
+ */
+
+typedef struct zpl_z64_s zpl_z64_t;	/**** Z64 graphic encoder ****/
+
+
+/*
+ * Prototypes...
+ */
+
+extern unsigned		ZPLCompressHex(const unsigned char *line,
+			               unsigned length, unsigned char *comp);
+extern void		ZPLZ64Close(zpl_z64_t *z64, int finish);
+extern zpl_z64_t	*ZPLZ64Open(FILE *fp, int level);
+extern int		ZPLZ64Write(zpl_z64_t *z64, const unsigned char *line,
+			            unsigned length);
+
+
+/*
+ * C++ magic...
+ */
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+
+/*
+ * End of "$Id$".
+ */
@@ -63,20 +63,80 @@ typedef struct sockpeercred cupsd_ucred_t;
 #endif /* HAVE_SYS_UCRED_H */
 
 
+/*
+ * Local structures...
+ */
+
+#if HAVE_LIBPAM
+typedef struct cupsd_authdata_s		/**** Authentication data ****/
+{
+  char	username[HTTP_MAX_VALUE],	/* Username string */
+	password[HTTP_MAX_VALUE];	/* Password string */
+} cupsd_authdata_t;
+#endif /* HAVE_LIBPAM */
+
+typedef struct cupsd_ipnode_s		/**** IP mask radix tree node ****/
+{
+  struct cupsd_ipnode_s	*child[2];	/* Children for 0 and 1 bits */
+  int			match;		/* Non-zero if a network ends here */
+} cupsd_ipnode_t;
+
+typedef struct cupsd_authtree_s		/**** Compiled Allow/Deny lines ****/
+{
+  int			count;		/* Number of masks compiled */
+  cupsd_ipnode_t	*ip;		/* Radix tree of IP networks */
+  cups_array_t		*others;	/* Name, interface, and other masks */
+} cupsd_authtree_t;
+
+typedef struct cupsd_locnode_s		/**** Location trie node ****/
+{
+  struct cupsd_locnode_s *child,	/* First child node */
+			*next;		/* Next sibling node */
+  int			ch;		/* Character for this node */
+  cups_array_t		*locs;		/* Locations ending at this node */
+} cupsd_locnode_t;
+
+
+/*
+ * Local globals...
+ */
+
+static cupsd_locnode_t	*loc_trie = NULL,
+					/* Case-sensitive location trie */
+			*loc_ftrie = NULL;
+					/* Case-insensitive location trie */
+static int		loc_compiled = 0;
+					/* Are the location tries current? */
+
+
 /*
  * Local functions...
  */
 
+static void		add_location(cupsd_locnode_t *trie,
+			             cupsd_location_t *loc, int fold);
 #ifdef HAVE_AUTHORIZATION_H
 static int		check_authref(cupsd_client_t *con, const char *right);
 #endif /* HAVE_AUTHORIZATION_H */
+static int		check_group(const char *username, struct passwd *user,
+			            const char *groupname);
+static int		check_masks(unsigned ip[4], const char *name,
+			            size_t namelen, cups_array_t *masks,
+				    cupsd_authtree_t **tree);
 static int		compare_locations(cupsd_location_t *a,
 			                  cupsd_location_t *b);
+static void		compile_locations(void);
+static cupsd_authtree_t	*compile_masks(cups_array_t *masks);
 static cupsd_authmask_t	*copy_authmask(cupsd_authmask_t *am, void *data);
 #if !HAVE_LIBPAM
 static char		*cups_crypt(const char *pw, const char *salt);
 #endif /* !HAVE_LIBPAM */
+static cupsd_location_t	*find_location(cupsd_locnode_t *trie,
+			               const char *uri, int limit, int fold);
 static void		free_authmask(cupsd_authmask_t *am, void *data);
+static void		free_authtree(cupsd_authtree_t *tree);
+static void		free_ipnode(cupsd_ipnode_t *node);
+static void		free_locnode(cupsd_locnode_t *node);
 #if HAVE_LIBPAM
 static int		pam_func(int, const struct pam_message **,
 			         struct pam_response **, void *);
@@ -85,19 +145,6 @@ static void		to64(char *s, unsigned long v, int n);
 #endif /* HAVE_LIBPAM */
 
 
-/*
- * Local structures...
- */
-
-#if HAVE_LIBPAM
-typedef struct cupsd_authdata_s		/**** Authentication data ****/
-{
-  char	username[HTTP_MAX_VALUE],	/* Username string */
-	password[HTTP_MAX_VALUE];	/* Password string */
-} cupsd_authdata_t;
-#endif /* HAVE_LIBPAM */
-
-
 /*
  * 'cupsdAddIPMask()' - Add an IP address authorization mask.
  */
@@ -151,6 +198,8 @@ cupsdAddLocation(cupsd_location_t *loc)	/* I - Location to add */
   {
     cupsArrayAdd(Locations, loc);
 
+    loc_compiled = 0;
+
     cupsdLogMessage(CUPSD_LOG_DEBUG2, "cupsdAddLocation: Added location \"%s\"", loc->location ? loc->location : "(null)");
   }
 }
@@ -569,6 +618,16 @@ cupsdAuthorize(cupsd_client_t *con)	/* I - Client connection */
     {
       default :
       case CUPSD_AUTH_BASIC :
+          if (cupsdCheckAuthCache(username, password))
+	  {
+	   /*
+	    * Same username and password were recently validated...
+	    */
+
+	    cupsdLogClient(con, CUPSD_LOG_DEBUG, "Authorized as \"%s\" using cached Basic credentials.", username);
+	    break;
+	  }
+
           {
 #if HAVE_LIBPAM
 	   /*
@@ -723,6 +782,8 @@ cupsdAuthorize(cupsd_client_t *con)	/* I - Client connection */
 #endif /* HAVE_LIBPAM */
           }
 
+	  cupsdAddAuthCache(username, password, AuthCacheTimeout);
+
 	  cupsdLogClient(con, CUPSD_LOG_DEBUG, "Authorized as \"%s\" using Basic.", username);
           break;
     }
@@ -935,20 +996,20 @@ cupsdCheckAccess(
       case CUPSD_AUTH_ALLOW : /* Order Deny,Allow */
           allow = 1;
 
-          if (cupsdCheckAuth(ip, name, namelen, loc->deny))
+          if (check_masks(ip, name, namelen, loc->deny, &loc->deny_tree))
 	    allow = 0;
 
-          if (cupsdCheckAuth(ip, name, namelen, loc->allow))
+          if (check_masks(ip, name, namelen, loc->allow, &loc->allow_tree))
 	    allow = 1;
 	  break;
 
       case CUPSD_AUTH_DENY : /* Order Allow,Deny */
           allow = 0;
 
-          if (cupsdCheckAuth(ip, name, namelen, loc->allow))
+          if (check_masks(ip, name, namelen, loc->allow, &loc->allow_tree))
 	    allow = 1;
 
-          if (cupsdCheckAuth(ip, name, namelen, loc->deny))
+          if (check_masks(ip, name, namelen, loc->deny, &loc->deny_tree))
 	    allow = 0;
 	  break;
     }
@@ -1149,13 +1210,7 @@ cupsdCheckGroup(
     struct passwd *user,		/* I - System user info */
     const char    *groupname)		/* I - Group name */
 {
-  int		i;			/* Looping var */
-  struct group	*group;			/* System group info */
-#ifdef HAVE_MBR_UID_TO_UUID
-  uuid_t	useruuid,		/* UUID for username */
-		groupuuid;		/* UUID for groupname */
   int		is_member;		/* True if user is a member of group */
-#endif /* HAVE_MBR_UID_TO_UUID */
 
 
   cupsdLogMessage(CUPSD_LOG_DEBUG2, "cupsdCheckGroup(username=\"%s\", user=%p, groupname=\"%s\")", username, user, groupname);
@@ -1168,76 +1223,17 @@ cupsdCheckGroup(
     return (0);
 
  /*
-  * Check to see if the user is a member of the named group...
+  * Use a cached result if we have one, otherwise ask the system...
   */
 
-  group = getgrnam(groupname);
-
-  if (group != NULL)
-  {
-   /*
-    * Group exists, check it...
-    */
-
-    for (i = 0; group->gr_mem[i]; i ++)
-      if (!_cups_strcasecmp(username, group->gr_mem[i]))
-	return (1);
-  }
-
- /*
-  * Group doesn't exist or user not in group list, check the group ID
-  * against the user's group ID...
-  */
-
-  if (user && group && group->gr_gid == user->pw_gid)
-    return (1);
-
-#ifdef HAVE_MBR_UID_TO_UUID
- /*
-  * Check group membership through MacOS X membership API...
-  */
-
-  if (user && !mbr_uid_to_uuid(user->pw_uid, useruuid))
-  {
-    if (group)
-    {
-     /*
-      * Map group name to UUID and check membership...
-      */
-
-      if (!mbr_gid_to_uuid(group->gr_gid, groupuuid))
-        if (!mbr_check_membership(useruuid, groupuuid, &is_member))
-	  if (is_member)
-	    return (1);
-    }
-    else if (groupname[0] == '#')
-    {
-     /*
-      * Use UUID directly and check for equality (user UUID) and
-      * membership (group UUID)...
-      */
-
-      if (!uuid_parse((char *)groupname + 1, groupuuid))
-      {
-        if (!uuid_compare(useruuid, groupuuid))
-	  return (1);
-	else if (!mbr_check_membership(useruuid, groupuuid, &is_member))
-	  if (is_member)
-	    return (1);
-      }
+  if (cupsdCheckGroupCache(username, groupname, &is_member))
+    return (is_member);
 
-      return (0);
-    }
-  }
-  else if (groupname[0] == '#')
-    return (0);
-#endif /* HAVE_MBR_UID_TO_UUID */
+  is_member = check_group(username, user, groupname);
 
- /*
-  * If we get this far, then the user isn't part of the named group...
-  */
+  cupsdAddGroupCache(username, groupname, is_member, AuthCacheTimeout);
 
-  return (0);
+  return (is_member);
 }
 
 
@@ -1339,6 +1335,17 @@ cupsdDeleteAllLocations(void)
 
   cupsArrayDelete(Locations);
   Locations = NULL;
+
+ /*
+  * Free the location tries...
+  */
+
+  free_locnode(loc_trie);
+  free_locnode(loc_ftrie);
+
+  loc_trie     = NULL;
+  loc_ftrie    = NULL;
+  loc_compiled = 0;
 }
 
 
@@ -1353,9 +1360,7 @@ cupsdFindBest(const char   *path,	/* I - Resource path */
   char			uri[HTTP_MAX_URI],
 					/* URI in request... */
 			*uriptr;	/* Pointer into URI */
-  cupsd_location_t	*loc,		/* Current location */
-			*best;		/* Best match for location so far */
-  size_t		bestlen;	/* Length of best match */
+  cupsd_location_t	*best;		/* Best match for location */
   int			limit;		/* Limit field */
   static const int	limits[] =	/* Map http_status_t to CUPSD_AUTH_LIMIT_xyz */
 		{
@@ -1406,52 +1411,31 @@ cupsdFindBest(const char   *path,	/* I - Resource path */
   }
 
  /*
-  * Loop through the list of locations to find a match...
+  * Look up the longest matching location in the location tries...
   */
 
-  limit   = limits[state];
-  best    = NULL;
-  bestlen = 0;
+  limit = limits[state];
 
   cupsdLogMessage(CUPSD_LOG_DEBUG2, "cupsdFindBest: uri=\"%s\", limit=%x...", uri, limit);
 
+  if (!loc_compiled)
+    compile_locations();
 
-  for (loc = (cupsd_location_t *)cupsArrayFirst(Locations);
-       loc;
-       loc = (cupsd_location_t *)cupsArrayNext(Locations))
+  if (!strncmp(uri, "/printers/", 10) || !strncmp(uri, "/classes/", 9))
   {
-    cupsdLogMessage(CUPSD_LOG_DEBUG2, "cupsdFindBest: Location %s(%d) Limit %x", loc->location ? loc->location : "(null)", (int)loc->length, loc->limit);
-
-    if (!strncmp(uri, "/printers/", 10) || !strncmp(uri, "/classes/", 9))
-    {
-     /*
-      * Use case-insensitive comparison for queue names...
-      */
+   /*
+    * Use case-insensitive comparison for queue names...
+    */
 
-      if (loc->length > bestlen && loc->location &&
-          !_cups_strncasecmp(uri, loc->location, loc->length) &&
-	  loc->location[0] == '/' &&
-	  (limit & loc->limit) != 0)
-      {
-	best    = loc;
-	bestlen = loc->length;
-      }
-    }
-    else
-    {
-     /*
-      * Use case-sensitive comparison for other URIs...
-      */
+    best = find_location(loc_ftrie, uri, limit, 1);
+  }
+  else
+  {
+   /*
+    * Use case-sensitive comparison for other URIs...
+    */
 
-      if (loc->length > bestlen && loc->location &&
-          !strncmp(uri, loc->location, loc->length) &&
-	  loc->location[0] == '/' &&
-	  (limit & loc->limit) != 0)
-      {
-	best    = loc;
-	bestlen = loc->length;
-      }
-    }
+    best = find_location(loc_trie, uri, limit, 0);
   }
 
  /*
@@ -1491,6 +1475,9 @@ cupsdFreeLocation(cupsd_location_t *loc)/* I - Location to free */
   cupsArrayDelete(loc->allow);
   cupsArrayDelete(loc->deny);
 
+  free_authtree(loc->allow_tree);
+  free_authtree(loc->deny_tree);
+
   _cupsStrFree(loc->location);
   free(loc);
 }
@@ -1865,6 +1852,59 @@ cupsdNewLocation(const char *location)	/* I - Location path */
 }
 
 
+/*
+ * 'add_location()' - Add a location to a location trie.
+ */
+
+static void
+add_location(cupsd_locnode_t  *trie,	/* I - Root of trie */
+             cupsd_location_t *loc,	/* I - Location */
+	     int              fold)	/* I - Fold case? */
+{
+  const char		*ptr;		/* Pointer into location */
+  int			ch;		/* Current character */
+  cupsd_locnode_t	*node,		/* Current node */
+			*child;		/* Child node */
+
+
+  for (node = trie, ptr = loc->location; *ptr; ptr ++)
+  {
+    ch = fold ? _cups_tolower(*ptr & 255) : (*ptr & 255);
+
+    for (child = node->child; child; child = child->next)
+      if (child->ch == ch)
+        break;
+
+    if (!child)
+    {
+      if ((child = calloc(1, sizeof(cupsd_locnode_t))) == NULL)
+      {
+        cupsdLogMessage(CUPSD_LOG_ERROR,
+	                "Unable to allocate memory for location \"%s\".",
+			loc->location);
+        return;
+      }
+
+      child->ch   = ch;
+      child->next = node->child;
+      node->child = child;
+    }
+
+    node = child;
+  }
+
+ /*
+  * Locations are added in configuration order, so the first one added at a
+  * node wins just like the first longest match did with the linear search...
+  */
+
+  if (!node->locs)
+    node->locs = cupsArrayNew(NULL, NULL);
+
+  cupsArrayAdd(node->locs, loc);
+}
+
+
 #ifdef HAVE_AUTHORIZATION_H
 /*
  * 'check_authref()' - Check if an authorization services reference has the
@@ -1916,6 +1956,154 @@ check_authref(cupsd_client_t *con,	/* I - Connection */
 #endif /* HAVE_AUTHORIZATION_H */
 
 
+/*
+ * 'check_group()' - Check the system group membership for a user.
+ */
+
+static int				/* O - 1 if user is a member, 0 otherwise */
+check_group(
+    const char    *username,		/* I - User name */
+    struct passwd *user,		/* I - System user info */
+    const char    *groupname)		/* I - Group name */
+{
+  int		i;			/* Looping var */
+  struct group	*group;			/* System group info */
+#ifdef HAVE_MBR_UID_TO_UUID
+  uuid_t	useruuid,		/* UUID for username */
+		groupuuid;		/* UUID for groupname */
+  int		is_member;		/* True if user is a member of group */
+#endif /* HAVE_MBR_UID_TO_UUID */
+
+
+ /*
+  * Check to see if the user is a member of the named group...
+  */
+
+  group = getgrnam(groupname);
+
+  if (group != NULL)
+  {
+   /*
+    * Group exists, check it...
+    */
+
+    for (i = 0; group->gr_mem[i]; i ++)
+      if (!_cups_strcasecmp(username, group->gr_mem[i]))
+	return (1);
+  }
+
+ /*
+  * Group doesn't exist or user not in group list, check the group ID
+  * against the user's group ID...
+  */
+
+  if (user && group && group->gr_gid == user->pw_gid)
+    return (1);
+
+#ifdef HAVE_MBR_UID_TO_UUID
+ /*
+  * Check group membership through MacOS X membership API...
+  */
+
+  if (user && !mbr_uid_to_uuid(user->pw_uid, useruuid))
+  {
+    if (group)
+    {
+     /*
+      * Map group name to UUID and check membership...
+      */
+
+      if (!mbr_gid_to_uuid(group->gr_gid, groupuuid))
+        if (!mbr_check_membership(useruuid, groupuuid, &is_member))
+	  if (is_member)
+	    return (1);
+    }
+    else if (groupname[0] == '#')
+    {
+     /*
+      * Use UUID directly and check for equality (user UUID) and
+      * membership (group UUID)...
+      */
+
+      if (!uuid_parse((char *)groupname + 1, groupuuid))
+      {
+        if (!uuid_compare(useruuid, groupuuid))
+	  return (1);
+	else if (!mbr_check_membership(useruuid, groupuuid, &is_member))
+	  if (is_member)
+	    return (1);
+      }
+
+      return (0);
+    }
+  }
+  else if (groupname[0] == '#')
+    return (0);
+#endif /* HAVE_MBR_UID_TO_UUID */
+
+ /*
+  * If we get this far, then the user isn't part of the named group...
+  */
+
+  return (0);
+}
+
+
+/*
+ * 'check_masks()' - Check Allow/Deny masks using a compiled tree.
+ */
+
+static int				/* O - 1 if mask matches, 0 otherwise */
+check_masks(unsigned         ip[4],	/* I - Client address */
+	    const char       *name,	/* I - Client hostname */
+	    size_t           namelen,	/* I - Length of hostname */
+	    cups_array_t     *masks,	/* I - Masks */
+	    cupsd_authtree_t **tree)	/* IO - Compiled masks */
+{
+  int			bit;		/* Current address bit */
+  cupsd_ipnode_t	*node;		/* Current node */
+
+
+  if (!masks)
+    return (0);
+
+ /*
+  * (Re)compile the masks as needed; masks are only ever appended, so the
+  * count tells us whether the tree is current...
+  */
+
+  if (!*tree || (*tree)->count != cupsArrayCount(masks))
+  {
+    free_authtree(*tree);
+    *tree = compile_masks(masks);
+  }
+
+  if (!*tree)
+    return (cupsdCheckAuth(ip, name, namelen, masks));
+
+ /*
+  * Walk the radix tree using the IPv6 (or IPv4-mapped) address bits...
+  */
+
+  for (node = (*tree)->ip, bit = 0; node; bit ++)
+  {
+    if (node->match)
+      return (1);
+
+    if (bit >= 128)
+      break;
+
+    node = node->child[(ip[bit / 32] >> (31 - bit % 32)) & 1];
+  }
+
+ /*
+  * Then check any names and interfaces...
+  */
+
+  return (cupsdCheckAuth(ip, name, namelen, (*tree)->others));
+}
+
+
 /*
  * 'compare_locations()' - Compare two locations.
  */
@@ -1928,6 +2116,125 @@ compare_locations(cupsd_location_t *a,	/* I - First location */
 }
 
 
+/*
+ * 'compile_locations()' - Build the location tries.
+ */
+
+static void
+compile_locations(void)
+{
+  cupsd_location_t	*loc;		/* Current location */
+
+
+  free_locnode(loc_trie);
+  free_locnode(loc_ftrie);
+
+  loc_trie     = calloc(1, sizeof(cupsd_locnode_t));
+  loc_ftrie    = calloc(1, sizeof(cupsd_locnode_t));
+  loc_compiled = 1;
+
+  if (!loc_trie || !loc_ftrie)
+    return;
+
+  for (loc = (cupsd_location_t *)cupsArrayFirst(Locations);
+       loc;
+       loc = (cupsd_location_t *)cupsArrayNext(Locations))
+    if (loc->location && loc->location[0] == '/')
+    {
+      add_location(loc_trie, loc, 0);
+      add_location(loc_ftrie, loc, 1);
+    }
+}
+
+
+/*
+ * 'compile_masks()' - Compile Allow/Deny masks into a radix tree.
+ */
+
+static cupsd_authtree_t	*		/* O - Compiled masks */
+compile_masks(cups_array_t *masks)	/* I - Masks */
+{
+  int			i,		/* Looping var */
+			bits,		/* Prefix length */
+			bit;		/* Current bit */
+  unsigned		hostbits;	/* Bits outside prefix */
+  cupsd_authmask_t	*mask;		/* Current mask */
+  cupsd_authtree_t	*tree;		/* Compiled masks */
+  cupsd_ipnode_t	**node;		/* Current node */
+
+
+  if ((tree = calloc(1, sizeof(cupsd_authtree_t))) == NULL)
+    return (NULL);
+
+  tree->count = cupsArrayCount(masks);
+
+  for (mask = (cupsd_authmask_t *)cupsArrayFirst(masks);
+       mask;
+       mask = (cupsd_authmask_t *)cupsArrayNext(masks))
+  {
+    if (mask->type == CUPSD_AUTH_IP)
+    {
+     /*
+      * Get the prefix length of the netmask; only contiguous netmasks can go in
+      * the tree...
+      */
+
+      for (bits = 0; bits < 128; bits ++)
+        if (!((mask->mask.ip.netmask[bits / 32] >> (31 - bits % 32)) & 1))
+	  break;
+
+      for (bit = bits, hostbits = 0; bit < 128; bit ++)
+        hostbits |= (mask->mask.ip.netmask[bit / 32] >> (31 - bit % 32)) & 1;
+
+      if (!hostbits)
+      {
+       /*
+        * An address with bits outside the netmask can never match...
+	*/
+
+        for (i = 0, hostbits = 0; i < 4; i ++)
+	  hostbits |= mask->mask.ip.address[i] & ~mask->mask.ip.netmask[i];
+
+        if (hostbits)
+	  continue;
+
+        for (node = &tree->ip, bit = 0; ; bit ++)
+	{
+	  if (!*node && (*node = calloc(1, sizeof(cupsd_ipnode_t))) == NULL)
+	  {
+	    free_authtree(tree);
+	    return (NULL);
+	  }
+
+	  if (bit >= bits)
+	    break;
+
+	  node = (*node)->child +
+	         ((mask->mask.ip.address[bit / 32] >> (31 - bit % 32)) & 1);
+	}
+
+        (*node)->match = 1;
+	continue;
+      }
+    }
+
+   /*
+    * Names, interfaces, and non-contiguous netmasks are checked the slow way...
+    */
+
+    if (!tree->others && (tree->others = cupsArrayNew(NULL, NULL)) == NULL)
+    {
+      free_authtree(tree);
+      return (NULL);
+    }
+
+    cupsArrayAdd(tree->others, mask);
+  }
+
+  return (tree);
+}
+
+
 /*
  * 'copy_authmask()' - Copy function for auth masks.
  */
@@ -1983,6 +2290,47 @@ cups_crypt(const char *pw,		/* I - Password string */
 #endif /* !HAVE_LIBPAM */
 
 
+/*
+ * 'find_location()' - Find the longest matching location in a trie.
+ */
+
+static cupsd_location_t	*		/* O - Location or NULL */
+find_location(cupsd_locnode_t *trie,	/* I - Root of trie */
+              const char      *uri,	/* I - URI path */
+	      int             limit,	/* I - Limit bits */
+	      int             fold)	/* I - Fold case? */
+{
+  int			ch;		/* Current character */
+  cupsd_locnode_t	*node;		/* Current node */
+  cupsd_location_t	*loc,		/* Current location */
+			*best = NULL;	/* Best match so far */
+
+
+  for (node = trie; node && *uri; uri ++)
+  {
+    ch = fold ? _cups_tolower(*uri & 255) : (*uri & 255);
+
+    for (node = node->child; node; node = node->next)
+      if (node->ch == ch)
+        break;
+
+    if (!node)
+      break;
+
+    for (loc = (cupsd_location_t *)cupsArrayFirst(node->locs);
+         loc;
+	 loc = (cupsd_location_t *)cupsArrayNext(node->locs))
+      if (limit & loc->limit)
+      {
+        best = loc;
+	break;
+      }
+  }
+
+  return (best);
+}
+
+
 /*
  * 'free_authmask()' - Free function for auth masks.
  */
@@ -2000,6 +2348,59 @@ free_authmask(cupsd_authmask_t *mask,	/* I - Auth mask to free */
 }
 
 
+/*
+ * 'free_authtree()' - Free compiled Allow/Deny masks.
+ */
+
+static void
+free_authtree(cupsd_authtree_t *tree)	/* I - Compiled masks */
+{
+  if (!tree)
+    return;
+
+  free_ipnode(tree->ip);
+  cupsArrayDelete(tree->others);
+  free(tree);
+}
+
+
+/*
+ * 'free_ipnode()' - Free a radix tree node and its children.
+ */
+
+static void
+free_ipnode(cupsd_ipnode_t *node)	/* I - Node */
+{
+  if (!node)
+    return;
+
+  free_ipnode(node->child[0]);
+  free_ipnode(node->child[1]);
+  free(node);
+}
+
+
+/*
+ * 'free_locnode()' - Free a location trie node, its siblings, and children.
+ */
+
+static void
+free_locnode(cupsd_locnode_t *node)	/* I - Node */
+{
+  cupsd_locnode_t	*next;		/* Next sibling */
+
+
+  for (; node; node = next)
+  {
+    next = node->next;
+
+    free_locnode(node->child);
+    cupsArrayDelete(node->locs);
+    free(node);
+  }
+}
+
+
 #if HAVE_LIBPAM
 /*
  * 'pam_func()' - PAM conversation function.
@@ -100,6 +100,8 @@ typedef struct
 			*allow,		/* Allow lines */
 			*deny;		/* Deny lines */
   http_encryption_t	encryption;	/* To encrypt or not to encrypt... */
+  struct cupsd_authtree_s *allow_tree,	/* Compiled allow lines */
+			*deny_tree;	/* Compiled deny lines */
 } cupsd_location_t;
 
 typedef struct cupsd_client_s cupsd_client_t;
@@ -141,6 +143,19 @@ extern void		cupsdFreeLocation(cupsd_location_t *loc);
 extern http_status_t	cupsdIsAuthorized(cupsd_client_t *con, const char *owner);
 extern cupsd_location_t	*cupsdNewLocation(const char *location);
 
+/* authcache.c */
+extern void		cupsdAddAuthCache(const char *username,
+			                  const char *password, int timeout);
+extern void		cupsdAddGroupCache(const char *username,
+			                   const char *groupname,
+					   int is_member, int timeout);
+extern int		cupsdCheckAuthCache(const char *username,
+			                    const char *password);
+extern int		cupsdCheckGroupCache(const char *username,
+			                     const char *groupname,
+					     int *is_member);
+extern void		cupsdFlushAuthCache(void);
+
 
 /*
  * End of "$Id: auth.h 11776 2014-03-28 19:16:05Z msweet $".
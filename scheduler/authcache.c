@@ -0,0 +1,341 @@
+/*
+ * "$Id$"
+ *
+ * Authentication and group membership caches for the CUPS scheduler.
+ *
+ * Copyright 2007-2016 by Apple Inc.
+ *
+ * These coded instructions, statements, and computer programs are the
+ * property of Apple Inc. and are protected by Federal copyright
+ * law.  Distribution and use rights are outlined in the file "LICENSE.txt"
+ * which should have been included with this file.  If this file is
+ * file is missing or damaged, see the license at "http://www.cups.org/".
+ *
+ * Passwords are never stored.  Each credential cache entry holds a keyed
+ * MD5 (HMAC) digest of the username and password, using a random key that is
+ * regenerated whenever the cache is flushed.  Digests are compared in constant
+ * time.  Only successful authentications are cached, so a wrong password
+ * always goes through the full (slow) authentication path.
+ */
+
+/*
+ * Include necessary headers...
+ */
+
+#include "cupsd.h"
+#include <cups/md5-private.h>
+
+
+/*
+ * Constants...
+ */
+
+#define CUPSD_AUTH_CACHE_SIZE	64	/* Maximum number of credentials */
+#define CUPSD_GROUP_CACHE_SIZE	256	/* Maximum number of group results */
+#define CUPSD_AUTH_KEY_SIZE	64	/* HMAC key/block size */
+
+
+/*
+ * Types...
+ */
+
+typedef struct cupsd_authcache_s	/**** Cached credentials ****/
+{
+  char		username[HTTP_MAX_VALUE];
+					/* Username */
+  unsigned char	digest[16];		/* Keyed digest of username/password */
+  time_t	expire;			/* Expiration time, 0 if unused */
+} cupsd_authcache_t;
+
+typedef struct cupsd_groupcache_s	/**** Cached group membership ****/
+{
+  char		username[HTTP_MAX_VALUE],
+					/* Username */
+		groupname[256];		/* Group name */
+  int		is_member;		/* Non-zero if user is a member */
+  time_t	expire;			/* Expiration time, 0 if unused */
+} cupsd_groupcache_t;
+
+
+/*
+ * Local globals...
+ */
+
+static cupsd_authcache_t	auth_cache[CUPSD_AUTH_CACHE_SIZE];
+					/* Credential cache */
+static cupsd_groupcache_t	group_cache[CUPSD_GROUP_CACHE_SIZE];
+					/* Group membership cache */
+static unsigned char	auth_key[CUPSD_AUTH_KEY_SIZE];
+					/* Random HMAC key */
+static int		auth_key_set = 0;
+					/* Has the key been generated? */
+
+
+/*
+ * Local functions...
+ */
+
+static void	auth_digest(const char *username, const char *password,
+		            unsigned char digest[16]);
+static void	init_key(void);
+
+
+/*
+ * 'cupsdAddAuthCache()' - Add successfully authenticated credentials.
+ */
+
+void
+cupsdAddAuthCache(const char *username,	/* I - Username */
+                  const char *password,	/* I - Password */
+		  int        timeout)	/* I - Time to live in seconds */
+{
+  int			i;		/* Looping var */
+  time_t		curtime;	/* Current time */
+  cupsd_authcache_t	*entry,		/* Current entry */
+			*oldest;	/* Entry to replace */
+
+
+  if (timeout <= 0 || !username || !password ||
+      strlen(username) >= sizeof(auth_cache[0].username))
+    return;
+
+  curtime = time(NULL);
+
+ /*
+  * Reuse the entry for this user if there is one, otherwise the first unused
+  * or expired entry, otherwise the entry that expires first...
+  */
+
+  for (i = 0, entry = auth_cache, oldest = auth_cache;
+       i < CUPSD_AUTH_CACHE_SIZE;
+       i ++, entry ++)
+  {
+    if (entry->expire && !strcmp(entry->username, username))
+    {
+      oldest = entry;
+      break;
+    }
+
+    if (entry->expire < oldest->expire)
+      oldest = entry;
+  }
+
+  strlcpy(oldest->username, username, sizeof(oldest->username));
+  auth_digest(username, password, oldest->digest);
+  oldest->expire = curtime + timeout;
+}
+
+
+/*
+ * 'cupsdAddGroupCache()' - Add a group membership result.
+ */
+
+void
+cupsdAddGroupCache(
+    const char *username,		/* I - Username */
+    const char *groupname,		/* I - Group name */
+    int        is_member,		/* I - Non-zero if user is a member */
+    int        timeout)			/* I - Time to live in seconds */
+{
+  int			i;		/* Looping var */
+  time_t		curtime;	/* Current time */
+  cupsd_groupcache_t	*entry,		/* Current entry */
+			*oldest;	/* Entry to replace */
+
+
+  if (timeout <= 0 || !username || !groupname ||
+      strlen(username) >= sizeof(group_cache[0].username) ||
+      strlen(groupname) >= sizeof(group_cache[0].groupname))
+    return;
+
+  curtime = time(NULL);
+
+  for (i = 0, entry = group_cache, oldest = group_cache;
+       i < CUPSD_GROUP_CACHE_SIZE;
+       i ++, entry ++)
+  {
+    if (entry->expire && !strcmp(entry->username, username) &&
+        !strcmp(entry->groupname, groupname))
+    {
+      oldest = entry;
+      break;
+    }
+
+    if (entry->expire < oldest->expire)
+      oldest = entry;
+  }
+
+  strlcpy(oldest->username, username, sizeof(oldest->username));
+  strlcpy(oldest->groupname, groupname, sizeof(oldest->groupname));
+  oldest->is_member = is_member;
+  oldest->expire    = curtime + timeout;
+}
+
+
+/*
+ * 'cupsdCheckAuthCache()' - Check for cached credentials.
+ */
+
+int					/* O - 1 if credentials match, 0 otherwise */
+cupsdCheckAuthCache(
+    const char *username,		/* I - Username */
+    const char *password)		/* I - Password */
+{
+  int			i, j;		/* Looping vars */
+  time_t		curtime;	/* Current time */
+  cupsd_authcache_t	*entry;		/* Current entry */
+  unsigned char		digest[16],	/* Digest of supplied credentials */
+			diff;		/* Difference between digests */
+
+
+  if (!auth_key_set || !username || !password)
+    return (0);
+
+  auth_digest(username, password, digest);
+
+  curtime = time(NULL);
+
+  for (i = 0, entry = auth_cache; i < CUPSD_AUTH_CACHE_SIZE; i ++, entry ++)
+  {
+    if (entry->expire <= curtime || strcmp(entry->username, username))
+      continue;
+
+   /*
+    * Compare all bytes so that the time taken does not depend on how much of
+    * the digest matches...
+    */
+
+    for (j = 0, diff = 0; j < (int)sizeof(digest); j ++)
+      diff |= (unsigned char)(digest[j] ^ entry->digest[j]);
+
+    return (diff == 0);
+  }
+
+  return (0);
+}
+
+
+/*
+ * 'cupsdCheckGroupCache()' - Check for a cached group membership result.
+ */
+
+int					/* O - 1 if found, 0 otherwise */
+cupsdCheckGroupCache(
+    const char *username,		/* I - Username */
+    const char *groupname,		/* I - Group name */
+    int        *is_member)		/* O - Non-zero if user is a member */
+{
+  int			i;		/* Looping var */
+  time_t		curtime;	/* Current time */
+  cupsd_groupcache_t	*entry;		/* Current entry */
+
+
+  if (!username || !groupname)
+    return (0);
+
+  curtime = time(NULL);
+
+  for (i = 0, entry = group_cache; i < CUPSD_GROUP_CACHE_SIZE; i ++, entry ++)
+    if (entry->expire > curtime && !strcmp(entry->username, username) &&
+        !strcmp(entry->groupname, groupname))
+    {
+      *is_member = entry->is_member;
+      return (1);
+    }
+
+  return (0);
+}
+
+
+/*
+ * 'cupsdFlushAuthCache()' - Flush the authentication and group caches.
+ */
+
+void
+cupsdFlushAuthCache(void)
+{
+  memset(auth_cache, 0, sizeof(auth_cache));
+  memset(group_cache, 0, sizeof(group_cache));
+
+  init_key();
+}
+
+
+/*
+ * 'auth_digest()' - Compute the keyed digest of a username/password.
+ */
+
+static void
+auth_digest(const char    *username,	/* I - Username */
+            const char    *password,	/* I - Password */
+	    unsigned char digest[16])	/* O - HMAC-MD5 digest */
+{
+  int			i;		/* Looping var */
+  unsigned char		pad[CUPSD_AUTH_KEY_SIZE];
+					/* Inner/outer key pad */
+  _cups_md5_state_t	state;		/* MD5 state */
+
+
+  if (!auth_key_set)
+    init_key();
+
+  for (i = 0; i < CUPSD_AUTH_KEY_SIZE; i ++)
+    pad[i] = auth_key[i] ^ 0x36;
+
+  _cupsMD5Init(&state);
+  _cupsMD5Append(&state, pad, CUPSD_AUTH_KEY_SIZE);
+  _cupsMD5Append(&state, (const unsigned char *)username,
+                 (int)strlen(username) + 1);
+  _cupsMD5Append(&state, (const unsigned char *)password,
+                 (int)strlen(password));
+  _cupsMD5Finish(&state, digest);
+
+  for (i = 0; i < CUPSD_AUTH_KEY_SIZE; i ++)
+    pad[i] = auth_key[i] ^ 0x5c;
+
+  _cupsMD5Init(&state);
+  _cupsMD5Append(&state, pad, CUPSD_AUTH_KEY_SIZE);
+  _cupsMD5Append(&state, digest, 16);
+  _cupsMD5Finish(&state, digest);
+}
+
+
+/*
+ * 'init_key()' - Create a new random key for the cache.
+ */
+
+static void
+init_key(void)
+{
+  int		i,			/* Looping var */
+		fd;			/* /dev/urandom file */
+  ssize_t	bytes = 0;		/* Bytes read */
+  struct timeval tod;			/* Time of day */
+
+
+  if ((fd = open("/dev/urandom", O_RDONLY)) >= 0)
+  {
+    bytes = read(fd, auth_key, sizeof(auth_key));
+    close(fd);
+  }
+
+  if (bytes != (ssize_t)sizeof(auth_key))
+  {
+   /*
+    * Fall back on the pseudo-random number generator...
+    */
+
+    gettimeofday(&tod, NULL);
+    CUPS_SRAND((unsigned)(tod.tv_sec + tod.tv_usec + getpid()));
+
+    for (i = 0; i < CUPSD_AUTH_KEY_SIZE; i ++)
+      auth_key[i] = (unsigned char)CUPS_RAND();
+  }
+
+  auth_key_set = 1;
+}
+
+
+/*
+ * End of "$Id$".
+ */
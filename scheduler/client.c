@@ -32,469 +32,283 @@
 #endif /* HAVE_TCPD_H */
 
 
+/*
+ * Local constants...
+ */
+
+#define CUPSD_IDLE_DELAY	2	/* Seconds before a waiting client is
+					 * demoted to the idle list */
+#define CUPSD_COMPRESS_ATTRS	256	/* Attributes per compressed write */
+#define CUPSD_CGI_MAX_ENV	262144	/* Maximum size of worker request */
+
+
+/*
+ * Local globals...
+ */
+
+static cups_array_t	*cgi_workers = NULL;
+					/* Persistent CGI workers */
+
+
 /*
  * Local functions...
  */
 
+static int		accept_client(cupsd_listener_t *lis);
 static int		check_if_modified(cupsd_client_t *con,
 			                  struct stat *filestats);
+static void		check_timeout(cupsd_client_t *con);
 static int		compare_clients(cupsd_client_t *a, cupsd_client_t *b,
 			                void *data);
 #ifdef HAVE_SSL
 static int		cupsd_start_tls(cupsd_client_t *con, http_encryption_t e);
 #endif /* HAVE_SSL */
+static int		demote_client(cupsd_client_t *con);
+static cupsd_cgi_t	*get_cgi_worker(const char *command);
+static char		*get_etag(struct stat *filestats, char *etag,
+			          size_t etagsize);
 static char		*get_file(cupsd_client_t *con, struct stat *filestats,
 			          char *filename, size_t len);
+static int		get_gzip_file(cupsd_client_t *con, char *filename,
+			              size_t len, struct stat *filestats,
+				      int *vary);
 static http_status_t	install_cupsd_conf(cupsd_client_t *con);
 static int		is_cgi(cupsd_client_t *con, const char *filename,
 		               struct stat *filestats, mime_type_t *type);
 static int		is_path_absolute(const char *path);
 static int		pipe_command(cupsd_client_t *con, int infile, int *outfile,
 			             char *command, char *options, int root);
+static int		promote_client(cupsd_client_t *con);
+static int		send_cgi_request(cupsd_cgi_t *worker, int infile,
+			                 int outfile, char *envp[]);
+static cupsd_cgi_t	*start_cgi_worker(const char *command);
+static void		stop_cgi_worker(cupsd_cgi_t *worker, int kill);
+static void		update_cgi_worker(cupsd_cgi_t *worker);
 static int		valid_host(cupsd_client_t *con);
 static int		write_file(cupsd_client_t *con, http_status_t code,
 		        	   char *filename, char *type,
-				   struct stat *filestats);
+				   struct stat *filestats,
+				   const char *encoding, int vary);
+static int		write_metrics(cupsd_client_t *con, char *filename,
+			              size_t len, struct stat *filestats);
 static void		write_pipe(cupsd_client_t *con);
 
 
 /*
- * 'cupsdAcceptClient()' - Accept a new client.
+ * 'cupsdAcceptClient()' - Accept new clients.
  */
 
 void
 cupsdAcceptClient(cupsd_listener_t *lis)/* I - Listener socket */
 {
-  const char		*hostname;	/* Hostname of client */
-  char			name[256];	/* Hostname of client */
-  int			count;		/* Count of connections on a host */
-  cupsd_client_t	*con,		/* New client pointer */
-			*tempcon;	/* Temporary client pointer */
-  socklen_t		addrlen;	/* Length of address */
-  http_addr_t		temp;		/* Temporary address variable */
-  static time_t		last_dos = 0;	/* Time of last DoS attack */
-#ifdef HAVE_TCPD_H
-  struct request_info	wrap_req;	/* TCP wrappers request information */
-#endif /* HAVE_TCPD_H */
-
-
   cupsdLogMessage(CUPSD_LOG_DEBUG2, "cupsdAcceptClient(lis=%p(%d)) Clients=%d", lis, lis->fd, cupsArrayCount(Clients));
 
  /*
-  * Make sure we don't have a full set of clients already...
+  * Drain the backlog of pending connections; the listening socket is
+  * non-blocking, so accept() fails with EAGAIN once it is empty...
   */
 
-  if (cupsArrayCount(Clients) == MaxClients)
-    return;
+  while (accept_client(lis));
+}
 
- /*
-  * Get a pointer to the next available client...
-  */
 
-  if (!Clients)
-    Clients = cupsArrayNew(NULL, NULL);
+/*
+ * 'cupsdClientCount()' - Return the number of client connections.
+ */
 
-  if (!Clients)
-  {
-    cupsdLogMessage(CUPSD_LOG_ERROR,
-                    "Unable to allocate memory for clients array!");
-    cupsdPauseListening();
-    return;
-  }
+int					/* O - Number of clients */
+cupsdClientCount(void)
+{
+  return (cupsArrayCount(Clients) + cupsArrayCount(IdleClients));
+}
 
-  if (!ActiveClients)
-    ActiveClients = cupsArrayNew((cups_array_func_t)compare_clients, NULL);
 
-  if (!ActiveClients)
-  {
-    cupsdLogMessage(CUPSD_LOG_ERROR,
-                    "Unable to allocate memory for active clients array!");
-    cupsdPauseListening();
-    return;
-  }
+/*
+ * 'cupsdClientReady()' - Return whether a client has buffered input to read.
+ *
+ * Pipelined requests stay in the input buffer while the current response is
+ * being sent; they are read once the client is back in the waiting state.
+ */
 
-  if ((con = calloc(1, sizeof(cupsd_client_t))) == NULL)
-  {
-    cupsdLogMessage(CUPSD_LOG_ERROR, "Unable to allocate memory for client!");
-    cupsdPauseListening();
-    return;
-  }
+int					/* O - 1 if ready, 0 otherwise */
+cupsdClientReady(cupsd_client_t *con)	/* I - Client connection */
+{
+  http_state_t	state;			/* HTTP state */
 
- /*
-  * Accept the client and get the remote address...
-  */
 
-  con->number = ++ LastClientNumber;
-  con->file   = -1;
+  if (!httpGetReady(con->http))
+    return (0);
 
-  if ((con->http = httpAcceptConnection(lis->fd, 0)) == NULL)
-  {
-    if (errno == ENFILE || errno == EMFILE)
-      cupsdPauseListening();
+  state = httpGetState(con->http);
 
-    cupsdLogMessage(CUPSD_LOG_ERROR, "Unable to accept client connection - %s.",
-                    strerror(errno));
-    free(con);
+  return (state != HTTP_STATE_GET_SEND && state != HTTP_STATE_POST_SEND &&
+          state != HTTP_STATE_STATUS);
+}
 
-    return;
-  }
 
- /*
-  * Save the connected address and port number...
-  */
+/*
+ * 'cupsdCloseAllClients()' - Close all remote clients immediately.
+ */
 
-  con->clientaddr = lis->address;
+void
+cupsdCloseAllClients(void)
+{
+  cupsd_client_t	*con;		/* Current client */
+
+
+  cupsdLogMessage(CUPSD_LOG_DEBUG2, "cupsdCloseAllClients() Clients=%d, IdleClients=%d", cupsArrayCount(Clients), cupsArrayCount(IdleClients));
+
+  for (con = (cupsd_client_t *)cupsArrayFirst(Clients);
+       con;
+       con = (cupsd_client_t *)cupsArrayNext(Clients))
+    if (cupsdCloseClient(con))
+      cupsdCloseClient(con);
+
+  for (con = (cupsd_client_t *)cupsArrayFirst(IdleClients);
+       con;
+       con = (cupsd_client_t *)cupsArrayNext(IdleClients))
+    cupsdCloseClient(con);
+}
+
+
+/*
+ * 'cupsdCloseClient()' - Close a remote client.
+ */
+
+int					/* O - 1 if partial close, 0 if fully closed */
+cupsdCloseClient(cupsd_client_t *con)	/* I - Client to close */
+{
+  int		partial,		/* Do partial close for SSL? */
+		idle;			/* Idle client? */
+
+
+  cupsdLogClient(con, CUPSD_LOG_DEBUG, "Closing connection.");
 
  /*
-  * Check the number of clients on the same address...
+  * Flush pending writes before closing...
   */
 
-  for (count = 0, tempcon = (cupsd_client_t *)cupsArrayFirst(Clients);
-       tempcon;
-       tempcon = (cupsd_client_t *)cupsArrayNext(Clients))
-    if (httpAddrEqual(httpGetAddress(tempcon->http), httpGetAddress(con->http)))
-    {
-      count ++;
-      if (count >= MaxClientsPerHost)
-	break;
-    }
+  httpFlushWrite(con->http);
 
-  if (count >= MaxClientsPerHost)
+  partial = 0;
+  idle    = !con->http;
+
+  if (con->pipe_pid != 0)
   {
-    if ((time(NULL) - last_dos) >= 60)
+   /*
+    * Stop any CGI process; a worker in the middle of a request cannot be
+    * reused.  Detach the worker first so that stopping it does not close
+    * this client again...
+    */
+
+    if (con->pipe_worker)
     {
-      last_dos = time(NULL);
-      cupsdLogMessage(CUPSD_LOG_WARN,
-                      "Possible DoS attack - more than %d clients connecting "
-		      "from %s.",
-	              MaxClientsPerHost,
-		      httpGetHostname(con->http, name, sizeof(name)));
+      cupsd_cgi_t *worker = con->pipe_worker;
+					/* CGI worker */
+
+      con->pipe_worker = NULL;
+      stop_cgi_worker(worker, 1);
     }
+    else
+      cupsdEndProcess(con->pipe_pid, 1);
 
-    httpClose(con->http);
-    free(con);
-    return;
+    con->pipe_pid = 0;
+  }
+
+  if (con->file >= 0)
+  {
+    cupsdRemoveSelect(con->file);
+
+    close(con->file);
+    con->file = -1;
   }
 
  /*
-  * Get the hostname or format the IP address as needed...
+  * Close the socket and clear the file from the input set for select()...
   */
 
-  if (HostNameLookups)
-    hostname = httpResolveHostname(con->http, NULL, 0);
-  else
-    hostname = httpGetHostname(con->http, NULL, 0);
-
-  if (hostname == NULL && HostNameLookups == 2)
+  if (idle)
   {
    /*
-    * Can't have an unresolved IP address with double-lookups enabled...
+    * Idle clients only have the bare socket...
     */
 
-    httpClose(con->http);
-
-    cupsdLogClient(con, CUPSD_LOG_WARN,
-                    "Name lookup failed - connection from %s closed!",
-                    httpGetHostname(con->http, NULL, 0));
+    cupsdRemoveSelect(con->idle_fd);
+    close(con->idle_fd);
+    con->idle_fd = -1;
 
-    free(con);
-    return;
+    cupsdClearString(&con->idle_hostname);
   }
-
-  if (HostNameLookups == 2)
+  else if (httpGetFd(con->http) >= 0)
   {
+    cupsArrayRemove(ActiveClients, con);
+    cupsdSetBusyState();
+
+#ifdef HAVE_SSL
    /*
-    * Do double lookups as needed...
+    * Shutdown encryption as needed...
     */
 
-    http_addrlist_t	*addrlist,	/* List of addresses */
-			*addr;		/* Current address */
+    if (httpIsEncrypted(con->http))
+      partial = 1;
+#endif /* HAVE_SSL */
 
-    if ((addrlist = httpAddrGetList(hostname, AF_UNSPEC, NULL)) != NULL)
+    if (partial)
     {
      /*
-      * See if the hostname maps to the same IP address...
+      * Only do a partial close so that the encrypted client gets everything.
       */
 
-      for (addr = addrlist; addr; addr = addr->next)
-        if (httpAddrEqual(httpGetAddress(con->http), &(addr->addr)))
-          break;
-    }
-    else
-      addr = NULL;
+      httpShutdown(con->http);
+      cupsdAddSelect(httpGetFd(con->http), (cupsd_selfunc_t)cupsdReadClient,
+                     NULL, con);
 
-    httpAddrFreeList(addrlist);
+     /*
+      * Finish the close if the client never closes its end; the timer may
+      * have just fired to get us here...
+      */
 
-    if (!addr)
+      cupsdSetTimer(&con->timer, time(NULL) + Timeout,
+                    (cupsd_timerfunc_t)check_timeout, con);
+
+      cupsdLogClient(con, CUPSD_LOG_DEBUG, "Waiting for socket close.");
+    }
+    else
     {
      /*
-      * Can't have a hostname that doesn't resolve to the same IP address
-      * with double-lookups enabled...
+      * Shut the socket down fully...
       */
 
+      cupsdRemoveSelect(httpGetFd(con->http));
       httpClose(con->http);
-
-      cupsdLogClient(con, CUPSD_LOG_WARN,
-                      "IP lookup failed - connection from %s closed!",
-                      httpGetHostname(con->http, NULL, 0));
-      free(con);
-      return;
+      con->http = NULL;
     }
   }
 
-#ifdef HAVE_TCPD_H
- /*
-  * See if the connection is denied by TCP wrappers...
-  */
+  if (!partial)
+  {
+   /*
+    * Free memory...
+    */
 
-  request_init(&wrap_req, RQ_DAEMON, "cupsd", RQ_FILE, httpGetFd(con->http),
-               NULL);
-  fromhost(&wrap_req);
+    cupsdRemoveSelect(httpGetFd(con->http));
 
-  if (!hosts_access(&wrap_req))
-  {
     httpClose(con->http);
 
-    cupsdLogClient(con, CUPSD_LOG_WARN,
-                    "Connection from %s refused by /etc/hosts.allow and "
-		    "/etc/hosts.deny rules.", httpGetHostname(con->http, NULL, 0));
-    free(con);
-    return;
-  }
-#endif /* HAVE_TCPD_H */
+    if (con->filename)
+    {
+      unlink(con->filename);
+      cupsdClearString(&con->filename);
+    }
 
-#ifdef AF_LOCAL
-  if (httpAddrFamily(httpGetAddress(con->http)) == AF_LOCAL)
-  {
-#  ifdef __APPLE__
-    socklen_t	peersize;		/* Size of peer credentials */
-    pid_t	peerpid;		/* Peer process ID */
-    char	peername[256];		/* Name of process */
+    cupsdClearString(&con->command);
+    cupsdClearString(&con->options);
+    cupsdClearString(&con->query_string);
 
-    peersize = sizeof(peerpid);
-    if (!getsockopt(httpGetFd(con->http), SOL_LOCAL, LOCAL_PEERPID, &peerpid,
-                    &peersize))
+    if (con->request)
     {
-      if (!proc_name((int)peerpid, peername, sizeof(peername)))
-	cupsdLogClient(con, CUPSD_LOG_DEBUG,
-	               "Accepted from %s (Domain ???[%d])",
-                       httpGetHostname(con->http, NULL, 0), (int)peerpid);
-      else
-	cupsdLogClient(con, CUPSD_LOG_DEBUG,
-                       "Accepted from %s (Domain %s[%d])",
-                       httpGetHostname(con->http, NULL, 0), peername, (int)peerpid);
-    }
-    else
-#  endif /* __APPLE__ */
-
-    cupsdLogClient(con, CUPSD_LOG_DEBUG, "Accepted from %s (Domain)",
-                   httpGetHostname(con->http, NULL, 0));
-  }
-  else
-#endif /* AF_LOCAL */
-  cupsdLogClient(con, CUPSD_LOG_DEBUG, "Accepted from %s:%d (IPv%d)",
-                 httpGetHostname(con->http, NULL, 0),
-		 httpAddrPort(httpGetAddress(con->http)),
-		 httpAddrFamily(httpGetAddress(con->http)) == AF_INET ? 4 : 6);
-
- /*
-  * Get the local address the client connected to...
-  */
-
-  addrlen = sizeof(temp);
-  if (getsockname(httpGetFd(con->http), (struct sockaddr *)&temp, &addrlen))
-  {
-    cupsdLogClient(con, CUPSD_LOG_ERROR, "Unable to get local address - %s",
-                   strerror(errno));
-
-    strlcpy(con->servername, "localhost", sizeof(con->servername));
-    con->serverport = LocalPort;
-  }
-#ifdef AF_LOCAL
-  else if (httpAddrFamily(&temp) == AF_LOCAL)
-  {
-    strlcpy(con->servername, "localhost", sizeof(con->servername));
-    con->serverport = LocalPort;
-  }
-#endif /* AF_LOCAL */
-  else
-  {
-    if (httpAddrLocalhost(&temp))
-      strlcpy(con->servername, "localhost", sizeof(con->servername));
-    else if (HostNameLookups)
-      httpAddrLookup(&temp, con->servername, sizeof(con->servername));
-    else
-      httpAddrString(&temp, con->servername, sizeof(con->servername));
-
-    con->serverport = httpAddrPort(&(lis->address));
-  }
-
- /*
-  * Add the connection to the array of active clients...
-  */
-
-  cupsArrayAdd(Clients, con);
-
- /*
-  * Add the socket to the server select.
-  */
-
-  cupsdAddSelect(httpGetFd(con->http), (cupsd_selfunc_t)cupsdReadClient, NULL,
-                 con);
-
-  cupsdLogClient(con, CUPSD_LOG_DEBUG, "Waiting for request.");
-
- /*
-  * Temporarily suspend accept()'s until we lose a client...
-  */
-
-  if (cupsArrayCount(Clients) == MaxClients)
-    cupsdPauseListening();
-
-#ifdef HAVE_SSL
- /*
-  * See if we are connecting on a secure port...
-  */
-
-  if (lis->encryption == HTTP_ENCRYPTION_ALWAYS)
-  {
-   /*
-    * https connection; go secure...
-    */
-
-    if (cupsd_start_tls(con, HTTP_ENCRYPTION_ALWAYS))
-      cupsdCloseClient(con);
-  }
-  else
-    con->auto_ssl = 1;
-#endif /* HAVE_SSL */
-}
-
-
-/*
- * 'cupsdCloseAllClients()' - Close all remote clients immediately.
- */
-
-void
-cupsdCloseAllClients(void)
-{
-  cupsd_client_t	*con;		/* Current client */
-
-
-  cupsdLogMessage(CUPSD_LOG_DEBUG2, "cupsdCloseAllClients() Clients=%d", cupsArrayCount(Clients));
-
-  for (con = (cupsd_client_t *)cupsArrayFirst(Clients);
-       con;
-       con = (cupsd_client_t *)cupsArrayNext(Clients))
-    if (cupsdCloseClient(con))
-      cupsdCloseClient(con);
-}
-
-
-/*
- * 'cupsdCloseClient()' - Close a remote client.
- */
-
-int					/* O - 1 if partial close, 0 if fully closed */
-cupsdCloseClient(cupsd_client_t *con)	/* I - Client to close */
-{
-  int		partial;		/* Do partial close for SSL? */
-
-
-  cupsdLogClient(con, CUPSD_LOG_DEBUG, "Closing connection.");
-
- /*
-  * Flush pending writes before closing...
-  */
-
-  httpFlushWrite(con->http);
-
-  partial = 0;
-
-  if (con->pipe_pid != 0)
-  {
-   /*
-    * Stop any CGI process...
-    */
-
-    cupsdEndProcess(con->pipe_pid, 1);
-    con->pipe_pid = 0;
-  }
-
-  if (con->file >= 0)
-  {
-    cupsdRemoveSelect(con->file);
-
-    close(con->file);
-    con->file = -1;
-  }
-
- /*
-  * Close the socket and clear the file from the input set for select()...
-  */
-
-  if (httpGetFd(con->http) >= 0)
-  {
-    cupsArrayRemove(ActiveClients, con);
-    cupsdSetBusyState();
-
-#ifdef HAVE_SSL
-   /*
-    * Shutdown encryption as needed...
-    */
-
-    if (httpIsEncrypted(con->http))
-      partial = 1;
-#endif /* HAVE_SSL */
-
-    if (partial)
-    {
-     /*
-      * Only do a partial close so that the encrypted client gets everything.
-      */
-
-      httpShutdown(con->http);
-      cupsdAddSelect(httpGetFd(con->http), (cupsd_selfunc_t)cupsdReadClient,
-                     NULL, con);
-
-      cupsdLogClient(con, CUPSD_LOG_DEBUG, "Waiting for socket close.");
-    }
-    else
-    {
-     /*
-      * Shut the socket down fully...
-      */
-
-      cupsdRemoveSelect(httpGetFd(con->http));
-      httpClose(con->http);
-      con->http = NULL;
-    }
-  }
-
-  if (!partial)
-  {
-   /*
-    * Free memory...
-    */
-
-    cupsdRemoveSelect(httpGetFd(con->http));
-
-    httpClose(con->http);
-
-    if (con->filename)
-    {
-      unlink(con->filename);
-      cupsdClearString(&con->filename);
-    }
-
-    cupsdClearString(&con->command);
-    cupsdClearString(&con->options);
-    cupsdClearString(&con->query_string);
-
-    if (con->request)
-    {
-      ippDelete(con->request);
-      con->request = NULL;
+      ippDelete(con->request);
+      con->request = NULL;
     }
 
     if (con->response)
@@ -522,14 +336,16 @@ cupsdCloseClient(cupsd_client_t *con)	/* I - Client to close */
     * limit...
     */
 
-    if (cupsArrayCount(Clients) == MaxClients)
+    if (cupsdClientCount() == MaxClients)
       cupsdResumeListening();
 
    /*
     * Compact the list of clients as necessary...
     */
 
-    cupsArrayRemove(Clients, con);
+    cupsArrayRemove(idle ? IdleClients : Clients, con);
+
+    cupsdClearTimer(&con->timer);
 
     free(con);
   }
@@ -555,10 +371,16 @@ cupsdReadClient(cupsd_client_t *con)	/* I - Client to read from */
   char			buf[1024];	/* Buffer for real filename */
   struct stat		filestats;	/* File information */
   mime_type_t		*type;		/* MIME type of file */
+  const char		*encoding;	/* Content coding of file */
+  int			vary;		/* Send "Vary: Accept-Encoding"? */
+  char			etag[256];	/* Entity tag of file */
   cupsd_printer_t	*p;		/* Printer */
   static unsigned	request_id = 0;	/* Request ID for temp files */
 
 
+  if (!con->http && !promote_client(con))
+    return;
+
   status = HTTP_STATUS_CONTINUE;
 
   cupsdLogClient(con, CUPSD_LOG_DEBUG2, "cupsdReadClient: error=%d, used=%d, state=%s, data_encoding=HTTP_ENCODING_%s, data_remaining=" CUPS_LLFMT ", request=%p(%s), file=%d", httpError(con->http), (int)httpGetReady(con->http), httpStateString(httpGetState(con->http)), httpIsChunked(con->http) ? "CHUNKED" : "LENGTH", CUPS_LLCAST httpGetRemaining(con->http), con->request, con->request ? ippStateString(ippGetState(con->request)) : "", con->file);
@@ -568,11 +390,12 @@ cupsdReadClient(cupsd_client_t *con)	/* I - Client to read from */
       httpGetState(con->http) == HTTP_STATE_STATUS)
   {
    /*
-    * If we get called in the wrong state, then something went wrong with the
-    * connection and we need to shut it down...
+    * If we get called while sending a response, then either the client has
+    * pipelined another request or the connection has been closed...
     */
 
-    if (!httpGetReady(con->http) && recv(httpGetFd(con->http), buf, 1, MSG_PEEK) < 1)
+    if (!httpGetReady(con->http) &&
+        recv(httpGetFd(con->http), buf, 1, MSG_PEEK) < 1)
     {
      /*
       * Connection closed...
@@ -583,6 +406,19 @@ cupsdReadClient(cupsd_client_t *con)	/* I - Client to read from */
       return;
     }
 
+    if (httpGetState(con->http) != HTTP_STATE_STATUS)
+    {
+     /*
+      * Stop reading until the current response has been sent; the next
+      * request is read once the client is back in the waiting state...
+      */
+
+      cupsdLogClient(con, CUPSD_LOG_DEBUG2, "Deferring pipelined request.");
+      cupsdAddSelect(httpGetFd(con->http), NULL,
+                     (cupsd_selfunc_t)cupsdWriteClient, con);
+      return;
+    }
+
     cupsdLogClient(con, CUPSD_LOG_DEBUG, "Closing on unexpected HTTP read state %s.", httpStateString(httpGetState(con->http)));
     cupsdCloseClient(con);
     return;
@@ -813,6 +649,13 @@ cupsdReadClient(cupsd_client_t *con)	/* I - Client to read from */
 
   if (status == HTTP_STATUS_OK)
   {
+    if (TraceFile)
+    {
+      cupsdTraceSpan(CUPSD_TRACE_CLIENT, con->number, "read-headers",
+                     &con->start, con->uri);
+      gettimeofday(&con->trace_start, NULL);
+    }
+
     if (httpGetField(con->http, HTTP_FIELD_ACCEPT_LANGUAGE)[0])
     {
      /*
@@ -851,8 +694,32 @@ cupsdReadClient(cupsd_client_t *con)	/* I - Client to read from */
     else
       con->language = cupsLangGet(DefaultLocale);
 
+   /*
+    * Remember the content coding the client accepts, since the request fields
+    * are cleared before the response is sent.  Local clients don't benefit
+    * from compression...
+    */
+
+    con->coding = NULL;
+
+    if (CompressResponseSize > 0 &&
+        httpGetVersion(con->http) == HTTP_VERSION_1_1)
+    {
+#ifdef AF_LOCAL
+      if (httpAddrFamily(httpGetAddress(con->http)) != AF_LOCAL)
+#endif /* AF_LOCAL */
+      con->coding = httpGetContentEncoding(con->http);
+    }
+
     cupsdAuthorize(con);
 
+    if (TraceFile)
+    {
+      cupsdTraceSpan(CUPSD_TRACE_CLIENT, con->number, "authenticate",
+                     &con->trace_start, con->username);
+      gettimeofday(&con->trace_start, NULL);
+    }
+
     if (!_cups_strncasecmp(httpGetField(con->http, HTTP_FIELD_CONNECTION),
                            "Keep-Alive", 10) && KeepAlive)
       httpSetKeepAlive(con->http, HTTP_KEEPALIVE_ON);
@@ -996,7 +863,16 @@ cupsdReadClient(cupsd_client_t *con)	/* I - Client to read from */
 #endif /* HAVE_SSL */
       }
 
-      if ((status = cupsdIsAuthorized(con, NULL)) != HTTP_STATUS_OK)
+      status = cupsdIsAuthorized(con, NULL);
+
+      if (TraceFile)
+      {
+	cupsdTraceSpan(CUPSD_TRACE_CLIENT, con->number, "authorize",
+		       &con->trace_start, httpStatus(status));
+	gettimeofday(&con->trace_start, NULL);
+      }
+
+      if (status != HTTP_STATUS_OK)
       {
 	cupsdSendError(con, status, CUPSD_AUTH_NONE);
 	cupsdCloseClient(con);
@@ -1244,27 +1120,59 @@ cupsdReadClient(cupsd_client_t *con)	/* I - Client to read from */
 	      if (httpGetVersion(con->http) <= HTTP_VERSION_1_0)
 		httpSetKeepAlive(con->http, HTTP_KEEPALIVE_OFF);
 	    }
-            else if (!strncmp(con->uri, "/admin/log/", 11) && (strchr(con->uri + 11, '/') || strlen(con->uri) == 11))
+	    else if (Metrics && !strcmp(con->uri, "/metrics"))
 	    {
 	     /*
-	      * GET can only be done to configuration files directly under
-	      * /admin/conf...
+	      * Send scheduler metrics - write a snapshot to a temporary file
+	      * and send it like any other file so we don't block on a slow
+	      * client...
 	      */
 
-	      cupsdLogClient(con, CUPSD_LOG_ERROR, "Request for subdirectory \"%s\".", con->uri);
+	      if (!write_metrics(con, buf, sizeof(buf), &filestats))
+	      {
+		if (!cupsdSendError(con, HTTP_STATUS_SERVER_ERROR, CUPSD_AUTH_NONE))
+		{
+		  cupsdCloseClient(con);
+		  return;
+		}
 
-	      if (!cupsdSendError(con, HTTP_STATUS_FORBIDDEN, CUPSD_AUTH_NONE))
+		break;
+	      }
+
+	      strlcpy(line, "text/plain; version=0.0.4", sizeof(line));
+
+	      if (!write_file(con, HTTP_STATUS_OK, buf, line, &filestats, NULL, 0))
 	      {
+	        unlink(buf);
 		cupsdCloseClient(con);
 		return;
 	      }
 
-	      break;
+	      unlink(buf);
+
+	      cupsdLogRequest(con, HTTP_STATUS_OK);
 	    }
-	    else
+            else if (!strncmp(con->uri, "/admin/log/", 11) && (strchr(con->uri + 11, '/') || strlen(con->uri) == 11))
 	    {
 	     /*
-	      * Serve a file...
+	      * GET can only be done to configuration files directly under
+	      * /admin/conf...
+	      */
+
+	      cupsdLogClient(con, CUPSD_LOG_ERROR, "Request for subdirectory \"%s\".", con->uri);
+
+	      if (!cupsdSendError(con, HTTP_STATUS_FORBIDDEN, CUPSD_AUTH_NONE))
+	      {
+		cupsdCloseClient(con);
+		return;
+	      }
+
+	      break;
+	    }
+	    else
+	    {
+	     /*
+	      * Serve a file...
 	      */
 
               if ((filename = get_file(con, &filestats, buf,
@@ -1306,8 +1214,16 @@ cupsdReadClient(cupsd_client_t *con)	/* I - Client to read from */
 	        break;
 	      }
 
+              encoding = get_gzip_file(con, buf, sizeof(buf), &filestats, &vary) ? "gzip" : NULL;
+
 	      if (!check_if_modified(con, &filestats))
               {
+		httpSetField(con->http, HTTP_FIELD_ETAG,
+			     get_etag(&filestats, etag, sizeof(etag)));
+
+		if (vary)
+		  httpSetField(con->http, HTTP_FIELD_VARY, "Accept-Encoding");
+
         	if (!cupsdSendError(con, HTTP_STATUS_NOT_MODIFIED, CUPSD_AUTH_NONE))
 		{
 		  cupsdCloseClient(con);
@@ -1321,7 +1237,8 @@ cupsdReadClient(cupsd_client_t *con)	/* I - Client to read from */
 		else
 	          snprintf(line, sizeof(line), "%s/%s", type->super, type->type);
 
-        	if (!write_file(con, HTTP_STATUS_OK, filename, line, &filestats))
+        	if (!write_file(con, HTTP_STATUS_OK, filename, line, &filestats,
+		                encoding, vary))
 		{
 		  cupsdCloseClient(con);
 		  return;
@@ -1625,6 +1542,43 @@ cupsdReadClient(cupsd_client_t *con)	/* I - Client to read from */
 		break;
 	      }
 	    }
+	    else if (Metrics && !strcmp(con->uri, "/metrics"))
+	    {
+	     /*
+	      * Send the same header as a GET of the scheduler metrics...
+	      */
+
+	      if (!write_metrics(con, buf, sizeof(buf), &filestats))
+	      {
+		if (!cupsdSendError(con, HTTP_STATUS_SERVER_ERROR, CUPSD_AUTH_NONE))
+		{
+		  cupsdCloseClient(con);
+		  return;
+		}
+
+		break;
+	      }
+
+	      unlink(buf);
+
+              httpClearFields(con->http);
+
+	      httpSetField(con->http, HTTP_FIELD_LAST_MODIFIED,
+			   httpGetDateString(filestats.st_mtime));
+	      httpSetField(con->http, HTTP_FIELD_ETAG,
+			   get_etag(&filestats, etag, sizeof(etag)));
+	      httpSetLength(con->http, (size_t)filestats.st_size);
+
+              if (!cupsdSendHeader(con, HTTP_STATUS_OK,
+	                           "text/plain; version=0.0.4", CUPSD_AUTH_NONE))
+	      {
+		cupsdCloseClient(con);
+		return;
+	      }
+
+              cupsdLogRequest(con, HTTP_STATUS_OK);
+	      break;
+	    }
 	    else if (!WebInterface)
 	    {
               httpClearFields(con->http);
@@ -1692,23 +1646,33 @@ cupsdReadClient(cupsd_client_t *con)	/* I - Client to read from */
 
               cupsdLogRequest(con, HTTP_STATUS_NOT_FOUND);
 	    }
-	    else if (!check_if_modified(con, &filestats))
-            {
-              if (!cupsdSendError(con, HTTP_STATUS_NOT_MODIFIED, CUPSD_AUTH_NONE))
+	    else
+	    {
+	      type     = mimeFileType(MimeDatabase, filename, NULL, NULL);
+              encoding = get_gzip_file(con, buf, sizeof(buf), &filestats, &vary) ? "gzip" : NULL;
+
+	      if (!check_if_modified(con, &filestats))
 	      {
-		cupsdCloseClient(con);
-		return;
+		httpSetField(con->http, HTTP_FIELD_ETAG,
+			     get_etag(&filestats, etag, sizeof(etag)));
+
+		if (vary)
+		  httpSetField(con->http, HTTP_FIELD_VARY, "Accept-Encoding");
+
+		if (!cupsdSendError(con, HTTP_STATUS_NOT_MODIFIED, CUPSD_AUTH_NONE))
+		{
+		  cupsdCloseClient(con);
+		  return;
+		}
+
+		cupsdLogRequest(con, HTTP_STATUS_NOT_MODIFIED);
+		break;
 	      }
 
-              cupsdLogRequest(con, HTTP_STATUS_NOT_MODIFIED);
-	    }
-	    else
-	    {
 	     /*
 	      * Serve a file...
 	      */
 
-	      type = mimeFileType(MimeDatabase, filename, NULL, NULL);
 	      if (type == NULL)
 		strlcpy(line, "text/plain", sizeof(line));
 	      else
@@ -1718,8 +1682,16 @@ cupsdReadClient(cupsd_client_t *con)	/* I - Client to read from */
 
 	      httpSetField(con->http, HTTP_FIELD_LAST_MODIFIED,
 			   httpGetDateString(filestats.st_mtime));
+	      httpSetField(con->http, HTTP_FIELD_ETAG,
+			   get_etag(&filestats, etag, sizeof(etag)));
 	      httpSetLength(con->http, (size_t)filestats.st_size);
 
+	      if (encoding)
+		httpSetField(con->http, HTTP_FIELD_CONTENT_ENCODING, encoding);
+
+	      if (vary)
+		httpSetField(con->http, HTTP_FIELD_VARY, "Accept-Encoding");
+
               if (!cupsdSendHeader(con, HTTP_STATUS_OK, line, CUPSD_AUTH_NONE))
 	      {
 		cupsdCloseClient(con);
@@ -1890,6 +1862,14 @@ cupsdReadClient(cupsd_client_t *con)	/* I - Client to read from */
 			      ippOpString(con->request->request.op.operation_id),
 			      con->request->request.op.request_id);
 	      con->bytes += (off_t)ippLength(con->request);
+
+	      if (TraceFile)
+	      {
+		cupsdTraceSpan(CUPSD_TRACE_CLIENT, con->number, "ipp-read",
+			       &con->trace_start,
+			       ippOpString(con->request->request.op.operation_id));
+		gettimeofday(&con->trace_start, NULL);
+	      }
 	    }
 	  }
 
@@ -1998,6 +1978,15 @@ cupsdReadClient(cupsd_client_t *con)	/* I - Client to read from */
 	    close(con->file);
 	    con->file = -1;
 
+	    if (TraceFile)
+	    {
+	      snprintf(line, sizeof(line), CUPS_LLFMT " bytes",
+	               CUPS_LLCAST filestats.st_size);
+	      cupsdTraceSpan(CUPSD_TRACE_CLIENT, con->number, "spool",
+			     &con->trace_start, line);
+	      gettimeofday(&con->trace_start, NULL);
+	    }
+
             if (filestats.st_size > MaxRequestSize &&
 	        MaxRequestSize > 0)
 	    {
@@ -2080,6 +2069,9 @@ cupsdReadClient(cupsd_client_t *con)	/* I - Client to read from */
     {
       cupsArrayRemove(ActiveClients, con);
       cupsdSetBusyState();
+
+      cupsdSetTimer(&con->timer, time(NULL) + CUPSD_IDLE_DELAY,
+                    (cupsd_timerfunc_t)check_timeout, con);
     }
   }
 }
@@ -2155,7 +2147,9 @@ cupsdSendError(cupsd_client_t *con,	/* I - Connection */
                http_status_t  code,	/* I - Error code */
 	       int            auth_type)/* I - Authentication type */
 {
-  char	location[HTTP_MAX_VALUE];	/* Location field */
+  char	location[HTTP_MAX_VALUE],	/* Location field */
+	etag[HTTP_MAX_VALUE],		/* ETag field */
+	vary[HTTP_MAX_VALUE];		/* Vary field */
 
 
   cupsdLogClient(con, CUPSD_LOG_DEBUG2, "cupsdSendError code=%d, auth_type=%d", code, auth_type);
@@ -2191,10 +2185,26 @@ cupsdSendError(cupsd_client_t *con,	/* I - Connection */
 
   strlcpy(location, httpGetField(con->http, HTTP_FIELD_LOCATION), sizeof(location));
 
+  if (code == HTTP_STATUS_NOT_MODIFIED && httpGetField(con->http, HTTP_FIELD_ETAG))
+    strlcpy(etag, httpGetField(con->http, HTTP_FIELD_ETAG), sizeof(etag));
+  else
+    etag[0] = '\0';
+
+  if (code == HTTP_STATUS_NOT_MODIFIED && httpGetField(con->http, HTTP_FIELD_VARY))
+    strlcpy(vary, httpGetField(con->http, HTTP_FIELD_VARY), sizeof(vary));
+  else
+    vary[0] = '\0';
+
   httpClearFields(con->http);
 
   httpSetField(con->http, HTTP_FIELD_LOCATION, location);
 
+  if (etag[0])
+    httpSetField(con->http, HTTP_FIELD_ETAG, etag);
+
+  if (vary[0])
+    httpSetField(con->http, HTTP_FIELD_VARY, vary);
+
   if (code >= HTTP_STATUS_BAD_REQUEST && con->type != CUPSD_AUTH_NEGOTIATE)
     httpSetKeepAlive(con->http, HTTP_KEEPALIVE_OFF);
 
@@ -2429,6 +2439,28 @@ cupsdSendHeader(
 }
 
 
+/*
+ * 'cupsdStopCGIWorkers()' - Stop all persistent CGI workers.
+ *
+ * Idle workers exit when they see the end of their request channel.
+ */
+
+void
+cupsdStopCGIWorkers(void)
+{
+  cupsd_cgi_t	*worker;		/* Current worker */
+
+
+  for (worker = (cupsd_cgi_t *)cupsArrayFirst(cgi_workers);
+       worker;
+       worker = (cupsd_cgi_t *)cupsArrayNext(cgi_workers))
+    stop_cgi_worker(worker, 0);
+
+  cupsArrayDelete(cgi_workers);
+  cgi_workers = NULL;
+}
+
+
 /*
  * 'cupsdUpdateCGI()' - Read status messages from CGI scripts and programs.
  */
@@ -2548,6 +2580,7 @@ cupsdWriteClient(cupsd_client_t *con)	/* I - Client connection */
   if (con->response && con->response->state != IPP_STATE_DATA)
   {
     size_t wused = httpGetPending(con->http);	/* Previous write buffer use */
+    int count = 0;			/* Number of attributes written */
 
     do
     {
@@ -2558,10 +2591,17 @@ cupsdWriteClient(cupsd_client_t *con)	/* I - Client connection */
       ipp_state = ippWrite(con->http, con->response);
 
      /*
-      * If the write buffer has been flushed, stop buffering up attributes...
+      * If the write buffer has been flushed, stop buffering up attributes.
+      * Compressed output is buffered by zlib instead of the write buffer, so
+      * write a fixed number of attributes at a time...
       */
 
-      if (httpGetPending(con->http) <= wused)
+      if (con->coding)
+      {
+        if (++ count >= CUPSD_COMPRESS_ATTRS)
+	  break;
+      }
+      else if (httpGetPending(con->http) <= wused)
         break;
     }
     while (ipp_state != IPP_STATE_DATA && ipp_state != IPP_STATE_ERROR);
@@ -2676,6 +2716,25 @@ cupsdWriteClient(cupsd_client_t *con)	/* I - Client connection */
 		!httpGetField(con->http, HTTP_FIELD_CONTENT_LENGTH)[0])
 	      httpSetLength(con->http, 0);
 
+           /*
+	    * Compress large or unknown-length text output from the CGI if the
+	    * client supports it...
+	    */
+
+            if (con->coding && con->pipe_status == HTTP_STATUS_OK &&
+	        !httpGetField(con->http, HTTP_FIELD_CONTENT_ENCODING)[0] &&
+		!strncmp(httpGetField(con->http, HTTP_FIELD_CONTENT_TYPE),
+		         "text/", 5) &&
+		(!httpGetField(con->http, HTTP_FIELD_CONTENT_LENGTH)[0] ||
+		 strtoll(httpGetField(con->http, HTTP_FIELD_CONTENT_LENGTH),
+		         NULL, 10) >= CompressResponseSize))
+	    {
+	      httpSetLength(con->http, 0);
+	      httpSetField(con->http, HTTP_FIELD_CONTENT_ENCODING, con->coding);
+	    }
+	    else
+	      con->coding = NULL;
+
             cupsdLogClient(con, CUPSD_LOG_DEBUG, "Sending status %d for CGI.", con->pipe_status);
 
             if (con->pipe_status == HTTP_STATUS_OK)
@@ -2716,104 +2775,472 @@ cupsdWriteClient(cupsd_client_t *con)	/* I - Client connection */
 	return;
       }
 
-      if (httpIsChunked(con->http))
-        httpFlushWrite(con->http);
+      if (httpIsChunked(con->http))
+        httpFlushWrite(con->http);
+
+      con->bytes += con->header_used;
+
+      if (httpGetState(con->http) == HTTP_STATE_WAITING)
+	bytes = 0;
+      else
+        bytes = con->header_used;
+
+      con->header_used = 0;
+    }
+  }
+
+  if (bytes <= 0 ||
+      (httpGetState(con->http) != HTTP_STATE_GET_SEND &&
+       httpGetState(con->http) != HTTP_STATE_POST_SEND))
+  {
+    if (!con->sent_header && con->pipe_pid)
+      cupsdSendError(con, HTTP_STATUS_SERVER_ERROR, CUPSD_AUTH_NONE);
+    else
+    {
+      cupsdLogRequest(con, HTTP_STATUS_OK);
+
+      if (httpIsChunked(con->http) && (!con->pipe_pid || con->sent_header > 0))
+      {
+        cupsdLogClient(con, CUPSD_LOG_DEBUG, "Sending 0-length chunk.");
+
+	if (httpWrite2(con->http, "", 0) < 0)
+	{
+	  cupsdLogClient(con, CUPSD_LOG_DEBUG, "Closing for error %d (%s)",
+			 httpError(con->http), strerror(httpError(con->http)));
+	  cupsdCloseClient(con);
+	  return;
+	}
+      }
+
+      cupsdLogClient(con, CUPSD_LOG_DEBUG, "Flushing write buffer.");
+      httpFlushWrite(con->http);
+      cupsdLogClient(con, CUPSD_LOG_DEBUG, "New state is %s", httpStateString(httpGetState(con->http)));
+    }
+
+    cupsdAddSelect(httpGetFd(con->http), (cupsd_selfunc_t)cupsdReadClient, NULL, con);
+
+    cupsdLogClient(con, CUPSD_LOG_DEBUG, "Waiting for request.");
+
+    if (TraceFile)
+    {
+      cupsdTraceSpan(CUPSD_TRACE_CLIENT, con->number, "write-response",
+                     &con->trace_start, NULL);
+      cupsdTraceSpan(CUPSD_TRACE_CLIENT, con->number,
+                     httpStateString(con->operation) + 11, &con->start,
+		     con->uri);
+    }
+
+    if (con->file >= 0)
+    {
+      cupsdRemoveSelect(con->file);
+
+      if (con->pipe_worker)
+      {
+       /*
+        * Release the worker; it accepts another request once it tells us it
+	* is ready...
+	*/
+
+        cupsdDeleteCert(con->pipe_pid);
+
+	con->pipe_worker->con = NULL;
+	con->pipe_worker      = NULL;
+      }
+      else if (con->pipe_pid)
+	cupsdEndProcess(con->pipe_pid, 0);
+
+      close(con->file);
+      con->file     = -1;
+      con->pipe_pid = 0;
+    }
+
+    if (con->filename)
+    {
+      unlink(con->filename);
+      cupsdClearString(&con->filename);
+    }
+
+    if (con->request)
+    {
+      ippDelete(con->request);
+      con->request = NULL;
+    }
+
+    if (con->response)
+    {
+      ippDelete(con->response);
+      con->response = NULL;
+    }
+
+    cupsdClearString(&con->command);
+    cupsdClearString(&con->options);
+    cupsdClearString(&con->query_string);
+
+    if (!httpGetKeepAlive(con->http))
+    {
+      cupsdLogClient(con, CUPSD_LOG_DEBUG,
+		     "Closing because Keep-Alive is disabled.");
+      cupsdCloseClient(con);
+      return;
+    }
+    else
+    {
+      cupsArrayRemove(ActiveClients, con);
+      cupsdSetBusyState();
+
+      cupsdSetTimer(&con->timer, time(NULL) + CUPSD_IDLE_DELAY,
+                    (cupsd_timerfunc_t)check_timeout, con);
+
+     /*
+      * Start on the next request right away if the client pipelined it...
+      */
+
+      if (cupsdClientReady(con))
+        cupsdReadClient(con);
+    }
+  }
+}
+
+
+/*
+ * 'accept_client()' - Accept a single new client.
+ */
+
+static int				/* O - 1 to accept more, 0 to stop */
+accept_client(cupsd_listener_t *lis)	/* I - Listener socket */
+{
+  const char		*hostname;	/* Hostname of client */
+  char			name[256];	/* Hostname of client */
+  int			count;		/* Count of connections on a host */
+  cupsd_client_t	*con,		/* New client pointer */
+			*tempcon;	/* Temporary client pointer */
+  socklen_t		addrlen;	/* Length of address */
+  http_addr_t		temp;		/* Temporary address variable */
+  static time_t		last_dos = 0;	/* Time of last DoS attack */
+#ifdef HAVE_TCPD_H
+  struct request_info	wrap_req;	/* TCP wrappers request information */
+#endif /* HAVE_TCPD_H */
+
+
+ /*
+  * Make sure we don't have a full set of clients already...
+  */
+
+  if (cupsdClientCount() == MaxClients)
+    return (0);
+
+ /*
+  * Get a pointer to the next available client...
+  */
+
+  if (!Clients)
+    Clients = cupsArrayNew(NULL, NULL);
+
+  if (!Clients)
+  {
+    cupsdLogMessage(CUPSD_LOG_ERROR,
+                    "Unable to allocate memory for clients array!");
+    cupsdPauseListening();
+    return (0);
+  }
+
+  if (!ActiveClients)
+    ActiveClients = cupsArrayNew((cups_array_func_t)compare_clients, NULL);
+
+  if (!ActiveClients)
+  {
+    cupsdLogMessage(CUPSD_LOG_ERROR,
+                    "Unable to allocate memory for active clients array!");
+    cupsdPauseListening();
+    return (0);
+  }
+
+  if ((con = calloc(1, sizeof(cupsd_client_t))) == NULL)
+  {
+    cupsdLogMessage(CUPSD_LOG_ERROR, "Unable to allocate memory for client!");
+    cupsdPauseListening();
+    return (0);
+  }
+
+ /*
+  * Accept the client and get the remote address...
+  */
+
+  con->file    = -1;
+  con->idle_fd = -1;
+
+  if ((con->http = httpAcceptConnection(lis->fd, 0)) == NULL)
+  {
+    free(con);
+
+    if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+      return (0);			/* No more pending connections */
+    else if (errno == ECONNABORTED)
+      return (1);			/* Client gave up, try the next one */
+
+    if (errno == ENFILE || errno == EMFILE)
+      cupsdPauseListening();
+
+    cupsdLogMessage(CUPSD_LOG_ERROR, "Unable to accept client connection - %s.",
+                    strerror(errno));
+
+    return (0);
+  }
+
+  con->number = ++ LastClientNumber;
+
+ /*
+  * Save the connected address and port number...
+  */
+
+  con->clientaddr = lis->address;
+
+ /*
+  * Check the number of clients on the same address; the limit can't be
+  * reached when it is at least MaxClients, so skip the scan in that case...
+  */
+
+  count = 0;
+
+  if (MaxClientsPerHost < MaxClients)
+  {
+    for (tempcon = (cupsd_client_t *)cupsArrayFirst(Clients);
+	 tempcon && count < MaxClientsPerHost;
+	 tempcon = (cupsd_client_t *)cupsArrayNext(Clients))
+      if (httpAddrEqual(httpGetAddress(tempcon->http),
+                        httpGetAddress(con->http)))
+	count ++;
+
+    for (tempcon = (cupsd_client_t *)cupsArrayFirst(IdleClients);
+	 tempcon && count < MaxClientsPerHost;
+	 tempcon = (cupsd_client_t *)cupsArrayNext(IdleClients))
+      if (httpAddrEqual(&(tempcon->idle_addr), httpGetAddress(con->http)))
+	count ++;
+  }
+
+  if (count >= MaxClientsPerHost)
+  {
+    if ((time(NULL) - last_dos) >= 60)
+    {
+      last_dos = time(NULL);
+      cupsdLogMessage(CUPSD_LOG_WARN,
+                      "Possible DoS attack - more than %d clients connecting "
+		      "from %s.",
+	              MaxClientsPerHost,
+		      httpGetHostname(con->http, name, sizeof(name)));
+    }
+
+    httpClose(con->http);
+    free(con);
+    return (1);
+  }
+
+ /*
+  * Get the hostname or format the IP address as needed...
+  */
+
+  if (HostNameLookups)
+    hostname = httpResolveHostname(con->http, NULL, 0);
+  else
+    hostname = httpGetHostname(con->http, NULL, 0);
+
+  if (hostname == NULL && HostNameLookups == 2)
+  {
+   /*
+    * Can't have an unresolved IP address with double-lookups enabled...
+    */
+
+    httpClose(con->http);
+
+    cupsdLogClient(con, CUPSD_LOG_WARN,
+                    "Name lookup failed - connection from %s closed!",
+                    httpGetHostname(con->http, NULL, 0));
+
+    free(con);
+    return (1);
+  }
+
+  if (HostNameLookups == 2)
+  {
+   /*
+    * Do double lookups as needed...
+    */
+
+    http_addrlist_t	*addrlist,	/* List of addresses */
+			*addr;		/* Current address */
+
+    if ((addrlist = httpAddrGetList(hostname, AF_UNSPEC, NULL)) != NULL)
+    {
+     /*
+      * See if the hostname maps to the same IP address...
+      */
+
+      for (addr = addrlist; addr; addr = addr->next)
+        if (httpAddrEqual(httpGetAddress(con->http), &(addr->addr)))
+          break;
+    }
+    else
+      addr = NULL;
+
+    httpAddrFreeList(addrlist);
+
+    if (!addr)
+    {
+     /*
+      * Can't have a hostname that doesn't resolve to the same IP address
+      * with double-lookups enabled...
+      */
+
+      httpClose(con->http);
+
+      cupsdLogClient(con, CUPSD_LOG_WARN,
+                      "IP lookup failed - connection from %s closed!",
+                      httpGetHostname(con->http, NULL, 0));
+      free(con);
+      return (1);
+    }
+  }
+
+#ifdef HAVE_TCPD_H
+ /*
+  * See if the connection is denied by TCP wrappers...
+  */
+
+  request_init(&wrap_req, RQ_DAEMON, "cupsd", RQ_FILE, httpGetFd(con->http),
+               NULL);
+  fromhost(&wrap_req);
+
+  if (!hosts_access(&wrap_req))
+  {
+    httpClose(con->http);
+
+    cupsdLogClient(con, CUPSD_LOG_WARN,
+                    "Connection from %s refused by /etc/hosts.allow and "
+		    "/etc/hosts.deny rules.", httpGetHostname(con->http, NULL, 0));
+    free(con);
+    return (1);
+  }
+#endif /* HAVE_TCPD_H */
+
+#ifdef AF_LOCAL
+  if (httpAddrFamily(httpGetAddress(con->http)) == AF_LOCAL)
+  {
+#  ifdef __APPLE__
+    socklen_t	peersize;		/* Size of peer credentials */
+    pid_t	peerpid;		/* Peer process ID */
+    char	peername[256];		/* Name of process */
+
+    peersize = sizeof(peerpid);
+    if (!getsockopt(httpGetFd(con->http), SOL_LOCAL, LOCAL_PEERPID, &peerpid,
+                    &peersize))
+    {
+      if (!proc_name((int)peerpid, peername, sizeof(peername)))
+	cupsdLogClient(con, CUPSD_LOG_DEBUG,
+	               "Accepted from %s (Domain ???[%d])",
+                       httpGetHostname(con->http, NULL, 0), (int)peerpid);
+      else
+	cupsdLogClient(con, CUPSD_LOG_DEBUG,
+                       "Accepted from %s (Domain %s[%d])",
+                       httpGetHostname(con->http, NULL, 0), peername, (int)peerpid);
+    }
+    else
+#  endif /* __APPLE__ */
+
+    cupsdLogClient(con, CUPSD_LOG_DEBUG, "Accepted from %s (Domain)",
+                   httpGetHostname(con->http, NULL, 0));
+  }
+  else
+#endif /* AF_LOCAL */
+  cupsdLogClient(con, CUPSD_LOG_DEBUG, "Accepted from %s:%d (IPv%d)",
+                 httpGetHostname(con->http, NULL, 0),
+		 httpAddrPort(httpGetAddress(con->http)),
+		 httpAddrFamily(httpGetAddress(con->http)) == AF_INET ? 4 : 6);
 
-      con->bytes += con->header_used;
+ /*
+  * Get the local address the client connected to...
+  */
 
-      if (httpGetState(con->http) == HTTP_STATE_WAITING)
-	bytes = 0;
-      else
-        bytes = con->header_used;
+  addrlen = sizeof(temp);
+  if (getsockname(httpGetFd(con->http), (struct sockaddr *)&temp, &addrlen))
+  {
+    cupsdLogClient(con, CUPSD_LOG_ERROR, "Unable to get local address - %s",
+                   strerror(errno));
 
-      con->header_used = 0;
-    }
+    strlcpy(con->servername, "localhost", sizeof(con->servername));
+    con->serverport = LocalPort;
   }
-
-  if (bytes <= 0 ||
-      (httpGetState(con->http) != HTTP_STATE_GET_SEND &&
-       httpGetState(con->http) != HTTP_STATE_POST_SEND))
+#ifdef AF_LOCAL
+  else if (httpAddrFamily(&temp) == AF_LOCAL)
   {
-    if (!con->sent_header && con->pipe_pid)
-      cupsdSendError(con, HTTP_STATUS_SERVER_ERROR, CUPSD_AUTH_NONE);
+    strlcpy(con->servername, "localhost", sizeof(con->servername));
+    con->serverport = LocalPort;
+  }
+#endif /* AF_LOCAL */
+  else
+  {
+    if (httpAddrLocalhost(&temp))
+      strlcpy(con->servername, "localhost", sizeof(con->servername));
+    else if (HostNameLookups)
+      httpAddrLookup(&temp, con->servername, sizeof(con->servername));
     else
-    {
-      cupsdLogRequest(con, HTTP_STATUS_OK);
-
-      if (httpIsChunked(con->http) && (!con->pipe_pid || con->sent_header > 0))
-      {
-        cupsdLogClient(con, CUPSD_LOG_DEBUG, "Sending 0-length chunk.");
+      httpAddrString(&temp, con->servername, sizeof(con->servername));
 
-	if (httpWrite2(con->http, "", 0) < 0)
-	{
-	  cupsdLogClient(con, CUPSD_LOG_DEBUG, "Closing for error %d (%s)",
-			 httpError(con->http), strerror(httpError(con->http)));
-	  cupsdCloseClient(con);
-	  return;
-	}
-      }
+    con->serverport = httpAddrPort(&(lis->address));
+  }
 
-      cupsdLogClient(con, CUPSD_LOG_DEBUG, "Flushing write buffer.");
-      httpFlushWrite(con->http);
-      cupsdLogClient(con, CUPSD_LOG_DEBUG, "New state is %s", httpStateString(httpGetState(con->http)));
-    }
+ /*
+  * Add the connection to the array of active clients...
+  */
 
-    cupsdAddSelect(httpGetFd(con->http), (cupsd_selfunc_t)cupsdReadClient, NULL, con);
+  cupsArrayAdd(Clients, con);
 
-    cupsdLogClient(con, CUPSD_LOG_DEBUG, "Waiting for request.");
+  cupsdSetTimer(&con->timer, time(NULL) + CUPSD_IDLE_DELAY,
+                (cupsd_timerfunc_t)check_timeout, con);
 
-    if (con->file >= 0)
-    {
-      cupsdRemoveSelect(con->file);
+ /*
+  * Add the socket to the server select.
+  */
 
-      if (con->pipe_pid)
-	cupsdEndProcess(con->pipe_pid, 0);
+  cupsdAddSelect(httpGetFd(con->http), (cupsd_selfunc_t)cupsdReadClient, NULL,
+                 con);
 
-      close(con->file);
-      con->file     = -1;
-      con->pipe_pid = 0;
-    }
+  cupsdLogClient(con, CUPSD_LOG_DEBUG, "Waiting for request.");
 
-    if (con->filename)
-    {
-      unlink(con->filename);
-      cupsdClearString(&con->filename);
-    }
+ /*
+  * Temporarily suspend accept()'s until we lose a client...
+  */
 
-    if (con->request)
-    {
-      ippDelete(con->request);
-      con->request = NULL;
-    }
+  if (cupsdClientCount() == MaxClients)
+  {
+    cupsdPauseListening();
+    return (0);
+  }
 
-    if (con->response)
-    {
-      ippDelete(con->response);
-      con->response = NULL;
-    }
+#ifdef HAVE_SSL
+ /*
+  * See if we are connecting on a secure port...
+  */
 
-    cupsdClearString(&con->command);
-    cupsdClearString(&con->options);
-    cupsdClearString(&con->query_string);
+  if (lis->encryption == HTTP_ENCRYPTION_ALWAYS)
+  {
+   /*
+    * https connection; go secure...
+    */
 
-    if (!httpGetKeepAlive(con->http))
-    {
-      cupsdLogClient(con, CUPSD_LOG_DEBUG,
-		     "Closing because Keep-Alive is disabled.");
+    if (cupsd_start_tls(con, HTTP_ENCRYPTION_ALWAYS))
       cupsdCloseClient(con);
-      return;
-    }
-    else
-    {
-      cupsArrayRemove(ActiveClients, con);
-      cupsdSetBusyState();
-    }
   }
+  else
+    con->auto_ssl = 1;
+#endif /* HAVE_SSL */
+
+  return (1);
 }
 
 
 /*
- * 'check_if_modified()' - Decode an "If-Modified-Since" line.
+ * 'check_if_modified()' - Decode an "If-None-Match" or "If-Modified-Since"
+ *                         line.
  */
 
 static int				/* O - 1 if modified since */
@@ -2824,7 +3251,43 @@ check_if_modified(
   const char	*ptr;			/* Pointer into field */
   time_t	date;			/* Time/date value */
   off_t		size;			/* Size/length value */
+  char		etag[256];		/* ETag for file */
+  size_t	etaglen;		/* Length of ETag */
+
+
+  if ((ptr = httpGetField(con->http, HTTP_FIELD_IF_NONE_MATCH)) != NULL &&
+      *ptr)
+  {
+   /*
+    * If-None-Match takes precedence over If-Modified-Since; compare each
+    * entity tag in the list, ignoring any weak indicator...
+    */
+
+    cupsdLogClient(con, CUPSD_LOG_DEBUG2, "check_if_modified: If-None-Match=\"%s\"", ptr);
+
+    etaglen = strlen(get_etag(filestats, etag, sizeof(etag)));
+
+    while (*ptr)
+    {
+      while (isspace(*ptr & 255) || *ptr == ',')
+        ptr ++;
+
+      if (*ptr == '*')
+        return (0);
+
+      if (!strncmp(ptr, "W/", 2))
+        ptr += 2;
+
+      if (!strncmp(ptr, etag, etaglen) &&
+          (!ptr[etaglen] || ptr[etaglen] == ',' || isspace(ptr[etaglen] & 255)))
+        return (0);
+
+      while (*ptr && *ptr != ',')
+        ptr ++;
+    }
 
+    return (1);
+  }
 
   size = 0;
   date = 0;
@@ -2864,6 +3327,49 @@ check_if_modified(
 }
 
 
+/*
+ * 'check_timeout()' - Demote or close a client connection after a period of
+ *                     inactivity.
+ */
+
+static void
+check_timeout(cupsd_client_t *con)	/* I - Client connection */
+{
+  time_t	curtime,		/* Current time */
+		activity,		/* Time of last activity */
+		expire;			/* Inactivity expiration time */
+
+
+  curtime  = time(NULL);
+  activity = con->http ? httpGetActivity(con->http) : con->idle_activity;
+  expire   = activity + Timeout;
+
+  if (expire > curtime || con->pipe_pid)
+  {
+   /*
+    * Still active; release the buffers of a client that has been waiting
+    * for a request for a while and check again later...
+    */
+
+    if (httpGetState(con->http) == HTTP_STATE_WAITING)
+    {
+      if ((activity + CUPSD_IDLE_DELAY) <= curtime)
+        demote_client(con);
+      else if ((activity + CUPSD_IDLE_DELAY) < expire)
+        expire = activity + CUPSD_IDLE_DELAY;
+    }
+
+    cupsdSetTimer(&con->timer, expire > curtime ? expire : curtime + 1,
+                  (cupsd_timerfunc_t)check_timeout, con);
+    return;
+  }
+
+  cupsdLogMessage(CUPSD_LOG_DEBUG, "Closing client %d after %d seconds of inactivity.", con->number, Timeout);
+
+  cupsdCloseClient(con);
+}
+
+
 /*
  * 'compare_clients()' - Compare two client connections.
  */
@@ -2886,24 +3392,153 @@ compare_clients(cupsd_client_t *a,	/* I - First client */
 
 #ifdef HAVE_SSL
 /*
- * 'cupsd_start_tls()' - Start encryption on a connection.
+ * 'cupsd_start_tls()' - Start encryption on a connection.
+ */
+
+static int				/* O - 0 on success, -1 on error */
+cupsd_start_tls(cupsd_client_t    *con,	/* I - Client connection */
+                http_encryption_t e)	/* I - Encryption mode */
+{
+  if (httpEncryption(con->http, e))
+  {
+    cupsdLogClient(con, CUPSD_LOG_ERROR, "Unable to encrypt connection: %s",
+                   cupsLastErrorString());
+    return (-1);
+  }
+
+  cupsdLogClient(con, CUPSD_LOG_DEBUG, "Connection now encrypted.");
+  return (0);
+}
+#endif /* HAVE_SSL */
+
+
+/*
+ * 'demote_client()' - Release the HTTP state of a client that is waiting for
+ *                     a request.
+ *
+ * The socket stays in the select set; the next read from the client creates
+ * a new HTTP connection for it with promote_client().
+ */
+
+static int				/* O - 1 if demoted, 0 otherwise */
+demote_client(cupsd_client_t *con)	/* I - Client connection */
+{
+ /*
+  * Only demote clients that have nothing buffered in either direction and
+  * no request in progress...
+  */
+
+  if (httpGetState(con->http) != HTTP_STATE_WAITING ||
+      httpGetReady(con->http) || httpGetPending(con->http) ||
+      con->request || con->response || con->file >= 0 || con->pipe_pid)
+    return (0);
+
+  if (!IdleClients && (IdleClients = cupsArrayNew(NULL, NULL)) == NULL)
+    return (0);
+
+ /*
+  * Save what we need to recreate the connection and free the rest;
+  * encrypted connections keep their HTTP state...
+  */
+
+  con->idle_addr     = *httpGetAddress(con->http);
+  con->idle_activity = httpGetActivity(con->http);
+
+  cupsdSetString(&con->idle_hostname, httpGetHostname(con->http, NULL, 0));
+
+  if ((con->idle_fd = _httpReleaseSocket(con->http)) < 0)
+  {
+    cupsdClearString(&con->idle_hostname);
+    return (0);
+  }
+
+  con->http = NULL;
+
+  cupsArrayRemove(Clients, con);
+  cupsArrayAdd(IdleClients, con);
+
+  cupsdLogClient(con, CUPSD_LOG_DEBUG2, "Demoted to idle.");
+
+  return (1);
+}
+
+
+/*
+ * 'get_cgi_worker()' - Get an idle persistent worker for a CGI program.
+ *
+ * Only the web interface programs that come with CUPS speak the worker
+ * protocol.  A new worker is started while the program has fewer than
+ * CGIWorkers of them; otherwise the caller runs the program normally.
+ */
+
+static cupsd_cgi_t *			/* O - Worker or NULL */
+get_cgi_worker(const char *command)	/* I - Command to run */
+{
+  int		i,			/* Looping var */
+		count;			/* Number of workers for command */
+  size_t	len;			/* Length of ServerBin */
+  cupsd_cgi_t	*worker;		/* Current worker */
+  static const char * const programs[] =
+  {					/* Programs that support workers */
+    "admin.cgi",
+    "classes.cgi",
+    "help.cgi",
+    "jobs.cgi",
+    "printers.cgi"
+  };
+
+
+  len = strlen(ServerBin);
+
+  if (CGIWorkers <= 0 || strncmp(command, ServerBin, len) ||
+      strncmp(command + len, "/cgi-bin/", 9))
+    return (NULL);
+
+  for (i = 0; i < (int)(sizeof(programs) / sizeof(programs[0])); i ++)
+    if (!strcmp(command + len + 9, programs[i]))
+      break;
+
+  if (i >= (int)(sizeof(programs) / sizeof(programs[0])))
+    return (NULL);
+
+  for (count = 0, worker = (cupsd_cgi_t *)cupsArrayFirst(cgi_workers);
+       worker;
+       worker = (cupsd_cgi_t *)cupsArrayNext(cgi_workers))
+  {
+    if (strcmp(worker->command, command))
+      continue;
+
+    if (!worker->busy && !worker->con)
+      return (worker);
+
+    count ++;
+  }
+
+  if (count >= CGIWorkers)
+    return (NULL);
+
+  return (start_cgi_worker(command));
+}
+
+
+/*
+ * 'get_etag()' - Get a strong entity tag for a file.
+ *
+ * The entity tag is made from the inode, modification time, and size of the
+ * file, so it changes whenever the file is replaced or updated.
  */
 
-static int				/* O - 0 on success, -1 on error */
-cupsd_start_tls(cupsd_client_t    *con,	/* I - Client connection */
-                http_encryption_t e)	/* I - Encryption mode */
+static char *				/* O - Entity tag */
+get_etag(struct stat *filestats,	/* I - File information */
+         char        *etag,		/* I - Entity tag buffer */
+	 size_t      etagsize)		/* I - Size of buffer */
 {
-  if (httpEncryption(con->http, e))
-  {
-    cupsdLogClient(con, CUPSD_LOG_ERROR, "Unable to encrypt connection: %s",
-                   cupsLastErrorString());
-    return (-1);
-  }
+  snprintf(etag, etagsize, "\"" CUPS_LLFMT "-" CUPS_LLFMT "-" CUPS_LLFMT "\"",
+           CUPS_LLCAST filestats->st_ino, CUPS_LLCAST filestats->st_mtime,
+	   CUPS_LLCAST filestats->st_size);
 
-  cupsdLogClient(con, CUPSD_LOG_DEBUG, "Connection now encrypted.");
-  return (0);
+  return (etag);
 }
-#endif /* HAVE_SSL */
 
 
 /*
@@ -3185,6 +3820,111 @@ get_file(cupsd_client_t *con,		/* I  - Client connection */
 }
 
 
+/*
+ * 'get_gzip_file()' - Look for a precompressed copy of a document.
+ *
+ * If the client accepts gzip content coding and there is an up-to-date
+ * "filename.gz" next to a document under DocumentRoot, the filename and file
+ * information are updated to point to the compressed copy.  "vary" is set
+ * whenever such a copy exists, since the response then depends on the
+ * client's Accept-Encoding even when the original document is sent.
+ */
+
+static int				/* O  - 1 if using ".gz" file, 0 otherwise */
+get_gzip_file(cupsd_client_t *con,	/* I  - Client connection */
+              char           *filename,	/* IO - Filename buffer */
+	      size_t         len,	/* I  - Buffer length */
+              struct stat    *filestats,/* IO - File information */
+	      int            *vary)	/* O  - 1 if response varies, 0 otherwise */
+{
+  const char	*ptr,			/* Pointer into Accept-Encoding */
+		*start;			/* Start of coding name */
+  size_t	namelen;		/* Length of coding name */
+  int		accept_gzip = 0;	/* Does the client accept gzip? */
+  char		gzname[1024];		/* Compressed filename */
+  struct stat	gzstats;		/* Compressed file information */
+
+
+ /*
+  * Only look for static documents...
+  */
+
+  *vary = 0;
+
+  if (strncmp(filename, DocumentRoot, strlen(DocumentRoot)) ||
+      !S_ISREG(filestats->st_mode))
+    return (0);
+
+ /*
+  * Look for a world-readable compressed copy that is at least as new as the
+  * original document...
+  */
+
+  if (snprintf(gzname, sizeof(gzname), "%s.gz", filename) >= (int)sizeof(gzname) ||
+      strlen(gzname) >= len)
+    return (0);
+
+  if (lstat(gzname, &gzstats) || !S_ISREG(gzstats.st_mode) ||
+      !(gzstats.st_mode & S_IROTH) || gzstats.st_mtime < filestats->st_mtime)
+    return (0);
+
+  *vary = 1;
+
+ /*
+  * See if the client accepts gzip with a non-zero qvalue...
+  */
+
+  if ((ptr = httpGetField(con->http, HTTP_FIELD_ACCEPT_ENCODING)) == NULL)
+    return (0);
+
+  while (*ptr && !accept_gzip)
+  {
+    while (isspace(*ptr & 255) || *ptr == ',')
+      ptr ++;
+
+    for (start = ptr; *ptr && *ptr != ',' && *ptr != ';' && !isspace(*ptr & 255); ptr ++);
+
+    namelen = (size_t)(ptr - start);
+
+    if ((namelen == 4 && !_cups_strncasecmp(start, "gzip", 4)) ||
+        (namelen == 6 && !_cups_strncasecmp(start, "x-gzip", 6)))
+    {
+      accept_gzip = 1;
+
+      while (*ptr && *ptr != ',')
+      {
+        if (!strncmp(ptr, "q=0", 3))
+	{
+	 /*
+	  * A qvalue of "0", "0.", "0.0", etc. means "not acceptable"...
+	  */
+
+	  for (ptr += 3; *ptr == '.' || *ptr == '0'; ptr ++);
+
+	  if (!*ptr || *ptr == ',' || *ptr == ';' || isspace(*ptr & 255))
+	    accept_gzip = 0;
+	}
+	else
+	  ptr ++;
+      }
+    }
+
+    while (*ptr && *ptr != ',')
+      ptr ++;
+  }
+
+  if (!accept_gzip)
+    return (0);
+
+  cupsdLogClient(con, CUPSD_LOG_DEBUG, "Using precompressed file \"%s\".", gzname);
+
+  strlcpy(filename, gzname, len);
+  *filestats = gzstats;
+
+  return (1);
+}
+
+
 /*
  * 'install_cupsd_conf()' - Install a configuration file.
  */
@@ -3472,6 +4212,7 @@ pipe_command(cupsd_client_t *con,	/* I - Client connection */
 		commch;			/* Command string character */
   char		*uriptr;		/* URI string pointer */
   int		fds[2];			/* Pipe FDs */
+  cupsd_cgi_t	*worker;		/* Persistent CGI worker */
   int		argc;			/* Number of arguments */
   int		envc;			/* Number of environment variables */
   char		argbuf[10240],		/* Argument buffer */
@@ -3812,10 +4553,30 @@ pipe_command(cupsd_client_t *con,	/* I - Client connection */
   }
 
  /*
-  * Then execute the command...
+  * Then pass the request to a persistent worker or execute the command...
   */
 
-  if (cupsdStartProcess(command, argv, envp, infile, fds[1], CGIPipes[1],
+  if (!root && (worker = get_cgi_worker(command)) != NULL &&
+      send_cgi_request(worker, infile, fds[1], envp))
+  {
+    pid = worker->pid;
+
+    worker->busy     = 1;
+    worker->con      = con;
+    con->pipe_worker = worker;
+
+    cupsdDeleteCert(pid);
+
+    if (con->username[0])
+      cupsdAddCert(pid, con->username, con->type);
+
+    cupsdLogMessage(CUPSD_LOG_DEBUG, "[CGI] Sent request to %s (PID %d)",
+                    command, pid);
+
+    *outfile = fds[0];
+    close(fds[1]);
+  }
+  else   if (cupsdStartProcess(command, argv, envp, infile, fds[1], CGIPipes[1],
 			-1, -1, root, DefaultProfile, NULL, &pid) < 0)
   {
    /*
@@ -3847,6 +4608,302 @@ pipe_command(cupsd_client_t *con,	/* I - Client connection */
 }
 
 
+/*
+ * 'promote_client()' - Recreate the HTTP state of an idle client.
+ */
+
+static int				/* O - 1 on success, 0 on error */
+promote_client(cupsd_client_t *con)	/* I - Client connection */
+{
+  http_t	*http;			/* HTTP connection */
+
+
+  if ((http = _httpCreateServer(con->idle_fd, &(con->idle_addr),
+                                con->idle_hostname, 0)) == NULL)
+  {
+    cupsdLogClient(con, CUPSD_LOG_ERROR,
+                   "Unable to allocate memory for idle client.");
+    cupsdCloseClient(con);
+    return (0);
+  }
+
+  con->http    = http;
+  con->idle_fd = -1;
+
+  cupsdClearString(&con->idle_hostname);
+
+  cupsArrayRemove(IdleClients, con);
+  cupsArrayAdd(Clients, con);
+
+  cupsdLogClient(con, CUPSD_LOG_DEBUG2, "Promoted from idle.");
+
+  return (1);
+}
+
+
+/*
+ * 'send_cgi_request()' - Send a request to a persistent CGI worker.
+ *
+ * The request is the length of the environment strings, the standard input
+ * and output file descriptors, and the nul-separated environment strings.
+ */
+
+static int				/* O - 1 on success, 0 on error */
+send_cgi_request(cupsd_cgi_t *worker,	/* I - Worker */
+                 int         infile,	/* I - Standard input or -1 */
+		 int         outfile,	/* I - Standard output */
+		 char        *envp[])	/* I - Environment */
+{
+  int		i;			/* Looping var */
+  unsigned	length;			/* Length of environment */
+  size_t	bytes,			/* Bytes in environment */
+		envlen;			/* Length of variable */
+  ssize_t	sent;			/* Bytes sent */
+  char		*buffer,		/* Request buffer */
+		*bufptr;		/* Pointer into buffer */
+  int		fds[2],			/* File descriptors to pass */
+		nullfd = -1;		/* /dev/null for standard input */
+  struct iovec	iov;			/* I/O vector */
+  struct msghdr	msg;			/* Message header */
+  struct cmsghdr *cmsg;			/* Control message */
+  union
+  {
+    struct cmsghdr	hdr;		/* Alignment */
+    char		buf[CMSG_SPACE(2 * sizeof(int))];
+					/* Control buffer */
+  }		control;		/* Control message buffer */
+
+
+ /*
+  * Build the request...
+  */
+
+  for (i = 0, bytes = 0; envp[i]; i ++)
+    bytes += strlen(envp[i]) + 1;
+
+  if (bytes > CUPSD_CGI_MAX_ENV ||
+      (buffer = malloc(sizeof(length) + bytes)) == NULL)
+    return (0);
+
+  length = (unsigned)bytes;
+  memcpy(buffer, &length, sizeof(length));
+
+  for (i = 0, bufptr = buffer + sizeof(length); envp[i]; i ++)
+  {
+    envlen = strlen(envp[i]) + 1;
+    memcpy(bufptr, envp[i], envlen);
+    bufptr += envlen;
+  }
+
+  if (infile < 0 && (infile = nullfd = open("/dev/null", O_RDONLY)) < 0)
+  {
+    free(buffer);
+    return (0);
+  }
+
+  fds[0] = infile;
+  fds[1] = outfile;
+
+ /*
+  * Send it with the file descriptors; the channel is non-blocking and an
+  * idle worker is waiting for the request, so anything short of a complete
+  * write means the worker is gone or stuck...
+  */
+
+  iov.iov_base = buffer;
+  iov.iov_len  = sizeof(length) + bytes;
+
+  memset(&msg, 0, sizeof(msg));
+  memset(&control, 0, sizeof(control));
+  msg.msg_iov        = &iov;
+  msg.msg_iovlen     = 1;
+  msg.msg_control    = control.buf;
+  msg.msg_controllen = sizeof(control.buf);
+
+  cmsg             = CMSG_FIRSTHDR(&msg);
+  cmsg->cmsg_level = SOL_SOCKET;
+  cmsg->cmsg_type  = SCM_RIGHTS;
+  cmsg->cmsg_len   = CMSG_LEN(sizeof(fds));
+  memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+
+  while ((sent = sendmsg(worker->fd, &msg, 0)) < 0 && errno == EINTR);
+
+  free(buffer);
+
+  if (nullfd >= 0)
+    close(nullfd);
+
+  if (sent != (ssize_t)(sizeof(length) + bytes))
+  {
+    cupsdLogMessage(CUPSD_LOG_ERROR,
+                    "[CGI] Unable to send request to %s (PID %d) - %s",
+		    worker->command, worker->pid,
+		    sent < 0 ? strerror(errno) : "Short write");
+    stop_cgi_worker(worker, 1);
+    return (0);
+  }
+
+  return (1);
+}
+
+
+/*
+ * 'start_cgi_worker()' - Start a persistent CGI worker.
+ */
+
+static cupsd_cgi_t *			/* O - New worker or NULL */
+start_cgi_worker(const char *command)	/* I - Command to run */
+{
+  int		fds[2];			/* Request channel */
+  int		envc;			/* Number of environment variables */
+  char		*argv[2],		/* Command-line arguments */
+		*envp[MAX_ENV + 1];	/* Environment variables */
+  cupsd_cgi_t	*worker;		/* New worker */
+
+
+  if (!cgi_workers && (cgi_workers = cupsArrayNew(NULL, NULL)) == NULL)
+    return (NULL);
+
+  if ((worker = calloc(1, sizeof(cupsd_cgi_t))) == NULL)
+    return (NULL);
+
+  if (socketpair(AF_LOCAL, SOCK_STREAM, 0, fds))
+  {
+    cupsdLogMessage(CUPSD_LOG_ERROR,
+                    "[CGI] Unable to create worker channel for %s - %s",
+		    command, strerror(errno));
+    free(worker);
+    return (NULL);
+  }
+
+  fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+  fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL) | O_NONBLOCK);
+  fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+
+ /*
+  * The worker gets its request channel as file descriptor 3 and everything
+  * else with each request...
+  */
+
+  argv[0] = (char *)command;
+  argv[1] = NULL;
+
+  envc = cupsdLoadEnv(envp, (int)(sizeof(envp) / sizeof(envp[0])) - 1);
+
+  envp[envc ++] = "CUPS_CGI_WORKER=1";
+  envp[envc]    = NULL;
+
+  if (!cupsdStartProcess(command, argv, envp, -1, -1, CGIPipes[1], fds[1], -1,
+                         0, DefaultProfile, NULL, &(worker->pid)))
+  {
+    cupsdLogMessage(CUPSD_LOG_ERROR, "[CGI] Unable to start worker %s - %s",
+                    command, strerror(errno));
+
+    close(fds[0]);
+    close(fds[1]);
+    free(worker);
+    return (NULL);
+  }
+
+  close(fds[1]);
+
+  worker->fd = fds[0];
+  cupsdSetString(&worker->command, command);
+
+  cupsArrayAdd(cgi_workers, worker);
+
+  cupsdAddSelect(worker->fd, (cupsd_selfunc_t)update_cgi_worker, NULL, worker);
+
+  cupsdLogMessage(CUPSD_LOG_DEBUG, "[CGI] Started worker %s (PID %d)",
+                  command, worker->pid);
+
+  return (worker);
+}
+
+
+/*
+ * 'stop_cgi_worker()' - Stop a persistent CGI worker.
+ */
+
+static void
+stop_cgi_worker(cupsd_cgi_t *worker,	/* I - Worker */
+                int         force)	/* I - Kill the worker process? */
+{
+  cupsd_client_t	*con;		/* Current client */
+
+
+  cupsdLogMessage(CUPSD_LOG_DEBUG, "[CGI] Stopping worker %s (PID %d)",
+                  worker->command, worker->pid);
+
+ /*
+  * Close any clients using this worker; the rest of their response will
+  * never arrive, and without the worker the remaining output would be sent
+  * without its CGI headers being parsed.  Clear the process ID first so
+  * that closing them doesn't signal the old process.  Callers may be walking
+  * the client array, so preserve its current position...
+  */
+
+  worker->con = NULL;
+
+  cupsArraySave(Clients);
+
+  for (con = (cupsd_client_t *)cupsArrayFirst(Clients);
+       con;
+       con = (cupsd_client_t *)cupsArrayNext(Clients))
+    if (con->pipe_worker == worker)
+    {
+      cupsdLogClient(con, CUPSD_LOG_ERROR,
+                     "CGI worker %s (PID %d) stopped before the response was "
+		     "complete.", worker->command, worker->pid);
+
+      con->pipe_worker = NULL;
+      con->pipe_pid    = 0;
+
+      cupsdCloseClient(con);
+    }
+
+  cupsArrayRestore(Clients);
+
+  if (force)
+    cupsdEndProcess(worker->pid, 1);
+
+  cupsdRemoveSelect(worker->fd);
+  close(worker->fd);
+
+  cupsArrayRemove(cgi_workers, worker);
+
+  cupsdClearString(&worker->command);
+  free(worker);
+}
+
+
+/*
+ * 'update_cgi_worker()' - Read the ready notification from a CGI worker.
+ */
+
+static void
+update_cgi_worker(cupsd_cgi_t *worker)	/* I - Worker */
+{
+  char		buffer[16];		/* Notification buffer */
+  ssize_t	bytes;			/* Bytes read */
+
+
+  if ((bytes = read(worker->fd, buffer, sizeof(buffer))) > 0)
+  {
+    worker->busy = 0;
+    return;
+  }
+  else if (bytes < 0 && (errno == EAGAIN || errno == EINTR))
+    return;
+
+ /*
+  * End-of-file, the worker has exited...
+  */
+
+  stop_cgi_worker(worker, 0);
+}
+
+
 /*
  * 'valid_host()' - Is the Host: field valid?
  */
@@ -4026,8 +5083,13 @@ write_file(cupsd_client_t *con,		/* I - Client connection */
            http_status_t  code,		/* I - HTTP status */
 	   char           *filename,	/* I - Filename */
 	   char           *type,	/* I - File type */
-	   struct stat    *filestats)	/* O - File information */
+	   struct stat    *filestats,	/* O - File information */
+	   const char     *encoding,	/* I - Content coding of file or NULL */
+	   int            vary)		/* I - Send "Vary: Accept-Encoding"? */
 {
+  char	etag[256];			/* Entity tag for file */
+
+
   con->file = open(filename, O_RDONLY);
 
   cupsdLogClient(con, CUPSD_LOG_DEBUG2, "write_file: code=%d, filename=\"%s\" (%d), type=\"%s\", filestats=%p.", code, filename, con->file, type ? type : "(null)", filestats);
@@ -4046,6 +5108,20 @@ write_file(cupsd_client_t *con,		/* I - Client connection */
 
   httpSetField(con->http, HTTP_FIELD_LAST_MODIFIED,
 	       httpGetDateString(filestats->st_mtime));
+  httpSetField(con->http, HTTP_FIELD_ETAG,
+               get_etag(filestats, etag, sizeof(etag)));
+
+  if (encoding)
+  {
+   /*
+    * The file is already encoded, so libcups sends it as-is...
+    */
+
+    httpSetField(con->http, HTTP_FIELD_CONTENT_ENCODING, encoding);
+  }
+
+  if (vary)
+    httpSetField(con->http, HTTP_FIELD_VARY, "Accept-Encoding");
 
   if (!cupsdSendHeader(con, code, type, CUPSD_AUTH_NONE))
     return (0);
@@ -4058,6 +5134,46 @@ write_file(cupsd_client_t *con,		/* I - Client connection */
 }
 
 
+/*
+ * 'write_metrics()' - Write a snapshot of the scheduler metrics to a file.
+ *
+ * The snapshot is written to a temporary file so that it can be sent like
+ * any other file without blocking on a slow client.
+ */
+
+static int				/* O - 1 on success, 0 on error */
+write_metrics(cupsd_client_t *con,	/* I - Client connection */
+              char           *filename,	/* O - Snapshot filename */
+	      size_t         len,	/* I - Size of filename buffer */
+	      struct stat    *filestats)/* O - Snapshot file information */
+{
+  cups_file_t	*fp;			/* Snapshot file */
+  int		status = 0;		/* Write status */
+
+
+  snprintf(filename, len, "%s/%05d-metrics", TempDir, con->number);
+
+  if ((fp = cupsFileOpen(filename, "w")) != NULL)
+  {
+    status = cupsdWriteMetrics(fp);
+
+    if (cupsFileClose(fp) || stat(filename, filestats))
+      status = 0;
+  }
+
+  if (!status)
+  {
+    cupsdLogClient(con, CUPSD_LOG_ERROR,
+                   "Unable to write metrics to \"%s\": %s", filename,
+		   strerror(errno));
+
+    unlink(filename);
+  }
+
+  return (status);
+}
+
+
 /*
  * 'write_pipe()' - Flag that data is available on the CGI pipe.
  */
@@ -18,6 +18,20 @@
 #endif /* HAVE_AUTHORIZATION_H */
 
 
+/*
+ * Persistent CGI worker structure...
+ */
+
+typedef struct cupsd_cgi_s
+{
+  char			*command;	/* CGI program */
+  int			pid,		/* Process ID */
+			fd,		/* Request channel */
+			busy;		/* Processing a request? */
+  cupsd_client_t	*con;		/* Client using the worker, if any */
+} cupsd_cgi_t;
+
+
 /*
  * HTTP client structure...
  */
@@ -30,6 +44,8 @@ struct cupsd_client_s
 			*response;	/* IPP response information */
   cupsd_location_t	*best;		/* Best match for AAA */
   struct timeval	start;		/* Request start time */
+  struct timeval	trace_start;	/* Start of current trace span */
+  cupsd_timer_t		timer;		/* Inactivity timer */
   http_state_t		operation;	/* Request operation */
   off_t			bytes;		/* Bytes transferred for this request */
   int			type;		/* AuthType for username */
@@ -46,12 +62,14 @@ struct cupsd_client_s
   int			file;		/* Input/output file */
   int			file_ready;	/* Input ready on file/pipe? */
   int			pipe_pid;	/* Pipe process ID (or 0 if not a pipe) */
+  cupsd_cgi_t		*pipe_worker;	/* Persistent CGI worker, if any */
   http_status_t		pipe_status;	/* HTTP status from pipe process */
   int			sent_header,	/* Non-zero if sent HTTP header */
 			got_fields,	/* Non-zero if all fields seen */
 			header_used;	/* Number of header bytes used */
   char			header[2048];	/* Header from CGI program */
   cups_lang_t		*language;	/* Language to use */
+  const char		*coding;	/* Response content coding, if any */
 #ifdef HAVE_SSL
   int			auto_ssl;	/* Automatic test for SSL/TLS */
 #endif /* HAVE_SSL */
@@ -67,6 +85,10 @@ struct cupsd_client_s
 #ifdef HAVE_AUTHORIZATION_H
   AuthorizationRef	authref;	/* Authorization ref */
 #endif /* HAVE_AUTHORIZATION_H */
+  int			idle_fd;	/* Socket while idle, -1 otherwise */
+  http_addr_t		idle_addr;	/* Peer address while idle */
+  char			*idle_hostname;	/* Peer hostname while idle */
+  time_t		idle_activity;	/* Last activity while idle */
 };
 
 #define HTTP(con) ((con)->http)
@@ -81,6 +103,7 @@ typedef struct
   int			fd;		/* File descriptor for this server */
   http_addr_t		address;	/* Bind address of socket */
   http_encryption_t	encryption;	/* To encrypt or not to encrypt... */
+  int			shard;		/* SO_REUSEPORT shard number, 0 for first */
 #if defined(HAVE_LAUNCHD) || defined(HAVE_SYSTEMD)
   int			on_demand;	/* Is this a socket from launchd/systemd? */
 #endif /* HAVE_LAUNCHD || HAVE_SYSTEMD */
@@ -95,6 +118,8 @@ VAR int			LastClientNumber VALUE(0),
 					/* Last client connection number */
 			ListenBackLog	VALUE(SOMAXCONN),
 					/* Max backlog of pending connections */
+			ListenShards	VALUE(1),
+					/* Number of sockets per listen address */
 			LocalPort	VALUE(631),
 					/* Local port to use */
 			RemotePort	VALUE(0);
@@ -107,8 +132,10 @@ VAR time_t		ListeningPaused	VALUE(0);
 					/* Time when listening was paused */
 VAR cups_array_t	*Clients	VALUE(NULL),
 					/* HTTP clients */
-			*ActiveClients	VALUE(NULL);
+			*ActiveClients	VALUE(NULL),
 					/* Active HTTP clients */
+			*IdleClients	VALUE(NULL);
+					/* Idle keep-alive HTTP clients */
 VAR char		*ServerHeader	VALUE(NULL);
 					/* Server header in requests */
 VAR int			CGIPipes[2]	VALUE2(-1,-1);
@@ -122,6 +149,8 @@ VAR cupsd_statbuf_t	*CGIStatusBuffer VALUE(NULL);
  */
 
 extern void	cupsdAcceptClient(cupsd_listener_t *lis);
+extern int	cupsdClientCount(void);
+extern int	cupsdClientReady(cupsd_client_t *con);
 extern void	cupsdCloseAllClients(void);
 extern int	cupsdCloseClient(cupsd_client_t *con);
 extern void	cupsdDeleteAllListeners(void);
@@ -137,6 +166,7 @@ extern int	cupsdSendHeader(cupsd_client_t *con, http_status_t code,
 		                char *type, int auth_type);
 extern void	cupsdShutdownClient(cupsd_client_t *con);
 extern void	cupsdStartListening(void);
+extern void	cupsdStopCGIWorkers(void);
 extern void	cupsdStopListening(void);
 extern void	cupsdUpdateCGI(void);
 extern void	cupsdWriteClient(cupsd_client_t *con);
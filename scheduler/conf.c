@@ -71,14 +71,17 @@ typedef struct
 
 static const cupsd_var_t	cupsd_vars[] =
 {
+  { "AuthCacheTimeout",		&AuthCacheTimeout,	CUPSD_VARTYPE_TIME },
   { "AutoPurgeJobs", 		&JobAutoPurge,		CUPSD_VARTYPE_BOOLEAN },
 #if defined(HAVE_DNSSD) || defined(HAVE_AVAHI)
   { "BrowseDNSSDSubTypes",	&DNSSDSubTypes,		CUPSD_VARTYPE_STRING },
 #endif /* HAVE_DNSSD || HAVE_AVAHI */
   { "BrowseWebIF",		&BrowseWebIF,		CUPSD_VARTYPE_BOOLEAN },
   { "Browsing",			&Browsing,		CUPSD_VARTYPE_BOOLEAN },
+  { "CGIWorkers",		&CGIWorkers,		CUPSD_VARTYPE_INTEGER },
   { "Classification",		&Classification,	CUPSD_VARTYPE_STRING },
   { "ClassifyOverride",		&ClassifyOverride,	CUPSD_VARTYPE_BOOLEAN },
+  { "CompressResponseSize",	&CompressResponseSize,	CUPSD_VARTYPE_INTEGER },
   { "DefaultLanguage",		&DefaultLanguage,	CUPSD_VARTYPE_STRING },
   { "DefaultLeaseDuration",	&DefaultLeaseDuration,	CUPSD_VARTYPE_TIME },
   { "DefaultPaperSize",		&DefaultPaperSize,	CUPSD_VARTYPE_STRING },
@@ -104,7 +107,9 @@ static const cupsd_var_t	cupsd_vars[] =
 #endif /* HAVE_LAUNCHD */
   { "LimitRequestBody",		&MaxRequestSize,	CUPSD_VARTYPE_INTEGER },
   { "ListenBackLog",		&ListenBackLog,		CUPSD_VARTYPE_INTEGER },
+  { "ListenShards",		&ListenShards,		CUPSD_VARTYPE_INTEGER },
   { "LogDebugHistory",		&LogDebugHistory,	CUPSD_VARTYPE_INTEGER },
+  { "LogQueueSize",		&LogQueueSize,		CUPSD_VARTYPE_INTEGER },
   { "MaxActiveJobs",		&MaxActiveJobs,		CUPSD_VARTYPE_INTEGER },
   { "MaxClients",		&MaxClients,		CUPSD_VARTYPE_INTEGER },
   { "MaxClientsPerHost",	&MaxClientsPerHost,	CUPSD_VARTYPE_INTEGER },
@@ -122,6 +127,7 @@ static const cupsd_var_t	cupsd_vars[] =
   { "MaxSubscriptionsPerJob",	&MaxSubscriptionsPerJob,	CUPSD_VARTYPE_INTEGER },
   { "MaxSubscriptionsPerPrinter",&MaxSubscriptionsPerPrinter,	CUPSD_VARTYPE_INTEGER },
   { "MaxSubscriptionsPerUser",	&MaxSubscriptionsPerUser,	CUPSD_VARTYPE_INTEGER },
+  { "Metrics",			&Metrics,		CUPSD_VARTYPE_BOOLEAN },
   { "MultipleOperationTimeout",	&MultipleOperationTimeout,	CUPSD_VARTYPE_TIME },
   { "PageLogFormat",		&PageLogFormat,		CUPSD_VARTYPE_STRING },
   { "PreserveJobFiles",		&JobFiles,		CUPSD_VARTYPE_TIME },
@@ -162,7 +168,8 @@ static const cupsd_var_t	cupsfiles_vars[] =
 #ifdef HAVE_AUTHORIZATION_H
   { "SystemGroupAuthKey",	&SystemGroupAuthKey,	CUPSD_VARTYPE_STRING },
 #endif /* HAVE_AUTHORIZATION_H */
-  { "TempDir",			&TempDir,		CUPSD_VARTYPE_PATHNAME }
+  { "TempDir",			&TempDir,		CUPSD_VARTYPE_PATHNAME },
+  { "TraceLog",			&TraceLog,		CUPSD_VARTYPE_STRING }
 };
 
 static int		default_auth_type = CUPSD_AUTH_AUTO;
@@ -595,6 +602,7 @@ cupsdReadConfiguration(void)
   */
 
   cupsdDeleteAllLocations();
+  cupsdFlushAuthCache();
 
   cupsdDeleteAllListeners();
 
@@ -618,6 +626,7 @@ cupsdReadConfiguration(void)
   cupsdSetString(&AccessLog, CUPS_LOGDIR "/access_log");
   cupsdClearString(&ErrorLog);
   cupsdSetString(&PageLog, CUPS_LOGDIR "/page_log");
+  cupsdClearString(&TraceLog);
   cupsdSetString(&PageLogFormat,
                  "%p %u %j %T %P %C %{job-billing} "
 		 "%{job-originating-host-name} %{job-name} %{media} %{sides}");
@@ -737,6 +746,9 @@ cupsdReadConfiguration(void)
   */
 
   AccessLogLevel           = CUPSD_ACCESSLOG_ACTIONS;
+  AuthCacheTimeout         = 0;
+  CGIWorkers               = 1;
+  CompressResponseSize     = 65536;
   ConfigFilePerm           = CUPS_DEFAULT_CONFIG_FILE_PERM;
   FatalErrors              = parse_fatal_errors(CUPS_DEFAULT_FATAL_ERRORS);
   default_auth_type        = CUPSD_AUTH_BASIC;
@@ -755,7 +767,9 @@ cupsdReadConfiguration(void)
   KeepAlive                = TRUE;
   KeepAliveTimeout         = DEFAULT_KEEPALIVE;
   ListenBackLog            = SOMAXCONN;
+  ListenShards             = 1;
   LogDebugHistory          = 200;
+  LogQueueSize             = 0;
   LogFilePerm              = CUPS_DEFAULT_LOG_FILE_PERM;
   LogLevel                 = CUPSD_LOG_WARN;
   LogTimeFormat            = CUPSD_TIME_STANDARD;
@@ -763,6 +777,7 @@ cupsdReadConfiguration(void)
   MaxClientsPerHost        = 0;
   MaxLogSize               = 1024 * 1024;
   MaxRequestSize           = 0;
+  Metrics                  = FALSE;
   MultipleOperationTimeout = DEFAULT_TIMEOUT;
   NumSystemGroups          = 0;
   ReloadTimeout	           = DEFAULT_KEEPALIVE;
@@ -1207,6 +1222,8 @@ cupsdReadConfiguration(void)
 			     Group, 1, 0) < 0 ||
        cupsdCheckPermissions(ServerRoot, "ppd", 0755, RunUser,
 			     Group, 1, 1) < 0 ||
+       cupsdCheckPermissions(ServerRoot, "printers", 0700, RunUser,
+			     Group, 1, 1) < 0 ||
        cupsdCheckPermissions(ServerRoot, "ssl", 0700, RunUser,
 			     Group, 1, 0) < 0 ||
        cupsdCheckPermissions(ConfigurationFile, NULL, ConfigFilePerm, RunUser,
@@ -1391,6 +1408,27 @@ cupsdReadConfiguration(void)
                   "Allowing up to %d client connections per host.",
                   MaxClientsPerHost);
 
+ /*
+  * Check the ListenBackLog and ListenShards settings...
+  */
+
+  if (ListenBackLog <= 0)
+    ListenBackLog = SOMAXCONN;
+
+  if (ListenShards < 1)
+    ListenShards = 1;
+  else if (ListenShards > 64)
+    ListenShards = 64;
+
+#ifndef SO_REUSEPORT
+  if (ListenShards > 1)
+  {
+    cupsdLogMessage(CUPSD_LOG_WARN,
+                    "ListenShards is not supported on this system.");
+    ListenShards = 1;
+  }
+#endif /* !SO_REUSEPORT */
+
  /*
   * Update the default policy, as needed...
   */
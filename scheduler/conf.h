@@ -168,6 +168,10 @@ VAR int			ClassifyOverride	VALUE(0),
 					/* Allow overrides? */
 			LogDebugHistory		VALUE(200),
 					/* Amount of automatic debug history */
+			LogQueueSize		VALUE(0),
+					/* Size of log queue, 0 = no log thread */
+			AuthCacheTimeout	VALUE(0),
+					/* Time to cache authentication, 0 = off */
 			FatalErrors		VALUE(CUPSD_FATAL_CONFIG),
 					/* Which errors are fatal? */
 			StrictConformance	VALUE(FALSE),
@@ -198,6 +202,10 @@ VAR int			MaxClients		VALUE(100),
 					/* Maximum size of log files */
 			MaxRequestSize		VALUE(0),
 					/* Maximum size of IPP requests */
+			CompressResponseSize	VALUE(65536),
+					/* Minimum size of compressed responses */
+			CGIWorkers		VALUE(1),
+					/* Persistent workers per CGI program */
 			HostNameLookups		VALUE(FALSE),
 					/* Do we do reverse lookups? */
 			Timeout			VALUE(DEFAULT_TIMEOUT),
@@ -279,6 +287,7 @@ extern int	cupsdCheckProgram(const char *filename, cupsd_printer_t *p);
 extern int	cupsdDefaultAuthType(void);
 extern void	cupsdFreeAliases(cups_array_t *aliases);
 extern char	*cupsdGetDateTime(struct timeval *t, cupsd_time_t format);
+extern unsigned	cupsdGetLogDropped(void);
 extern int	cupsdLogClient(cupsd_client_t *con, int level,
                                const char *message, ...)
                                __attribute__((__format__(__printf__, 3, 4)));
@@ -296,6 +305,8 @@ extern int	cupsdLogMessage(int level, const char *message, ...)
 extern int	cupsdLogPage(cupsd_job_t *job, const char *page);
 extern int	cupsdLogRequest(cupsd_client_t *con, http_status_t code);
 extern int	cupsdReadConfiguration(void);
+extern void	cupsdStartLogThread(void);
+extern void	cupsdStopLogThread(void);
 extern int	cupsdWriteErrorLog(int level, const char *message);
 
 
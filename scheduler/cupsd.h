@@ -88,6 +88,24 @@ extern const char *cups_hstrerror(int);
 #define DEFAULT_KEEPALIVE	30	/* Timeout between requests */
 
 
+/*
+ * Atomic operations for data that is shared with helper threads...
+ */
+
+#if defined(__clang__) || (defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 7)))
+#  define CUPSD_HAVE_ATOMICS	1
+#  define cupsdAtomicGet(p)	__atomic_load_n((p), __ATOMIC_SEQ_CST)
+#  define cupsdAtomicSet(p,v)	__atomic_store_n((p), (v), __ATOMIC_SEQ_CST)
+#  define cupsdAtomicAdd(p,v)	__atomic_add_fetch((p), (v), __ATOMIC_RELAXED)
+#  define cupsdAtomicSwap(p,v)	__atomic_exchange_n((p), (v), __ATOMIC_SEQ_CST)
+#  define cupsdAtomicCAS(p,o,n)	__atomic_compare_exchange_n((p), (o), (n), 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST)
+#else
+#  define cupsdAtomicGet(p)	(*(p))
+#  define cupsdAtomicSet(p,v)	(*(p) = (v))
+#  define cupsdAtomicAdd(p,v)	(*(p) += (v))
+#endif /* __clang__ || __GNUC__ >= 4.7 */
+
+
 /*
  * Global variable macros...
  */
@@ -108,6 +126,7 @@ extern const char *cups_hstrerror(int);
  */
 
 #include "sysman.h"
+#include "timer.h"
 #include "statbuf.h"
 #include "cert.h"
 #include "auth.h"
@@ -122,6 +141,8 @@ extern const char *cups_hstrerror(int);
 #include "dirsvc.h"
 #include "network.h"
 #include "subscriptions.h"
+#include "metrics.h"
+#include "trace.h"
 
 
 /*
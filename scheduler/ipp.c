@@ -85,6 +85,7 @@ static void	copy_subscription_attrs(cupsd_client_t *con,
 					cups_array_t *exclude);
 static void	create_job(cupsd_client_t *con, ipp_attribute_t *uri);
 static cups_array_t *create_requested_array(ipp_t *request);
+static cups_array_t *create_search_array(ipp_t *request);
 static void	create_subscriptions(cupsd_client_t *con, ipp_attribute_t *uri);
 static void	delete_printer(cupsd_client_t *con, ipp_attribute_t *uri);
 static void	get_default(cupsd_client_t *con);
@@ -103,6 +104,8 @@ static void	get_subscriptions(cupsd_client_t *con, ipp_attribute_t *uri);
 static const char *get_username(cupsd_client_t *con);
 static void	hold_job(cupsd_client_t *con, ipp_attribute_t *uri);
 static void	hold_new_jobs(cupsd_client_t *con, ipp_attribute_t *uri);
+static int	match_search(cups_array_t *search, ipp_attribute_t *attr);
+static int	match_search_text(cups_array_t *search, const char *text);
 static void	move_job(cupsd_client_t *con, ipp_attribute_t *uri);
 static int	ppd_parse_line(const char *line, char *option, int olen,
 		               char *choice, int clen);
@@ -112,6 +115,7 @@ static void	reject_jobs(cupsd_client_t *con, ipp_attribute_t *uri);
 static void	release_held_new_jobs(cupsd_client_t *con,
 		                      ipp_attribute_t *uri);
 static void	release_job(cupsd_client_t *con, ipp_attribute_t *uri);
+static void	remove_attrs(ipp_t *ipp, ipp_attribute_t *last);
 static void	renew_subscription(cupsd_client_t *con, int sub_id);
 static void	restart_job(cupsd_client_t *con, ipp_attribute_t *uri);
 static void	save_auth_info(cupsd_client_t *con, cupsd_job_t *job,
@@ -152,12 +156,15 @@ cupsdProcessIPPRequest(
   ipp_attribute_t	*uri = NULL;	/* Printer or job URI attribute */
   ipp_attribute_t	*username;	/* requesting-user-name attr */
   int			sub_id;		/* Subscription ID */
+  struct timeval	start;		/* Start time of request */
 
 
   cupsdLogMessage(CUPSD_LOG_DEBUG2,
                   "cupsdProcessIPPRequest(%p[%d]): operation_id = %04x",
                   con, con->number, con->request->request.op.operation_id);
 
+  gettimeofday(&start, NULL);
+
  /*
   * First build an empty response message for this request...
   */
@@ -623,6 +630,15 @@ cupsdProcessIPPRequest(
     }
   }
 
+  cupsdMetricsAddRequest(con->request->request.op.operation_id, &start);
+
+  if (TraceFile)
+  {
+    cupsdTraceSpan(CUPSD_TRACE_CLIENT, con->number, "operation", &start,
+                   ippOpString(con->request->request.op.operation_id));
+    gettimeofday(&con->trace_start, NULL);
+  }
+
   if (con->response)
   {
    /*
@@ -675,10 +691,29 @@ cupsdProcessIPPRequest(
 	  length += (size_t)fileinfo.st_size;
       }
 
-      cupsdLogMessage(CUPSD_LOG_DEBUG,
-		      "[Client %d] Content-Length: " CUPS_LLFMT,
-		      con->number, CUPS_LLCAST length);
-      httpSetLength(con->http, length);
+      if (con->coding && length >= (size_t)CompressResponseSize)
+      {
+       /*
+        * Compress large responses for clients that support it; the
+	* compressed length isn't known up front, so use chunking...
+	*/
+
+	cupsdLogMessage(CUPSD_LOG_DEBUG,
+			"[Client %d] Content-Encoding: %s (" CUPS_LLFMT
+			" bytes)", con->number, con->coding,
+			CUPS_LLCAST length);
+	httpSetLength(con->http, 0);
+	httpSetField(con->http, HTTP_FIELD_CONTENT_ENCODING, con->coding);
+      }
+      else
+      {
+        con->coding = NULL;
+
+	cupsdLogMessage(CUPSD_LOG_DEBUG,
+			"[Client %d] Content-Length: " CUPS_LLFMT,
+			con->number, CUPS_LLCAST length);
+	httpSetLength(con->http, length);
+      }
     }
 
     if (cupsdSendHeader(con, HTTP_OK, "application/ipp", CUPSD_AUTH_NONE))
@@ -1719,6 +1754,8 @@ add_job(cupsd_client_t  *con,		/* I - Client connection */
     ippSetString(job->attrs, &job->reasons, 0, "none");
   }
 
+  cupsdUpdateJobTimer(job);
+
   if (!(printer->type & CUPS_PRINTER_REMOTE) || Classification)
   {
    /*
@@ -1910,6 +1947,15 @@ add_job(cupsd_client_t  *con,		/* I - Client connection */
 
   cupsdAddEvent(CUPSD_EVENT_JOB_CREATED, printer, job, "Job created.");
 
+ /*
+  * Record the time spent receiving the request, including any document data,
+  * on the job's trace track...
+  */
+
+  if (TraceFile)
+    cupsdTraceSpan(CUPSD_TRACE_JOB, job->id, "spool", &con->start,
+                   ippOpString(con->request->request.op.operation_id));
+
  /*
   * Return the new job...
   */
@@ -5274,6 +5320,111 @@ create_requested_array(ipp_t *request)	/* I - IPP request */
   return (ra);
 }
 
+/*
+ * 'create_search_array()' - Create an array for the search-query words.
+ *
+ * The query uses the same syntax as the web interface search field.  Each
+ * word is stored with a "|" prefix when it starts a new alternative or a "&"
+ * prefix when it must match together with the preceding word(s).
+ */
+
+static cups_array_t *			/* O - Array of words or NULL */
+create_search_array(ipp_t *request)	/* I - IPP request */
+{
+  ipp_attribute_t	*attr;		/* search-query attribute */
+  cups_array_t		*search;	/* Search words */
+  const char		*qptr,		/* Pointer into query */
+			*qend;		/* End of current word */
+  char			prefix,		/* Prefix for next word */
+			word[256];	/* Current word with prefix */
+  int			quoted;		/* Quote character or 0 */
+  size_t		wlen;		/* Length of current word */
+
+
+  if ((attr = ippFindAttribute(request, "search-query",
+                               IPP_TAG_TEXT)) == NULL)
+    return (NULL);
+
+  search = cupsArrayNew3(NULL, NULL, NULL, 0, (cups_acopy_func_t)strdup,
+                         (cups_afree_func_t)free);
+  prefix = '|';
+
+  for (qptr = attr->values[0].string.text; *qptr;)
+  {
+   /*
+    * Skip leading whitespace and find the end of the current word...
+    */
+
+    while (isspace(*qptr & 255))
+      qptr ++;
+
+    if (!*qptr)
+      break;
+
+    if (*qptr == '\"' || *qptr == '\'')
+    {
+      quoted = *qptr++;
+
+      for (qend = qptr; *qend && *qend != quoted; qend ++);
+
+      if (!*qend)
+      {
+       /*
+        * No closing quote, ignore the query...
+	*/
+
+        cupsArrayDelete(search);
+	return (NULL);
+      }
+    }
+    else
+    {
+      quoted = 0;
+
+      for (qend = qptr + 1; *qend && !isspace(*qend & 255); qend ++);
+    }
+
+    wlen = (size_t)(qend - qptr);
+
+   /*
+    * Look for logic words: AND, OR
+    */
+
+    if (wlen == 3 && !_cups_strncasecmp(qptr, "AND", 3))
+    {
+      if (cupsArrayCount(search) > 0)
+        prefix = '&';
+    }
+    else if (wlen == 2 && !_cups_strncasecmp(qptr, "OR", 2))
+    {
+      prefix = '|';
+    }
+    else
+    {
+      if (wlen > (sizeof(word) - 2))
+        wlen = sizeof(word) - 2;
+
+      word[0] = prefix;
+      memcpy(word + 1, qptr, wlen);
+      word[wlen + 1] = '\0';
+
+      cupsArrayAdd(search, word);
+
+      prefix = '|';
+    }
+
+    qptr = quoted ? qend + 1 : qend;
+  }
+
+  if (!cupsArrayCount(search))
+  {
+    cupsArrayDelete(search);
+    search = NULL;
+  }
+
+  return (search);
+}
+
 
 /*
  * 'create_subscriptions()' - Create one or more notification subscriptions.
@@ -5619,6 +5770,8 @@ create_subscriptions(
     sub->lease    = lease;
     sub->expire   = lease ? time(NULL) + lease : 0;
 
+    cupsdUpdateSubscriptionTimer(sub);
+
     cupsdSetString(&sub->owner, username);
 
     if (user_data)
@@ -5719,6 +5872,13 @@ delete_printer(cupsd_client_t  *con,	/* I - Client connection */
            printer->name);
   unlink(filename);
 
+  snprintf(filename, sizeof(filename), "%s/printers/%s.state", ServerRoot,
+           printer->name);
+  unlink(filename);
+  snprintf(filename, sizeof(filename), "%s/printers/%s.state.O", ServerRoot,
+           printer->name);
+  unlink(filename);
+
   snprintf(filename, sizeof(filename), "%s/%s.png", CacheDir, printer->name);
   unlink(filename);
 
@@ -6180,7 +6340,8 @@ get_jobs(cupsd_client_t  *con,		/* I - Client connection */
 		first_index = 1,	/* First index */
 		current_index = 0;	/* Current index */
   int		limit = 0;		/* Maximum number of jobs to return */
-  int		count;			/* Number of jobs that match */
+  int		count;			/* Number of jobs that are returned */
+  int		descending;		/* Return jobs in reverse order? */
   int		need_load_job = 0;	/* Do we need to load the job? */
   const char	*job_attr;		/* Job attribute requested */
   ipp_attribute_t *job_ids;		/* job-ids attribute */
@@ -6189,7 +6350,14 @@ get_jobs(cupsd_client_t  *con,		/* I - Client connection */
   cups_array_t	*list;			/* Which job list... */
   int		delete_list = 0;	/* Delete the list afterwards? */
   cups_array_t	*ra,			/* Requested attributes array */
-		*exclude;		/* Private attributes array */
+		*exclude,		/* Private attributes array */
+		*search;		/* Search words */
+  ipp_attribute_t *last,		/* Last attribute before job */
+		*total_count;		/* total-count attribute */
+  cupsd_policy_t *job_policy,		/* Policy for current job */
+		*exclude_policy;	/* Policy for private attributes */
+  cupsd_printer_t *exclude_printer;	/* Printer for private attributes */
+  const char	*exclude_owner;		/* Owner for private attributes */
   cupsd_policy_t *policy;		/* Current policy */
 
 
@@ -6265,6 +6433,25 @@ get_jobs(cupsd_client_t  *con,		/* I - Client connection */
 
   job_ids = ippFindAttribute(con->request, "job-ids", IPP_TAG_INTEGER);
 
+ /*
+  * See if they want the jobs in a particular order...
+  */
+
+  if ((attr = ippFindAttribute(con->request, "sort-order",
+                               IPP_TAG_KEYWORD)) != NULL &&
+      strcmp(attr->values[0].string.text, "ascending") &&
+      strcmp(attr->values[0].string.text, "descending"))
+  {
+    send_ipp_status(con, IPP_ATTRIBUTES,
+                    _("The sort-order value \"%s\" is not supported."),
+		    attr->values[0].string.text);
+    ippAddString(con->response, IPP_TAG_UNSUPPORTED_GROUP, IPP_TAG_KEYWORD,
+                 "sort-order", NULL, attr->values[0].string.text);
+    return;
+  }
+
+  descending = attr && !strcmp(attr->values[0].string.text, "descending");
+
  /*
   * See if the "which-jobs" attribute have been specified...
   */
@@ -6424,6 +6611,12 @@ get_jobs(cupsd_client_t  *con,		/* I - Client connection */
       break;
     }
 
+  if (job_ids)
+    total_count = NULL;
+  else
+    total_count = ippAddInteger(con->response, IPP_TAG_OPERATION,
+                                IPP_TAG_INTEGER, "total-count", 0);
+
   if (need_load_job && (limit == 0 || limit > 500) && (list == Jobs || delete_list))
   {
    /*
@@ -6489,9 +6682,20 @@ get_jobs(cupsd_client_t  *con,		/* I - Client connection */
   }
   else
   {
-    for (count = 0, job = (cupsd_job_t *)cupsArrayFirst(list);
-	 (limit <= 0 || count < limit) && job;
-	 job = (cupsd_job_t *)cupsArrayNext(list))
+   /*
+    * Jobs past the limit are still checked against the filters so that
+    * clients can page through the list using "total-count"...
+    */
+
+    search = create_search_array(con->request);
+
+    for (count = 0, exclude = NULL, exclude_policy = NULL,
+             exclude_printer = NULL, exclude_owner = NULL,
+             job = (cupsd_job_t *)(descending ? cupsArrayLast(list) :
+	                                        cupsArrayFirst(list));
+	 job;
+	 job = (cupsd_job_t *)(descending ? cupsArrayPrev(list) :
+	                                    cupsArrayNext(list)))
     {
      /*
       * Filter out jobs that don't match...
@@ -6523,8 +6727,65 @@ get_jobs(cupsd_client_t  *con,		/* I - Client connection */
       if (job->id < first_job_id)
 	continue;
 
+      if (username[0] && _cups_strcasecmp(username, job->username))
+	continue;
+
+      job_policy = job->printer ? job->printer->op_policy_ptr : policy;
+
+      if ((search || (current_index + 1 >= first_index &&
+                      (limit <= 0 || count < limit))) &&
+          (!exclude_owner || job_policy != exclude_policy ||
+	   strcmp(job->username, exclude_owner) ||
+	   (job->printer != exclude_printer &&
+	    (cupsArrayCount(job->printer ? job->printer->users : NULL) ||
+	     cupsArrayCount(exclude_printer ? exclude_printer->users : NULL)))))
+      {
+       /*
+        * Get the private attributes, reusing them for consecutive jobs with
+	* the same policy and owner (the printer only matters for @ACL)...
+	*/
+
+	exclude = cupsdGetPrivateAttrs(job_policy, con, job->printer,
+	                               job->username);
+
+        exclude_policy  = job_policy;
+        exclude_printer = job->printer;
+        exclude_owner   = job->username;
+      }
+
+      if (search)
+      {
+       /*
+        * Check the attributes the client would see, loading the job when
+	* attributes other than the core ones were requested so that the
+	* result does not depend on which jobs are in memory...
+	*/
+
+        int	matched;		/* Does the job match? */
+
+        if (need_load_job && !job->attrs)
+        {
+          cupsdLoadJob(job);
+
+	  if (!job->attrs)
+	  {
+	    cupsdLogMessage(CUPSD_LOG_DEBUG2, "get_jobs: No attributes for job %d", job->id);
+	    continue;
+	  }
+        }
+
+        last = con->response->last;
+
+        copy_job_attrs(con, job, ra, exclude);
+	matched = match_search(search, last->next);
+	remove_attrs(con->response, last);
+
+	if (!matched)
+	  continue;
+      }
+
       current_index ++;
-      if (current_index < first_index)
+      if (current_index < first_index || (limit > 0 && count >= limit))
         continue;
 
       if (need_load_job && !job->attrs)
@@ -6538,23 +6799,20 @@ get_jobs(cupsd_client_t  *con,		/* I - Client connection */
 	}
       }
 
-      if (username[0] && _cups_strcasecmp(username, job->username))
-	continue;
-
       if (count > 0)
 	ippAddSeparator(con->response);
 
       count ++;
 
-      exclude = cupsdGetPrivateAttrs(job->printer ?
-                                         job->printer->op_policy_ptr :
-					 policy, con, job->printer,
-					 job->username);
-
       copy_job_attrs(con, job, ra, exclude);
     }
 
-    cupsdLogMessage(CUPSD_LOG_DEBUG2, "get_jobs: count=%d", count);
+    total_count->values[0].integer = current_index;
+
+    cupsArrayDelete(search);
+
+    cupsdLogMessage(CUPSD_LOG_DEBUG2, "get_jobs: count=%d, total=%d", count,
+                    current_index);
   }
 
   cupsArrayDelete(ra);
@@ -7148,14 +7406,20 @@ get_printers(cupsd_client_t *con,	/* I - Client connection */
   http_status_t	status;			/* Policy status */
   ipp_attribute_t *attr;		/* Current attribute */
   int		limit;			/* Max number of printers to return */
-  int		count;			/* Number of printers that match */
+  int		count;			/* Number of printers that are returned */
+  int		total;			/* Number of printers that match */
+  int		first_index;		/* First index */
+  int		descending;		/* Return printers in reverse order? */
   cupsd_printer_t *printer;		/* Current printer pointer */
   cups_ptype_t	printer_type,		/* printer-type attribute */
 		printer_mask;		/* printer-type-mask attribute */
   char		*location;		/* Location string */
   const char	*username;		/* Current user */
   char		*first_printer_name;	/* first-printer-name attribute */
-  cups_array_t	*ra;			/* Requested attributes array */
+  cups_array_t	*ra,			/* Requested attributes array */
+		*search;		/* Search words */
+  ipp_attribute_t *last,		/* Last attribute before printer */
+		*total_count;		/* total-count attribute */
   int		local;			/* Local connection? */
 
 
@@ -7198,6 +7462,27 @@ get_printers(cupsd_client_t *con,	/* I - Client connection */
   else
     first_printer_name = NULL;
 
+  if ((attr = ippFindAttribute(con->request, "first-index",
+                               IPP_TAG_INTEGER)) != NULL)
+    first_index = attr->values[0].integer;
+  else
+    first_index = 1;
+
+  if ((attr = ippFindAttribute(con->request, "sort-order",
+                               IPP_TAG_KEYWORD)) != NULL &&
+      strcmp(attr->values[0].string.text, "ascending") &&
+      strcmp(attr->values[0].string.text, "descending"))
+  {
+    send_ipp_status(con, IPP_ATTRIBUTES,
+                    _("The sort-order value \"%s\" is not supported."),
+		    attr->values[0].string.text);
+    ippAddString(con->response, IPP_TAG_UNSUPPORTED_GROUP, IPP_TAG_KEYWORD,
+                 "sort-order", NULL, attr->values[0].string.text);
+    return;
+  }
+
+  descending = attr && !strcmp(attr->values[0].string.text, "descending");
+
  /*
   * Support filtering...
   */
@@ -7230,23 +7515,26 @@ get_printers(cupsd_client_t *con,	/* I - Client connection */
   else
     username = NULL;
 
-  ra = create_requested_array(con->request);
+  ra     = create_requested_array(con->request);
+  search = create_search_array(con->request);
+
+  total_count = ippAddInteger(con->response, IPP_TAG_OPERATION,
+                              IPP_TAG_INTEGER, "total-count", 0);
 
  /*
-  * OK, build a list of printers for this printer...
+  * OK, build a list of printers for this printer...  Printers past the
+  * limit are still checked so that "total-count" covers all matches.
   */
 
-  if (first_printer_name)
-  {
-    if ((printer = cupsdFindDest(first_printer_name)) == NULL)
-      printer = (cupsd_printer_t *)cupsArrayFirst(Printers);
-  }
-  else
-    printer = (cupsd_printer_t *)cupsArrayFirst(Printers);
+  if (!first_printer_name ||
+      (printer = cupsdFindDest(first_printer_name)) == NULL)
+    printer = (cupsd_printer_t *)(descending ? cupsArrayLast(Printers) :
+                                               cupsArrayFirst(Printers));
 
-  for (count = 0;
-       count < limit && printer;
-       printer = (cupsd_printer_t *)cupsArrayNext(Printers))
+  for (count = 0, total = 0;
+       printer;
+       printer = (cupsd_printer_t *)(descending ? cupsArrayPrev(Printers) :
+                                                  cupsArrayNext(Printers)))
   {
     if (!local && !printer->shared)
       continue;
@@ -7265,6 +7553,24 @@ get_printers(cupsd_client_t *con,	/* I - Client connection */
 	  !user_allowed(printer, username))
         continue;
 
+      if (search)
+      {
+        int	matched;		/* Does the printer match? */
+
+        last = con->response->last;
+
+        copy_printer_attrs(con, printer, ra);
+	matched = match_search(search, last->next);
+	remove_attrs(con->response, last);
+
+	if (!matched)
+	  continue;
+      }
+
+      total ++;
+      if (total < first_index || count >= limit)
+        continue;
+
      /*
       * Add the group separator as needed...
       */
@@ -7282,7 +7588,10 @@ get_printers(cupsd_client_t *con,	/* I - Client connection */
     }
   }
 
+  total_count->values[0].integer = total;
+
   cupsArrayDelete(ra);
+  cupsArrayDelete(search);
 
   con->response->request.status.status_code = IPP_OK;
 }
@@ -7741,6 +8050,109 @@ hold_new_jobs(cupsd_client_t  *con,	/* I - Connection */
 }
 
 
+/*
+ * 'match_search()' - See if an object's attributes match a search query.
+ *
+ * Like the web interface, text, name, keyword, URI, and MIME type values
+ * and integer values other than "time-at-xxx" are checked.
+ */
+
+static int				/* O - 1 if matched, 0 otherwise */
+match_search(cups_array_t    *search,	/* I - Search words */
+             ipp_attribute_t *attr)	/* I - First attribute to check */
+{
+  int		i;			/* Looping var */
+  char		number[255];		/* Integer value as a string */
+
+
+  for (; attr; attr = attr->next)
+  {
+    if (!attr->name)
+      continue;
+
+    switch (attr->value_tag)
+    {
+      case IPP_TAG_TEXTLANG :
+      case IPP_TAG_NAMELANG :
+      case IPP_TAG_TEXT :
+      case IPP_TAG_NAME :
+      case IPP_TAG_KEYWORD :
+      case IPP_TAG_URI :
+      case IPP_TAG_MIMETYPE :
+          for (i = 0; i < attr->num_values; i ++)
+	    if (match_search_text(search, attr->values[i].string.text))
+	      return (1);
+	  break;
+
+      case IPP_TAG_INTEGER :
+          if (!strncmp(attr->name, "time-at-", 8))
+	    break;			/* Ignore time-at-xxx */
+
+          for (i = 0; i < attr->num_values; i ++)
+	  {
+	    snprintf(number, sizeof(number), "%d", attr->values[i].integer);
+
+	    if (match_search_text(search, number))
+	      return (1);
+	  }
+	  break;
+
+      default :
+          break;
+    }
+  }
+
+  return (0);
+}
+
+
+/*
+ * 'match_search_text()' - See if a string matches a search query.
+ */
+
+static int				/* O - 1 if matched, 0 otherwise */
+match_search_text(cups_array_t *search,	/* I - Search words */
+                  const char   *text)	/* I - Text to check */
+{
+  const char	*word,			/* Current word */
+		*tptr;			/* Pointer into text */
+  size_t	wlen;			/* Length of word */
+  int		matched = 0;		/* Do all words so far match? */
+
+
+  if (!text)
+    return (0);
+
+  for (word = (const char *)cupsArrayFirst(search);
+       word;
+       word = (const char *)cupsArrayNext(search))
+  {
+    if (*word == '|')
+    {
+     /*
+      * Start of a new alternative; stop if the previous one matched...
+      */
+
+      if (matched)
+        return (1);
+
+      matched = 1;
+    }
+    else if (!matched)
+      continue;
+
+    for (wlen = strlen(word + 1), tptr = text; *tptr; tptr ++)
+      if (!_cups_strncasecmp(tptr, word + 1, wlen))
+        break;
+
+    if (!*tptr && wlen)
+      matched = 0;
+  }
+
+  return (matched);
+}
+
+
 /*
  * 'move_job()' - Move a job to a new destination.
  */
@@ -8212,6 +8624,8 @@ print_job(cupsd_client_t  *con,		/* I - Client connection */
 
     cupsdLogMessage(CUPSD_LOG_DEBUG, "[Job ???] Auto-typing file...");
 
+    if (TraceFile)
+      gettimeofday(&con->trace_start, NULL);
 
     filetype = mimeFileType(MimeDatabase, con->filename,
                             doc_name ? doc_name->values[0].string.text : NULL,
@@ -8220,6 +8634,10 @@ print_job(cupsd_client_t  *con,		/* I - Client connection */
     if (!filetype)
       filetype = mimeType(MimeDatabase, super, type);
 
+    if (TraceFile)
+      cupsdTraceSpan(CUPSD_TRACE_CLIENT, con->number, "auto-type",
+                     &con->trace_start, filetype ? filetype->type : NULL);
+
     cupsdLogMessage(CUPSD_LOG_INFO, "[Job ???] Request file type is %s/%s.",
 		    filetype->super, filetype->type);
 
@@ -8815,6 +9233,35 @@ release_job(cupsd_client_t  *con,	/* I - Client connection */
 }
 
 
+/*
+ * 'remove_attrs()' - Remove the attributes following "last" from a message.
+ */
+
+static void
+remove_attrs(ipp_t           *ipp,	/* I - IPP message */
+             ipp_attribute_t *last)	/* I - Last attribute to keep */
+{
+  ipp_attribute_t	*attr,		/* Current attribute */
+			*next;		/* Next attribute */
+
+
+  for (attr = last ? last->next : ipp->attrs; attr; attr = next)
+  {
+    next = attr->next;
+
+    ippDeleteAttribute(NULL, attr);
+  }
+
+  if (last)
+    last->next = NULL;
+  else
+    ipp->attrs = NULL;
+
+  ipp->last    = last;
+  ipp->current = last;
+}
+
+
 /*
  * 'renew_subscription()' - Renew an existing subscription...
  */
@@ -8891,6 +9338,8 @@ renew_subscription(
 
   sub->expire = sub->lease ? time(NULL) + sub->lease : 0;
 
+  cupsdUpdateSubscriptionTimer(sub);
+
   cupsdMarkDirty(CUPSD_DIRTY_SUBSCRIPTIONS);
 
   con->response->request.status.status_code = IPP_OK;
@@ -9458,6 +9907,9 @@ send_document(cupsd_client_t  *con,	/* I - Client connection */
 
     cupsdLogJob(job, CUPSD_LOG_DEBUG, "Auto-typing file...");
 
+    if (TraceFile)
+      gettimeofday(&con->trace_start, NULL);
+
     doc_name = ippFindAttribute(con->request, "document-name", IPP_TAG_NAME);
     filetype = mimeFileType(MimeDatabase, con->filename,
                             doc_name ? doc_name->values[0].string.text : NULL,
@@ -9466,6 +9918,10 @@ send_document(cupsd_client_t  *con,	/* I - Client connection */
     if (!filetype)
       filetype = mimeType(MimeDatabase, super, type);
 
+    if (TraceFile)
+      cupsdTraceSpan(CUPSD_TRACE_CLIENT, con->number, "auto-type",
+                     &con->trace_start, filetype ? filetype->type : NULL);
+
     if (filetype)
       cupsdLogJob(job, CUPSD_LOG_DEBUG, "Request file type is %s/%s.",
 		  filetype->super, filetype->type);
@@ -9620,6 +10076,8 @@ send_document(cupsd_client_t  *con,	/* I - Client connection */
       job->state_value              = IPP_JOB_HELD;
       job->hold_until               = time(NULL) + MultipleOperationTimeout;
 
+      cupsdUpdateJobTimer(job);
+
       ippSetString(job->attrs, &job->reasons, 0, "job-incoming");
 
       job->dirty = 1;
@@ -112,12 +112,17 @@ static mime_filter_t	gziptoany_filter =
 			  0,		/* Cost */
 			  "gziptoany"	/* Filter program to run */
 			};
+static cupsd_timer_t	check_timer,	/* Pending job check timer */
+			history_timer,	/* Job history cleanup timer */
+			unload_timer;	/* Completed job unload timer */
 
 
 /*
  * Local functions...
  */
 
+static void	check_jobs(void *data);
+static void	clean_jobs(void *data);
 static int	compare_active_jobs(void *first, void *second, void *data);
 static int	compare_completed_jobs(void *first, void *second, void *data);
 static int	compare_jobs(void *first, void *second, void *data);
@@ -128,6 +133,7 @@ static char	*get_options(cupsd_job_t *job, int banner_page, char *copies,
 		             size_t copies_size, char *title,
 			     size_t title_size);
 static size_t	ipp_length(ipp_t *ipp);
+static void	job_timeout(cupsd_job_t *job);
 static void	load_job_cache(const char *filename);
 static void	load_next_job_id(const char *filename);
 static void	load_request_root(void);
@@ -135,8 +141,11 @@ static void	remove_job_files(cupsd_job_t *job);
 static void	remove_job_history(cupsd_job_t *job);
 static void	set_time(cupsd_job_t *job, const char *name);
 static void	start_job(cupsd_job_t *job, cupsd_printer_t *printer);
+static void	start_unload_timer(void);
 static void	stop_job(cupsd_job_t *job, cupsd_jobaction_t action);
 static void	unload_job(cupsd_job_t *job);
+static void	unload_jobs(void *data);
+static void	update_history_timer(void);
 static void	update_job(cupsd_job_t *job);
 static void	update_job_attrs(cupsd_job_t *job, int do_message);
 
@@ -229,6 +238,7 @@ cupsdCheckJobs(void)
 			*pclass;	/* Printer class destination */
   ipp_attribute_t	*attr;		/* Job attribute */
   time_t		curtime;	/* Current time */
+  int			pending = 0;	/* Jobs still waiting to print? */
 
 
   curtime = time(NULL);
@@ -322,6 +332,9 @@ cupsdCheckJobs(void)
 	((FilterLevel + job->pending_cost) < FilterLimit || FilterLevel == 0))
       cupsdContinueJob(job);
 
+    if (job->pending_cost > 0 || job->state_value == IPP_JOB_PENDING)
+      pending = 1;
+
    /*
     * Start pending jobs if the destination is available...
     */
@@ -397,6 +410,13 @@ cupsdCheckJobs(void)
       }
     }
   }
+
+ /*
+  * Check again in a little while if any jobs are still waiting...
+  */
+
+  if (pending && !check_timer.when)
+    cupsdSetTimer(&check_timer, curtime + 10, check_jobs, NULL);
 }
 
 
@@ -460,6 +480,8 @@ cupsdCleanJobs(void)
 
   cupsdLogMessage(CUPSD_LOG_DEBUG2, "cupsdCleanJobs: JobHistoryUpdate=%ld",
                   (long)JobHistoryUpdate);
+
+  update_history_timer();
 }
 
 
@@ -1408,6 +1430,8 @@ cupsdDeleteJob(cupsd_job_t       *job,	/* I - Job */
   cupsArrayRemove(ActiveJobs, job);
   cupsArrayRemove(PrintingJobs, job);
 
+  cupsdClearTimer(&job->timer);
+
   free(job);
 }
 
@@ -1732,6 +1756,8 @@ cupsdLoadJob(cupsd_job_t *job)		/* I - Job */
 
     cupsdLogMessage(CUPSD_LOG_DEBUG2, "cupsdLoadJob: JobHistoryUpdate=%ld",
 		    (long)JobHistoryUpdate);
+
+    update_history_timer();
   }
 
   if (!job->dest)
@@ -2035,6 +2061,10 @@ cupsdLoadJob(cupsd_job_t *job)		/* I - Job */
   }
 
   job->access_time = time(NULL);
+
+  if (job->state_value >= IPP_JOB_STOPPED)
+    start_unload_timer();
+
   return (1);
 
  /*
@@ -2442,6 +2472,8 @@ cupsdSetJobHoldUntil(cupsd_job_t *job,	/* I - Job */
 
   cupsdLogMessage(CUPSD_LOG_DEBUG2, "cupsdSetJobHoldUntil: hold_until=%d",
                   (int)job->hold_until);
+
+  cupsdUpdateJobTimer(job);
 }
 
 
@@ -2726,6 +2758,14 @@ cupsdSetJobState(
   if (action >= CUPSD_JOB_FORCE && job && job->printer)
     finalize_job(job, 0);
 
+  if (job)
+  {
+    cupsdUpdateJobTimer(job);
+
+    if (job->state_value >= IPP_JOB_STOPPED)
+      start_unload_timer();
+  }
+
  /*
   * Update the server "busy" state...
   */
@@ -2775,22 +2815,38 @@ void
 cupsdUnloadCompletedJobs(void)
 {
   cupsd_job_t	*job;			/* Current job */
-  time_t	expire;			/* Expiration time */
+  time_t	curtime,		/* Current time */
+		expire,			/* Expiration time */
+		next = 0;		/* Next time to check */
 
 
-  expire = time(NULL) - 60;
+  curtime = time(NULL);
+  expire  = curtime - 60;
 
   for (job = (cupsd_job_t *)cupsArrayFirst(Jobs);
        job;
        job = (cupsd_job_t *)cupsArrayNext(Jobs))
-    if (job->attrs && job->state_value >= IPP_JOB_STOPPED && !job->printer &&
-        job->access_time < expire)
+    if (job->attrs && job->state_value >= IPP_JOB_STOPPED)
     {
-      if (job->dirty)
-        cupsdSaveJob(job);
+      if (!job->printer && job->access_time < expire)
+      {
+        if (job->dirty)
+          cupsdSaveJob(job);
 
-      unload_job(job);
+        unload_job(job);
+      }
+      else if (!next || (job->access_time + 61) < next)
+        next = job->access_time + 61;
     }
+
+ /*
+  * Check again when the next loaded job can be unloaded...
+  */
+
+  if (next && next <= curtime)
+    next = curtime + 60;
+
+  cupsdSetTimer(&unload_timer, next, unload_jobs, NULL);
 }
 
 
@@ -2847,6 +2903,79 @@ cupsdUpdateJobs(void)
 
   cupsdLogMessage(CUPSD_LOG_DEBUG2, "cupsdUpdateAllJobs: JobHistoryUpdate=%ld",
                   (long)JobHistoryUpdate);
+
+  update_history_timer();
+}
+
+
+/*
+ * 'cupsdUpdateJobTimer()' - Update the hold/cancel/kill timer for a job.
+ */
+
+void
+cupsdUpdateJobTimer(cupsd_job_t *job)	/* I - Job */
+{
+  time_t	when = 0,		/* Next time to check the job */
+		curtime;		/* Current time */
+
+
+  if (job->kill_time)
+    when = job->kill_time;
+
+  if (job->cancel_time && (!when || job->cancel_time < when))
+    when = job->cancel_time;
+
+ /*
+  * cupsdCheckJobs releases held jobs once hold_until has passed...
+  */
+
+  if (job->state_value == IPP_JOB_HELD && job->hold_until &&
+      (!when || (job->hold_until + 1) < when))
+    when = job->hold_until + 1;
+
+  if (!when)
+  {
+    cupsdClearTimer(&job->timer);
+    return;
+  }
+
+ /*
+  * Don't check more than once a second for jobs that cannot be acted on yet,
+  * e.g. a held job with a Send-Document request in progress...
+  */
+
+  curtime = time(NULL);
+
+  if (when <= curtime)
+    when = curtime + 1;
+
+  cupsdSetTimer(&job->timer, when, (cupsd_timerfunc_t)job_timeout, job);
+}
+
+
+/*
+ * 'check_jobs()' - Check for pending jobs that can now be printed.
+ */
+
+static void
+check_jobs(void *data)			/* I - Unused */
+{
+  (void)data;
+
+  cupsdCheckJobs();
+}
+
+
+/*
+ * 'clean_jobs()' - Clean out old jobs when the job history expires.
+ */
+
+static void
+clean_jobs(void *data)			/* I - Unused */
+{
+  (void)data;
+
+  cupsdCleanJobs();
 }
 
 
@@ -3100,6 +3229,8 @@ finalize_job(cupsd_job_t *job,		/* I - Job */
   job->cancel_time = 0;
   job->kill_time   = 0;
 
+  cupsdUpdateJobTimer(job);
+
  /*
   * Close pipes and status buffer...
   */
@@ -3508,6 +3639,10 @@ finalize_job(cupsd_job_t *job,		/* I - Job */
 
   cupsArrayRemove(PrintingJobs, job);
 
+  if (TraceFile)
+    cupsdTraceSpan(CUPSD_TRACE_JOB, job->id, "job", &job->trace_start,
+                   ippEnumString("job-state", (int)job_state));
+
  /*
   * Apply any PPD updates...
   */
@@ -4043,6 +4178,18 @@ ipp_length(ipp_t *ipp)			/* I - IPP request */
 }
 
 
+/*
+ * 'job_timeout()' - Handle a job hold/cancel/kill timeout.
+ */
+
+static void
+job_timeout(cupsd_job_t *job)		/* I - Job */
+{
+  cupsdUpdateJobTimer(job);
+  cupsdCheckJobs();
+}
+
+
 /*
  * 'load_job_cache()' - Load jobs from the job.cache file.
  */
@@ -4151,7 +4298,10 @@ load_job_cache(const char *filename)	/* I - job.cache filename */
       cupsArrayAdd(Jobs, job);
 
       if (job->state_value <= IPP_JOB_STOPPED && cupsdLoadJob(job))
+      {
 	cupsArrayAdd(ActiveJobs, job);
+	cupsdUpdateJobTimer(job);
+      }
       else if (job->state_value > IPP_JOB_STOPPED)
       {
         if (!job->completed_time || !job->creation_time || !job->name || !job->koctets)
@@ -4439,12 +4589,18 @@ load_request_root(void)
 	cupsArrayAdd(Jobs, job);
 
 	if (job->state_value <= IPP_JOB_STOPPED)
+	{
 	  cupsArrayAdd(ActiveJobs, job);
+	  cupsdUpdateJobTimer(job);
+	}
 	else
 	  unload_job(job);
       }
       else
+      {
+        cupsdClearTimer(&job->timer);
         free(job);
+      }
     }
 
   cupsDirClose(dir);
@@ -4559,6 +4715,8 @@ set_time(cupsd_job_t *job,		/* I - Job to update */
 
     cupsdLogMessage(CUPSD_LOG_DEBUG2, "set_time: JobHistoryUpdate=%ld",
 		    (long)JobHistoryUpdate);
+
+    update_history_timer();
   }
 }
 
@@ -4625,6 +4783,13 @@ start_job(cupsd_job_t     *job,		/* I - Job ID */
   job->progress     = 0;
   job->printer      = printer;
   printer->job      = job;
+  job->trace_page   = 0;
+
+  if (TraceFile)
+  {
+    gettimeofday(&job->trace_start, NULL);
+    cupsdTraceEvent(CUPSD_TRACE_JOB, job->id, "start", printer->name);
+  }
 
   if (cancel_after)
     job->cancel_time = time(NULL) + ippGetInteger(cancel_after, 0);
@@ -4633,6 +4798,8 @@ start_job(cupsd_job_t     *job,		/* I - Job ID */
   else
     job->cancel_time = 0;
 
+  cupsdUpdateJobTimer(job);
+
  /*
   * Check for support files...
   */
@@ -4756,6 +4923,18 @@ start_job(cupsd_job_t     *job,		/* I - Job ID */
 }
 
 
+/*
+ * 'start_unload_timer()' - Start the timer for unloading completed jobs.
+ */
+
+static void
+start_unload_timer(void)
+{
+  if (!unload_timer.when)
+    cupsdSetTimer(&unload_timer, time(NULL) + 61, unload_jobs, NULL);
+}
+
+
 /*
  * 'stop_job()' - Stop a print job.
  */
@@ -4778,6 +4957,8 @@ stop_job(cupsd_job_t       *job,	/* I - Job */
   else if (action >= CUPSD_JOB_FORCE)
     job->kill_time = 0;
 
+  cupsdUpdateJobTimer(job);
+
   for (i = 0; job->filters[i]; i ++)
     if (job->filters[i] > 0)
     {
@@ -4831,6 +5012,30 @@ unload_job(cupsd_job_t *job)		/* I - Job */
 }
 
 
+/*
+ * 'unload_jobs()' - Unload completed jobs when the unload timer fires.
+ */
+
+static void
+unload_jobs(void *data)			/* I - Unused */
+{
+  (void)data;
+
+  cupsdUnloadCompletedJobs();
+}
+
+
+/*
+ * 'update_history_timer()' - Update the job history cleanup timer.
+ */
+
+static void
+update_history_timer(void)
+{
+  cupsdSetTimer(&history_timer, JobHistoryUpdate, clean_jobs, NULL);
+}
+
+
 /*
  * 'update_job()' - Read a status update from a job's filters.
  */
@@ -4884,6 +5089,12 @@ update_job(cupsd_job_t *job)		/* I - Job to check */
 
       cupsdLogJob(job, CUPSD_LOG_DEBUG, "PAGE: %s", message);
 
+      if (TraceFile && !job->trace_page)
+      {
+        cupsdTraceEvent(CUPSD_TRACE_JOB, job->id, "first-page", message);
+	job->trace_page = 1;
+      }
+
       if (job->impressions)
       {
         if (!_cups_strncasecmp(message, "total ", 6))
@@ -4978,6 +5189,8 @@ update_job(cupsd_job_t *job)		/* I - Job to check */
 	      job->cancel_time = time(NULL) + ippGetInteger(cancel_after, 0);
 	    else
 	      job->cancel_time = time(NULL) + MaxJobTime;
+
+	    cupsdUpdateJobTimer(job);
 	  }
         }
       }
@@ -5052,56 +5265,63 @@ update_job(cupsd_job_t *job)		/* I - Job to check */
       {
         cupsdSetPrinterAttr(job->printer, "marker-colors", (char *)attr);
 	job->printer->marker_time = time(NULL);
+	job->printer->state_dirty = 1;
 	event |= CUPSD_EVENT_PRINTER_STATE;
-        cupsdMarkDirty(CUPSD_DIRTY_PRINTERS);
+        cupsdMarkDirty(CUPSD_DIRTY_PRINTSTATE);
       }
 
       if ((attr = cupsGetOption("marker-levels", num_attrs, attrs)) != NULL)
       {
         cupsdSetPrinterAttr(job->printer, "marker-levels", (char *)attr);
 	job->printer->marker_time = time(NULL);
+	job->printer->state_dirty = 1;
 	event |= CUPSD_EVENT_PRINTER_STATE;
-        cupsdMarkDirty(CUPSD_DIRTY_PRINTERS);
+        cupsdMarkDirty(CUPSD_DIRTY_PRINTSTATE);
       }
 
       if ((attr = cupsGetOption("marker-low-levels", num_attrs, attrs)) != NULL)
       {
         cupsdSetPrinterAttr(job->printer, "marker-low-levels", (char *)attr);
 	job->printer->marker_time = time(NULL);
+	job->printer->state_dirty = 1;
 	event |= CUPSD_EVENT_PRINTER_STATE;
-        cupsdMarkDirty(CUPSD_DIRTY_PRINTERS);
+        cupsdMarkDirty(CUPSD_DIRTY_PRINTSTATE);
       }
 
       if ((attr = cupsGetOption("marker-high-levels", num_attrs, attrs)) != NULL)
       {
         cupsdSetPrinterAttr(job->printer, "marker-high-levels", (char *)attr);
 	job->printer->marker_time = time(NULL);
+	job->printer->state_dirty = 1;
 	event |= CUPSD_EVENT_PRINTER_STATE;
-        cupsdMarkDirty(CUPSD_DIRTY_PRINTERS);
+        cupsdMarkDirty(CUPSD_DIRTY_PRINTSTATE);
       }
 
       if ((attr = cupsGetOption("marker-message", num_attrs, attrs)) != NULL)
       {
         cupsdSetPrinterAttr(job->printer, "marker-message", (char *)attr);
 	job->printer->marker_time = time(NULL);
+	job->printer->state_dirty = 1;
 	event |= CUPSD_EVENT_PRINTER_STATE;
-        cupsdMarkDirty(CUPSD_DIRTY_PRINTERS);
+        cupsdMarkDirty(CUPSD_DIRTY_PRINTSTATE);
       }
 
       if ((attr = cupsGetOption("marker-names", num_attrs, attrs)) != NULL)
       {
         cupsdSetPrinterAttr(job->printer, "marker-names", (char *)attr);
 	job->printer->marker_time = time(NULL);
+	job->printer->state_dirty = 1;
 	event |= CUPSD_EVENT_PRINTER_STATE;
-        cupsdMarkDirty(CUPSD_DIRTY_PRINTERS);
+        cupsdMarkDirty(CUPSD_DIRTY_PRINTSTATE);
       }
 
       if ((attr = cupsGetOption("marker-types", num_attrs, attrs)) != NULL)
       {
         cupsdSetPrinterAttr(job->printer, "marker-types", (char *)attr);
 	job->printer->marker_time = time(NULL);
+	job->printer->state_dirty = 1;
 	event |= CUPSD_EVENT_PRINTER_STATE;
-        cupsdMarkDirty(CUPSD_DIRTY_PRINTERS);
+        cupsdMarkDirty(CUPSD_DIRTY_PRINTSTATE);
       }
 
       cupsFreeOptions(num_attrs, attrs);
@@ -90,6 +90,9 @@ struct cupsd_job_s			/**** Job request ****/
   int			progress;	/* Printing progress */
   int			num_keywords;	/* Number of PPD keywords */
   cups_option_t		*keywords;	/* PPD keywords */
+  struct timeval	trace_start;	/* Start of processing for tracing */
+  int			trace_page;	/* Traced the first page? */
+  cupsd_timer_t		timer;		/* Hold/cancel/kill timer */
 };
 
 typedef struct cupsd_joblog_s		/**** Job log message ****/
@@ -177,6 +180,7 @@ extern void		cupsdStopAllJobs(cupsd_jobaction_t action,
 extern int		cupsdTimeoutJob(cupsd_job_t *job);
 extern void		cupsdUnloadCompletedJobs(void);
 extern void		cupsdUpdateJobs(void);
+extern void		cupsdUpdateJobTimer(cupsd_job_t *job);
 
 
 /*
@@ -30,6 +30,21 @@
 #endif /* __linux && !IPV6_V6ONLY */
 
 
+/*
+ * Local globals...
+ */
+
+static cupsd_timer_t	resume_timer;	/* Timer for resuming listening */
+
+
+/*
+ * Local functions...
+ */
+
+static void	add_shards(void);
+static void	resume_listening(void *data);
+
+
 /*
  * 'cupsdDeleteAllListeners()' - Delete all listeners.
  */
@@ -72,7 +87,7 @@ cupsdPauseListening(void)
   if (cupsArrayCount(Listeners) < 1)
     return;
 
-  if (cupsArrayCount(Clients) == MaxClients)
+  if (cupsdClientCount() == MaxClients)
     cupsdLogMessage(CUPSD_LOG_WARN,
                     "Max clients reached, holding new connections...");
   else if (errno == ENFILE || errno == EMFILE)
@@ -88,6 +103,8 @@ cupsdPauseListening(void)
     cupsdRemoveSelect(lis->fd);
 
   ListeningPaused = time(NULL) + 30;
+
+  cupsdSetTimer(&resume_timer, ListeningPaused, resume_listening, NULL);
 }
 
 
@@ -114,6 +131,8 @@ cupsdResumeListening(void)
     cupsdAddSelect(lis->fd, (cupsd_selfunc_t)cupsdAcceptClient, NULL, lis);
 
   ListeningPaused = 0;
+
+  cupsdClearTimer(&resume_timer);
 }
 
 
@@ -140,6 +159,15 @@ cupsdStartListening(void)
   cupsdLogMessage(CUPSD_LOG_DEBUG2, "cupsdStartListening: %d Listeners",
                   cupsArrayCount(Listeners));
 
+#ifdef SO_REUSEPORT
+ /*
+  * Add the extra sockets for each network address...
+  */
+
+  if (ListenShards > 1)
+    add_shards();
+#endif /* SO_REUSEPORT */
+
  /*
   * Setup socket listeners...
   */
@@ -162,7 +190,11 @@ cupsdStartListening(void)
       * Create a socket for listening...
       */
 
-      lis->fd = httpAddrListen(&(lis->address), p);
+      lis->fd = _httpAddrListen(&(lis->address), p, ListenBackLog,
+#ifdef AF_LOCAL
+                                lis->address.addr.sa_family != AF_LOCAL &&
+#endif /* AF_LOCAL */
+                                ListenShards > 1);
 
       if (lis->fd == -1)
       {
@@ -187,6 +219,13 @@ cupsdStartListening(void)
       }
     }
 
+   /*
+    * Use a non-blocking socket so that cupsdAcceptClient() can drain the
+    * backlog...
+    */
+
+    fcntl(lis->fd, F_SETFL, fcntl(lis->fd, F_GETFL) | O_NONBLOCK);
+
     if (p)
       cupsdLogMessage(CUPSD_LOG_INFO, "Listening to %s:%d on fd %d...",
         	      s, p, lis->fd);
@@ -301,6 +340,81 @@ cupsdStopListening(void)
 }
 
 
+#ifdef SO_REUSEPORT
+/*
+ * 'add_shards()' - Add SO_REUSEPORT listeners for each network address.
+ */
+
+static void
+add_shards(void)
+{
+  int			i,		/* Looping var */
+			count,		/* Number of configured listeners */
+			shard;		/* Current shard */
+  cupsd_listener_t	*lis,		/* Current listening socket */
+			*temp;		/* New listening socket */
+
+
+  count = cupsArrayCount(Listeners);
+
+  for (i = 0; i < count; i ++)
+    if (((cupsd_listener_t *)cupsArrayIndex(Listeners, i))->shard)
+      return;				/* Already added */
+
+  for (i = 0; i < count; i ++)
+  {
+    lis = (cupsd_listener_t *)cupsArrayIndex(Listeners, i);
+
+   /*
+    * On-demand sockets are already open and domain sockets can't be shared...
+    */
+
+    if (lis->fd != -1)
+      continue;
+
+#ifdef AF_LOCAL
+    if (lis->address.addr.sa_family == AF_LOCAL)
+      continue;
+#endif /* AF_LOCAL */
+
+    for (shard = 1; shard < ListenShards; shard ++)
+    {
+      if ((temp = calloc(1, sizeof(cupsd_listener_t))) == NULL)
+      {
+	cupsdLogMessage(CUPSD_LOG_ERROR,
+			"Unable to allocate memory for listener - %s.",
+			strerror(errno));
+        return;
+      }
+
+      temp->fd         = -1;
+      temp->address    = lis->address;
+      temp->encryption = lis->encryption;
+      temp->shard      = shard;
+
+      cupsArrayAdd(Listeners, temp);
+    }
+  }
+}
+#endif /* SO_REUSEPORT */
+
+
+/*
+ * 'resume_listening()' - Resume listening after a pause, if possible.
+ */
+
+static void
+resume_listening(void *data)		/* I - Unused */
+{
+  (void)data;
+
+  if (cupsdClientCount() < MaxClients)
+    cupsdResumeListening();
+  else
+    cupsdSetTimer(&resume_timer, time(NULL) + 1, resume_listening, NULL);
+}
+
+
 /*
  * End of "$Id: listen.c 12178 2014-09-30 18:56:48Z msweet $".
  */
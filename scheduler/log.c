@@ -26,6 +26,10 @@
 #  include <systemd/sd-journal.h>
 #endif /* HAVE_ASL_H */
 #include <syslog.h>
+#if defined(HAVE_PTHREAD_H) && defined(CUPSD_HAVE_ATOMICS)
+#  define CUPSD_LOG_THREAD 1
+#  include <pthread.h>
+#endif /* HAVE_PTHREAD_H && CUPSD_HAVE_ATOMICS */
 
 
 /*
@@ -56,14 +60,68 @@
 #define PWG_JobAccountingUserURI	"JAUU"
 
 
+/*
+ * Log queue types...
+ */
+
+typedef enum
+{
+  CUPSD_LOGFILE_ERROR,			/* ErrorLog */
+  CUPSD_LOGFILE_ACCESS,			/* AccessLog */
+  CUPSD_LOGFILE_PAGE			/* PageLog */
+} cupsd_logfile_t;
+
+#ifdef CUPSD_LOG_THREAD
+typedef struct cupsd_logslot_s		/**** Log queue slot ****/
+{
+  size_t		sequence;	/* Slot sequence number */
+  cupsd_logfile_t	file;		/* Destination log file */
+  int			level;		/* Log level */
+  struct timeval	time;		/* Time of message */
+  char			*message;	/* Message string */
+} cupsd_logslot_t;
+#endif /* CUPSD_LOG_THREAD */
+
+
 /*
  * Local globals...
  */
 
 static _cups_mutex_t log_mutex = _CUPS_MUTEX_INITIALIZER;
 					/* Mutex for logging */
-static size_t	log_linesize = 0;	/* Size of line for output file */
-static char	*log_line = NULL;	/* Line for output file */
+static int	log_mutex_locked = 0;	/* Is the log mutex held? */
+static const char log_letters[] =	/* Log level letters... */
+		{
+		  ' ',
+		  'X',
+		  'A',
+		  'C',
+		  'E',
+		  'W',
+		  'N',
+		  'I',
+		  'D',
+		  'd'
+		};
+
+#ifdef CUPSD_LOG_THREAD
+static cupsd_logslot_t *log_queue = NULL;
+					/* Ring buffer of queued messages */
+static size_t	log_queue_mask = 0,	/* Mask for ring buffer index */
+		log_queue_head = 0,	/* Next slot for producers */
+		log_queue_tail = 0;	/* Next slot for the writer */
+static unsigned	log_dropped = 0,	/* Messages dropped since last report */
+		log_dropped_total = 0;	/* Messages dropped since startup */
+static int	log_thread_running = 0,	/* Is the writer thread running? */
+		log_thread_sleeping = 0,/* Is the writer thread waiting? */
+		log_thread_stop = 0;	/* Should the writer thread exit? */
+static pthread_t log_thread;		/* Writer thread */
+static pthread_t log_mutex_owner;	/* Thread holding the log mutex */
+static pthread_mutex_t log_queue_mutex = PTHREAD_MUTEX_INITIALIZER;
+					/* Mutex for writer wakeups */
+static pthread_cond_t log_queue_cond = PTHREAD_COND_INITIALIZER;
+					/* Condition for writer wakeups */
+#endif /* CUPSD_LOG_THREAD */
 
 #ifdef HAVE_ASL_H
 static const int log_levels[] =		/* ASL levels... */
@@ -100,7 +158,24 @@ static const int log_levels[] =		/* SYSLOG levels... */
  * Local functions...
  */
 
-static int	format_log_line(const char *message, va_list ap);
+static cups_file_t *check_log_file(cupsd_logfile_t file);
+static char	*format_date_time(struct timeval *t, cupsd_time_t format,
+		                  char *s, size_t slen);
+static char	*format_log_line(char *buffer, size_t bufsize,
+		                 const char *message, va_list ap);
+static cups_file_t *get_log_file(cupsd_logfile_t file);
+static int	log_lock(void);
+#ifdef CUPSD_LOG_THREAD
+static int	log_queue_add(cupsd_logfile_t file, int level,
+		              const char *message);
+static void	*log_thread_func(void *arg);
+static void	log_thread_wake(void);
+#endif /* CUPSD_LOG_THREAD */
+static void	log_unlock(void);
+static void	put_log_line(cups_file_t *lf, cupsd_logfile_t file, int level,
+		             struct timeval *t, const char *message);
+static int	write_log_line(cupsd_logfile_t file, int level,
+		               const char *message);
 
 
 /*
@@ -323,25 +398,9 @@ cupsdGetDateTime(struct timeval *t,	/* I - Time value or NULL for current */
                  cupsd_time_t   format)	/* I - Format to use */
 {
   struct timeval	curtime;	/* Current time value */
-  struct tm		*date;		/* Date/time value */
   static struct timeval	last_time = { 0, 0 };
 	    				/* Last time we formatted */
   static char		s[1024];	/* Date/time string */
-  static const char * const months[12] =/* Months */
-		{
-		  "Jan",
-		  "Feb",
-		  "Mar",
-		  "Apr",
-		  "May",
-		  "Jun",
-		  "Jul",
-		  "Aug",
-		  "Sep",
-		  "Oct",
-		  "Nov",
-		  "Dec"
-		};
 
 
  /*
@@ -359,46 +418,29 @@ cupsdGetDateTime(struct timeval *t,	/* I - Time value or NULL for current */
   {
     last_time = *t;
 
-   /*
-    * Get the date and time from the UNIX time value, and then format it
-    * into a string.  Note that we *can't* use the strftime() function since
-    * it is localized and will seriously confuse automatic programs if the
-    * month names are in the wrong language!
-    *
-    * Also, we use the "timezone" variable that contains the current timezone
-    * offset from GMT in seconds so that we are reporting local time in the
-    * log files.  If you want GMT, set the TZ environment variable accordingly
-    * before starting the scheduler.
-    *
-    * (*BSD and Darwin store the timezone offset in the tm structure)
-    */
-
-    date = localtime(&(t->tv_sec));
-
-    if (format == CUPSD_TIME_STANDARD)
-      snprintf(s, sizeof(s), "[%02d/%s/%04d:%02d:%02d:%02d %+03ld%02ld]",
-	       date->tm_mday, months[date->tm_mon], 1900 + date->tm_year,
-	       date->tm_hour, date->tm_min, date->tm_sec,
-#ifdef HAVE_TM_GMTOFF
-	       date->tm_gmtoff / 3600, (date->tm_gmtoff / 60) % 60);
-#else
-	       timezone / 3600, (timezone / 60) % 60);
-#endif /* HAVE_TM_GMTOFF */
-    else
-      snprintf(s, sizeof(s), "[%02d/%s/%04d:%02d:%02d:%02d.%06d %+03ld%02ld]",
-	       date->tm_mday, months[date->tm_mon], 1900 + date->tm_year,
-	       date->tm_hour, date->tm_min, date->tm_sec, (int)t->tv_usec,
-#ifdef HAVE_TM_GMTOFF
-	       date->tm_gmtoff / 3600, (date->tm_gmtoff / 60) % 60);
-#else
-	       timezone / 3600, (timezone / 60) % 60);
-#endif /* HAVE_TM_GMTOFF */
+    format_date_time(t, format, s, sizeof(s));
   }
 
   return (s);
 }
 
 
+/*
+ * 'cupsdGetLogDropped()' - Return the number of log messages dropped because
+ *                          the log queue was full.
+ */
+
+unsigned				/* O - Number of dropped messages */
+cupsdGetLogDropped(void)
+{
+#ifdef CUPSD_LOG_THREAD
+  return (cupsdAtomicGet(&log_dropped_total));
+#else
+  return (0);
+#endif /* CUPSD_LOG_THREAD */
+}
+
+
 /*
  * 'cupsdLogFCMessage()' - Log a file checking message.
  */
@@ -517,9 +559,11 @@ cupsdLogClient(cupsd_client_t *con,	/* I - Client connection */
                const char     *message,	/* I - Printf-style message string */
                ...)			/* I - Additional arguments as needed */
 {
-  va_list		ap, ap2;	/* Argument pointers */
-  char			clientmsg[1024];/* Format string for client message */
-  int			status;		/* Formatting status */
+  va_list		ap;		/* Argument pointer */
+  char			clientmsg[1024],/* Format string for client message */
+			line[8192],	/* Formatted log line */
+			*ptr;		/* Pointer to formatted line */
+  int			status;		/* Write status */
 
 
  /*
@@ -543,22 +587,15 @@ cupsdLogClient(cupsd_client_t *con,	/* I - Client connection */
     strlcpy(clientmsg, message, sizeof(clientmsg));
 
   va_start(ap, message);
+  ptr = format_log_line(line, sizeof(line), clientmsg, ap);
+  va_end(ap);
 
-  do
-  {
-    va_copy(ap2, ap);
-    status = format_log_line(clientmsg, ap2);
-    va_end(ap2);
-  }
-  while (status == 0);
+  status = cupsdWriteErrorLog(level, ptr);
 
-  va_end(ap);
+  if (ptr != line)
+    free(ptr);
 
-  if (status > 0)
-    return (cupsdWriteErrorLog(level, log_line));
-  else
-    return (cupsdWriteErrorLog(CUPSD_LOG_ERROR,
-                               "Unable to allocate memory for log line."));
+  return (status);
 }
 
 
@@ -572,9 +609,11 @@ cupsdLogJob(cupsd_job_t *job,		/* I - Job */
 	    const char  *message,	/* I - Printf-style message string */
 	    ...)			/* I - Additional arguments as needed */
 {
-  va_list		ap, ap2;	/* Argument pointers */
-  char			jobmsg[1024];	/* Format string for job message */
-  int			status;		/* Formatting status */
+  va_list		ap;		/* Argument pointer */
+  char			jobmsg[1024],	/* Format string for job message */
+			line[8192],	/* Formatted log line */
+			*ptr;		/* Pointer to formatted line */
+  int			status = 1;	/* Write status */
 
 
  /*
@@ -650,19 +689,11 @@ cupsdLogJob(cupsd_job_t *job,		/* I - Job */
     };
 
     va_start(ap, message);
-
-    do
-    {
-      va_copy(ap2, ap);
-      status = format_log_line(message, ap2);
-      va_end(ap2);
-    }
-    while (status == 0);
-
+    ptr = format_log_line(line, sizeof(line), message, ap);
     va_end(ap);
 
     if (job)
-      sd_journal_send("MESSAGE=%s", log_line,
+      sd_journal_send("MESSAGE=%s", ptr,
 		      "PRIORITY=%i", log_levels[level],
 		      PWG_Event"=JobStateChanged",
 		      PWG_ServiceURI"=%s", printer ? printer->uri : "",
@@ -671,10 +702,13 @@ cupsdLogJob(cupsd_job_t *job,		/* I - Job */
 		      PWG_JobImpressionsCompleted"=%d", ippGetInteger(job->impressions, 0),
 		      NULL);
     else
-      sd_journal_send("MESSAGE=%s", log_line,
+      sd_journal_send("MESSAGE=%s", ptr,
 		      "PRIORITY=%i", log_levels[level],
 		      NULL);
 
+    if (ptr != line)
+      free(ptr);
+
     return (1);
   }
 #endif /* HAVE_ASL_H */
@@ -689,70 +723,57 @@ cupsdLogJob(cupsd_job_t *job,		/* I - Job */
     strlcpy(jobmsg, message, sizeof(jobmsg));
 
   va_start(ap, message);
-
-  do
-  {
-    va_copy(ap2, ap);
-    status = format_log_line(jobmsg, ap2);
-    va_end(ap2);
-  }
-  while (status == 0);
-
+  ptr = format_log_line(line, sizeof(line), jobmsg, ap);
   va_end(ap);
 
-  if (status > 0)
+  if (job &&
+      (level > LogLevel ||
+       (level == CUPSD_LOG_INFO && LogLevel < CUPSD_LOG_DEBUG)) &&
+      LogDebugHistory > 0)
   {
-    if (job &&
-        (level > LogLevel ||
-         (level == CUPSD_LOG_INFO && LogLevel < CUPSD_LOG_DEBUG)) &&
-	LogDebugHistory > 0)
-    {
-     /*
-      * Add message to the job history...
-      */
+   /*
+    * Add message to the job history...
+    */
 
-      cupsd_joblog_t *temp;		/* Copy of log message */
-      size_t         log_len = strlen(log_line);
+    cupsd_joblog_t *temp;		/* Copy of log message */
+    size_t         log_len = strlen(ptr);
 					/* Length of log message */
 
-      if ((temp = malloc(sizeof(cupsd_joblog_t) + log_len)) != NULL)
-      {
-        temp->time = time(NULL);
-	memcpy(temp->message, log_line, log_len + 1);
-      }
+    if ((temp = malloc(sizeof(cupsd_joblog_t) + log_len)) != NULL)
+    {
+      temp->time = time(NULL);
+      memcpy(temp->message, ptr, log_len + 1);
+    }
 
-      if (!job->history)
-	job->history = cupsArrayNew(NULL, NULL);
+    if (!job->history)
+      job->history = cupsArrayNew(NULL, NULL);
 
-      if (job->history && temp)
-      {
-	cupsArrayAdd(job->history, temp);
+    if (job->history && temp)
+    {
+      cupsArrayAdd(job->history, temp);
 
-	if (cupsArrayCount(job->history) > LogDebugHistory)
-	{
-	 /*
-	  * Remove excess messages...
-	  */
+      if (cupsArrayCount(job->history) > LogDebugHistory)
+      {
+       /*
+	* Remove excess messages...
+	*/
 
-	  temp = cupsArrayFirst(job->history);
-	  cupsArrayRemove(job->history, temp);
-	  free(temp);
-	}
-      }
-      else if (temp)
+	temp = cupsArrayFirst(job->history);
+	cupsArrayRemove(job->history, temp);
 	free(temp);
-
-      return (1);
+      }
     }
-    else if (level <= LogLevel &&
-             (level != CUPSD_LOG_INFO || LogLevel >= CUPSD_LOG_DEBUG))
-      return (cupsdWriteErrorLog(level, log_line));
-    else
-      return (1);
+    else if (temp)
+      free(temp);
   }
-  else
-    return (cupsdWriteErrorLog(CUPSD_LOG_ERROR,
-                               "Unable to allocate memory for log line."));
+  else if (level <= LogLevel &&
+	   (level != CUPSD_LOG_INFO || LogLevel >= CUPSD_LOG_DEBUG))
+    status = cupsdWriteErrorLog(level, ptr);
+
+  if (ptr != line)
+    free(ptr);
+
+  return (status);
 }
 
 
@@ -765,8 +786,10 @@ cupsdLogMessage(int        level,	/* I - Log level */
                 const char *message,	/* I - printf-style message string */
 	        ...)			/* I - Additional args as needed */
 {
-  va_list		ap, ap2;	/* Argument pointers */
-  int			status;		/* Formatting status */
+  va_list		ap;		/* Argument pointer */
+  char			line[8192],	/* Formatted log line */
+			*ptr;		/* Pointer to formatted line */
+  int			status;		/* Write status */
 
 
  /*
@@ -835,22 +858,15 @@ cupsdLogMessage(int        level,	/* I - Log level */
   */
 
   va_start(ap, message);
+  ptr = format_log_line(line, sizeof(line), message, ap);
+  va_end(ap);
 
-  do
-  {
-    va_copy(ap2, ap);
-    status = format_log_line(message, ap2);
-    va_end(ap2);
-  }
-  while (status == 0);
+  status = cupsdWriteErrorLog(level, ptr);
 
-  va_end(ap);
+  if (ptr != line)
+    free(ptr);
 
-  if (status > 0)
-    return (cupsdWriteErrorLog(level, log_line));
-  else
-    return (cupsdWriteErrorLog(CUPSD_LOG_ERROR,
-                               "Unable to allocate memory for log line!"));
+  return (status);
 }
 
 
@@ -1120,23 +1136,13 @@ cupsdLogPage(cupsd_job_t *job,		/* I - Job being printed */
 #endif /* HAVE_ASL_H */
 
  /*
-  * Not using syslog; check the log file...
-  */
-
-  if (!cupsdCheckLogFile(&PageFile, PageLog))
-    return (0);
-
- /*
-  * Print a page log entry of the form:
+  * Not using syslog; queue or write a page log entry of the form:
   *
   *    printer user job-id [DD/MON/YYYY:HH:MM:SS +TTTT] page num-copies \
   *        billing hostname
   */
 
-  cupsFilePrintf(PageFile, "%s\n", buffer);
-  cupsFileFlush(PageFile);
-
-  return (1);
+  return (write_log_line(CUPSD_LOGFILE_PAGE, CUPSD_LOG_INFO, buffer));
 }
 
 
@@ -1148,7 +1154,8 @@ int					/* O - 1 on success, 0 on error */
 cupsdLogRequest(cupsd_client_t *con,	/* I - Request to log */
                 http_status_t  code)	/* I - Response code */
 {
-  char	temp[2048];			/* Temporary string for URI */
+  char	temp[2048],			/* Temporary string for URI */
+	line[4096];			/* Log line */
   static const char * const states[] =	/* HTTP client states... */
 		{
 		  "WAITING",
@@ -1330,34 +1337,123 @@ cupsdLogRequest(cupsd_client_t *con,	/* I - Request to log */
 #endif /* HAVE_ASL_H */
 
  /*
-  * Not using syslog; check the log file...
+  * Not using syslog; queue or write a log of the request in "common log
+  * format"...
   */
 
-  if (!cupsdCheckLogFile(&AccessFile, AccessLog))
-    return (0);
+  snprintf(line, sizeof(line),
+           "%s - %s %s \"%s %s HTTP/%d.%d\" %d " CUPS_LLFMT " %s %s",
+	   con->http->hostname,
+	   con->username[0] != '\0' ? con->username : "-",
+	   cupsdGetDateTime(&(con->start), LogTimeFormat),
+	   states[con->operation],
+	   _httpEncodeURI(temp, con->uri, sizeof(temp)),
+	   con->http->version / 100, con->http->version % 100,
+	   code, CUPS_LLCAST con->bytes,
+	   con->request ?
+	       ippOpString(con->request->request.op.operation_id) : "-",
+	   con->response ?
+	       ippErrorString(con->response->request.status.status_code) :
+	       "-");
+
+  return (write_log_line(CUPSD_LOGFILE_ACCESS, CUPSD_LOG_INFO, line));
+}
+
+
+/*
+ * 'cupsdStartLogThread()' - Start the log writer thread.
+ *
+ * When LogQueueSize is non-zero, log lines for the access, error, and page
+ * log files are added to a ring buffer and written by a separate thread so
+ * that the main loop never blocks on log file I/O.
+ */
+
+void
+cupsdStartLogThread(void)
+{
+#ifdef CUPSD_LOG_THREAD
+  size_t	i,			/* Looping var */
+		count;			/* Number of slots */
+
+
+  if (log_thread_running || LogQueueSize <= 0)
+    return;
 
  /*
-  * Write a log of the request in "common log format"...
+  * Round the queue size up to a power of 2 so we can mask the indices...
   */
 
-  cupsFilePrintf(AccessFile,
-                 "%s - %s %s \"%s %s HTTP/%d.%d\" %d " CUPS_LLFMT " %s %s\n",
-        	 con->http->hostname,
-		 con->username[0] != '\0' ? con->username : "-",
-		 cupsdGetDateTime(&(con->start), LogTimeFormat),
-		 states[con->operation],
-		 _httpEncodeURI(temp, con->uri, sizeof(temp)),
-		 con->http->version / 100, con->http->version % 100,
-		 code, CUPS_LLCAST con->bytes,
-		 con->request ?
-		     ippOpString(con->request->request.op.operation_id) : "-",
-		 con->response ?
-		     ippErrorString(con->response->request.status.status_code) :
-		     "-");
-
-  cupsFileFlush(AccessFile);
+  for (count = 16; count < (size_t)LogQueueSize && count < 1048576; count <<= 1);
 
-  return (1);
+  if ((log_queue = calloc(count, sizeof(cupsd_logslot_t))) == NULL)
+  {
+    cupsdLogMessage(CUPSD_LOG_ERROR,
+                    "Unable to allocate memory for log queue - %s",
+		    strerror(errno));
+    return;
+  }
+
+  for (i = 0; i < count; i ++)
+    log_queue[i].sequence = i;
+
+  log_queue_mask      = count - 1;
+  log_queue_head      = 0;
+  log_queue_tail      = 0;
+  log_dropped         = 0;
+  log_thread_sleeping = 0;
+  log_thread_stop     = 0;
+
+  if ((errno = pthread_create(&log_thread, NULL, log_thread_func, NULL)) != 0)
+  {
+    cupsdLogMessage(CUPSD_LOG_ERROR, "Unable to create log thread - %s",
+                    strerror(errno));
+    free(log_queue);
+    log_queue = NULL;
+    return;
+  }
+
+  cupsdAtomicSet(&log_thread_running, 1);
+
+  cupsdLogMessage(CUPSD_LOG_DEBUG, "Started log thread with %d queue slots.",
+                  (int)count);
+#endif /* CUPSD_LOG_THREAD */
+}
+
+
+/*
+ * 'cupsdStopLogThread()' - Flush the log queue and stop the log writer thread.
+ */
+
+void
+cupsdStopLogThread(void)
+{
+#ifdef CUPSD_LOG_THREAD
+  if (!log_thread_running)
+    return;
+
+ /*
+  * Send new messages straight to the log files and wait for the writer to
+  * empty the queue...
+  */
+
+  cupsdAtomicSet(&log_thread_running, 0);
+  cupsdAtomicSet(&log_thread_stop, 1);
+
+  pthread_mutex_lock(&log_queue_mutex);
+  pthread_cond_signal(&log_queue_cond);
+  pthread_mutex_unlock(&log_queue_mutex);
+
+  pthread_join(log_thread, NULL);
+
+ /*
+  * Write anything that was queued after the writer exited...
+  */
+
+  log_thread_func(NULL);
+
+  free(log_queue);
+  log_queue = NULL;
+#endif /* CUPSD_LOG_THREAD */
 }
 
 
@@ -1369,22 +1465,6 @@ int					/* O - 1 on success, 0 on failure */
 cupsdWriteErrorLog(int        level,	/* I - Log level */
                    const char *message)	/* I - Message string */
 {
-  int		ret = 1;		/* Return value */
-  static const char	levels[] =	/* Log levels... */
-		{
-		  ' ',
-		  'X',
-		  'A',
-		  'C',
-		  'E',
-		  'W',
-		  'N',
-		  'I',
-		  'D',
-		  'd'
-		};
-
-
 #ifdef HAVE_ASL_H
   if (!strcmp(ErrorLog, "syslog"))
   {
@@ -1418,96 +1498,521 @@ cupsdWriteErrorLog(int        level,	/* I - Log level */
 #endif /* HAVE_ASL_H */
 
  /*
-  * Not using syslog; check the log file...
+  * Not using syslog; queue or write the message to the log file...
   */
 
-  _cupsMutexLock(&log_mutex);
+  return (write_log_line(CUPSD_LOGFILE_ERROR, level, message));
+}
 
-  if (!cupsdCheckLogFile(&ErrorFile, ErrorLog))
-  {
-    ret = 0;
-  }
-  else
+
+/*
+ * 'check_log_file()' - Open/rotate a log file and return it.
+ */
+
+static cups_file_t *			/* O - Log file or NULL */
+check_log_file(cupsd_logfile_t file)	/* I - Log file to check */
+{
+  switch (file)
   {
-   /*
-    * Write the log message...
-    */
+    case CUPSD_LOGFILE_ERROR :
+        return (cupsdCheckLogFile(&ErrorFile, ErrorLog) ? ErrorFile : NULL);
+
+    case CUPSD_LOGFILE_ACCESS :
+        return (cupsdCheckLogFile(&AccessFile, AccessLog) ? AccessFile : NULL);
 
-    cupsFilePrintf(ErrorFile, "%c %s %s\n", levels[level],
-                   cupsdGetDateTime(NULL, LogTimeFormat), message);
-    cupsFileFlush(ErrorFile);
+    default :
+        return (cupsdCheckLogFile(&PageFile, PageLog) ? PageFile : NULL);
   }
+}
 
-  _cupsMutexUnlock(&log_mutex);
 
-  return (ret);
+/*
+ * 'format_date_time()' - Format a date/time string into a buffer.
+ */
+
+static char *				/* O - Date/time string */
+format_date_time(struct timeval *t,	/* I - Time value */
+                 cupsd_time_t   format,	/* I - Format to use */
+		 char           *s,	/* I - String buffer */
+		 size_t         slen)	/* I - Size of string buffer */
+{
+  struct tm		date;		/* Date/time value */
+  static const char * const months[12] =/* Months */
+		{
+		  "Jan",
+		  "Feb",
+		  "Mar",
+		  "Apr",
+		  "May",
+		  "Jun",
+		  "Jul",
+		  "Aug",
+		  "Sep",
+		  "Oct",
+		  "Nov",
+		  "Dec"
+		};
+
+
+ /*
+  * Get the date and time from the UNIX time value, and then format it
+  * into a string.  Note that we *can't* use the strftime() function since
+  * it is localized and will seriously confuse automatic programs if the
+  * month names are in the wrong language!
+  *
+  * Also, we use the "timezone" variable that contains the current timezone
+  * offset from GMT in seconds so that we are reporting local time in the
+  * log files.  If you want GMT, set the TZ environment variable accordingly
+  * before starting the scheduler.
+  *
+  * (*BSD and Darwin store the timezone offset in the tm structure)
+  *
+  * localtime_r() is used since the log thread formats dates too...
+  */
+
+  localtime_r(&(t->tv_sec), &date);
+
+  if (format == CUPSD_TIME_STANDARD)
+    snprintf(s, slen, "[%02d/%s/%04d:%02d:%02d:%02d %+03ld%02ld]",
+	     date.tm_mday, months[date.tm_mon], 1900 + date.tm_year,
+	     date.tm_hour, date.tm_min, date.tm_sec,
+#ifdef HAVE_TM_GMTOFF
+	     date.tm_gmtoff / 3600, (date.tm_gmtoff / 60) % 60);
+#else
+	     timezone / 3600, (timezone / 60) % 60);
+#endif /* HAVE_TM_GMTOFF */
+  else
+    snprintf(s, slen, "[%02d/%s/%04d:%02d:%02d:%02d.%06d %+03ld%02ld]",
+	     date.tm_mday, months[date.tm_mon], 1900 + date.tm_year,
+	     date.tm_hour, date.tm_min, date.tm_sec, (int)t->tv_usec,
+#ifdef HAVE_TM_GMTOFF
+	     date.tm_gmtoff / 3600, (date.tm_gmtoff / 60) % 60);
+#else
+	     timezone / 3600, (timezone / 60) % 60);
+#endif /* HAVE_TM_GMTOFF */
+
+  return (s);
 }
 
 
 /*
  * 'format_log_line()' - Format a line for a log file.
  *
- * This function resizes a global string buffer as needed.  Each call returns
- * a pointer to this buffer, so the contents are only good until the next call
- * to format_log_line()...
+ * Lines that do not fit in the supplied buffer are formatted into a new
+ * 64k buffer, which the caller must free.  Each caller supplies its
+ * own buffer since the log writer thread logs messages, too.
  */
 
-static int				/* O - -1 for fatal, 0 for retry, 1 for success */
-format_log_line(const char *message,	/* I - Printf-style format string */
+static char *				/* O - Formatted line */
+format_log_line(char       *buffer,	/* I - Line buffer */
+                size_t     bufsize,	/* I - Size of line buffer */
+                const char *message,	/* I - Printf-style format string */
                 va_list    ap)		/* I - Argument list */
 {
+  va_list	ap2;			/* Copy of argument list */
   ssize_t	len;			/* Length of formatted line */
+  char		*line;			/* Larger line buffer */
 
 
  /*
-  * Allocate the line buffer as needed...
+  * Format the log message...
   */
 
-  if (!log_linesize)
+  va_copy(ap2, ap);
+  len = _cups_safe_vsnprintf(buffer, bufsize, message, ap2);
+  va_end(ap2);
+
+ /*
+  * Allocate a larger buffer as needed...
+  */
+
+  if (len < 0 || (size_t)len < bufsize - 2)
+    return (buffer);
+
+ /*
+  * _cups_safe_vsnprintf() stops counting string arguments when the buffer is
+  * full, so a full buffer means the line may have been truncated...
+  */
+
+  if ((line = malloc(65536)) == NULL)
+    return (buffer);
+
+  _cups_safe_vsnprintf(line, 65536, message, ap);
+
+  return (line);
+}
+
+
+/*
+ * 'get_log_file()' - Return the currently open log file.
+ */
+
+static cups_file_t *			/* O - Log file or NULL */
+get_log_file(cupsd_logfile_t file)	/* I - Log file */
+{
+  switch (file)
   {
-    log_linesize = 8192;
-    log_line     = malloc(log_linesize);
+    case CUPSD_LOGFILE_ERROR :
+        return (ErrorFile);
+
+    case CUPSD_LOGFILE_ACCESS :
+        return (AccessFile);
 
-    if (!log_line)
-      return (-1);
+    default :
+        return (PageFile);
   }
+}
+
+
+/*
+ * 'log_lock()' - Lock the log files.
+ *
+ * Opening or rotating a log file can log messages of its own, so the lock
+ * is not taken again when the calling thread already holds it.
+ */
+
+static int				/* O - 1 if locked, 0 if already held */
+log_lock(void)
+{
+#ifdef CUPSD_LOG_THREAD
+  if (cupsdAtomicGet(&log_mutex_locked) &&
+      pthread_equal(log_mutex_owner, pthread_self()))
+    return (0);
+
+  _cupsMutexLock(&log_mutex);
+
+  log_mutex_owner = pthread_self();
+  cupsdAtomicSet(&log_mutex_locked, 1);
+
+#else
+  if (log_mutex_locked)
+    return (0);
+
+  _cupsMutexLock(&log_mutex);
+
+  log_mutex_locked = 1;
+#endif /* CUPSD_LOG_THREAD */
+
+  return (1);
+}
+
+
+#ifdef CUPSD_LOG_THREAD
+/*
+ * 'log_queue_add()' - Add a message to the log queue.
+ *
+ * The queue is a bounded multiple-producer, single-consumer ring buffer.  Each
+ * slot carries a sequence number that tells producers when the slot is free
+ * and tells the writer when the slot has been filled.
+ *
+ * When the queue is full, debug messages are dropped and counted; all other
+ * messages wait for the writer to make room.
+ */
+
+static int				/* O - 1 if queued or dropped, 0 to write now */
+log_queue_add(cupsd_logfile_t file,	/* I - Log file */
+              int             level,	/* I - Log level */
+              const char      *message)	/* I - Message string */
+{
+  size_t		pos,		/* Queue position */
+			sequence;	/* Slot sequence number */
+  cupsd_logslot_t	*slot;		/* Queue slot */
+  char			*copy;		/* Copy of message */
+  struct timeval	curtime;	/* Time of message */
+
 
  /*
-  * Format the log message...
+  * The writer thread logs its own messages directly...
   */
 
-  len = _cups_safe_vsnprintf(log_line, log_linesize, message, ap);
+  if (!cupsdAtomicGet(&log_thread_running) ||
+      pthread_equal(pthread_self(), log_thread))
+    return (0);
+
+  gettimeofday(&curtime, NULL);
+
+  if ((copy = strdup(message)) == NULL)
+    return (0);
 
  /*
-  * Resize the buffer as needed...
+  * Claim a slot...
   */
 
-  if ((size_t)len >= log_linesize && log_linesize < 65536)
+  pos = cupsdAtomicGet(&log_queue_head);
+
+  for (;;)
   {
-    char	*temp;			/* Temporary string pointer */
+    slot     = log_queue + (pos & log_queue_mask);
+    sequence = cupsdAtomicGet(&slot->sequence);
 
-    len ++;
+    if (sequence == pos)
+    {
+      if (cupsdAtomicCAS(&log_queue_head, &pos, pos + 1))
+        break;
+    }
+    else if ((ssize_t)(sequence - pos) < 0)
+    {
+     /*
+      * Queue is full...
+      */
 
-    if (len < 8192)
-      len = 8192;
-    else if (len > 65536)
-      len = 65536;
+      if (file == CUPSD_LOGFILE_ERROR && level >= CUPSD_LOG_DEBUG)
+      {
+        free(copy);
 
-    temp = realloc(log_line, (size_t)len);
+        cupsdAtomicAdd(&log_dropped, 1);
+        cupsdAtomicAdd(&log_dropped_total, 1);
 
-    if (temp)
-    {
-      log_line     = temp;
-      log_linesize = (size_t)len;
+        return (1);
+      }
 
-      return (0);
+      log_thread_wake();
+      usleep(1000);
+
+      pos = cupsdAtomicGet(&log_queue_head);
     }
+    else
+      pos = cupsdAtomicGet(&log_queue_head);
   }
 
+ /*
+  * Fill the slot and hand it to the writer...
+  */
+
+  slot->file    = file;
+  slot->level   = level;
+  slot->time    = curtime;
+  slot->message = copy;
+
+  cupsdAtomicSet(&slot->sequence, pos + 1);
+
+  if (cupsdAtomicGet(&log_thread_sleeping))
+    log_thread_wake();
+
   return (1);
 }
 
 
+/*
+ * 'log_thread_func()' - Write queued log messages.
+ *
+ * This is also called from cupsdStopLogThread() after the writer thread has
+ * exited in order to write any stragglers.
+ */
+
+static void *				/* O - Thread exit status */
+log_thread_func(void *arg)		/* I - Thread data (unused) */
+{
+  int			i;		/* Looping var */
+  cupsd_logslot_t	*slot;		/* Queue slot */
+  cups_file_t		*files[3];	/* Log files */
+  int			checked[3];	/* Log files checked in this batch? */
+  int			count;		/* Messages written in this batch */
+  unsigned		dropped;	/* Messages dropped */
+  struct timeval	curtime;	/* Current time */
+  struct timespec	timeout;	/* Wakeup timeout */
+  char			message[256];	/* Dropped message */
+
+
+  (void)arg;
+
+  for (;;)
+  {
+   /*
+    * Write everything that is queued, checking each log file for rotation
+    * once per batch instead of once per line...
+    */
+
+    count = 0;
+    memset(checked, 0, sizeof(checked));
+
+    log_lock();
+
+    for (;;)
+    {
+      slot = log_queue + (log_queue_tail & log_queue_mask);
+
+      if (cupsdAtomicGet(&slot->sequence) != log_queue_tail + 1)
+        break;
+
+      if (!checked[slot->file])
+      {
+        files[slot->file]   = check_log_file(slot->file);
+	checked[slot->file] = 1;
+      }
+
+      if (files[slot->file])
+        put_log_line(files[slot->file], slot->file, slot->level, &slot->time,
+	             slot->message);
+
+      free(slot->message);
+      slot->message = NULL;
+
+      cupsdAtomicSet(&slot->sequence, log_queue_tail + log_queue_mask + 1);
+      log_queue_tail ++;
+      count ++;
+    }
+
+    if ((dropped = cupsdAtomicSwap(&log_dropped, 0)) > 0)
+    {
+      if (!checked[CUPSD_LOGFILE_ERROR])
+      {
+        files[CUPSD_LOGFILE_ERROR]   = check_log_file(CUPSD_LOGFILE_ERROR);
+	checked[CUPSD_LOGFILE_ERROR] = 1;
+      }
+
+      if (files[CUPSD_LOGFILE_ERROR])
+      {
+        gettimeofday(&curtime, NULL);
+	snprintf(message, sizeof(message),
+	         "Dropped %u debug messages because the log queue was full.",
+		 dropped);
+	put_log_line(files[CUPSD_LOGFILE_ERROR], CUPSD_LOGFILE_ERROR,
+	             CUPSD_LOG_WARN, &curtime, message);
+      }
+    }
+
+    for (i = 0; i < 3; i ++)
+      if (checked[i] && files[i])
+        cupsFileFlush(files[i]);
+
+    log_unlock();
+
+    if (count || dropped)
+      continue;
+
+   /*
+    * Nothing more to write, wait for producers...
+    */
+
+    if (cupsdAtomicGet(&log_thread_stop))
+      break;
+
+    pthread_mutex_lock(&log_queue_mutex);
+
+    cupsdAtomicSet(&log_thread_sleeping, 1);
+
+    slot = log_queue + (log_queue_tail & log_queue_mask);
+
+    if (cupsdAtomicGet(&slot->sequence) != log_queue_tail + 1 &&
+        !cupsdAtomicGet(&log_thread_stop))
+    {
+      gettimeofday(&curtime, NULL);
+      timeout.tv_sec  = curtime.tv_sec + 1;
+      timeout.tv_nsec = curtime.tv_usec * 1000;
+
+      pthread_cond_timedwait(&log_queue_cond, &log_queue_mutex, &timeout);
+    }
+
+    cupsdAtomicSet(&log_thread_sleeping, 0);
+
+    pthread_mutex_unlock(&log_queue_mutex);
+  }
+
+  return (NULL);
+}
+
+
+/*
+ * 'log_thread_wake()' - Wake up the log writer thread.
+ */
+
+static void
+log_thread_wake(void)
+{
+  pthread_mutex_lock(&log_queue_mutex);
+  pthread_cond_signal(&log_queue_cond);
+  pthread_mutex_unlock(&log_queue_mutex);
+}
+#endif /* CUPSD_LOG_THREAD */
+
+
+/*
+ * 'log_unlock()' - Unlock the log files.
+ */
+
+static void
+log_unlock(void)
+{
+  cupsdAtomicSet(&log_mutex_locked, 0);
+
+  _cupsMutexUnlock(&log_mutex);
+}
+
+
+/*
+ * 'put_log_line()' - Write a single line to a log file.
+ */
+
+static void
+put_log_line(cups_file_t     *lf,	/* I - Log file */
+             cupsd_logfile_t file,	/* I - Which log file */
+	     int             level,	/* I - Log level */
+	     struct timeval  *t,	/* I - Time of message */
+	     const char      *message)	/* I - Message string */
+{
+  char	date[256];			/* Date/time string */
+
+
+  if (file == CUPSD_LOGFILE_ERROR)
+    cupsFilePrintf(lf, "%c %s %s\n", log_letters[level],
+                   format_date_time(t, LogTimeFormat, date, sizeof(date)),
+		   message);
+  else
+    cupsFilePrintf(lf, "%s\n", message);
+}
+
+
+/*
+ * 'write_log_line()' - Queue or write a line to a log file.
+ */
+
+static int				/* O - 1 on success, 0 on failure */
+write_log_line(cupsd_logfile_t file,	/* I - Log file */
+               int             level,	/* I - Log level */
+               const char      *message)/* I - Message string */
+{
+  cups_file_t		*lf;		/* Log file */
+  struct timeval	curtime;	/* Current time */
+
+
+#ifdef CUPSD_LOG_THREAD
+  if (log_queue_add(file, level, message))
+    return (1);
+#endif /* CUPSD_LOG_THREAD */
+
+  if (!log_lock())
+  {
+   /*
+    * Opening or rotating a log file logged this message; write it to the
+    * file that is open now, if any...
+    */
+
+    if ((lf = get_log_file(file)) != NULL)
+    {
+      gettimeofday(&curtime, NULL);
+
+      put_log_line(lf, file, level, &curtime, message);
+      cupsFileFlush(lf);
+    }
+
+    return (lf != NULL);
+  }
+
+  if ((lf = check_log_file(file)) != NULL)
+  {
+    gettimeofday(&curtime, NULL);
+
+    put_log_line(lf, file, level, &curtime, message);
+    cupsFileFlush(lf);
+  }
+
+  log_unlock();
+
+  return (lf != NULL);
+}
+
+
 /*
  * End of "$Id: log.c 12928 2015-10-23 21:31:58Z msweet $".
  */
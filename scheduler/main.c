@@ -116,12 +116,10 @@ main(int  argc,				/* I - Number of command-line args */
   cupsd_job_t		*job;		/* Current job */
   cupsd_listener_t	*lis;		/* Current listener */
   time_t		current_time,	/* Current time */
-			activity,	/* Client activity timer */
-			senddoc_time,	/* Send-Document time */
-			expire_time,	/* Subscription expire time */
 			report_time,	/* Malloc/client/job report time */
 			event_time;	/* Last event notification time */
   long			timeout;	/* Timeout for cupsdDoSelect() */
+  struct timeval	loop_start;	/* Start of main loop work */
   struct rlimit		limit;		/* Runtime limit */
 #if defined(HAVE_SIGACTION) && !defined(HAVE_SIGSET)
   struct sigaction	action;		/* Actions for POSIX signals */
@@ -676,10 +674,10 @@ main(int  argc,				/* I - Number of command-line args */
 
   current_time  = time(NULL);
   event_time    = current_time;
-  expire_time   = current_time;
   fds           = 1;
   report_time   = 0;
-  senddoc_time  = current_time;
+
+  memset(&loop_start, 0, sizeof(loop_start));
 
   while (!stop_scheduler)
   {
@@ -700,7 +698,7 @@ main(int  argc,				/* I - Number of command-line args */
       * Close any idle clients...
       */
 
-      if (cupsArrayCount(Clients) > 0)
+      if (cupsdClientCount() > 0)
       {
 	for (con = (cupsd_client_t *)cupsArrayFirst(Clients);
 	     con;
@@ -710,6 +708,11 @@ main(int  argc,				/* I - Number of command-line args */
 	  else
 	    con->http->keep_alive = HTTP_KEEPALIVE_OFF;
 
+	for (con = (cupsd_client_t *)cupsArrayFirst(IdleClients);
+	     con;
+	     con = (cupsd_client_t *)cupsArrayNext(IdleClients))
+	  cupsdCloseClient(con);
+
         cupsdPauseListening();
       }
 
@@ -718,7 +721,7 @@ main(int  argc,				/* I - Number of command-line args */
       * if the reload timeout has elapsed...
       */
 
-      if ((cupsArrayCount(Clients) == 0 &&
+      if ((cupsdClientCount() == 0 &&
            (cupsArrayCount(PrintingJobs) == 0 || NeedReload != RELOAD_ALL)) ||
           (time(NULL) - ReloadTime) >= ReloadTimeout)
       {
@@ -778,6 +781,9 @@ main(int  argc,				/* I - Number of command-line args */
     * times.
     */
 
+    if (loop_start.tv_sec)
+      cupsdMetricsAddLoop(&loop_start);
+
     if ((timeout = select_timeout(fds)) > 1 && LastEvent)
       timeout = 1;
 
@@ -862,14 +868,16 @@ main(int  argc,				/* I - Number of command-line args */
       break;
     }
 
+    gettimeofday(&loop_start, NULL);
+
     current_time = time(NULL);
 
    /*
-    * Write dirty config/state files...
+    * Run any expired timers: client and job timeouts, subscription expiration,
+    * writing dirty config/state files, etc.
     */
 
-    if (DirtyCleanTime && current_time >= DirtyCleanTime)
-      cupsdCleanDirty();
+    cupsdRunTimers();
 
 #ifdef __APPLE__
    /*
@@ -913,28 +921,6 @@ main(int  argc,				/* I - Number of command-line args */
     }
 #endif /* HAVE_LAUNCHD || HAVE_SYSTEMD */
 
-   /*
-    * Resume listening for new connections as needed...
-    */
-
-    if (ListeningPaused && ListeningPaused <= current_time &&
-        cupsArrayCount(Clients) < MaxClients)
-      cupsdResumeListening();
-
-   /*
-    * Expire subscriptions and unload completed jobs as needed...
-    */
-
-    if (current_time > expire_time)
-    {
-      if (cupsArrayCount(Subscriptions) > 0)
-        cupsdExpireSubscriptions(NULL, NULL);
-
-      cupsdUnloadCompletedJobs();
-
-      expire_time = current_time;
-    }
-
 #ifndef HAVE_AUTHORIZATION_H
    /*
     * Update the root certificate once every 5 minutes if we have client
@@ -942,7 +928,7 @@ main(int  argc,				/* I - Number of command-line args */
     */
 
     if ((current_time - RootCertTime) >= RootCertDuration && RootCertDuration &&
-        !RunUser && cupsArrayCount(Clients))
+        !RunUser && cupsdClientCount())
     {
      /*
       * Update the root certificate...
@@ -954,53 +940,14 @@ main(int  argc,				/* I - Number of command-line args */
 #endif /* !HAVE_AUTHORIZATION_H */
 
    /*
-    * Check for new data on the client sockets...
+    * Process pending data in the client input buffers...
     */
 
     for (con = (cupsd_client_t *)cupsArrayFirst(Clients);
 	 con;
 	 con = (cupsd_client_t *)cupsArrayNext(Clients))
-    {
-     /*
-      * Process pending data in the input buffer...
-      */
-
-      if (httpGetReady(con->http))
-      {
+      if (cupsdClientReady(con))
         cupsdReadClient(con);
-	continue;
-      }
-
-     /*
-      * Check the activity and close old clients...
-      */
-
-      activity = current_time - Timeout;
-      if (httpGetActivity(con->http) < activity && !con->pipe_pid)
-      {
-        cupsdLogMessage(CUPSD_LOG_DEBUG, "Closing client %d after %d seconds of inactivity.", con->number, Timeout);
-
-        cupsdCloseClient(con);
-        continue;
-      }
-    }
-
-   /*
-    * Update any pending multi-file documents...
-    */
-
-    if ((current_time - senddoc_time) >= 10)
-    {
-      cupsdCheckJobs();
-      senddoc_time = current_time;
-    }
-
-   /*
-    * Clean job history...
-    */
-
-    if (JobHistoryUpdate && current_time >= JobHistoryUpdate)
-      cupsdCleanJobs();
 
    /*
     * Log statistics at most once a minute when in debug mode...
@@ -1024,13 +971,17 @@ main(int  argc,				/* I - Number of command-line args */
 #endif /* HAVE_MALLINFO */
 
       cupsdLogMessage(CUPSD_LOG_DEBUG, "Report: clients=%d",
-                      cupsArrayCount(Clients));
+                      cupsdClientCount());
+      cupsdLogMessage(CUPSD_LOG_DEBUG, "Report: clients-idle=%d",
+                      cupsArrayCount(IdleClients));
       cupsdLogMessage(CUPSD_LOG_DEBUG, "Report: jobs=%d",
                       cupsArrayCount(Jobs));
       cupsdLogMessage(CUPSD_LOG_DEBUG, "Report: jobs-active=%d",
                       cupsArrayCount(ActiveJobs));
       cupsdLogMessage(CUPSD_LOG_DEBUG, "Report: printers=%d",
                       cupsArrayCount(Printers));
+      cupsdLogMessage(CUPSD_LOG_DEBUG, "Report: log-dropped=%u",
+                      cupsdGetLogDropped());
 
       string_count = _cupsStrStatistics(&alloc_bytes, &total_bytes);
       cupsdLogMessage(CUPSD_LOG_DEBUG,
@@ -1570,15 +1521,12 @@ static long				/* O - Number of seconds */
 select_timeout(int fds)			/* I - Number of descriptors returned */
 {
   long			timeout;	/* Timeout for select */
-  time_t		now;		/* Current time */
+  time_t		now,		/* Current time */
+			next;		/* Time of next timer */
   cupsd_client_t	*con;		/* Client information */
-  cupsd_job_t		*job;		/* Job information */
   const char		*why;		/* Debugging aid */
 
 
-  cupsdLogMessage(CUPSD_LOG_DEBUG2, "select_timeout: JobHistoryUpdate=%ld",
-		  (long)JobHistoryUpdate);
-
  /*
   * Check to see if any of the clients have pending data to be
   * processed; if so, the timeout should be 0...
@@ -1587,26 +1535,24 @@ select_timeout(int fds)			/* I - Number of descriptors returned */
   for (con = (cupsd_client_t *)cupsArrayFirst(Clients);
        con;
        con = (cupsd_client_t *)cupsArrayNext(Clients))
-    if (httpGetReady(con->http))
+    if (cupsdClientReady(con))
       return (0);
 
  /*
-  * If select has been active in the last second (fds > 0) or we have
-  * many resources in use then don't bother trying to optimize the
-  * timeout, just make it 1 second.
-  */
-
-  if (fds > 0 || cupsArrayCount(Clients) > 50)
-    return (1);
-
- /*
-  * Otherwise, check all of the possible events that we need to wake for...
+  * Otherwise, wait for the next timer; client and job timeouts, subscription
+  * expiration, dirty files, etc. all live in the timer wheel...
   */
 
   now     = time(NULL);
   timeout = now + 86400;		/* 86400 == 1 day */
   why     = "do nothing";
 
+  if ((next = cupsdNextTimer()) != 0 && next < timeout)
+  {
+    timeout = next;
+    why     = "run timers";
+  }
+
 #ifdef __APPLE__
  /*
   * When going to sleep, wake up to cancel jobs that don't complete in time.
@@ -1619,96 +1565,6 @@ select_timeout(int fds)			/* I - Number of descriptors returned */
   }
 #endif /* __APPLE__ */
 
- /*
-  * Check whether we are accepting new connections...
-  */
-
-  if (ListeningPaused > 0 && cupsArrayCount(Clients) < MaxClients &&
-      ListeningPaused < timeout)
-  {
-    if (ListeningPaused <= now)
-      timeout = now;
-    else
-      timeout = ListeningPaused;
-
-    why = "resume listening";
-  }
-
- /*
-  * Check the activity and close old clients...
-  */
-
-  for (con = (cupsd_client_t *)cupsArrayFirst(Clients);
-       con;
-       con = (cupsd_client_t *)cupsArrayNext(Clients))
-    if ((httpGetActivity(con->http) + Timeout) < timeout)
-    {
-      timeout = httpGetActivity(con->http) + Timeout;
-      why     = "timeout a client connection";
-    }
-
- /*
-  * Write out changes to configuration and state files...
-  */
-
-  if (DirtyCleanTime && timeout > DirtyCleanTime)
-  {
-    timeout = DirtyCleanTime;
-    why     = "write dirty config/state files";
-  }
-
- /*
-  * Check for any job activity...
-  */
-
-  if (JobHistoryUpdate && timeout > JobHistoryUpdate)
-  {
-    timeout = JobHistoryUpdate;
-    why     = "update job history";
-  }
-
-  for (job = (cupsd_job_t *)cupsArrayFirst(ActiveJobs);
-       job;
-       job = (cupsd_job_t *)cupsArrayNext(ActiveJobs))
-  {
-    if (job->cancel_time && job->cancel_time < timeout)
-    {
-      timeout = job->cancel_time;
-      why     = "cancel stuck jobs";
-    }
-
-    if (job->kill_time && job->kill_time < timeout)
-    {
-      timeout = job->kill_time;
-      why     = "kill unresponsive jobs";
-    }
-
-    if (job->state_value == IPP_JOB_HELD && job->hold_until < timeout)
-    {
-      timeout = job->hold_until;
-      why     = "release held jobs";
-    }
-
-    if (job->state_value == IPP_JOB_PENDING && timeout > (now + 10))
-    {
-      timeout = now + 10;
-      why     = "start pending jobs";
-      break;
-    }
-  }
-
-#ifdef HAVE_MALLINFO
- /*
-  * Log memory usage every minute...
-  */
-
-  if (LogLevel >= CUPSD_LOG_DEBUG && (mallinfo_time + 60) < timeout)
-  {
-    timeout = mallinfo_time + 60;
-    why     = "display memory usage";
-  }
-#endif /* HAVE_MALLINFO */
-
  /*
   * Adjust from absolute to relative time.  We add 1 second to the timeout since
   * events occur after the timeout expires, and limit the timeout to 86400
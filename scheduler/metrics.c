@@ -0,0 +1,418 @@
+/*
+ * "$Id$"
+ *
+ * Metrics routines for the CUPS scheduler.
+ *
+ * Copyright 2007-2016 by Apple Inc.
+ *
+ * These coded instructions, statements, and computer programs are the
+ * property of Apple Inc. and are protected by Federal copyright
+ * law.  Distribution and use rights are outlined in the file "LICENSE.txt"
+ * which should have been included with this file.  If this file is
+ * file is missing or damaged, see the license at "http://www.cups.org/".
+ */
+
+/*
+ * Include necessary headers...
+ */
+
+#include "cupsd.h"
+
+
+/*
+ * Constants...
+ */
+
+#define CUPSD_METRICS_BUCKETS	9	/* Number of histogram buckets */
+#define CUPSD_METRICS_OPS	256	/* Number of operation slots */
+
+
+/*
+ * Types...
+ */
+
+typedef struct cupsd_histogram_s	/**** Latency histogram ****/
+{
+  unsigned long long	count,		/* Number of samples */
+			usecs,		/* Sum of samples in microseconds */
+			buckets[CUPSD_METRICS_BUCKETS];
+					/* Samples per bucket */
+} cupsd_histogram_t;
+
+typedef struct cupsd_depth_s		/**** Queue depth for a printer ****/
+{
+  const char		*name;		/* Printer or class name */
+  int			jobs[4];	/* Pending, held, processing, stopped */
+} cupsd_depth_t;
+
+
+/*
+ * Local globals...
+ */
+
+static const unsigned long long metrics_limits[CUPSD_METRICS_BUCKETS] =
+			{		/* Bucket limits in microseconds */
+			  500,
+			  1000,
+			  5000,
+			  10000,
+			  50000,
+			  100000,
+			  500000,
+			  1000000,
+			  5000000
+			};
+static cupsd_histogram_t metrics_loop,	/* Main loop iterations */
+			metrics_ops[CUPSD_METRICS_OPS],
+					/* IPP operations */
+			metrics_procs;	/* Job processes */
+static unsigned long long metrics_spawned = 0;
+					/* Number of job processes started */
+
+
+/*
+ * Local functions...
+ */
+
+static void	add_histogram(cupsd_histogram_t *h, struct timeval *start);
+static int	compare_depths(cupsd_depth_t *a, cupsd_depth_t *b);
+static char	*quote_label(const char *s, char *buffer, size_t bufsize);
+static void	write_histogram(cups_file_t *fp, const char *name,
+		                const char *label, cupsd_histogram_t *h);
+
+
+/*
+ * 'cupsdMetricsAddLoop()' - Record the time spent in a main loop iteration.
+ */
+
+void
+cupsdMetricsAddLoop(struct timeval *start)/* I - Start of iteration */
+{
+  add_histogram(&metrics_loop, start);
+}
+
+
+/*
+ * 'cupsdMetricsAddProcess()' - Record the run time of a job process.
+ */
+
+void
+cupsdMetricsAddProcess(
+    struct timeval *start)		/* I - Start time of process */
+{
+  add_histogram(&metrics_procs, start);
+}
+
+
+/*
+ * 'cupsdMetricsAddRequest()' - Record the processing time of an IPP request.
+ *
+ * Standard operations map to the first half of the table and CUPS vendor
+ * operations to the second half; anything else is counted in slot 0.
+ */
+
+void
+cupsdMetricsAddRequest(
+    ipp_op_t       op,			/* I - Operation code */
+    struct timeval *start)		/* I - Start time of request */
+{
+  int	slot;				/* Operation slot */
+
+
+  if (op > 0 && op < CUPSD_METRICS_OPS / 2)
+    slot = op;
+  else if (op >= IPP_OP_PRIVATE && op < IPP_OP_PRIVATE + CUPSD_METRICS_OPS / 2)
+    slot = CUPSD_METRICS_OPS / 2 + op - IPP_OP_PRIVATE;
+  else
+    slot = 0;
+
+  add_histogram(metrics_ops + slot, start);
+}
+
+
+/*
+ * 'cupsdMetricsStartProcess()' - Count a new job process.
+ */
+
+void
+cupsdMetricsStartProcess(void)
+{
+  cupsdAtomicAdd(&metrics_spawned, 1);
+}
+
+
+/*
+ * 'cupsdWriteMetrics()' - Write all metrics in the Prometheus text format.
+ */
+
+int					/* O - 1 on success, 0 on error */
+cupsdWriteMetrics(cups_file_t *fp)	/* I - File to write to */
+{
+  int			i,		/* Looping var */
+			slot;		/* Operation slot */
+  const char		*opname;	/* Operation name */
+  char			label[1024],	/* Label string */
+			name[256];	/* Quoted name */
+  cups_array_t		*depths;	/* Queue depths */
+  cupsd_depth_t		*depth,		/* Current queue depth */
+			key;		/* Search key */
+  cupsd_printer_t	*p;		/* Current printer */
+  cupsd_job_t		*job;		/* Current job */
+  long long		spooled;	/* Spooled bytes */
+  static const char * const states[4] =	/* Job state labels */
+  {
+    "pending",
+    "held",
+    "processing",
+    "stopped"
+  };
+
+
+ /*
+  * IPP requests...
+  */
+
+  cupsFilePuts(fp, "# HELP cups_ipp_request_seconds Time spent processing IPP requests.\n"
+                   "# TYPE cups_ipp_request_seconds histogram\n");
+
+  for (slot = 0; slot < CUPSD_METRICS_OPS; slot ++)
+  {
+    if (!metrics_ops[slot].count)
+      continue;
+
+    if (slot == 0)
+      opname = "other";
+    else if (slot < CUPSD_METRICS_OPS / 2)
+      opname = ippOpString((ipp_op_t)slot);
+    else
+      opname = ippOpString((ipp_op_t)(IPP_OP_PRIVATE + slot - CUPSD_METRICS_OPS / 2));
+
+    snprintf(label, sizeof(label), "operation=\"%s\"", opname);
+    write_histogram(fp, "cups_ipp_request_seconds", label, metrics_ops + slot);
+  }
+
+ /*
+  * Queue depths, counted in a single pass over the active jobs...
+  */
+
+  depths = cupsArrayNew((cups_array_func_t)compare_depths, NULL);
+
+  for (p = (cupsd_printer_t *)cupsArrayFirst(Printers);
+       p;
+       p = (cupsd_printer_t *)cupsArrayNext(Printers))
+    if ((depth = calloc(1, sizeof(cupsd_depth_t))) != NULL)
+    {
+      depth->name = p->name;
+      cupsArrayAdd(depths, depth);
+    }
+
+  spooled = 0;
+
+  for (job = (cupsd_job_t *)cupsArrayFirst(ActiveJobs);
+       job;
+       job = (cupsd_job_t *)cupsArrayNext(ActiveJobs))
+  {
+    spooled += 1024 * (long long)job->koctets;
+
+    if (!job->dest || job->state_value < IPP_JSTATE_PENDING ||
+        job->state_value > IPP_JSTATE_STOPPED)
+      continue;
+
+    key.name = job->dest;
+
+    if ((depth = (cupsd_depth_t *)cupsArrayFind(depths, &key)) != NULL)
+      depth->jobs[job->state_value - IPP_JSTATE_PENDING] ++;
+  }
+
+  cupsFilePuts(fp, "# HELP cups_printer_jobs Number of active jobs for each printer and state.\n"
+                   "# TYPE cups_printer_jobs gauge\n");
+
+  for (depth = (cupsd_depth_t *)cupsArrayFirst(depths);
+       depth;
+       depth = (cupsd_depth_t *)cupsArrayNext(depths))
+  {
+    quote_label(depth->name, name, sizeof(name));
+
+    for (i = 0; i < 4; i ++)
+      cupsFilePrintf(fp, "cups_printer_jobs{printer=\"%s\",state=\"%s\"} %d\n",
+                     name, states[i], depth->jobs[i]);
+
+    free(depth);
+  }
+
+  cupsArrayDelete(depths);
+
+  cupsFilePrintf(fp, "# HELP cups_spool_bytes Size of the documents for active jobs.\n"
+                     "# TYPE cups_spool_bytes gauge\n"
+		     "cups_spool_bytes %lld\n", spooled);
+
+ /*
+  * Job processes...
+  */
+
+  cupsFilePrintf(fp, "# HELP cups_job_processes_started_total Number of filter and backend processes started.\n"
+                     "# TYPE cups_job_processes_started_total counter\n"
+		     "cups_job_processes_started_total %llu\n",
+		 cupsdAtomicGet(&metrics_spawned));
+
+  cupsFilePuts(fp, "# HELP cups_job_process_seconds Run time of filter and backend processes.\n"
+                   "# TYPE cups_job_process_seconds histogram\n");
+  write_histogram(fp, "cups_job_process_seconds", NULL, &metrics_procs);
+
+ /*
+  * Clients and the main loop...
+  */
+
+  cupsFilePrintf(fp, "# HELP cups_clients Number of client connections.\n"
+                     "# TYPE cups_clients gauge\n"
+		     "cups_clients %d\n"
+                     "# HELP cups_clients_active Number of client connections with a request in progress.\n"
+                     "# TYPE cups_clients_active gauge\n"
+		     "cups_clients_active %d\n"
+                     "# HELP cups_clients_idle Number of idle keep-alive client connections.\n"
+                     "# TYPE cups_clients_idle gauge\n"
+		     "cups_clients_idle %d\n",
+		 cupsdClientCount(), cupsArrayCount(ActiveClients),
+		 cupsArrayCount(IdleClients));
+
+  cupsFilePuts(fp, "# HELP cups_main_loop_seconds Time spent handling events in each main loop iteration.\n"
+                   "# TYPE cups_main_loop_seconds histogram\n");
+  write_histogram(fp, "cups_main_loop_seconds", NULL, &metrics_loop);
+
+  cupsFilePrintf(fp, "# HELP cups_log_dropped_total Number of debug log messages dropped because the log queue was full.\n"
+                     "# TYPE cups_log_dropped_total counter\n"
+		     "cups_log_dropped_total %u\n", cupsdGetLogDropped());
+
+  return (1);
+}
+
+
+/*
+ * 'add_histogram()' - Add a sample to a histogram.
+ */
+
+static void
+add_histogram(cupsd_histogram_t *h,	/* I - Histogram */
+              struct timeval    *start)	/* I - Start time */
+{
+  int			i;		/* Looping var */
+  struct timeval	curtime;	/* Current time */
+  unsigned long long	usecs;		/* Elapsed microseconds */
+
+
+  gettimeofday(&curtime, NULL);
+
+  if (curtime.tv_sec < start->tv_sec ||
+      (curtime.tv_sec == start->tv_sec && curtime.tv_usec < start->tv_usec))
+    usecs = 0;				/* Clock went backwards */
+  else
+    usecs = (unsigned long long)(curtime.tv_sec - start->tv_sec) * 1000000 +
+            (unsigned long long)(curtime.tv_usec - start->tv_usec);
+
+  for (i = 0; i < CUPSD_METRICS_BUCKETS; i ++)
+    if (usecs <= metrics_limits[i])
+    {
+      cupsdAtomicAdd(h->buckets + i, 1);
+      break;
+    }
+
+  cupsdAtomicAdd(&h->usecs, usecs);
+  cupsdAtomicAdd(&h->count, 1);
+}
+
+
+/*
+ * 'compare_depths()' - Compare two queue depth records.
+ */
+
+static int				/* O - Result of comparison */
+compare_depths(cupsd_depth_t *a,	/* I - First record */
+               cupsd_depth_t *b)	/* I - Second record */
+{
+  return (_cups_strcasecmp(a->name, b->name));
+}
+
+
+/*
+ * 'quote_label()' - Quote a label value.
+ */
+
+static char *				/* O - Quoted string */
+quote_label(const char *s,		/* I - Original string */
+            char       *buffer,		/* I - String buffer */
+	    size_t     bufsize)		/* I - Size of string buffer */
+{
+  char	*bufptr,			/* Pointer into buffer */
+	*bufend;			/* End of buffer */
+
+
+  for (bufptr = buffer, bufend = buffer + bufsize - 2; *s && bufptr < bufend; s ++)
+  {
+    if (*s == '\\' || *s == '\"')
+      *bufptr++ = '\\';
+    else if (*s == '\n')
+    {
+      *bufptr++ = '\\';
+      *bufptr++ = 'n';
+      continue;
+    }
+
+    *bufptr++ = *s;
+  }
+
+  *bufptr = '\0';
+
+  return (buffer);
+}
+
+
+/*
+ * 'write_histogram()' - Write a histogram.
+ */
+
+static void
+write_histogram(cups_file_t       *fp,	/* I - File to write to */
+                const char        *name,/* I - Metric name */
+		const char        *label,
+					/* I - Labels or NULL */
+		cupsd_histogram_t *h)	/* I - Histogram */
+{
+  int			i;		/* Looping var */
+  unsigned long long	total;		/* Cumulative count */
+  const char		*sep = label ? "," : "";
+					/* Label separator */
+
+
+  if (!label)
+    label = "";
+
+  for (i = 0, total = 0; i < CUPSD_METRICS_BUCKETS; i ++)
+  {
+    total += cupsdAtomicGet(h->buckets + i);
+
+    cupsFilePrintf(fp, "%s_bucket{%s%sle=\"%g\"} %llu\n", name, label, sep,
+                   metrics_limits[i] / 1000000.0, total);
+  }
+
+  cupsFilePrintf(fp, "%s_bucket{%s%sle=\"+Inf\"} %llu\n", name, label, sep,
+                 cupsdAtomicGet(&h->count));
+
+  if (*label)
+  {
+    cupsFilePrintf(fp, "%s_sum{%s} %.6f\n", name, label,
+                   cupsdAtomicGet(&h->usecs) / 1000000.0);
+    cupsFilePrintf(fp, "%s_count{%s} %llu\n", name, label,
+                   cupsdAtomicGet(&h->count));
+  }
+  else
+  {
+    cupsFilePrintf(fp, "%s_sum %.6f\n", name,
+                   cupsdAtomicGet(&h->usecs) / 1000000.0);
+    cupsFilePrintf(fp, "%s_count %llu\n", name, cupsdAtomicGet(&h->count));
+  }
+}
+
+
+/*
+ * End of "$Id$".
+ */
@@ -0,0 +1,38 @@
+/*
+ * "$Id$"
+ *
+ * Metrics definitions for the CUPS scheduler.
+ *
+ * Copyright 2007-2016 by Apple Inc.
+ *
+ * These coded instructions, statements, and computer programs are the
+ * property of Apple Inc. and are protected by Federal copyright
+ * law.  Distribution and use rights are outlined in the file "LICENSE.txt"
+ * which should have been included with this file.  If this file is
+ * file is missing or damaged, see the license at "http://www.cups.org/".
+ */
+
+
+/*
+ * Globals...
+ */
+
+VAR int			Metrics			VALUE(FALSE);
+					/* Serve metrics at /metrics? */
+
+
+/*
+ * Prototypes...
+ */
+
+extern void		cupsdMetricsAddLoop(struct timeval *start);
+extern void		cupsdMetricsAddProcess(struct timeval *start);
+extern void		cupsdMetricsAddRequest(ipp_op_t op,
+			                       struct timeval *start);
+extern void		cupsdMetricsStartProcess(void);
+extern int		cupsdWriteMetrics(cups_file_t *fp);
+
+
+/*
+ * End of "$Id$".
+ */
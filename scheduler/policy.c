@@ -26,6 +26,7 @@
  */
 
 static int	compare_ops(cupsd_location_t *a, cupsd_location_t *b);
+static int	op_slot(ipp_op_t op);
 static int	compare_policies(cupsd_policy_t *a, cupsd_policy_t *b);
 static void	free_policy(cupsd_policy_t *p);
 static int	hash_op(cupsd_location_t *op);
@@ -73,6 +74,7 @@ cupsdAddPolicyOp(cupsd_policy_t   *p,	/* I - Policy */
                  ipp_op_t         op)	/* I - IPP operation code */
 {
   cupsd_location_t	*temp;		/* New policy operation */
+  int			slot;		/* Lookup table slot */
 
 
   cupsdLogMessage(CUPSD_LOG_DEBUG2, "cupsdAddPolicyOp(p=%p, po=%p, op=%x(%s))",
@@ -96,6 +98,13 @@ cupsdAddPolicyOp(cupsd_policy_t   *p,	/* I - Policy */
     temp->limit = CUPSD_AUTH_LIMIT_IPP;
 
     cupsArrayAdd(p->ops, temp);
+
+   /*
+    * The first Limit for an operation wins, just like cupsArrayFind()...
+    */
+
+    if ((slot = op_slot(op)) >= 0 && !p->op_table[slot])
+      p->op_table[slot] = temp;
   }
 
   return (temp);
@@ -141,6 +150,19 @@ cupsdCheckPolicy(cupsd_policy_t *p,	/* I - Policy */
   * Return the status of the check...
   */
 
+  if (TraceFile)
+  {
+    http_status_t	status;		/* Authorization status */
+    struct timeval	start;		/* Start of check */
+
+    gettimeofday(&start, NULL);
+    status = cupsdIsAuthorized(con, owner);
+    cupsdTraceSpan(CUPSD_TRACE_CLIENT, con->number, "check-policy", &start,
+                   p->name);
+
+    return (status);
+  }
+
   return (cupsdIsAuthorized(con, owner));
 }
 
@@ -215,6 +237,7 @@ cupsdFindPolicyOp(cupsd_policy_t *p,	/* I - Policy */
 {
   cupsd_location_t	key,		/* Search key... */
 			*po;		/* Current policy operation */
+  int			slot;		/* Lookup table slot */
 
 
   cupsdLogMessage(CUPSD_LOG_DEBUG2, "cupsdFindPolicyOp(p=%p, op=%x(%s))",
@@ -228,19 +251,26 @@ cupsdFindPolicyOp(cupsd_policy_t *p,	/* I - Policy */
     return (NULL);
 
  /*
-  * Check the operation against the available policies...
+  * Check the operation against the available policies, using the lookup
+  * table for the standard and CUPS operations...
   */
 
-  key.op = op;
-  if ((po = (cupsd_location_t *)cupsArrayFind(p->ops, &key)) != NULL)
+  if ((slot = op_slot(op)) >= 0)
+    po = p->op_table[slot];
+  else
+  {
+    key.op = op;
+    po     = (cupsd_location_t *)cupsArrayFind(p->ops, &key);
+  }
+
+  if (po)
   {
     cupsdLogMessage(CUPSD_LOG_DEBUG2,
 		    "cupsdFindPolicyOp: Found exact match...");
     return (po);
   }
 
-  key.op = IPP_ANY_OPERATION;
-  if ((po = (cupsd_location_t *)cupsArrayFind(p->ops, &key)) != NULL)
+  if ((po = p->op_table[IPP_ANY_OPERATION]) != NULL)
   {
     cupsdLogMessage(CUPSD_LOG_DEBUG2,
 		    "cupsdFindPolicyOp: Found wildcard match...");
@@ -502,6 +532,22 @@ hash_op(cupsd_location_t *op)		/* I - Operation */
 }
 
 
+/*
+ * 'op_slot()' - Get the lookup table slot for an operation.
+ */
+
+static int				/* O - Slot or -1 if not in table */
+op_slot(ipp_op_t op)			/* I - IPP operation */
+{
+  if (op >= 0 && op < 0x100)
+    return ((int)op);
+  else if (op >= 0x4000 && op < 0x4100)
+    return ((int)op - 0x4000 + 0x100);
+  else
+    return (-1);
+}
+
+
 /*
  * End of "$Id: policy.c 11681 2014-03-05 19:07:24Z msweet $".
  */
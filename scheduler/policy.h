@@ -14,6 +14,14 @@
  */
 
 
+/*
+ * Operation lookup table size; slots 0-255 are standard operations
+ * (0 = IPP_ANY_OPERATION) and 256-511 are CUPS operations 0x4000-0x40FF...
+ */
+
+#define CUPSD_POLICY_OPS	512
+
+
 /*
  * Policy structure...
  */
@@ -26,6 +34,8 @@ typedef struct
 			*sub_access,	/* Private users/groups for subscriptions */
 			*sub_attrs,	/* Private attributes for subscriptions */
 			*ops;		/* Operations */
+  cupsd_location_t	*op_table[CUPSD_POLICY_OPS];
+					/* Operation lookup table */
 } cupsd_policy_t;
 
 typedef struct cupsd_printer_s cupsd_printer_t;
@@ -50,8 +50,13 @@ static int	compare_printers(void *first, void *second, void *data);
 static void	delete_printer_filters(cupsd_printer_t *p);
 static void	dirty_printer(cupsd_printer_t *p);
 static void	load_ppd(cupsd_printer_t *p);
+static int	load_state(cupsd_printer_t *p, const char *line, char *value,
+		           int linenum, const char *filename);
+static void	load_state_file(cupsd_printer_t *p);
 static ipp_t	*new_media_col(_pwg_size_t *size, const char *source,
 		               const char *type);
+static void	remove_state_file(cupsd_printer_t *p);
+static void	write_state(cups_file_t *fp, cupsd_printer_t *p);
 static void	write_xml_string(cups_file_t *fp, const char *s);
 
 
@@ -842,7 +847,6 @@ cupsdFindPrinter(const char *name)	/* I - Name of printer to find */
 void
 cupsdLoadAllPrinters(void)
 {
-  int			i;		/* Looping var */
   cups_file_t		*fp;		/* printers.conf file */
   int			linenum;	/* Current line number */
   char			line[4096],	/* Line from file */
@@ -907,9 +911,11 @@ cupsdLoadAllPrinters(void)
       if (p != NULL)
       {
        /*
-        * Close out the current printer...
+        * Load any newer state for the printer, then close it out...
 	*/
 
+        load_state_file(p);
+
         cupsdSetPrinterAttrs(p);
 
         if (strncmp(p->device_uri, "file:", 5) &&
@@ -948,6 +954,12 @@ cupsdLoadAllPrinters(void)
       cupsdLogMessage(CUPSD_LOG_ERROR,
                       "Syntax error on line %d of printers.conf.", linenum);
     }
+    else if (load_state(p, line, value, linenum, "printers.conf"))
+    {
+     /*
+      * State, StateMessage, StateTime, Reason, or Attribute...
+      */
+    }
     else if (!_cups_strcasecmp(line, "UUID"))
     {
       if (value && !strncmp(value, "urn:uuid:", 9))
@@ -1030,73 +1042,6 @@ cupsdLoadAllPrinters(void)
 	cupsdLogMessage(CUPSD_LOG_ERROR,
 	                "Syntax error on line %d of printers.conf.", linenum);
     }
-    else if (!_cups_strcasecmp(line, "Reason"))
-    {
-      if (value &&
-          strcmp(value, "connecting-to-device") &&
-          strcmp(value, "cups-insecure-filter-warning") &&
-          strcmp(value, "cups-missing-filter-warning"))
-      {
-        for (i = 0 ; i < p->num_reasons; i ++)
-	  if (!strcmp(value, p->reasons[i]))
-	    break;
-
-        if (i >= p->num_reasons &&
-	    p->num_reasons < (int)(sizeof(p->reasons) / sizeof(p->reasons[0])))
-	{
-	  p->reasons[p->num_reasons] = _cupsStrAlloc(value);
-	  p->num_reasons ++;
-	}
-      }
-      else
-	cupsdLogMessage(CUPSD_LOG_ERROR,
-	                "Syntax error on line %d of printers.conf.", linenum);
-    }
-    else if (!_cups_strcasecmp(line, "State"))
-    {
-     /*
-      * Set the initial queue state...
-      */
-
-      if (value && !_cups_strcasecmp(value, "idle"))
-        p->state = IPP_PRINTER_IDLE;
-      else if (value && !_cups_strcasecmp(value, "stopped"))
-      {
-        p->state = IPP_PRINTER_STOPPED;
-
-        for (i = 0 ; i < p->num_reasons; i ++)
-	  if (!strcmp("paused", p->reasons[i]))
-	    break;
-
-        if (i >= p->num_reasons &&
-	    p->num_reasons < (int)(sizeof(p->reasons) / sizeof(p->reasons[0])))
-	{
-	  p->reasons[p->num_reasons] = _cupsStrAlloc("paused");
-	  p->num_reasons ++;
-	}
-      }
-      else
-	cupsdLogMessage(CUPSD_LOG_ERROR,
-	                "Syntax error on line %d of printers.conf.", linenum);
-    }
-    else if (!_cups_strcasecmp(line, "StateMessage"))
-    {
-     /*
-      * Set the initial queue state message...
-      */
-
-      if (value)
-	strlcpy(p->state_message, value, sizeof(p->state_message));
-    }
-    else if (!_cups_strcasecmp(line, "StateTime"))
-    {
-     /*
-      * Set the state time...
-      */
-
-      if (value)
-        p->state_time = atoi(value);
-    }
     else if (!_cups_strcasecmp(line, "ConfigTime"))
     {
      /*
@@ -1268,26 +1213,6 @@ cupsdLoadAllPrinters(void)
       else
 	cupsdLogMessage(CUPSD_LOG_ERROR, "Syntax error on line %d of printers.conf.", linenum);
     }
-    else if (!_cups_strcasecmp(line, "Attribute") && value)
-    {
-      for (valueptr = value; *valueptr && !isspace(*valueptr & 255); valueptr ++);
-
-      if (!*valueptr)
-        cupsdLogMessage(CUPSD_LOG_ERROR,
-	                "Syntax error on line %d of printers.conf.", linenum);
-      else
-      {
-        for (; *valueptr && isspace(*valueptr & 255); *valueptr++ = '\0');
-
-        if (!p->attrs)
-	  cupsdSetPrinterAttrs(p);
-
-        if (!strcmp(value, "marker-change-time"))
-	  p->marker_time = atoi(valueptr);
-	else
-          cupsdSetPrinterAttr(p, value, valueptr);
-      }
-    }
     else if (_cups_strcasecmp(line, "Filter") &&
              _cups_strcasecmp(line, "Prefilter") &&
              _cups_strcasecmp(line, "Product"))
@@ -1324,6 +1249,16 @@ cupsdRenamePrinter(
                   "cupsdRenamePrinter: Removing %s from Printers", p->name);
   cupsArrayRemove(Printers, p);
 
+ /*
+  * Remove the state file for the old name...
+  */
+
+  if (p->state_saved)
+  {
+    remove_state_file(p);
+    p->state_dirty = 1;
+  }
+
  /*
   * Rename the printer type...
   */
@@ -1372,13 +1307,11 @@ cupsdSaveAllPrinters(void)
   char			filename[1024],	/* printers.conf filename */
 			temp[1024],	/* Temporary string */
 			value[2048],	/* Value string */
-			*ptr,		/* Pointer into value */
 			*name;		/* Current user/group name */
   cupsd_printer_t	*printer;	/* Current printer class */
   time_t		curtime;	/* Current time */
   struct tm		*curdate;	/* Current date */
   cups_option_t		*option;	/* Current option */
-  ipp_attribute_t	*marker;	/* Current marker attribute */
 
 
  /*
@@ -1479,24 +1412,9 @@ cupsdSaveAllPrinters(void)
     if (printer->port_monitor)
       cupsFilePutConf(fp, "PortMonitor", printer->port_monitor);
 
-    if (printer->state == IPP_PRINTER_STOPPED)
-    {
-      cupsFilePuts(fp, "State Stopped\n");
-
-      if (printer->state_message[0])
-        cupsFilePutConf(fp, "StateMessage", printer->state_message);
-    }
-    else
-      cupsFilePuts(fp, "State Idle\n");
-
-    cupsFilePrintf(fp, "StateTime %d\n", (int)printer->state_time);
     cupsFilePrintf(fp, "ConfigTime %d\n", (int)printer->config_time);
 
-    for (i = 0; i < printer->num_reasons; i ++)
-      if (strcmp(printer->reasons[i], "connecting-to-device") &&
-          strcmp(printer->reasons[i], "cups-insecure-filter-warning") &&
-          strcmp(printer->reasons[i], "cups-missing-filter-warning"))
-        cupsFilePutConf(fp, "Reason", printer->reasons[i]);
+    write_state(fp, printer);
 
     cupsFilePrintf(fp, "Type %d\n", printer->type);
 
@@ -1536,116 +1454,64 @@ cupsdSaveAllPrinters(void)
       cupsFilePutConf(fp, "Option", value);
     }
 
-    if ((marker = ippFindAttribute(printer->attrs, "marker-colors",
-                                   IPP_TAG_NAME)) != NULL)
-    {
-      snprintf(value, sizeof(value), "%s ", marker->name);
-
-      for (i = 0, ptr = value + strlen(value);
-           i < marker->num_values && ptr < (value + sizeof(value) - 1);
-	   i ++)
-      {
-        if (i)
-	  *ptr++ = ',';
-
-        strlcpy(ptr, marker->values[i].string.text, (size_t)(value + sizeof(value) - ptr));
-        ptr += strlen(ptr);
-      }
-
-      *ptr = '\0';
-      cupsFilePutConf(fp, "Attribute", value);
-    }
+    if (printer == DefaultPrinter)
+      cupsFilePuts(fp, "</DefaultPrinter>\n");
+    else
+      cupsFilePuts(fp, "</Printer>\n");
+  }
 
-    if ((marker = ippFindAttribute(printer->attrs, "marker-levels",
-                                   IPP_TAG_INTEGER)) != NULL)
-    {
-      cupsFilePrintf(fp, "Attribute %s %d", marker->name,
-                     marker->values[0].integer);
-      for (i = 1; i < marker->num_values; i ++)
-        cupsFilePrintf(fp, ",%d", marker->values[i].integer);
-      cupsFilePuts(fp, "\n");
-    }
+  if (cupsdCloseCreatedConfFile(fp, filename))
+    return;
 
-    if ((marker = ippFindAttribute(printer->attrs, "marker-low-levels",
-                                   IPP_TAG_INTEGER)) != NULL)
-    {
-      cupsFilePrintf(fp, "Attribute %s %d", marker->name,
-                     marker->values[0].integer);
-      for (i = 1; i < marker->num_values; i ++)
-        cupsFilePrintf(fp, ",%d", marker->values[i].integer);
-      cupsFilePuts(fp, "\n");
-    }
+ /*
+  * printers.conf now has the current state of every printer, so remove the
+  * per-printer state files...
+  */
 
-    if ((marker = ippFindAttribute(printer->attrs, "marker-high-levels",
-                                   IPP_TAG_INTEGER)) != NULL)
-    {
-      cupsFilePrintf(fp, "Attribute %s %d", marker->name,
-                     marker->values[0].integer);
-      for (i = 1; i < marker->num_values; i ++)
-        cupsFilePrintf(fp, ",%d", marker->values[i].integer);
-      cupsFilePuts(fp, "\n");
-    }
+  for (printer = (cupsd_printer_t *)cupsArrayFirst(Printers);
+       printer;
+       printer = (cupsd_printer_t *)cupsArrayNext(Printers))
+  {
+    printer->state_dirty = 0;
 
-    if ((marker = ippFindAttribute(printer->attrs, "marker-message",
-                                   IPP_TAG_TEXT)) != NULL)
-    {
-      snprintf(value, sizeof(value), "%s %s", marker->name,
-               marker->values[0].string.text);
+    if (printer->state_saved)
+      remove_state_file(printer);
+  }
+}
 
-      cupsFilePutConf(fp, "Attribute", value);
-    }
 
-    if ((marker = ippFindAttribute(printer->attrs, "marker-names",
-                                   IPP_TAG_NAME)) != NULL)
-    {
-      snprintf(value, sizeof(value), "%s ", marker->name);
+/*
+ * 'cupsdSavePrinterState()' - Save the state of a printer to its state file.
+ */
 
-      for (i = 0, ptr = value + strlen(value);
-           i < marker->num_values && ptr < (value + sizeof(value) - 1);
-	   i ++)
-      {
-        if (i)
-	  *ptr++ = ',';
+void
+cupsdSavePrinterState(
+    cupsd_printer_t *p)			/* I - Printer */
+{
+  cups_file_t	*fp;			/* State file */
+  char		filename[1024];		/* State filename */
 
-        strlcpy(ptr, marker->values[i].string.text, (size_t)(value + sizeof(value) - ptr));
-        ptr += strlen(ptr);
-      }
 
-      *ptr = '\0';
-      cupsFilePutConf(fp, "Attribute", value);
-    }
+  p->state_dirty = 0;
 
-    if ((marker = ippFindAttribute(printer->attrs, "marker-types",
-                                   IPP_TAG_KEYWORD)) != NULL)
-    {
-      snprintf(value, sizeof(value), "%s ", marker->name);
+  if (p->type & CUPS_PRINTER_CLASS)
+    return;
 
-      for (i = 0, ptr = value + strlen(value);
-           i < marker->num_values && ptr < (value + sizeof(value) - 1);
-	   i ++)
-      {
-        if (i)
-	  *ptr++ = ',';
+  snprintf(filename, sizeof(filename), "%s/printers/%s.state", ServerRoot,
+           p->name);
 
-        strlcpy(ptr, marker->values[i].string.text, (size_t)(value + sizeof(value) - ptr));
-        ptr += strlen(ptr);
-      }
+  if ((fp = cupsdCreateConfFile(filename, ConfigFilePerm & 0600)) == NULL)
+    return;
 
-      *ptr = '\0';
-      cupsFilePutConf(fp, "Attribute", value);
-    }
+  cupsdLogMessage(CUPSD_LOG_DEBUG, "Saving state for %s...", p->name);
 
-    if (printer->marker_time)
-      cupsFilePrintf(fp, "Attribute marker-change-time %ld\n",
-                     (long)printer->marker_time);
+  cupsFilePuts(fp, "# Printer state file for " CUPS_SVERSION "\n");
+  cupsFilePuts(fp, "# DO NOT EDIT THIS FILE WHEN CUPSD IS RUNNING\n");
 
-    if (printer == DefaultPrinter)
-      cupsFilePuts(fp, "</DefaultPrinter>\n");
-    else
-      cupsFilePuts(fp, "</Printer>\n");
-  }
+  write_state(fp, p);
 
-  cupsdCloseCreatedConfFile(fp, filename);
+  if (!cupsdCloseCreatedConfFile(fp, filename))
+    p->state_saved = 1;
 }
 
 
@@ -3741,7 +3607,10 @@ dirty_printer(cupsd_printer_t *p)	/* I - Printer */
   if (p->type & CUPS_PRINTER_CLASS)
     cupsdMarkDirty(CUPSD_DIRTY_CLASSES);
   else
-    cupsdMarkDirty(CUPSD_DIRTY_PRINTERS);
+  {
+    p->state_dirty = 1;
+    cupsdMarkDirty(CUPSD_DIRTY_PRINTSTATE);
+  }
 
   if (PrintcapFormat == PRINTCAP_PLIST)
     cupsdMarkDirty(CUPSD_DIRTY_PRINTCAP);
@@ -4994,6 +4863,180 @@ load_ppd(cupsd_printer_t *p)		/* I - Printer */
 }
 
 
+/*
+ * 'load_state()' - Load a printer state directive.
+ */
+
+static int				/* O - 1 if directive handled, 0 otherwise */
+load_state(cupsd_printer_t *p,		/* I - Printer */
+           const char      *line,	/* I - Directive */
+	   char            *value,	/* I - Value */
+	   int             linenum,	/* I - Line number */
+	   const char      *filename)	/* I - Filename for errors */
+{
+  int	i;				/* Looping var */
+  char	*valueptr;			/* Pointer into value */
+
+
+  if (!_cups_strcasecmp(line, "Reason"))
+  {
+    if (value &&
+	strcmp(value, "connecting-to-device") &&
+	strcmp(value, "cups-insecure-filter-warning") &&
+	strcmp(value, "cups-missing-filter-warning"))
+    {
+      for (i = 0 ; i < p->num_reasons; i ++)
+	if (!strcmp(value, p->reasons[i]))
+	  break;
+
+      if (i >= p->num_reasons &&
+	  p->num_reasons < (int)(sizeof(p->reasons) / sizeof(p->reasons[0])))
+      {
+	p->reasons[p->num_reasons] = _cupsStrAlloc(value);
+	p->num_reasons ++;
+      }
+    }
+    else
+      cupsdLogMessage(CUPSD_LOG_ERROR,
+		      "Syntax error on line %d of %s.", linenum, filename);
+  }
+  else if (!_cups_strcasecmp(line, "State"))
+  {
+   /*
+    * Set the initial queue state...
+    */
+
+    if (value && !_cups_strcasecmp(value, "idle"))
+      p->state = IPP_PRINTER_IDLE;
+    else if (value && !_cups_strcasecmp(value, "stopped"))
+    {
+      p->state = IPP_PRINTER_STOPPED;
+
+      for (i = 0 ; i < p->num_reasons; i ++)
+	if (!strcmp("paused", p->reasons[i]))
+	  break;
+
+      if (i >= p->num_reasons &&
+	  p->num_reasons < (int)(sizeof(p->reasons) / sizeof(p->reasons[0])))
+      {
+	p->reasons[p->num_reasons] = _cupsStrAlloc("paused");
+	p->num_reasons ++;
+      }
+    }
+    else
+      cupsdLogMessage(CUPSD_LOG_ERROR,
+		      "Syntax error on line %d of %s.", linenum, filename);
+  }
+  else if (!_cups_strcasecmp(line, "StateMessage"))
+  {
+   /*
+    * Set the initial queue state message...
+    */
+
+    if (value)
+      strlcpy(p->state_message, value, sizeof(p->state_message));
+  }
+  else if (!_cups_strcasecmp(line, "StateTime"))
+  {
+   /*
+    * Set the state time...
+    */
+
+    if (value)
+      p->state_time = atoi(value);
+  }
+  else if (!_cups_strcasecmp(line, "Attribute") && value)
+  {
+    for (valueptr = value; *valueptr && !isspace(*valueptr & 255); valueptr ++);
+
+    if (!*valueptr)
+      cupsdLogMessage(CUPSD_LOG_ERROR,
+		      "Syntax error on line %d of %s.", linenum, filename);
+    else
+    {
+      for (; *valueptr && isspace(*valueptr & 255); *valueptr++ = '\0');
+
+      if (!p->attrs)
+	cupsdSetPrinterAttrs(p);
+
+      if (!strcmp(value, "marker-change-time"))
+	p->marker_time = atoi(valueptr);
+      else
+	cupsdSetPrinterAttr(p, value, valueptr);
+    }
+  }
+  else
+    return (0);
+
+  return (1);
+}
+
+
+/*
+ * 'load_state_file()' - Load the state file for a printer, if any.
+ */
+
+static void
+load_state_file(cupsd_printer_t *p)	/* I - Printer */
+{
+  int		i;			/* Looping var */
+  cups_file_t	*fp;			/* State file */
+  int		linenum;		/* Current line number */
+  char		filename[1024],		/* State filename */
+		line[4096],		/* Line from file */
+		*value;			/* Pointer to value */
+  ipp_attribute_t *attr;		/* Marker attribute */
+  static const char * const markers[] =	/* Marker attributes */
+  {
+    "marker-colors",
+    "marker-levels",
+    "marker-low-levels",
+    "marker-high-levels",
+    "marker-message",
+    "marker-names",
+    "marker-types"
+  };
+
+
+  snprintf(filename, sizeof(filename), "%s/printers/%s.state", ServerRoot,
+           p->name);
+
+  if ((fp = cupsdOpenConfFile(filename)) == NULL)
+    return;
+
+  cupsdLogMessage(CUPSD_LOG_DEBUG, "Loading state for %s...", p->name);
+
+ /*
+  * The state file replaces the state from printers.conf...
+  */
+
+  for (i = 0; i < p->num_reasons; i ++)
+    _cupsStrFree(p->reasons[i]);
+
+  p->num_reasons      = 0;
+  p->state            = IPP_PRINTER_IDLE;
+  p->state_message[0] = '\0';
+  p->marker_time      = 0;
+
+  for (i = 0; i < (int)(sizeof(markers) / sizeof(markers[0])); i ++)
+    if (p->attrs && (attr = ippFindAttribute(p->attrs, markers[i],
+                                             IPP_TAG_ZERO)) != NULL)
+      ippDeleteAttribute(p->attrs, attr);
+
+  linenum = 0;
+
+  while (cupsFileGetConf(fp, line, sizeof(line), &value, &linenum))
+    if (!load_state(p, line, value, linenum, filename))
+      cupsdLogMessage(CUPSD_LOG_ERROR,
+                      "Unknown directive %s on line %d of %s.", line, linenum,
+		      filename);
+
+  cupsFileClose(fp);
+
+  p->state_saved = 1;
+}
+
+
 /*
  * 'new_media_col()' - Create a media-col collection value.
  */
@@ -5038,6 +5081,165 @@ new_media_col(_pwg_size_t *size,	/* I - media-size/margin values */
 }
 
 
+/*
+ * 'remove_state_file()' - Remove the state file for a printer.
+ */
+
+static void
+remove_state_file(cupsd_printer_t *p)	/* I - Printer */
+{
+  char	filename[1024];			/* State filename */
+
+
+  snprintf(filename, sizeof(filename), "%s/printers/%s.state", ServerRoot,
+           p->name);
+  cupsdUnlinkOrRemoveFile(filename);
+
+  snprintf(filename, sizeof(filename), "%s/printers/%s.state.O", ServerRoot,
+           p->name);
+  cupsdUnlinkOrRemoveFile(filename);
+
+  p->state_saved = 0;
+}
+
+
+/*
+ * 'write_state()' - Write the state directives for a printer.
+ */
+
+static void
+write_state(cups_file_t     *fp,	/* I - File to write to */
+            cupsd_printer_t *p)		/* I - Printer */
+{
+  int			i;		/* Looping var */
+  char			value[2048],	/* Value string */
+			*ptr;		/* Pointer into value */
+  ipp_attribute_t	*marker;	/* Current marker attribute */
+
+
+  if (p->state == IPP_PRINTER_STOPPED)
+  {
+    cupsFilePuts(fp, "State Stopped\n");
+
+    if (p->state_message[0])
+      cupsFilePutConf(fp, "StateMessage", p->state_message);
+  }
+  else
+    cupsFilePuts(fp, "State Idle\n");
+
+  cupsFilePrintf(fp, "StateTime %d\n", (int)p->state_time);
+
+  for (i = 0; i < p->num_reasons; i ++)
+    if (strcmp(p->reasons[i], "connecting-to-device") &&
+        strcmp(p->reasons[i], "cups-insecure-filter-warning") &&
+        strcmp(p->reasons[i], "cups-missing-filter-warning"))
+      cupsFilePutConf(fp, "Reason", p->reasons[i]);
+
+  if ((marker = ippFindAttribute(p->attrs, "marker-colors",
+				 IPP_TAG_NAME)) != NULL)
+  {
+    snprintf(value, sizeof(value), "%s ", marker->name);
+
+    for (i = 0, ptr = value + strlen(value);
+	 i < marker->num_values && ptr < (value + sizeof(value) - 1);
+	 i ++)
+    {
+      if (i)
+	*ptr++ = ',';
+
+      strlcpy(ptr, marker->values[i].string.text, (size_t)(value + sizeof(value) - ptr));
+      ptr += strlen(ptr);
+    }
+
+    *ptr = '\0';
+    cupsFilePutConf(fp, "Attribute", value);
+  }
+
+  if ((marker = ippFindAttribute(p->attrs, "marker-levels",
+				 IPP_TAG_INTEGER)) != NULL)
+  {
+    cupsFilePrintf(fp, "Attribute %s %d", marker->name,
+		   marker->values[0].integer);
+    for (i = 1; i < marker->num_values; i ++)
+      cupsFilePrintf(fp, ",%d", marker->values[i].integer);
+    cupsFilePuts(fp, "\n");
+  }
+
+  if ((marker = ippFindAttribute(p->attrs, "marker-low-levels",
+				 IPP_TAG_INTEGER)) != NULL)
+  {
+    cupsFilePrintf(fp, "Attribute %s %d", marker->name,
+		   marker->values[0].integer);
+    for (i = 1; i < marker->num_values; i ++)
+      cupsFilePrintf(fp, ",%d", marker->values[i].integer);
+    cupsFilePuts(fp, "\n");
+  }
+
+  if ((marker = ippFindAttribute(p->attrs, "marker-high-levels",
+				 IPP_TAG_INTEGER)) != NULL)
+  {
+    cupsFilePrintf(fp, "Attribute %s %d", marker->name,
+		   marker->values[0].integer);
+    for (i = 1; i < marker->num_values; i ++)
+      cupsFilePrintf(fp, ",%d", marker->values[i].integer);
+    cupsFilePuts(fp, "\n");
+  }
+
+  if ((marker = ippFindAttribute(p->attrs, "marker-message",
+				 IPP_TAG_TEXT)) != NULL)
+  {
+    snprintf(value, sizeof(value), "%s %s", marker->name,
+	     marker->values[0].string.text);
+
+    cupsFilePutConf(fp, "Attribute", value);
+  }
+
+  if ((marker = ippFindAttribute(p->attrs, "marker-names",
+				 IPP_TAG_NAME)) != NULL)
+  {
+    snprintf(value, sizeof(value), "%s ", marker->name);
+
+    for (i = 0, ptr = value + strlen(value);
+	 i < marker->num_values && ptr < (value + sizeof(value) - 1);
+	 i ++)
+    {
+      if (i)
+	*ptr++ = ',';
+
+      strlcpy(ptr, marker->values[i].string.text, (size_t)(value + sizeof(value) - ptr));
+      ptr += strlen(ptr);
+    }
+
+    *ptr = '\0';
+    cupsFilePutConf(fp, "Attribute", value);
+  }
+
+  if ((marker = ippFindAttribute(p->attrs, "marker-types",
+				 IPP_TAG_KEYWORD)) != NULL)
+  {
+    snprintf(value, sizeof(value), "%s ", marker->name);
+
+    for (i = 0, ptr = value + strlen(value);
+	 i < marker->num_values && ptr < (value + sizeof(value) - 1);
+	 i ++)
+    {
+      if (i)
+	*ptr++ = ',';
+
+      strlcpy(ptr, marker->values[i].string.text, (size_t)(value + sizeof(value) - ptr));
+      ptr += strlen(ptr);
+    }
+
+    *ptr = '\0';
+    cupsFilePutConf(fp, "Attribute", value);
+  }
+
+  if (p->marker_time)
+    cupsFilePrintf(fp, "Attribute marker-change-time %ld\n",
+		   (long)p->marker_time);
+}
+
+
 /*
  * 'write_xml_string()' - Write a string with XML escaping.
  */
@@ -113,6 +113,8 @@ struct cupsd_printer_s
   char		*alert,			/* PSX printer-alert value */
 		*alert_description;	/* PSX printer-alert-description value */
   time_t	marker_time;		/* Last time marker attributes were updated */
+  int		state_dirty,		/* Do we need to write the state file? */
+		state_saved;		/* Is there a state file? */
   _ppd_cache_t	*pc;			/* PPD cache and mapping data */
 
 #if defined(HAVE_DNSSD) || defined(HAVE_AVAHI)
@@ -165,6 +167,7 @@ extern void		cupsdLoadAllPrinters(void);
 extern void		cupsdRenamePrinter(cupsd_printer_t *p,
 			                   const char *name);
 extern void		cupsdSaveAllPrinters(void);
+extern void		cupsdSavePrinterState(cupsd_printer_t *p);
 extern int		cupsdSetAuthInfoRequired(cupsd_printer_t *p,
 			                         const char *values,
 						 ipp_attribute_t *attr);
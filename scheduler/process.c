@@ -43,9 +43,10 @@ extern char **environ;
 
 typedef struct
 {
-  int	pid,				/* Process ID */
-	job_id;				/* Job associated with process */
-  char	name[1];			/* Name of process */
+  int		pid,			/* Process ID */
+		job_id;			/* Job associated with process */
+  struct timeval start;			/* Time process was started */
+  char		name[1];		/* Name of process */
 } cupsd_proc_t;
 
 
@@ -422,6 +423,7 @@ cupsdFinishProcess(int    pid,		/* I - Process ID */
 {
   cupsd_proc_t	key,			/* Search key */
 		*proc;			/* Matching process */
+  const char	*base;			/* Base name of command */
 
 
   key.pid = pid;
@@ -431,6 +433,22 @@ cupsdFinishProcess(int    pid,		/* I - Process ID */
     if (job_id)
       *job_id = proc->job_id;
 
+    if (proc->job_id)
+    {
+      cupsdMetricsAddProcess(&proc->start);
+
+      if (TraceFile)
+      {
+        if ((base = strrchr(proc->name, '/')) != NULL)
+	  base ++;
+	else
+	  base = proc->name;
+
+        cupsdTraceSpan(CUPSD_TRACE_JOB, proc->job_id, base, &proc->start,
+	               NULL);
+      }
+    }
+
     strlcpy(name, proc->name, namelen);
     cupsArrayRemove(process_array, proc);
     free(proc);
@@ -822,10 +840,14 @@ cupsdStartProcess(
         proc->pid    = *pid;
 	proc->job_id = job ? job->id : 0;
 	_cups_strcpy(proc->name, command);
+	gettimeofday(&proc->start, NULL);
 
 	cupsArrayAdd(process_array, proc);
       }
     }
+
+    if (job)
+      cupsdMetricsStartProcess();
   }
 
   cupsdLogMessage(CUPSD_LOG_DEBUG2,
@@ -44,6 +44,18 @@ static int		started = 0;	/* Did we start the server already? */
 void
 cupsdStartServer(void)
 {
+ /*
+  * Start the log writer thread (as needed)...
+  */
+
+  cupsdStartLogThread();
+
+ /*
+  * Open the trace file (as needed)...
+  */
+
+  cupsdStartTrace();
+
  /*
   * Start color management (as needed)...
   */
@@ -110,6 +122,7 @@ cupsdStopServer(void)
   */
 
   cupsdCloseAllClients();
+  cupsdStopCGIWorkers();
   cupsdStopListening();
   cupsdStopBrowsing();
   cupsdStopAllNotifiers();
@@ -121,6 +134,12 @@ cupsdStopServer(void)
     Clients = NULL;
   }
 
+  if (IdleClients)
+  {
+    cupsArrayDelete(IdleClients);
+    IdleClients = NULL;
+  }
+
  /*
   * Close the pipe for CGI processes...
   */
@@ -137,9 +156,17 @@ cupsdStopServer(void)
   }
 
  /*
-  * Close all log files...
+  * Close the trace file...
+  */
+
+  cupsdStopTrace();
+
+ /*
+  * Flush any queued log messages and close all log files...
   */
 
+  cupsdStopLogThread();
+
   if (AccessFile != NULL)
   {
     if (AccessFile != LogStderr)
@@ -36,6 +36,7 @@ static int	cupsd_compare_subscriptions(cupsd_subscription_t *first,
 		                            cupsd_subscription_t *second,
 		                            void *unused);
 static void	cupsd_delete_event(cupsd_event_t *event);
+static void	cupsd_expire_subscription(cupsd_subscription_t *sub);
 #ifdef HAVE_DBUS
 static void	cupsd_send_dbus(cupsd_eventmask_t event, cupsd_printer_t *dest,
 		                cupsd_job_t *job);
@@ -474,6 +475,8 @@ cupsdDeleteSubscription(
 
   cupsArrayRemove(Subscriptions, sub);
 
+  cupsdClearTimer(&sub->timer);
+
  /*
   * Free memory...
   */
@@ -772,6 +775,8 @@ cupsdLoadAllSubscriptions(void)
 
       if (delete_sub)
         cupsdDeleteSubscription(sub, 0);
+      else
+        cupsdUpdateSubscriptionTimer(sub);
 
       sub        = NULL;
       delete_sub = 0;
@@ -1233,6 +1238,25 @@ cupsdStopAllNotifiers(void)
 }
 
 
+/*
+ * 'cupsdUpdateSubscriptionTimer()' - Update the lease expiration timer.
+ *
+ * Job subscriptions expire with their job, so only printer and server
+ * subscriptions use the timer.
+ */
+
+void
+cupsdUpdateSubscriptionTimer(
+    cupsd_subscription_t *sub)		/* I - Subscription object */
+{
+  if (sub->job || !sub->expire)
+    cupsdClearTimer(&sub->timer);
+  else
+    cupsdSetTimer(&sub->timer, sub->expire,
+                  (cupsd_timerfunc_t)cupsd_expire_subscription, sub);
+}
+
+
 /*
  * 'cupsd_compare_subscriptions()' - Compare two subscriptions.
  */
@@ -1268,6 +1292,22 @@ cupsd_delete_event(cupsd_event_t *event)/* I - Event to delete */
 }
 
 
+/*
+ * 'cupsd_expire_subscription()' - Expire a subscription whose lease is up.
+ */
+
+static void
+cupsd_expire_subscription(
+    cupsd_subscription_t *sub)		/* I - Subscription object */
+{
+  cupsdLogMessage(CUPSD_LOG_INFO, "Subscription %d has expired...", sub->id);
+
+  cupsdDeleteSubscription(sub, 0);
+
+  cupsdMarkDirty(CUPSD_DIRTY_SUBSCRIPTIONS);
+}
+
+
 #ifdef HAVE_DBUS
 /*
  * 'cupsd_send_dbus()' - Send a DBUS notification...
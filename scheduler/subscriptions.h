@@ -99,6 +99,7 @@ typedef struct cupsd_subscription_s	/**** Subscription structure ****/
   int			status;		/* Exit status of notifier */
   time_t		last;		/* Time of last notification */
   time_t		expire;		/* Lease expiration time */
+  cupsd_timer_t		timer;		/* Lease expiration timer */
   int			first_event_id,	/* First event-id in cache */
 			next_event_id;	/* Next event-id to use */
   cups_array_t		*events;	/* Cached events */
@@ -159,6 +160,7 @@ extern void	cupsdExpireSubscriptions(cupsd_printer_t *dest,
 extern void	cupsdLoadAllSubscriptions(void);
 extern void	cupsdSaveAllSubscriptions(void);
 extern void	cupsdStopAllNotifiers(void);
+extern void	cupsdUpdateSubscriptionTimer(cupsd_subscription_t *sub);
 
 
 /*
@@ -25,6 +25,20 @@
 #endif /* __APPLE__ */
 
 
+/*
+ * Local globals...
+ */
+
+static cupsd_timer_t	dirty_timer;	/* Timer for writing dirty files */
+
+
+/*
+ * Local functions...
+ */
+
+static void	clean_dirty(void *data);
+
+
 /*
  * The system management functions cover disk and power management which
  * are primarily used for portable computers.
@@ -51,6 +65,16 @@ cupsdCleanDirty(void)
 {
   if (DirtyFiles & CUPSD_DIRTY_PRINTERS)
     cupsdSaveAllPrinters();
+  else if (DirtyFiles & CUPSD_DIRTY_PRINTSTATE)
+  {
+    cupsd_printer_t	*p;		/* Current printer */
+
+    for (p = (cupsd_printer_t *)cupsArrayFirst(Printers);
+         p;
+	 p = (cupsd_printer_t *)cupsArrayNext(Printers))
+      if (p->state_dirty)
+        cupsdSavePrinterState(p);
+  }
 
   if (DirtyFiles & CUPSD_DIRTY_CLASSES)
     cupsdSaveAllClasses();
@@ -77,6 +101,8 @@ cupsdCleanDirty(void)
   DirtyFiles     = CUPSD_DIRTY_NONE;
   DirtyCleanTime = 0;
 
+  cupsdClearTimer(&dirty_timer);
+
   cupsdSetBusyState();
 }
 
@@ -88,8 +114,9 @@ cupsdCleanDirty(void)
 void
 cupsdMarkDirty(int what)		/* I - What file(s) are dirty? */
 {
-  cupsdLogMessage(CUPSD_LOG_DEBUG, "cupsdMarkDirty(%c%c%c%c%c)",
+  cupsdLogMessage(CUPSD_LOG_DEBUG, "cupsdMarkDirty(%c%c%c%c%c%c)",
 		  (what & CUPSD_DIRTY_PRINTERS) ? 'P' : '-',
+		  (what & CUPSD_DIRTY_PRINTSTATE) ? 's' : '-',
 		  (what & CUPSD_DIRTY_CLASSES) ? 'C' : '-',
 		  (what & CUPSD_DIRTY_PRINTCAP) ? 'p' : '-',
 		  (what & CUPSD_DIRTY_JOBS) ? 'J' : '-',
@@ -101,8 +128,12 @@ cupsdMarkDirty(int what)		/* I - What file(s) are dirty? */
   DirtyFiles |= what;
 
   if (!DirtyCleanTime)
+  {
     DirtyCleanTime = time(NULL) + DirtyCleanInterval;
 
+    cupsdSetTimer(&dirty_timer, DirtyCleanTime, clean_dirty, NULL);
+  }
+
   cupsdSetBusyState();
 }
 
@@ -203,6 +234,19 @@ cupsdSetBusyState(void)
 }
 
 
+/*
+ * 'clean_dirty()' - Write dirty config and state files when the timer fires.
+ */
+
+static void
+clean_dirty(void *data)			/* I - Unused */
+{
+  (void)data;
+
+  cupsdCleanDirty();
+}
+
+
 #ifdef __APPLE__
 /*
  * This is the Apple-specific system event code.  It works by creating
@@ -987,6 +1031,8 @@ sysUpdate(void)
               job->cancel_time = time(NULL) + ippGetInteger(cancel_after, 0);
             else
               job->cancel_time = time(NULL) + MaxJobTime;
+
+            cupsdUpdateJobTimer(job);
           }
         }
       }
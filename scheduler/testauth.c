@@ -0,0 +1,332 @@
+/*
+ * "$Id$"
+ *
+ * Authentication cache test program for CUPS.
+ *
+ * Copyright 2007-2016 by Apple Inc.
+ *
+ * These coded instructions, statements, and computer programs are the
+ * property of Apple Inc. and are protected by Federal copyright
+ * law.  Distribution and use rights are outlined in the file "LICENSE.txt"
+ * which should have been included with this file.  If this file is
+ * file is missing or damaged, see the license at "http://www.cups.org/".
+ *
+ * Usage:
+ *
+ *   ./testauth [-d delay-ms] [-n requests] [-u users]
+ *
+ * The benchmark authenticates Basic credentials through a stub PAM
+ * conversation that simply waits "delay-ms" milliseconds before checking the
+ * password, which is what a PAM stack backed by a directory server looks like
+ * to the scheduler.
+ */
+
+/*
+ * Include necessary headers...
+ */
+
+#include "cupsd.h"
+
+
+/*
+ * Local globals...
+ */
+
+static int	pam_calls = 0;		/* Number of stub PAM conversations */
+static int	pam_delay = 1;		/* Stub PAM delay in milliseconds */
+
+
+/*
+ * Local functions...
+ */
+
+static int	authorize(const char *username, const char *password,
+		          int timeout);
+static double	do_benchmark(int requests, int users, int timeout);
+static int	stub_pam(const char *username, const char *password);
+static void	usage(void) __attribute__((noreturn));
+
+
+/*
+ * 'main()' - Test the authentication and group caches.
+ */
+
+int					/* O - Exit status */
+main(int  argc,				/* I - Number of command-line arguments */
+     char *argv[])			/* I - Command-line arguments */
+{
+  int		i;			/* Looping var */
+  int		status = 0,		/* Exit status */
+		requests = 200,		/* Number of requests */
+		users = 10,		/* Number of users */
+		hits,			/* Number of cache hits */
+		is_member;		/* Group membership */
+  char		username[64],		/* Username */
+		password[64];		/* Password */
+  double	uncached,		/* Time without cache */
+		cached;			/* Time with cache */
+
+
+ /*
+  * Parse command-line options...
+  */
+
+  for (i = 1; i < argc; i ++)
+  {
+    if (!strcmp(argv[i], "-d") && (i + 1) < argc)
+      pam_delay = atoi(argv[++ i]);
+    else if (!strcmp(argv[i], "-n") && (i + 1) < argc)
+      requests = atoi(argv[++ i]);
+    else if (!strcmp(argv[i], "-u") && (i + 1) < argc)
+      users = atoi(argv[++ i]);
+    else
+      usage();
+  }
+
+  if (pam_delay < 0 || requests < 1 || users < 1)
+    usage();
+
+ /*
+  * Test the credential cache...
+  */
+
+  cupsdFlushAuthCache();
+
+  fputs("cupsdCheckAuthCache(empty): ", stdout);
+  if (cupsdCheckAuthCache("user", "secret"))
+  {
+    puts("FAIL (unexpected hit)");
+    status = 1;
+  }
+  else
+    puts("PASS");
+
+  fputs("cupsdAddAuthCache(timeout=0): ", stdout);
+  cupsdAddAuthCache("user", "secret", 0);
+  if (cupsdCheckAuthCache("user", "secret"))
+  {
+    puts("FAIL (cached with caching disabled)");
+    status = 1;
+  }
+  else
+    puts("PASS");
+
+  fputs("cupsdCheckAuthCache(match): ", stdout);
+  cupsdAddAuthCache("user", "secret", 60);
+  if (!cupsdCheckAuthCache("user", "secret"))
+  {
+    puts("FAIL (expected hit)");
+    status = 1;
+  }
+  else
+    puts("PASS");
+
+  fputs("cupsdCheckAuthCache(wrong password): ", stdout);
+  if (cupsdCheckAuthCache("user", "secreT") ||
+      cupsdCheckAuthCache("user", "secret2") ||
+      cupsdCheckAuthCache("user", ""))
+  {
+    puts("FAIL (wrong password accepted)");
+    status = 1;
+  }
+  else
+    puts("PASS");
+
+  fputs("cupsdCheckAuthCache(wrong user): ", stdout);
+  if (cupsdCheckAuthCache("user2", "secret") ||
+      cupsdCheckAuthCache("use", "rsecret"))
+  {
+    puts("FAIL (wrong user accepted)");
+    status = 1;
+  }
+  else
+    puts("PASS");
+
+  fputs("cupsdCheckAuthCache(bounded): ", stdout);
+  for (i = 0; i < 1000; i ++)
+  {
+    snprintf(username, sizeof(username), "user%d", i);
+    snprintf(password, sizeof(password), "pass%d", i);
+    cupsdAddAuthCache(username, password, 60);
+  }
+
+  for (i = 0, hits = 0; i < 1000; i ++)
+  {
+    snprintf(username, sizeof(username), "user%d", i);
+    snprintf(password, sizeof(password), "pass%d", i);
+    hits += cupsdCheckAuthCache(username, password);
+  }
+
+  if (hits == 0 || hits > 64)
+  {
+    printf("FAIL (%d hits)\n", hits);
+    status = 1;
+  }
+  else
+    printf("PASS (%d hits)\n", hits);
+
+  fputs("cupsdFlushAuthCache: ", stdout);
+  cupsdAddAuthCache("user", "secret", 60);
+  cupsdFlushAuthCache();
+  if (cupsdCheckAuthCache("user", "secret"))
+  {
+    puts("FAIL (hit after flush)");
+    status = 1;
+  }
+  else
+    puts("PASS");
+
+ /*
+  * Test the group cache...
+  */
+
+  fputs("cupsdCheckGroupCache: ", stdout);
+  cupsdAddGroupCache("user", "lpadmin", 1, 60);
+  cupsdAddGroupCache("user", "wheel", 0, 60);
+
+  if (!cupsdCheckGroupCache("user", "lpadmin", &is_member) || !is_member)
+  {
+    puts("FAIL (lpadmin)");
+    status = 1;
+  }
+  else if (!cupsdCheckGroupCache("user", "wheel", &is_member) || is_member)
+  {
+    puts("FAIL (wheel)");
+    status = 1;
+  }
+  else if (cupsdCheckGroupCache("user2", "lpadmin", &is_member))
+  {
+    puts("FAIL (user2)");
+    status = 1;
+  }
+  else
+  {
+    cupsdFlushAuthCache();
+
+    if (cupsdCheckGroupCache("user", "lpadmin", &is_member))
+    {
+      puts("FAIL (hit after flush)");
+      status = 1;
+    }
+    else
+      puts("PASS");
+  }
+
+ /*
+  * Benchmark Basic authentication with and without the cache...
+  */
+
+  printf("\nBenchmark: %d requests, %d users, %dms stub PAM delay\n",
+         requests, users, pam_delay);
+
+  uncached = do_benchmark(requests, users, 0);
+  printf("  No cache:  %d PAM calls, %.3f seconds, %.3fms/request\n",
+         pam_calls, uncached, 1000.0 * uncached / requests);
+
+  cached = do_benchmark(requests, users, 60);
+  printf("  Cache:     %d PAM calls, %.3f seconds, %.3fms/request\n",
+         pam_calls, cached, 1000.0 * cached / requests);
+
+  if (pam_calls > users)
+  {
+    printf("FAIL (%d PAM calls with cache, expected %d)\n", pam_calls, users);
+    status = 1;
+  }
+
+  return (status);
+}
+
+
+/*
+ * 'authorize()' - Authorize a user the way cupsdAuthorize() does for Basic.
+ */
+
+static int				/* O - 1 if authorized, 0 otherwise */
+authorize(const char *username,		/* I - Username */
+          const char *password,		/* I - Password */
+	  int        timeout)		/* I - Cache timeout */
+{
+  if (cupsdCheckAuthCache(username, password))
+    return (1);
+
+  if (!stub_pam(username, password))
+    return (0);
+
+  cupsdAddAuthCache(username, password, timeout);
+
+  return (1);
+}
+
+
+/*
+ * 'do_benchmark()' - Authorize a series of requests and return the time taken.
+ */
+
+static double				/* O - Elapsed time in seconds */
+do_benchmark(int requests,		/* I - Number of requests */
+             int users,			/* I - Number of users */
+	     int timeout)		/* I - Cache timeout */
+{
+  int			i;		/* Looping var */
+  char			username[64],	/* Username */
+			password[64];	/* Password */
+  struct timeval	start,		/* Start time */
+			end;		/* End time */
+
+
+  cupsdFlushAuthCache();
+  pam_calls = 0;
+
+  gettimeofday(&start, NULL);
+
+  for (i = 0; i < requests; i ++)
+  {
+    snprintf(username, sizeof(username), "user%d", i % users);
+    snprintf(password, sizeof(password), "pass%d", i % users);
+
+    if (!authorize(username, password, timeout))
+    {
+      printf("authorize(\"%s\") failed!\n", username);
+      exit(1);
+    }
+  }
+
+  gettimeofday(&end, NULL);
+
+  return (end.tv_sec - start.tv_sec + 0.000001 * (end.tv_usec - start.tv_usec));
+}
+
+
+/*
+ * 'stub_pam()' - Stub PAM conversation that accepts "passN" for "userN".
+ */
+
+static int				/* O - 1 if valid, 0 otherwise */
+stub_pam(const char *username,		/* I - Username */
+         const char *password)		/* I - Password */
+{
+  pam_calls ++;
+
+  if (pam_delay > 0)
+    usleep((useconds_t)(pam_delay * 1000));
+
+  return (!strncmp(username, "user", 4) && !strncmp(password, "pass", 4) &&
+          !strcmp(username + 4, password + 4));
+}
+
+
+/*
+ * 'usage()' - Show program usage...
+ */
+
+static void
+usage(void)
+{
+  puts("Usage: testauth [-d delay-ms] [-n requests] [-u users]");
+  exit(1);
+}
+
+
+/*
+ * End of "$Id$".
+ */
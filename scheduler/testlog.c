@@ -0,0 +1,324 @@
+/*
+ * "$Id$"
+ *
+ * Log file test program for CUPS.
+ *
+ * Copyright 2007-2016 by Apple Inc.
+ *
+ * These coded instructions, statements, and computer programs are the
+ * property of Apple Inc. and are protected by Federal copyright
+ * law.  Distribution and use rights are outlined in the file "LICENSE.txt"
+ * which should have been included with this file.  If this file is
+ * file is missing or damaged, see the license at "http://www.cups.org/".
+ *
+ * Usage:
+ *
+ *   ./testlog
+ *
+ * Logs enough messages through the log writer thread to rotate the error log
+ * several times and checks that no message is lost or garbled, then removes
+ * the log directory so that rotation fails and checks that the messages
+ * logged by the failed rotation do not hang the writer thread.
+ */
+
+/*
+ * Include necessary headers...
+ */
+
+#define _MAIN_C_
+#include "cupsd.h"
+
+
+/*
+ * Constants...
+ */
+
+#define TEST_LONG	10000		/* Length of long message */
+#define TEST_MESSAGES	2000		/* Number of messages to log */
+#define TEST_TIMEOUT	30		/* Seconds before a hang is a failure */
+
+
+/*
+ * Local globals...
+ */
+
+static int	end_process_calls = 0;	/* Number of cupsdEndProcess calls */
+
+
+/*
+ * Local functions...
+ */
+
+static int	check_logs(const char *filename, const char *backname);
+static void	sigalrm_handler(int sig);
+
+
+/*
+ * 'main()' - Test the log file functions.
+ */
+
+int					/* O - Exit status */
+main(void)
+{
+  int		i,			/* Looping var */
+		status = 0;		/* Exit status */
+  char		dirname[] = "/tmp/testlog.XXXXXX",
+					/* Temporary directory */
+		filename[1024],		/* Error log filename */
+		backname[1024];		/* Rotated error log filename */
+  static char	longmsg[TEST_LONG + 1];	/* Long message */
+
+
+  if (!mkdtemp(dirname))
+  {
+    perror(dirname);
+    return (1);
+  }
+
+  snprintf(filename, sizeof(filename), "%s/error_log", dirname);
+  snprintf(backname, sizeof(backname), "%s/error_log.O", dirname);
+
+  ErrorLog     = filename;
+  ServerRoot   = dirname;
+  RunUser      = getuid();
+  Group        = getgid();
+  LogLevel     = CUPSD_LOG_DEBUG2;
+  LogQueueSize = 64;
+  MaxLogSize   = 16384;
+  FatalErrors  = CUPSD_FATAL_LOG;
+
+  memset(longmsg, 'x', TEST_LONG);
+
+  signal(SIGALRM, sigalrm_handler);
+  alarm(TEST_TIMEOUT);
+
+ /*
+  * Rotate the error log while the writer thread is active...
+  */
+
+  fputs("cupsdLogMessage (rotate with log thread): ", stdout);
+  fflush(stdout);
+
+  cupsdStartLogThread();
+
+  for (i = 0; i < TEST_MESSAGES; i ++)
+    cupsdLogMessage(CUPSD_LOG_INFO, "Message %d of %d.", i, TEST_MESSAGES);
+
+  cupsdLogMessage(CUPSD_LOG_INFO, "Long message %s", longmsg);
+
+  cupsdStopLogThread();
+
+  if (check_logs(filename, backname))
+    status = 1;
+  else
+    puts("PASS");
+
+ /*
+  * Remove the log directory so that the next rotation fails...
+  */
+
+  fputs("cupsdLogMessage (failed rotation with log thread): ", stdout);
+  fflush(stdout);
+
+  unlink(backname);
+  unlink(filename);
+  rmdir(dirname);
+
+  cupsdStartLogThread();
+
+  for (i = 0; i < TEST_MESSAGES && !cupsdAtomicGet(&end_process_calls); i ++)
+  {
+    cupsdLogMessage(CUPSD_LOG_INFO, "Message %d of %d.", i, TEST_MESSAGES);
+    usleep(100);
+  }
+
+  cupsdStopLogThread();
+
+  if (!cupsdAtomicGet(&end_process_calls))
+  {
+    puts("FAIL (rotation did not fail)");
+    status = 1;
+  }
+  else
+    puts("PASS");
+
+  if (ErrorFile)
+    cupsFileClose(ErrorFile);
+
+  return (status);
+}
+
+
+/*
+ * 'cupsdAddEvent()' - Stub for the subscription code.
+ */
+
+void
+cupsdAddEvent(
+    cupsd_eventmask_t event,		/* I - Event */
+    cupsd_printer_t   *dest,		/* I - Printer associated with event */
+    cupsd_job_t       *job,		/* I - Job associated with event */
+    const char        *text,		/* I - Notification text */
+    ...)				/* I - Additional arguments as needed */
+{
+  (void)event;
+  (void)dest;
+  (void)job;
+  (void)text;
+}
+
+
+/*
+ * 'cupsdCheckPermissions()' - Stub for the configuration code.
+ */
+
+int					/* O - 0 on success */
+cupsdCheckPermissions(
+    const char *filename,		/* I - File/directory name */
+    const char *suffix,			/* I - Additional file/directory name */
+    mode_t     mode,			/* I - Permissions */
+    uid_t      user,			/* I - Owner */
+    gid_t      group,			/* I - Group */
+    int        is_dir,			/* I - 1 = directory, 0 = file */
+    int        create_dir)		/* I - 1 = create directory, -1 = create w/o logging, 0 = not */
+{
+  (void)filename;
+  (void)suffix;
+  (void)mode;
+  (void)user;
+  (void)group;
+  (void)is_dir;
+  (void)create_dir;
+
+  return (0);
+}
+
+
+/*
+ * 'cupsdEndProcess()' - Stub for the process code that logs like the real one.
+ */
+
+int					/* O - 0 on success */
+cupsdEndProcess(int pid,		/* I - Process ID */
+                int force)		/* I - Force child to die */
+{
+  cupsdAtomicAdd(&end_process_calls, 1);
+
+  cupsdLogMessage(CUPSD_LOG_DEBUG2, "cupsdEndProcess(pid=%d, force=%d)", pid,
+                  force);
+
+  return (0);
+}
+
+
+/*
+ * 'cupsdSetPrinterReasons()' - Stub for the printer code.
+ */
+
+int					/* O - 1 if changed, 0 otherwise */
+cupsdSetPrinterReasons(
+    cupsd_printer_t *p,			/* I - Printer */
+    const char      *s)			/* I - Reasons strings */
+{
+  (void)p;
+  (void)s;
+
+  return (0);
+}
+
+
+/*
+ * 'check_logs()' - Check the current and rotated error logs.
+ */
+
+static int				/* O - 0 on success, 1 on failure */
+check_logs(const char *filename,	/* I - Error log filename */
+           const char *backname)	/* I - Rotated error log filename */
+{
+  int		i,			/* Looping var */
+		next = -1,		/* Next message number */
+		number;			/* Message number */
+  size_t	length = 0;		/* Length of last line */
+  cups_file_t	*fp;			/* Log file */
+  char		line[TEST_LONG + 256],	/* Line from log file */
+		*ptr;			/* Pointer into line */
+  const char	*names[2];		/* Log filenames */
+
+
+  names[0] = backname;
+  names[1] = filename;
+
+  for (i = 0; i < 2; i ++)
+  {
+    if ((fp = cupsFileOpen(names[i], "r")) == NULL)
+    {
+      printf("FAIL (unable to open \"%s\" - %s)\n", names[i], strerror(errno));
+      return (1);
+    }
+
+    while (cupsFileGets(fp, line, sizeof(line)))
+    {
+      length = strlen(line);
+
+      if (!strchr("XACEWNIDd", line[0]) || line[1] != ' ' || line[2] != '[' ||
+          (ptr = strchr(line, ']')) == NULL)
+      {
+        printf("FAIL (bad line \"%.40s\")\n", line);
+        cupsFileClose(fp);
+        return (1);
+      }
+
+      if (sscanf(ptr + 1, " Message %d of", &number) != 1)
+        continue;
+
+      if (next >= 0 && number != next)
+      {
+        printf("FAIL (got message %d, expected %d)\n", number, next);
+        cupsFileClose(fp);
+        return (1);
+      }
+
+      next = number + 1;
+    }
+
+    cupsFileClose(fp);
+  }
+
+  if (next != TEST_MESSAGES)
+  {
+    printf("FAIL (last message %d, expected %d)\n", next - 1,
+           TEST_MESSAGES - 1);
+    return (1);
+  }
+
+  if (length < TEST_LONG || strncmp(line + length - TEST_LONG, "xxxx", 4))
+  {
+    printf("FAIL (long message truncated to %d bytes)\n", (int)length);
+    return (1);
+  }
+
+  return (0);
+}
+
+
+/*
+ * 'sigalrm_handler()' - Fail when the log functions hang.
+ */
+
+static void
+sigalrm_handler(int sig)		/* I - Signal number (unused) */
+{
+  static const char msg[] = "FAIL (timed out)\n";
+					/* Failure message */
+
+
+  (void)sig;
+
+  write(1, msg, sizeof(msg) - 1);
+  _exit(1);
+}
+
+
+/*
+ * End of "$Id$".
+ */
@@ -33,6 +33,8 @@
 static int	do_test(const char *server, int port,
 		        http_encryption_t encryption, int requests,
 			const char *opstring, int verbose);
+static int	get_memory(int pid, long *rss, long *data);
+static int	*open_idle(const char *server, int port, int count, int pid);
 static void	usage(void) __attribute__((noreturn));
 
 
@@ -60,6 +62,9 @@ main(int  argc,				/* I - Number of command-line arguments */
   double	elapsed;		/* Elapsed time */
   int		verbose;		/* Verbosity */
   const char	*opstring;		/* Operation name */
+  int		idle,			/* Number of idle connections */
+		*idle_fds,		/* Idle connection sockets */
+		server_pid;		/* Server process ID */
 
 
  /*
@@ -73,6 +78,9 @@ main(int  argc,				/* I - Number of command-line arguments */
   encryption = HTTP_ENCRYPT_IF_REQUESTED;
   verbose    = 0;
   opstring   = NULL;
+  idle       = 0;
+  idle_fds   = NULL;
+  server_pid = 0;
 
   for (i = 1; i < argc; i ++)
     if (argv[i][0] == '-')
@@ -92,6 +100,22 @@ main(int  argc,				/* I - Number of command-line arguments */
 	      children = atoi(argv[i]);
 	      break;
 
+	  case 'i' : /* Number of idle connections */
+	      i ++;
+	      if (i >= argc)
+		usage();
+
+	      idle = atoi(argv[i]);
+	      break;
+
+	  case 'm' : /* Server process ID for memory usage */
+	      i ++;
+	      if (i >= argc)
+		usage();
+
+	      server_pid = atoi(argv[i]);
+	      break;
+
           case 'o' : /* Operation */
 	      i ++;
 	      if (i >= argc)
@@ -128,6 +152,13 @@ main(int  argc,				/* I - Number of command-line arguments */
       }
     }
 
+ /*
+  * Open any idle keep-alive connections that are held during the test...
+  */
+
+  if (idle > 0 && (idle_fds = open_idle(server, port, idle, server_pid)) == NULL)
+    return (1);
+
  /*
   * Then create child processes to act as clients...
   */
@@ -229,6 +260,14 @@ main(int  argc,				/* I - Number of command-line arguments */
 	   good_children, requests, i, elapsed, elapsed / i, i / elapsed);
   }
 
+  if (idle_fds)
+  {
+    for (i = 0; i < idle; i ++)
+      httpAddrClose(NULL, idle_fds[i]);
+
+    free(idle_fds);
+  }
+
  /*
   * Exit with no errors...
   */
@@ -361,6 +400,149 @@ do_test(const char        *server,	/* I - Server to use */
 }
 
 
+/*
+ * 'get_memory()' - Get the resident and data sizes of a process in kilobytes.
+ */
+
+static int				/* O - 1 on success, 0 if unknown */
+get_memory(int  pid,			/* I - Process ID */
+           long *rss,			/* O - Resident size */
+	   long *data)			/* O - Data (heap) size */
+{
+  cups_file_t	*fp;			/* /proc status file */
+  char		filename[256],		/* Status filename */
+		line[256];		/* Line from file */
+
+
+  *rss  = -1;
+  *data = -1;
+
+  snprintf(filename, sizeof(filename), "/proc/%d/status", pid);
+
+  if ((fp = cupsFileOpen(filename, "r")) == NULL)
+    return (0);
+
+  while (cupsFileGets(fp, line, sizeof(line)))
+    if (!strncmp(line, "VmRSS:", 6))
+      *rss = strtol(line + 6, NULL, 10);
+    else if (!strncmp(line, "VmData:", 7))
+      *data = strtol(line + 7, NULL, 10);
+
+  cupsFileClose(fp);
+
+  return (*rss >= 0 && *data >= 0);
+}
+
+
+/*
+ * 'open_idle()' - Open keep-alive connections and leave them idle.
+ *
+ * Each connection sends one OPTIONS request so the server sees a keep-alive
+ * client rather than a connection that never sent anything.  Connections are
+ * opened in groups a few seconds apart, like clients arriving over time, so
+ * the server can settle each group before the next one arrives.  When a
+ * server process ID is given, the change in its memory usage is reported once
+ * the connections have been idle for a few seconds.
+ */
+
+static int *				/* O - Array of sockets or NULL */
+open_idle(const char *server,		/* I - Server to use */
+          int        port,		/* I - Port number to use */
+	  int        count,		/* I - Number of connections */
+	  int        pid)		/* I - Server process ID or 0 */
+{
+  int			i,		/* Looping var */
+			*fds;		/* Sockets */
+  char			portstr[32],	/* Port number string */
+			request[1024],	/* OPTIONS request */
+			buffer[2048];	/* Response from server */
+  http_addrlist_t	*addrlist;	/* Server addresses */
+  int			have_memory;	/* Have memory usage for server? */
+  long			rss_start,	/* Resident size before connecting */
+			rss_end,	/* Resident size while idle */
+			data_start,	/* Data size before connecting */
+			data_end;	/* Data size while idle */
+
+
+  snprintf(portstr, sizeof(portstr), "%d", port);
+
+  if ((addrlist = httpAddrGetList(server, AF_UNSPEC, portstr)) == NULL)
+  {
+    printf("testspeed: Unable to lookup \"%s\" - %s\n", server,
+           cupsLastErrorString());
+    return (NULL);
+  }
+
+  if ((fds = calloc((size_t)count, sizeof(int))) == NULL)
+  {
+    puts("testspeed: Unable to allocate memory for idle connections.");
+    httpAddrFreeList(addrlist);
+    return (NULL);
+  }
+
+  snprintf(request, sizeof(request),
+           "OPTIONS * HTTP/1.1\r\nHost: %s\r\nConnection: keep-alive\r\n\r\n",
+	   server);
+
+  have_memory = pid > 0 && get_memory(pid, &rss_start, &data_start);
+
+  printf("testspeed: Opening %d idle connections to %s...\n", count, server);
+
+  for (i = 0; i < count; i ++)
+  {
+    if (i > 0 && !(i % 1000))
+      sleep(3);
+
+    if (!httpAddrConnect2(addrlist, fds + i, 30000, NULL))
+    {
+      printf("testspeed: Unable to open idle connection %d - %s\n", i + 1,
+             strerror(errno));
+      break;
+    }
+
+    if (send(fds[i], request, strlen(request), 0) < 0 ||
+        recv(fds[i], buffer, sizeof(buffer), 0) < 7 ||
+	strncmp(buffer, "HTTP/1.", 7))
+    {
+      printf("testspeed: Idle connection %d failed - %s\n", i + 1,
+             strerror(errno));
+      httpAddrClose(NULL, fds[i]);
+      break;
+    }
+  }
+
+  httpAddrFreeList(addrlist);
+
+  if (i < count)
+  {
+    while (i > 0)
+      httpAddrClose(NULL, fds[-- i]);
+
+    free(fds);
+    return (NULL);
+  }
+
+  if (have_memory)
+  {
+   /*
+    * Give the server time to settle the connections and then report the
+    * memory they use...
+    */
+
+    sleep(5);
+
+    if (get_memory(pid, &rss_end, &data_end))
+      printf("testspeed: Server memory with %d idle connections: resident "
+             "%ldkB -> %ldkB (%.2fkB/connection), data %ldkB -> %ldkB "
+	     "(%.2fkB/connection)\n", count, rss_start, rss_end,
+	     (double)(rss_end - rss_start) / count, data_start, data_end,
+	     (double)(data_end - data_start) / count);
+  }
+
+  return (fds);
+}
+
+
 /*
  * 'usage()' - Show program usage...
  */
@@ -368,8 +550,9 @@ do_test(const char        *server,	/* I - Server to use */
 static void
 usage(void)
 {
-  puts("Usage: testspeed [-c children] [-h] [-o operation] [-r requests] [-v] "
-       "[-E] hostname[:port]");
+  puts("Usage: testspeed [-c children] [-h] [-i idle-connections] "
+       "[-m server-pid] [-o operation] [-r requests] [-v] [-E] "
+       "hostname[:port]");
   exit(0);
 }
 
@@ -0,0 +1,438 @@
+/*
+ * "$Id$"
+ *
+ * Timer routines for the CUPS scheduler.
+ *
+ * Copyright 2007-2016 by Apple Inc.
+ *
+ * These coded instructions, statements, and computer programs are the
+ * property of Apple Inc. and are protected by Federal copyright
+ * law.  Distribution and use rights are outlined in the file "LICENSE.txt"
+ * which should have been included with this file.  If this file is
+ * file is missing or damaged, see the license at "http://www.cups.org/".
+ *
+ * Timers are kept in a hierarchical timing wheel with one second resolution:
+ * level 0 holds timers due in the next 64 seconds, level 1 the next 64*64
+ * seconds, and so forth.  Setting, clearing, and finding the next timer are
+ * constant time operations; timers in the upper levels are moved ("cascaded")
+ * down one level each time the level below wraps around.
+ */
+
+/*
+ * Include necessary headers...
+ */
+
+#include "cupsd.h"
+
+
+/*
+ * Constants...
+ */
+
+#define CUPSD_TIMER_BITS	6	/* Bits per wheel level */
+#define CUPSD_TIMER_SLOTS	64	/* Slots per wheel level */
+#define CUPSD_TIMER_MASK	63	/* Slot mask */
+#define CUPSD_TIMER_LEVELS	4	/* Number of wheel levels */
+#define CUPSD_TIMER_RANGE	((time_t)1 << (CUPSD_TIMER_BITS * CUPSD_TIMER_LEVELS))
+					/* Maximum delta in the wheel */
+
+
+/*
+ * Local globals...
+ */
+
+static cupsd_timer_t	wheel[CUPSD_TIMER_LEVELS][CUPSD_TIMER_SLOTS];
+					/* Timer wheel slots */
+static cupsd_timer_t	expired;	/* Expired timers */
+static time_t		wheel_time = 0;	/* Time of last wheel update */
+static time_t		next_time = 0;	/* Cached time of next timer */
+static int		next_valid = 0;	/* Is next_time valid? */
+
+
+/*
+ * Local functions...
+ */
+
+static void	add_timer(cupsd_timer_t *timer);
+static void	cascade_timers(int level, int slot);
+static void	init_wheel(void);
+static void	link_timer(cupsd_timer_t *list, cupsd_timer_t *timer);
+static void	move_timers(cupsd_timer_t *from, cupsd_timer_t *to);
+static void	rehash_timers(time_t curtime);
+static void	unlink_timer(cupsd_timer_t *timer);
+
+
+/*
+ * 'cupsdClearTimer()' - Stop a timer.
+ */
+
+void
+cupsdClearTimer(cupsd_timer_t *timer)	/* I - Timer */
+{
+  if (!timer || !timer->next)
+    return;
+
+  if (next_valid && timer->when <= next_time)
+    next_valid = 0;
+
+  unlink_timer(timer);
+
+  timer->when = 0;
+}
+
+
+/*
+ * 'cupsdNextTimer()' - Return the time of the next timer, or 0 if none.
+ */
+
+time_t					/* O - Time of next timer */
+cupsdNextTimer(void)
+{
+  int		level,			/* Current level */
+		shift,			/* Shift for level */
+		i,			/* Looping var */
+		slot;			/* Current slot */
+  time_t	nearest;		/* Nearest time */
+  cupsd_timer_t	*timer;			/* Current timer */
+
+
+  if (!wheel_time)
+    return (0);
+
+  if (expired.next != &expired)
+    return (wheel_time);
+
+  if (next_valid)
+    return (next_time);
+
+ /*
+  * Level 0 slots hold timers for a single second, so the first non-empty
+  * slot gives the exact time; the upper levels hold a range of times, so look
+  * at every timer in the first non-empty slot...
+  */
+
+  nearest = 0;
+
+  for (i = 1; i < CUPSD_TIMER_SLOTS; i ++)
+  {
+    slot = (int)((wheel_time + i) & CUPSD_TIMER_MASK);
+
+    if (wheel[0][slot].next != &wheel[0][slot])
+    {
+      nearest = wheel_time + i;
+      break;
+    }
+  }
+
+  for (level = 1; level < CUPSD_TIMER_LEVELS; level ++)
+  {
+    shift = level * CUPSD_TIMER_BITS;
+
+    for (i = 1; i <= CUPSD_TIMER_SLOTS; i ++)
+    {
+      slot = (int)(((wheel_time >> shift) + i) & CUPSD_TIMER_MASK);
+
+      if (wheel[level][slot].next == &wheel[level][slot])
+        continue;
+
+      for (timer = wheel[level][slot].next;
+           timer != &wheel[level][slot];
+	   timer = timer->next)
+        if (!nearest || timer->when < nearest)
+	  nearest = timer->when;
+      break;
+    }
+  }
+
+  next_time  = nearest;
+  next_valid = 1;
+
+  return (nearest);
+}
+
+
+/*
+ * 'cupsdRunTimers()' - Run any expired timers.
+ */
+
+void
+cupsdRunTimers(void)
+{
+  time_t	curtime;		/* Current time */
+  cupsd_timer_t	fire,			/* Timers to fire */
+		*timer;			/* Current timer */
+
+
+  if (!wheel_time)
+    init_wheel();
+
+  curtime = time(NULL);
+
+  if (curtime < wheel_time || (curtime - wheel_time) > (CUPSD_TIMER_SLOTS * CUPSD_TIMER_SLOTS))
+  {
+   /*
+    * The clock has been changed or we have been asleep for a long time, so
+    * just rebuild the wheel...
+    */
+
+    rehash_timers(curtime);
+  }
+  else
+  {
+    while (wheel_time < curtime)
+    {
+      wheel_time ++;
+
+      if (!(wheel_time & CUPSD_TIMER_MASK))
+      {
+       /*
+        * Cascade the upper levels from the top down...
+	*/
+
+        if (!(wheel_time & ((1 << (2 * CUPSD_TIMER_BITS)) - 1)))
+	{
+	  if (!(wheel_time & ((1 << (3 * CUPSD_TIMER_BITS)) - 1)))
+	    cascade_timers(3, (int)((wheel_time >> (3 * CUPSD_TIMER_BITS)) &
+	                            CUPSD_TIMER_MASK));
+
+	  cascade_timers(2, (int)((wheel_time >> (2 * CUPSD_TIMER_BITS)) &
+	                          CUPSD_TIMER_MASK));
+	}
+
+	cascade_timers(1, (int)((wheel_time >> CUPSD_TIMER_BITS) &
+	                        CUPSD_TIMER_MASK));
+      }
+
+      move_timers(&wheel[0][wheel_time & CUPSD_TIMER_MASK], &expired);
+    }
+  }
+
+  next_valid = 0;
+
+  if (expired.next == &expired)
+    return;
+
+ /*
+  * Fire the expired timers; the callbacks may set or clear any timer,
+  * including the ones we are about to fire...
+  */
+
+  fire.prev = fire.next = &fire;
+
+  move_timers(&expired, &fire);
+
+  while ((timer = fire.next) != &fire)
+  {
+    unlink_timer(timer);
+    timer->when = 0;
+
+    (*timer->func)(timer->data);
+  }
+}
+
+
+/*
+ * 'cupsdSetTimer()' - Start or restart a timer.
+ *
+ * A "when" value of 0 stops the timer.
+ */
+
+void
+cupsdSetTimer(cupsd_timer_t     *timer,	/* I - Timer */
+              time_t            when,	/* I - Time to fire */
+	      cupsd_timerfunc_t func,	/* I - Function to call */
+	      void              *data)	/* I - Data for function */
+{
+  if (!timer)
+    return;
+
+  cupsdClearTimer(timer);
+
+  if (!when || !func)
+    return;
+
+  if (!wheel_time)
+    init_wheel();
+
+  timer->when = when;
+  timer->func = func;
+  timer->data = data;
+
+  add_timer(timer);
+
+  if (next_valid && (!next_time || when < next_time))
+    next_time = when < wheel_time ? wheel_time : when;
+}
+
+
+/*
+ * 'add_timer()' - Add a timer to the wheel.
+ */
+
+static void
+add_timer(cupsd_timer_t *timer)		/* I - Timer */
+{
+  time_t	delta,			/* Time until timer fires */
+		when;			/* Time used for slot */
+  int		level;			/* Wheel level */
+
+
+  delta = timer->when - wheel_time;
+  when  = timer->when;
+
+  if (delta <= 0)
+  {
+    link_timer(&expired, timer);
+    return;
+  }
+
+  if (delta >= CUPSD_TIMER_RANGE)
+  {
+   /*
+    * Park timers beyond the range of the wheel in the last slot; they get
+    * re-added as the wheel turns...
+    */
+
+    when  = wheel_time + CUPSD_TIMER_RANGE - 1;
+    delta = CUPSD_TIMER_RANGE - 1;
+  }
+
+  for (level = 0; level < (CUPSD_TIMER_LEVELS - 1); level ++)
+    if (delta < ((time_t)1 << ((level + 1) * CUPSD_TIMER_BITS)))
+      break;
+
+  link_timer(&wheel[level][(when >> (level * CUPSD_TIMER_BITS)) &
+                           CUPSD_TIMER_MASK], timer);
+}
+
+
+/*
+ * 'cascade_timers()' - Move the timers in an upper level slot down the wheel.
+ */
+
+static void
+cascade_timers(int level,		/* I - Wheel level */
+               int slot)		/* I - Slot */
+{
+  cupsd_timer_t	pending,		/* Timers to re-add */
+		*timer;			/* Current timer */
+
+
+  pending.prev = pending.next = &pending;
+
+  move_timers(&wheel[level][slot], &pending);
+
+  while ((timer = pending.next) != &pending)
+  {
+    unlink_timer(timer);
+    add_timer(timer);
+  }
+}
+
+
+/*
+ * 'init_wheel()' - Initialize the timer wheel.
+ */
+
+static void
+init_wheel(void)
+{
+  int		level,			/* Current level */
+		slot;			/* Current slot */
+
+
+  for (level = 0; level < CUPSD_TIMER_LEVELS; level ++)
+    for (slot = 0; slot < CUPSD_TIMER_SLOTS; slot ++)
+      wheel[level][slot].prev = wheel[level][slot].next = &wheel[level][slot];
+
+  expired.prev = expired.next = &expired;
+
+  wheel_time = time(NULL);
+  next_valid = 0;
+}
+
+
+/*
+ * 'link_timer()' - Add a timer to the end of a list.
+ */
+
+static void
+link_timer(cupsd_timer_t *list,		/* I - List */
+           cupsd_timer_t *timer)	/* I - Timer */
+{
+  timer->prev      = list->prev;
+  timer->next      = list;
+  list->prev->next = timer;
+  list->prev       = timer;
+}
+
+
+/*
+ * 'move_timers()' - Move all timers from one list to the end of another.
+ */
+
+static void
+move_timers(cupsd_timer_t *from,	/* I - Source list */
+            cupsd_timer_t *to)		/* I - Destination list */
+{
+  if (from->next == from)
+    return;
+
+  from->next->prev = to->prev;
+  to->prev->next   = from->next;
+  from->prev->next = to;
+  to->prev         = from->prev;
+
+  from->prev = from->next = from;
+}
+
+
+/*
+ * 'rehash_timers()' - Rebuild the wheel for a new current time.
+ */
+
+static void
+rehash_timers(time_t curtime)		/* I - Current time */
+{
+  int		level,			/* Current level */
+		slot;			/* Current slot */
+  cupsd_timer_t	pending,		/* Timers to re-add */
+		*timer;			/* Current timer */
+
+
+  cupsdLogMessage(CUPSD_LOG_DEBUG2, "rehash_timers: Clock moved by %ld seconds.",
+                  (long)(curtime - wheel_time));
+
+  pending.prev = pending.next = &pending;
+
+  for (level = 0; level < CUPSD_TIMER_LEVELS; level ++)
+    for (slot = 0; slot < CUPSD_TIMER_SLOTS; slot ++)
+      move_timers(&wheel[level][slot], &pending);
+
+  wheel_time = curtime;
+
+  while ((timer = pending.next) != &pending)
+  {
+    unlink_timer(timer);
+    add_timer(timer);
+  }
+}
+
+
+/*
+ * 'unlink_timer()' - Remove a timer from its list.
+ */
+
+static void
+unlink_timer(cupsd_timer_t *timer)	/* I - Timer */
+{
+  timer->prev->next = timer->next;
+  timer->next->prev = timer->prev;
+  timer->prev       = NULL;
+  timer->next       = NULL;
+}
+
+
+/*
+ * End of "$Id$".
+ */
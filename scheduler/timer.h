@@ -0,0 +1,50 @@
+/*
+ * "$Id$"
+ *
+ * Timer definitions for the CUPS scheduler.
+ *
+ * Copyright 2007-2016 by Apple Inc.
+ *
+ * These coded instructions, statements, and computer programs are the
+ * property of Apple Inc. and are protected by Federal copyright
+ * law.  Distribution and use rights are outlined in the file "LICENSE.txt"
+ * which should have been included with this file.  If this file is
+ * file is missing or damaged, see the license at "http://www.cups.org/".
+ */
+
+
+/*
+ * Timer callback function...
+ */
+
+typedef void (*cupsd_timerfunc_t)(void *data);
+
+
+/*
+ * Timer structure, normally embedded in the object it times...
+ */
+
+typedef struct cupsd_timer_s		/**** Timer ****/
+{
+  struct cupsd_timer_s	*prev,		/* Previous timer in wheel slot */
+			*next;		/* Next timer in wheel slot */
+  time_t		when;		/* Expiration time, 0 if not set */
+  cupsd_timerfunc_t	func;		/* Function to call */
+  void			*data;		/* Data for function */
+} cupsd_timer_t;
+
+
+/*
+ * Prototypes...
+ */
+
+extern void		cupsdClearTimer(cupsd_timer_t *timer);
+extern time_t		cupsdNextTimer(void);
+extern void		cupsdRunTimers(void);
+extern void		cupsdSetTimer(cupsd_timer_t *timer, time_t when,
+			              cupsd_timerfunc_t func, void *data);
+
+
+/*
+ * End of "$Id$".
+ */
@@ -0,0 +1,230 @@
+/*
+ * "$Id$"
+ *
+ * Request tracing routines for the CUPS scheduler.
+ *
+ * Copyright 2007-2016 by Apple Inc.
+ *
+ * These coded instructions, statements, and computer programs are the
+ * property of Apple Inc. and are protected by Federal copyright
+ * law.  Distribution and use rights are outlined in the file "LICENSE.txt"
+ * which should have been included with this file.  If this file is
+ * file is missing or damaged, see the license at "http://www.cups.org/".
+ *
+ * The trace file uses the JSON array form of the Chrome trace event format,
+ * which allows the closing bracket to be omitted.  This lets us append to an
+ * existing trace after a restart or reload and still produce a file that
+ * loads in chrome://tracing and other trace viewers.  The trace file is
+ * rotated with cupsdCheckLogFile() like the other log files, and each new
+ * file gets its own opening bracket and track names.
+ */
+
+/*
+ * Include necessary headers...
+ */
+
+#include "cupsd.h"
+
+
+/*
+ * Local functions...
+ */
+
+static char	*quote_string(const char *s, char *buffer, size_t bufsize);
+static void	write_event(cupsd_trace_t track, int id, const char *name,
+		            const char *phase, struct timeval *start,
+			    struct timeval *end, const char *detail);
+static void	write_header(void);
+
+
+/*
+ * 'cupsdStartTrace()' - Open the trace file, if any.
+ */
+
+void
+cupsdStartTrace(void)
+{
+  if (TraceFile || !TraceLog || !TraceLog[0])
+    return;
+
+  if (!cupsdCheckLogFile(&TraceFile, TraceLog))
+    return;
+
+  write_header();
+
+  cupsdLogMessage(CUPSD_LOG_INFO, "Writing trace events to \"%s\".",
+                  TraceLog);
+}
+
+
+/*
+ * 'cupsdStopTrace()' - Flush and close the trace file.
+ */
+
+void
+cupsdStopTrace(void)
+{
+  if (!TraceFile)
+    return;
+
+  if (TraceFile != LogStderr)
+    cupsFileClose(TraceFile);
+
+  TraceFile = NULL;
+}
+
+
+/*
+ * 'cupsdTraceEvent()' - Record an instant event.
+ */
+
+void
+cupsdTraceEvent(cupsd_trace_t track,	/* I - Track */
+                int           id,	/* I - Client number or job ID */
+                const char    *name,	/* I - Event name */
+		const char    *detail)	/* I - Detail string or NULL */
+{
+  struct timeval	now;		/* Current time */
+
+
+  if (!TraceFile)
+    return;
+
+  gettimeofday(&now, NULL);
+
+  write_event(track, id, name, "i", &now, NULL, detail);
+}
+
+
+/*
+ * 'cupsdTraceSpan()' - Record a span that ends now.
+ */
+
+void
+cupsdTraceSpan(cupsd_trace_t  track,	/* I - Track */
+               int            id,	/* I - Client number or job ID */
+               const char     *name,	/* I - Span name */
+	       struct timeval *start,	/* I - Start of span */
+	       const char     *detail)	/* I - Detail string or NULL */
+{
+  struct timeval	now;		/* Current time */
+
+
+  if (!TraceFile || !start->tv_sec)
+    return;
+
+  gettimeofday(&now, NULL);
+
+  write_event(track, id, name, "X", start, &now, detail);
+}
+
+
+/*
+ * 'quote_string()' - Quote a string for use in a JSON string value.
+ */
+
+static char *				/* O - Quoted string */
+quote_string(const char *s,		/* I - Original string */
+             char       *buffer,	/* I - String buffer */
+	     size_t     bufsize)	/* I - Size of buffer */
+{
+  char	*bufptr,			/* Pointer into buffer */
+	*bufend;			/* End of buffer */
+
+
+  for (bufptr = buffer, bufend = buffer + bufsize - 7;
+       *s && bufptr < bufend;
+       s ++)
+  {
+    if (*s == '\"' || *s == '\\')
+    {
+      *bufptr++ = '\\';
+      *bufptr++ = *s;
+    }
+    else if ((*s & 255) < ' ')
+    {
+      snprintf(bufptr, 7, "\\u%04x", *s & 255);
+      bufptr += 6;
+    }
+    else
+      *bufptr++ = *s;
+  }
+
+  *bufptr = '\0';
+
+  return (buffer);
+}
+
+
+/*
+ * 'write_event()' - Write a trace event.
+ */
+
+static void
+write_event(cupsd_trace_t  track,	/* I - Track */
+            int            id,		/* I - Client number or job ID */
+	    const char     *name,	/* I - Event name */
+	    const char     *phase,	/* I - Event phase */
+	    struct timeval *start,	/* I - Start time */
+	    struct timeval *end,	/* I - End time or NULL */
+	    const char     *detail)	/* I - Detail string or NULL */
+{
+  long long	ts;			/* Start timestamp in microseconds */
+  char		temp[1024];		/* Quoted name or detail string */
+
+
+ /*
+  * Rotate the trace file as needed, starting a new trace in the new file...
+  */
+
+  if (!cupsdCheckLogFile(&TraceFile, TraceLog))
+    return;
+
+  if (cupsFileTell(TraceFile) == 0)
+    write_header();
+
+  ts = (long long)start->tv_sec * 1000000 + start->tv_usec;
+
+  cupsFilePrintf(TraceFile,
+                 "{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"%s\","
+		 "\"ts\":%lld,", quote_string(name, temp, sizeof(temp)),
+		 track == CUPSD_TRACE_CLIENT ? "client" : "job", phase, ts);
+
+  if (end)
+    cupsFilePrintf(TraceFile, "\"dur\":%lld,",
+                   (long long)end->tv_sec * 1000000 + end->tv_usec - ts);
+  else
+    cupsFilePuts(TraceFile, "\"s\":\"t\",");
+
+  cupsFilePrintf(TraceFile, "\"pid\":%d,\"tid\":%d", (int)track, id);
+
+  if (detail)
+    cupsFilePrintf(TraceFile, ",\"args\":{\"detail\":\"%s\"}",
+                   quote_string(detail, temp, sizeof(temp)));
+
+  cupsFilePuts(TraceFile, "},\n");
+}
+
+
+/*
+ * 'write_header()' - Start a new trace as needed and name the tracks.
+ */
+
+static void
+write_header(void)
+{
+  if (cupsFileTell(TraceFile) == 0)
+    cupsFilePuts(TraceFile, "[\n");
+
+  cupsFilePrintf(TraceFile,
+                 "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,"
+		 "\"args\":{\"name\":\"cupsd clients\"}},\n"
+                 "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,"
+		 "\"args\":{\"name\":\"cupsd jobs\"}},\n",
+		 CUPSD_TRACE_CLIENT, CUPSD_TRACE_JOB);
+}
+
+
+/*
+ * End of "$Id$".
+ */
@@ -0,0 +1,52 @@
+/*
+ * "$Id$"
+ *
+ * Request tracing definitions for the CUPS scheduler.
+ *
+ * Copyright 2007-2016 by Apple Inc.
+ *
+ * These coded instructions, statements, and computer programs are the
+ * property of Apple Inc. and are protected by Federal copyright
+ * law.  Distribution and use rights are outlined in the file "LICENSE.txt"
+ * which should have been included with this file.  If this file is
+ * file is missing or damaged, see the license at "http://www.cups.org/".
+ */
+
+
+/*
+ * Trace tracks...
+ */
+
+typedef enum cupsd_trace_e		/**** Trace tracks ****/
+{
+  CUPSD_TRACE_CLIENT = 1,		/* Client connections, id = client number */
+  CUPSD_TRACE_JOB			/* Jobs, id = job ID */
+} cupsd_trace_t;
+
+
+/*
+ * Globals...
+ */
+
+VAR char		*TraceLog		VALUE(NULL);
+					/* Trace file name */
+VAR cups_file_t		*TraceFile		VALUE(NULL);
+					/* Trace file, NULL when not tracing */
+
+
+/*
+ * Prototypes...
+ */
+
+extern void		cupsdStartTrace(void);
+extern void		cupsdStopTrace(void);
+extern void		cupsdTraceEvent(cupsd_trace_t track, int id,
+			                const char *name, const char *detail);
+extern void		cupsdTraceSpan(cupsd_trace_t track, int id,
+			               const char *name, struct timeval *start,
+				       const char *detail);
+
+
+/*
+ * End of "$Id$".
+ */